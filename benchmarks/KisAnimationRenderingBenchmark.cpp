@@ -28,6 +28,9 @@
 #include "KisDocument.h"
 #include "kis_image.h"
 #include "kis_image_config.h"
+#include "kis_keyframe_channel.h"
+#include "kis_paint_layer.h"
+#include "kundo2command.h"
 
 namespace {
 void removeTempFiles(const QString &filesMask)
@@ -109,4 +112,74 @@ void KisAnimationRenderingBenchmark::testCacheRendering()
     }
 }
 
+void KisAnimationRenderingBenchmark::testFramesPerSecond()
+{
+    const QRect imageRect(0, 0, 2048, 2048);
+    const int numFrames = 48;
+    const int numLayers = 4;
+
+    TestUtil::MaskParent p(imageRect);
+    const KoColorSpace *cs = p.image->colorSpace();
+    KUndo2Command parentCommand;
+
+    QList<KisPaintLayerSP> layers;
+    layers << p.layer;
+
+    for (int i = 1; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(p.image, QString("layer%1").arg(i), OPACITY_OPAQUE_U8 / 2);
+        p.image->addNode(layer);
+        layers << layer;
+    }
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = layers[i];
+        layer->enableAnimation();
+        KisKeyframeChannel *channel = layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+
+        for (int frame = 0; frame < numFrames; frame++) {
+            if (frame > 0) {
+                channel->addKeyframe(frame, &parentCommand);
+            }
+
+            p.image->animationInterface()->switchCurrentTimeAsync(frame);
+            p.image->waitForDone();
+
+            const QRect fillRect(64 * frame + 32 * i, 64 * i, 512, 1024);
+            layer->paintDevice()->fill(fillRect, KoColor(QColor(5 * frame, 50 * i, 128), cs));
+        }
+    }
+
+    const KisTimeRange range = KisTimeRange::fromTime(0, numFrames - 1);
+    p.image->animationInterface()->setFullClipRange(range);
+    p.image->waitForDone();
+
+    KisImageConfig cfg;
+    const int oldNumThreads = cfg.maxNumberOfThreads();
+    const int oldNumClones = cfg.frameRenderingClones();
+
+    for (int numClones = 1; numClones <= QThread::idealThreadCount(); numClones *= 2) {
+        cfg.setMaxNumberOfThreads(QThread::idealThreadCount());
+        cfg.setFrameRenderingClones(numClones);
+
+        KisAsyncAnimationFramesSaveDialog dlg(p.image, range, "temp_frames.png", 0, 0);
+        dlg.setBatchMode(true);
+        dlg.setFrameConsumer([] (int, KisPaintDeviceSP) { return true; });
+
+        QElapsedTimer timer;
+        timer.start();
+
+        KisAsyncAnimationFramesSaveDialog::Result result = dlg.regenerateRange(0);
+        QCOMPARE(result, KisAsyncAnimationFramesSaveDialog::RenderComplete);
+
+        const qint64 elapsed = timer.elapsed();
+
+        qDebug() << "Clones:" << numClones
+                 << "Time:" << elapsed
+                 << "FPS:" << qreal(numFrames) * 1000.0 / qMax(qint64(1), elapsed);
+    }
+
+    cfg.setMaxNumberOfThreads(oldNumThreads);
+    cfg.setFrameRenderingClones(oldNumClones);
+}
+
 QTEST_MAIN(KisAnimationRenderingBenchmark)
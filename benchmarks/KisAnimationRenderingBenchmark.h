@@ -26,6 +26,7 @@ class KisAnimationRenderingBenchmark : public QObject
     Q_OBJECT
 private Q_SLOTS:
    void testCacheRendering();
+   void testFramesPerSecond();
 };
 
 #endif // KISANIMATIONRENDERINGBENCHMARK_H
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisKraLoadBenchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <testutil.h>
+#include <KoColorSpaceRegistry.h>
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+#include "kis_group_layer.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_image_config.h"
+
+#define IMAGE_WIDTH 4000
+#define IMAGE_HEIGHT 3000
+#define NUM_LAYERS 30
+
+#define SMALL_LAYER_SIZE 256
+#define NUM_SMALL_LAYERS 300
+
+
+bool saveManyLayersDocument(const QString &fileName, int width, int height, int numLayers)
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(doc->createUndoStore(),
+                                    width, height, cs,
+                                    "load benchmark");
+    doc->setCurrentImage(image);
+
+    /**
+     * Every layer has its own noisy gradient, so that the tiles
+     * were neither trivially compressible nor equal to each other
+     */
+    qsrand(1);
+    QVector<quint8> row(width * cs->pixelSize());
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+
+        for (int y = 0; y < height; y++) {
+            quint8 *ptr = row.data();
+            for (int x = 0; x < width; x++) {
+                *ptr++ = quint8(x + i);
+                *ptr++ = quint8(y + i);
+                *ptr++ = quint8(x + y + (qrand() & 0x7));
+                *ptr++ = 255;
+            }
+            layer->paintDevice()->writeBytes(row.data(), 0, y, width, 1);
+        }
+
+        image->addNode(layer, image->root());
+    }
+
+    image->initialRefreshGraph();
+
+    return doc->exportDocumentSync(QUrl::fromLocalFile(fileName), "application/x-krita");
+}
+
+void KisKraLoadBenchmark::initTestCase()
+{
+    m_fileName = QDir::tempPath() + QDir::separator() + "kis_kra_load_benchmark.kra";
+    m_smallLayersFileName = QDir::tempPath() + QDir::separator() + "kis_kra_load_benchmark_small.kra";
+
+    QVERIFY(saveManyLayersDocument(m_fileName, IMAGE_WIDTH, IMAGE_HEIGHT, NUM_LAYERS));
+    QVERIFY(saveManyLayersDocument(m_smallLayersFileName, SMALL_LAYER_SIZE, SMALL_LAYER_SIZE, NUM_SMALL_LAYERS));
+}
+
+void KisKraLoadBenchmark::cleanupTestCase()
+{
+    QFile::remove(m_fileName);
+    QFile::remove(m_smallLayersFileName);
+}
+
+void KisKraLoadBenchmark::benchmarkLoadManyLayers()
+{
+    QBENCHMARK_ONCE {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        QVERIFY(doc->loadNativeFormat(m_fileName));
+        QCOMPARE(doc->image()->root()->childCount(), quint32(NUM_LAYERS));
+    }
+}
+
+void KisKraLoadBenchmark::benchmarkLoadManyLayersThreads_data()
+{
+    QTest::addColumn<bool>("useSmallLayers");
+
+    QTest::newRow("big") << false;
+    QTest::newRow("small") << true;
+}
+
+void KisKraLoadBenchmark::benchmarkLoadManyLayersThreads()
+{
+    QFETCH(bool, useSmallLayers);
+
+    const QString fileName = useSmallLayers ? m_smallLayersFileName : m_fileName;
+    const int numLayers = useSmallLayers ? NUM_SMALL_LAYERS : NUM_LAYERS;
+
+    KisImageConfig cfg;
+    const int oldNumThreads = cfg.maxNumberOfThreads();
+
+    for (int numThreads = 1; numThreads <= QThread::idealThreadCount(); numThreads *= 2) {
+        cfg.setMaxNumberOfThreads(numThreads);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        QVERIFY(doc->loadNativeFormat(fileName));
+        QCOMPARE(doc->image()->root()->childCount(), quint32(numLayers));
+
+        qDebug() << "Threads:" << numThreads
+                 << "Time:" << timer.elapsed();
+    }
+
+    cfg.setMaxNumberOfThreads(oldNumThreads);
+}
+
+QTEST_MAIN(KisKraLoadBenchmark)
@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISKRALOADBENCHMARK_H
+#define KISKRALOADBENCHMARK_H
+
+#include <QtTest>
+
+/**
+ * Measures the time needed for opening synthetic documents with many
+ * layers. The documents are generated and saved on start.
+ */
+class KisKraLoadBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkLoadManyLayers();
+
+    /**
+     * Loads the documents with the layer decoding pool limited to
+     * 1, 2, 4... threads. The small layers are too small for the
+     * tiles of one layer to be decoded in parallel, so only the
+     * concurrent decoding of the layers makes them faster.
+     */
+    void benchmarkLoadManyLayersThreads_data();
+    void benchmarkLoadManyLayersThreads();
+
+private:
+    QString m_fileName;
+    QString m_smallLayersFileName;
+};
+
+#endif // KISKRALOADBENCHMARK_H
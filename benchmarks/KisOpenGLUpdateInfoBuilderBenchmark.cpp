@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisOpenGLUpdateInfoBuilderBenchmark.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
+
+namespace {
+
+/**
+ * Fills the device with noise, so that the 1-pixel cache of the color
+ * conversion doesn't make the conversion artificially cheap
+ */
+void fillWithNoise(KisPaintDeviceSP dev, const QRect &rc)
+{
+    const int stripeHeight = 256;
+    const int pixelSize = dev->pixelSize();
+
+    QVector<quint8> buffer(rc.width() * stripeHeight * pixelSize);
+    quint32 seed = 1;
+
+    for (int y = rc.top(); y <= rc.bottom(); y += stripeHeight) {
+        const QRect stripe(rc.left(), y, rc.width(), qMin(stripeHeight, rc.bottom() - y + 1));
+
+        for (int i = 0; i < buffer.size(); i++) {
+            seed = seed * 1664525 + 1013904223;
+            buffer[i] = quint8(seed >> 24);
+        }
+
+        dev->writeBytes(buffer.constData(), stripe);
+    }
+}
+
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkFullCanvasUpdate_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+    QTest::addColumn<bool>("softProofing");
+
+    QTest::newRow("8-bit") << Integer8BitsColorDepthID.id() << false;
+    QTest::newRow("16-bit") << Integer16BitsColorDepthID.id() << false;
+    QTest::newRow("8-bit, soft proofing") << Integer8BitsColorDepthID.id() << true;
+    QTest::newRow("16-bit, soft proofing") << Integer16BitsColorDepthID.id() << true;
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkFullCanvasUpdate()
+{
+    QFETCH(QString, colorDepthId);
+    QFETCH(bool, softProofing);
+
+    /**
+     * A full update of a 4K-sized canvas, with the texture
+     * settings used by default by the openGL canvas
+     */
+    const QRect imageRect(0, 0, 3840, 2160);
+    const int textureSize = 256;
+    const int textureBorder = 4;
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+    const KoColorSpace *dstCS = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "opengl update image");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+    image->addNode(layer, image->root());
+
+    fillWithNoise(layer->paintDevice(), imageRect);
+    image->refreshGraph();
+    image->waitForDone();
+
+    QScopedPointer<KoColorConversionTransformation> proofingTransform;
+
+    if (softProofing) {
+        const KoColorSpace *proofingSpace =
+            KoColorSpaceRegistry::instance()->colorSpace(CMYKAColorModelID.id(), Integer8BitsColorDepthID.id(), 0);
+
+        if (!proofingSpace) {
+            QSKIP("CMYK color space is not available");
+        }
+
+        KoColor warningColor(Qt::gray, cs);
+        proofingTransform.reset(
+            cs->createProofingTransform(dstCS, proofingSpace,
+                                        KoColorConversionTransformation::IntentPerceptual,
+                                        KoColorConversionTransformation::IntentAbsoluteColorimetric,
+                                        KoColorConversionTransformation::SoftProofing,
+                                        warningColor.data(), 1.0));
+        QVERIFY(proofingTransform);
+    }
+
+    KisOpenGLUpdateInfoBuilder builder;
+    builder.setConversionOptions(ConversionOptions(dstCS,
+                                                   KoColorConversionTransformation::internalRenderingIntent(),
+                                                   KoColorConversionTransformation::internalConversionFlags()));
+    builder.setTextureBorder(textureBorder);
+    builder.setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder, textureSize - 2 * textureBorder));
+    builder.setTextureInfoPool(toQShared(new KisTextureTileInfoPool(textureSize, textureSize)));
+
+    if (proofingTransform) {
+        builder.setProofingTransform(proofingTransform.data(), KoColorConversionTransformation::SoftProofing);
+    }
+
+    QBENCHMARK {
+        KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(imageRect, image);
+        QVERIFY(!info->tileList.isEmpty());
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkDownsampledUpdate_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+    QTest::addColumn<int>("levelOfDetail");
+
+    for (int lod = 0; lod <= 3; lod++) {
+        QTest::newRow(QString("8-bit, lod %1").arg(lod).toLatin1()) << Integer8BitsColorDepthID.id() << lod;
+    }
+
+    for (int lod = 0; lod <= 3; lod++) {
+        QTest::newRow(QString("16-bit, lod %1").arg(lod).toLatin1()) << Integer16BitsColorDepthID.id() << lod;
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkDownsampledUpdate()
+{
+    QFETCH(QString, colorDepthId);
+    QFETCH(int, levelOfDetail);
+
+    /**
+     * A full update of a huge canvas zoomed out: the tiles are
+     * downsampled before the conversion to the display color space
+     */
+    const QRect imageRect(0, 0, 8000, 6000);
+    const int textureSize = 256;
+    const int textureBorder = 4;
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+    const KoColorSpace *dstCS = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "opengl downsampling image");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+    image->addNode(layer, image->root());
+
+    fillWithNoise(layer->paintDevice(), imageRect);
+    image->refreshGraph();
+    image->waitForDone();
+
+    KisOpenGLUpdateInfoBuilder builder;
+    builder.setConversionOptions(ConversionOptions(dstCS,
+                                                   KoColorConversionTransformation::internalRenderingIntent(),
+                                                   KoColorConversionTransformation::internalConversionFlags()));
+    builder.setTextureBorder(textureBorder);
+    builder.setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder, textureSize - 2 * textureBorder));
+    builder.setTextureInfoPool(toQShared(new KisTextureTileInfoPool(textureSize, textureSize)));
+    builder.setDownsamplingLevelOfDetail(levelOfDetail);
+
+    qint64 patchBytes = 0;
+
+    QBENCHMARK {
+        KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(imageRect, image);
+
+        patchBytes = 0;
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+            patchBytes += tileInfo->realPatchSize().width() * tileInfo->realPatchSize().height() * tileInfo->pixelSize();
+        }
+    }
+
+    qDebug() << "converted and uploaded bytes:" << patchBytes;
+}
+
+QTEST_MAIN(KisOpenGLUpdateInfoBuilderBenchmark)
@@ -36,6 +36,8 @@
 
 #include "kis_selection.h"
 #include <kis_iterator_ng.h>
+#include <kis_gaussian_kernel.h>
+#include <kis_iir_gaussian_blur.h>
 
 void KisBlurBenchmark::initTestCase()
 {
@@ -87,6 +89,46 @@ void KisBlurBenchmark::benchmarkFilter()
     }
 }
 
+void KisBlurBenchmark::benchmarkGaussianKernel_data()
+{
+    QTest::addColumn<qreal>("radius");
+
+    QTest::newRow("10") << 10.0;
+    QTest::newRow("20") << 20.0;
+    QTest::newRow("50") << 50.0;
+    QTest::newRow("100") << 100.0;
+    QTest::newRow("200") << 200.0;
+}
+
+void KisBlurBenchmark::benchmarkGaussianKernel()
+{
+    QFETCH(qreal, radius);
+
+    const QRect rect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+    const QBitArray channelFlags(m_colorSpace->channelCount(), true);
+
+    QBENCHMARK_ONCE {
+        KisPaintDeviceSP device = new KisPaintDevice(*m_device);
+        KisGaussianKernel::applyGaussian(device, rect, radius, radius, channelFlags, 0);
+    }
+}
 
+void KisBlurBenchmark::benchmarkGaussianIIR_data()
+{
+    benchmarkGaussianKernel_data();
+}
+
+void KisBlurBenchmark::benchmarkGaussianIIR()
+{
+    QFETCH(qreal, radius);
+
+    const QRect rect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+    const QBitArray channelFlags(m_colorSpace->channelCount(), true);
+
+    QBENCHMARK_ONCE {
+        KisPaintDeviceSP device = new KisPaintDevice(*m_device);
+        KisIIRGaussianBlur::applyGaussian(device, rect, radius, radius, channelFlags, 0);
+    }
+}
 
 QTEST_MAIN(KisBlurBenchmark)
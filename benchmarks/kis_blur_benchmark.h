@@ -39,6 +39,12 @@ private Q_SLOTS:
     void cleanupTestCase();
     
     void benchmarkFilter();
+
+    void benchmarkGaussianKernel_data();
+    void benchmarkGaussianKernel();
+
+    void benchmarkGaussianIIR_data();
+    void benchmarkGaussianIIR();
     
 };
 
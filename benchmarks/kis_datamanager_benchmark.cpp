@@ -20,6 +20,7 @@
 #include "kis_benchmark_values.h"
 
 #include <QTest>
+#include <QThreadPool>
 #include <kis_datamanager.h>
 
 // RGBA
@@ -198,5 +199,82 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+/**
+ * Size of a big document in tiles (20000x15000 px)
+ */
+#define LOOKUP_TILES_COLS 313
+#define LOOKUP_TILES_ROWS 235
+#define LOOKUP_CYCLES 4
+
+class KisTileLookupJob : public QRunnable
+{
+public:
+    KisTileLookupJob(KisDataManager &dm, qint32 seed)
+        : m_dm(dm), m_seed(seed)
+    {
+    }
+
+    void run() override {
+        /**
+         * Walk through the tiles in a pseudo-random order, so that
+         * the threads do not follow each other
+         */
+        quint32 index = m_seed;
+        const quint32 numTiles = LOOKUP_TILES_COLS * LOOKUP_TILES_ROWS;
+
+        for (int i = 0; i < LOOKUP_CYCLES; i++) {
+            for (quint32 j = 0; j < numTiles; j++) {
+                index = (index + 7919) % numTiles;
+
+                const bool writable = !(j & 0x3);
+                KisTileSP tile = m_dm.getTile(index % LOOKUP_TILES_COLS,
+                                              index / LOOKUP_TILES_COLS,
+                                              writable);
+                Q_UNUSED(tile);
+            }
+        }
+    }
+
+private:
+    KisDataManager &m_dm;
+    qint32 m_seed;
+};
+
+void KisDatamanagerBenchmark::benchmarkConcurrentTileLookup_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    for (int i = 1; i <= 2 * QThread::idealThreadCount(); i *= 2) {
+        QTest::newRow(QString("%1 threads").arg(i).toLatin1()) << i;
+    }
+}
+
+void KisDatamanagerBenchmark::benchmarkConcurrentTileLookup()
+{
+    QFETCH(int, numThreads);
+
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    // only half of the tiles exist, the rest is created lazily
+    for (int row = 0; row < LOOKUP_TILES_ROWS; row++) {
+        for (int col = 0; col < LOOKUP_TILES_COLS; col += 2) {
+            dm.getTile(col, row, true);
+        }
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < numThreads; i++) {
+            pool.start(new KisTileLookupJob(dm, i * 1031));
+        }
+        pool.waitForDone();
+    }
+
+    delete[] p;
+}
 
 QTEST_MAIN(KisDatamanagerBenchmark)
@@ -36,6 +36,8 @@ private Q_SLOTS:
     void benchmarkExtent();
     void benchmarkClear();
     void benchmarkMemCpy();
+    void benchmarkConcurrentTileLookup_data();
+    void benchmarkConcurrentTileLookup();
 };
 
 #endif
@@ -37,6 +37,11 @@
 
 #include "kis_circle_mask_generator.h"
 #include "kis_rect_mask_generator.h"
+#include "kis_gauss_circle_mask_generator.h"
+#include "kis_gauss_rect_mask_generator.h"
+#include "kis_curve_circle_mask_generator.h"
+#include "kis_curve_rect_mask_generator.h"
+#include "kis_cubic_curve.h"
 
 void KisMaskGeneratorBenchmark::benchmarkCircle()
 {
@@ -60,19 +65,17 @@ void KisMaskGeneratorBenchmark::benchmarkCircle()
 #include "krita_utils.h"
 
 
-void benchmarkSIMD(qreal fade) {
+void benchmarkSIMD(KisMaskGenerator *gen, int size) {
     const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
     KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
-    dev->setRect(QRect(0, 0, 1000, 1000));
+    dev->setRect(QRect(0, 0, size, size));
     dev->initialize();
 
     MaskProcessingData data(dev, cs,
                             0.0, 1.0,
-                            500, 500, 0);
-
-    KisCircleMaskGenerator gen(1000, 1.0, fade, fade, 2, false);
+                            0.5 * size, 0.5 * size, 0);
 
-    KisBrushMaskApplicatorBase *applicator = gen.applicator();
+    KisBrushMaskApplicatorBase *applicator = gen->applicator();
     applicator->initializeData(&data);
 
     QVector<QRect> rects = KritaUtils::splitRectIntoPatches(dev->bounds(), QSize(63, 63));
@@ -84,6 +87,11 @@ void benchmarkSIMD(qreal fade) {
     }
 }
 
+void benchmarkSIMD(qreal fade) {
+    KisCircleMaskGenerator gen(1000, 1.0, fade, fade, 2, false);
+    benchmarkSIMD(&gen, 1000);
+}
+
 void KisMaskGeneratorBenchmark::benchmarkSIMD_SharpBrush()
 {
     benchmarkSIMD(1.0);
@@ -94,6 +102,74 @@ void KisMaskGeneratorBenchmark::benchmarkSIMD_FadedBrush()
     benchmarkSIMD(0.5);
 }
 
+enum GeneratorType {
+    Circle,
+    Rectangle,
+    GaussCircle,
+    GaussRectangle,
+    CurveCircle,
+    CurveRectangle
+};
+
+Q_DECLARE_METATYPE(GeneratorType)
+
+KisMaskGenerator* createGenerator(GeneratorType type, int size, qreal fade)
+{
+    switch (type) {
+    case Circle:
+        return new KisCircleMaskGenerator(size, 1.0, fade, fade, 2, true);
+    case Rectangle:
+        return new KisRectangleMaskGenerator(size, 1.0, fade, fade, 2, true);
+    case GaussCircle:
+        return new KisGaussCircleMaskGenerator(size, 1.0, fade, fade, 2, true);
+    case GaussRectangle:
+        return new KisGaussRectangleMaskGenerator(size, 1.0, fade, fade, 2, true);
+    case CurveCircle:
+        return new KisCurveCircleMaskGenerator(size, 1.0, fade, fade, 2, KisCubicCurve(), true);
+    case CurveRectangle:
+        return new KisCurveRectangleMaskGenerator(size, 1.0, fade, fade, 2, KisCubicCurve(), true);
+    }
+
+    return 0;
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_AllGenerators_data()
+{
+    QTest::addColumn<GeneratorType>("type");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<qreal>("fade");
+
+    const QList<QPair<GeneratorType, QString>> generators = {
+        qMakePair(Circle, QString("circle")),
+        qMakePair(Rectangle, QString("rect")),
+        qMakePair(GaussCircle, QString("gauss-circle")),
+        qMakePair(GaussRectangle, QString("gauss-rect")),
+        qMakePair(CurveCircle, QString("curve-circle")),
+        qMakePair(CurveRectangle, QString("curve-rect"))
+    };
+
+    const QList<int> sizes = {10, 50, 100, 300, 1000};
+
+    for (auto it = generators.begin(); it != generators.end(); ++it) {
+        Q_FOREACH (int size, sizes) {
+            QTest::newRow(qPrintable(QString("%1-%2-sharp").arg(it->second).arg(size)))
+                << it->first << size << 1.0;
+            QTest::newRow(qPrintable(QString("%1-%2-faded").arg(it->second).arg(size)))
+                << it->first << size << 0.5;
+        }
+    }
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_AllGenerators()
+{
+    QFETCH(GeneratorType, type);
+    QFETCH(int, size);
+    QFETCH(qreal, fade);
+
+    QScopedPointer<KisMaskGenerator> gen(createGenerator(type, size, fade));
+    benchmarkSIMD(gen.data(), size);
+}
+
 void KisMaskGeneratorBenchmark::benchmarkSquare()
 {
     KisRectangleMaskGenerator gen(1000, 0.5, 0.5, 0.5, 3, true);
@@ -28,6 +28,8 @@ private Q_SLOTS:
     void benchmarkCircle();
     void benchmarkSIMD_SharpBrush();
     void benchmarkSIMD_FadedBrush();
+    void benchmarkSIMD_AllGenerators_data();
+    void benchmarkSIMD_AllGenerators();
     void benchmarkSquare();
 
 };
@@ -16,13 +16,20 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include <QTest>
+#include <QElapsedTimer>
+#include <QThread>
 
 #include "kis_projection_benchmark.h"
 #include "kis_benchmark_values.h"
 
 #include <KoColor.h>
 
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include <KoCompositeOpRegistry.h>
+
 #include <kis_group_layer.h>
+#include <kis_paint_layer.h>
 #include <kis_paint_device.h>
 #include <KisDocument.h>
 #include <kis_image.h>
@@ -58,5 +65,111 @@ void KisProjectionBenchmark::benchmarkLoading()
     }
 }
 
+void KisProjectionBenchmark::benchmarkUpdatesThroughput_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        QTest::newRow(QString("%1 threads").arg(numThreads).toLatin1()) << numThreads;
+    }
+
+    if (maxThreads & (maxThreads - 1)) {
+        QTest::newRow(QString("%1 threads").arg(maxThreads).toLatin1()) << maxThreads;
+    }
+}
+
+void KisProjectionBenchmark::benchmarkUpdatesThroughput()
+{
+    QFETCH(int, numThreads);
+
+    /**
+     * Many small updates of a few layers stress the scheduling part
+     * of the update system rather than the merging itself
+     */
+    const int imageSize = 4096;
+    const int patchSize = 64;
+    const int numLayers = 3;
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "updates throughput");
+
+    KisPaintLayerSP layer;
+
+    for (int i = 0; i < numLayers; i++) {
+        layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8 / (i + 1));
+
+        KoColor color(QColor(50 * i, 100, 200 - 50 * i), cs);
+        layer->paintDevice()->fill(0, 0, imageSize, imageSize, color.data());
+
+        image->addNode(layer, image->root());
+    }
+
+    image->setWorkingThreadsLimit(numThreads);
+    image->refreshGraph();
+    image->waitForDone();
+
+    int numUpdates = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        for (int y = 0; y < imageSize; y += patchSize) {
+            for (int x = 0; x < imageSize; x += patchSize) {
+                layer->setDirty(QRect(x, y, patchSize, patchSize));
+                numUpdates++;
+            }
+        }
+
+        image->waitForDone();
+    }
+
+    qDebug() << "Threads:" << numThreads
+             << "updates/sec:" << qreal(numUpdates) / timer.elapsed() * 1000.0;
+}
+
+void KisProjectionBenchmark::benchmarkColorDepth_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+
+    QTest::newRow("8-bit") << Integer8BitsColorDepthID.id();
+    QTest::newRow("16-bit") << Integer16BitsColorDepthID.id();
+}
+
+void KisProjectionBenchmark::benchmarkColorDepth()
+{
+    QFETCH(QString, colorDepthId);
+
+    /**
+     * Full refresh of a stack of semi-transparent layers with
+     * the most common blending modes
+     */
+    const int imageSize = 4096;
+    const QStringList compositeOps({COMPOSITE_OVER, COMPOSITE_MULT, COMPOSITE_SCREEN,
+                                    COMPOSITE_OVERLAY, COMPOSITE_ALPHA_DARKEN});
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "color depth projection");
+
+    for (int i = 0; i < compositeOps.size(); i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->setCompositeOpId(compositeOps[i]);
+
+        KoColor color(QColor(40 * i, 100, 200 - 40 * i, 160), cs);
+        layer->paintDevice()->fill(0, 0, imageSize, imageSize, color.data());
+
+        image->addNode(layer, image->root());
+    }
+
+    image->refreshGraph();
+    image->waitForDone();
+
+    QBENCHMARK {
+        image->refreshGraph();
+        image->waitForDone();
+    }
+}
 
 QTEST_MAIN(KisProjectionBenchmark)
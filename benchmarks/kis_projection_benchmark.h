@@ -32,6 +32,12 @@ private Q_SLOTS:
 
     void benchmarkProjection();
     void benchmarkLoading();
+
+    void benchmarkUpdatesThroughput_data();
+    void benchmarkUpdatesThroughput();
+
+    void benchmarkColorDepth_data();
+    void benchmarkColorDepth();
 };
 
 #endif
@@ -27,6 +27,8 @@ inline double drand48()
 #endif
 
 #include <QTest>
+#include <QThreadPool>
+#include <QElapsedTimer>
 
 #include "kis_stroke_benchmark.h"
 #include "kis_benchmark_values.h"
@@ -35,6 +37,7 @@ inline double drand48()
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
 #include <KoColor.h>
 
 #include <kis_image.h>
@@ -145,6 +148,103 @@ void KisStrokeBenchmark::pixelbrush300pxRL()
 }
 
 
+void KisStrokeBenchmark::pixelbrushLargeDabs_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("threads");
+
+    const QList<int> sizes = {100, 300, 500, 1000, 2000};
+    const QList<int> threadCounts = {1, 2, 4, QThread::idealThreadCount()};
+
+    Q_FOREACH (int size, sizes) {
+        Q_FOREACH (int threads, threadCounts) {
+            QTest::newRow(qPrintable(QString("%1px-%2threads").arg(size).arg(threads)))
+                << size << threads;
+        }
+    }
+}
+
+void KisStrokeBenchmark::pixelbrushLargeDabs()
+{
+    QFETCH(int, size);
+    QFETCH(int, threads);
+
+    const int numDabs = 20;
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + "autobrush_300px.kpp");
+    bool loadedOk = preset->load();
+    KIS_ASSERT_RECOVER_RETURN(loadedOk);
+    KIS_ASSERT_RECOVER_RETURN(preset->settings());
+
+    preset->settings()->setPaintOpSize(size);
+    m_painter->setPaintOpPreset(preset, m_layer, m_image);
+
+    const int oldMaxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QElapsedTimer timer;
+    qint64 totalTime = 0;
+    int totalDabs = 0;
+
+    QBENCHMARK {
+        timer.start();
+
+        KisDistanceInformation currentDistance;
+        for (int i = 0; i < numDabs; i++) {
+            const QPointF pos((i + 1) * m_image->width() / qreal(numDabs + 1),
+                              0.5 * m_image->height());
+            m_painter->paintAt(KisPaintInformation(pos, 1.0), &currentDistance);
+        }
+
+        totalTime += timer.nsecsElapsed();
+        totalDabs += numDabs;
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(oldMaxThreadCount);
+
+    qDebug() << "size:" << size << "threads:" << threads
+             << "dabs/sec:" << qreal(totalDabs) * 1e9 / totalTime;
+}
+
+void KisStrokeBenchmark::pixelbrushColorDepth_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+
+    QTest::newRow("8-bit") << Integer8BitsColorDepthID.id();
+    QTest::newRow("16-bit") << Integer16BitsColorDepthID.id();
+}
+
+void KisStrokeBenchmark::pixelbrushColorDepth()
+{
+    QFETCH(QString, colorDepthId);
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+
+    KisImageSP image = new KisImage(0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, cs, "color depth stroke");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "stroke layer", OPACITY_OPAQUE_U8, cs);
+
+    KoColor white(Qt::white, cs);
+    layer->paintDevice()->fill(0, 0, image->width(), image->height(), white.data());
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + "autobrush_300px.kpp");
+    bool loadedOk = preset->load();
+    KIS_ASSERT_RECOVER_RETURN(loadedOk);
+
+    KisPainter painter(layer->paintDevice());
+    painter.setPaintColor(KoColor(Qt::black, cs));
+    painter.setPaintOpPreset(preset, layer, image);
+
+    QBENCHMARK{
+        KisDistanceInformation currentDistance;
+        for (int i = 0; i < LINES; i++){
+            KisPaintInformation pi1(m_startPoints[i], 0.0);
+            KisPaintInformation pi2(m_endPoints[i], 1.0);
+            painter.paintLine(pi1, pi2, &currentDistance);
+        }
+    }
+}
+
 void KisStrokeBenchmark::sprayPixels()
 {
     QString presetFileName = "spray_wu_pixels1.kpp";
@@ -73,6 +73,13 @@ private Q_SLOTS:
     void pixelbrush300px();
     void pixelbrush300pxRL();
 
+    // Large dabs with different sizes of the thread pool
+    void pixelbrushLargeDabs_data();
+    void pixelbrushLargeDabs();
+
+    void pixelbrushColorDepth_data();
+    void pixelbrushColorDepth();
+
     // Soft brush benchmarks
     void softbrushDefault30();
     void softbrushDefault30RL();
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_compression_benchmark.h"
+
+#include <QTest>
+
+#include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/swap/kis_abstract_compression.h"
+#include "tiles3/swap/kis_tile_compressor_2.h"
+#include "kis_paint_device_writer.h"
+
+#define NUM_TILES_X 32
+#define NUM_TILES_Y 32
+
+
+class KisNullPaintDeviceWriter : public KisPaintDeviceWriter {
+public:
+    bool write(const QByteArray &data) override {
+        m_bytesWritten += data.size();
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_bytesWritten += length;
+        return true;
+    }
+
+    qint64 bytesWritten() const {
+        return m_bytesWritten;
+    }
+
+private:
+    qint64 m_bytesWritten = 0;
+};
+
+/**
+ * Fills the data manager with a smooth gradient with a bit of noise,
+ * which is closer to the real paintings than a uniform fill
+ */
+void fillDataManager(KisTiledDataManager &dm, int pixelSize)
+{
+    const int width = NUM_TILES_X * KisTileData::WIDTH;
+    const int height = NUM_TILES_Y * KisTileData::HEIGHT;
+
+    QVector<quint8> row(width * pixelSize);
+    qsrand(1);
+
+    for (int y = 0; y < height; y++) {
+        quint8 *ptr = row.data();
+        for (int x = 0; x < width; x++) {
+            for (int i = 0; i < pixelSize; i++) {
+                *ptr++ = quint8(x + y + i * 16 + (qrand() & 0x3));
+            }
+        }
+        dm.writeBytes(row.data(), 0, y, width, 1);
+    }
+}
+
+void addCompressionRows()
+{
+    QTest::addColumn<QString>("compression");
+    QTest::addColumn<int>("pixelSize");
+
+    Q_FOREACH (const QString &name, KisAbstractCompression::availableCompressions()) {
+        Q_FOREACH (int pixelSize, QVector<int>({4, 8, 16})) {
+            QTest::newRow(QString("%1-%2").arg(name).arg(pixelSize).toLatin1())
+                << name << pixelSize;
+        }
+    }
+}
+
+void KisTileCompressionBenchmark::benchmarkSwapOut_data()
+{
+    addCompressionRows();
+}
+
+void KisTileCompressionBenchmark::benchmarkSwapOut()
+{
+    QFETCH(QString, compression);
+    QFETCH(int, pixelSize);
+
+    QVector<quint8> defaultPixel(pixelSize, 0);
+    KisTiledDataManager dm(pixelSize, defaultPixel.data());
+    fillDataManager(dm, pixelSize);
+
+    KisTileCompressor2 compressor(compression);
+    KisTileSP tile = dm.getTile(0, 0, false);
+    KisTileData *td = tile->tileData();
+
+    const qint32 bufferSize = compressor.tileDataBufferSize(td);
+    QVector<quint8> buffer(bufferSize);
+    qint32 bytesWritten = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < NUM_TILES_X * NUM_TILES_Y; i++) {
+            compressor.compressTileData(td, buffer.data(), bufferSize, bytesWritten);
+        }
+    }
+
+    qDebug() << compression << "ratio:" << qreal(bytesWritten) / td->pixelSize() / KisTileData::WIDTH / KisTileData::HEIGHT;
+}
+
+void KisTileCompressionBenchmark::benchmarkSwapIn_data()
+{
+    addCompressionRows();
+}
+
+void KisTileCompressionBenchmark::benchmarkSwapIn()
+{
+    QFETCH(QString, compression);
+    QFETCH(int, pixelSize);
+
+    QVector<quint8> defaultPixel(pixelSize, 0);
+    KisTiledDataManager dm(pixelSize, defaultPixel.data());
+    fillDataManager(dm, pixelSize);
+
+    KisTileCompressor2 compressor(compression);
+    KisTileSP tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    KisTileData *td = tile->tileData();
+
+    const qint32 bufferSize = compressor.tileDataBufferSize(td);
+    QVector<quint8> buffer(bufferSize);
+    qint32 bytesWritten = 0;
+    compressor.compressTileData(td, buffer.data(), bufferSize, bytesWritten);
+
+    QBENCHMARK {
+        for (int i = 0; i < NUM_TILES_X * NUM_TILES_Y; i++) {
+            compressor.decompressTileData(buffer.data(), bytesWritten, td);
+        }
+    }
+
+    tile->unlock();
+}
+
+void KisTileCompressionBenchmark::benchmarkSaveTiles_data()
+{
+    addCompressionRows();
+}
+
+void KisTileCompressionBenchmark::benchmarkSaveTiles()
+{
+    QFETCH(QString, compression);
+    QFETCH(int, pixelSize);
+
+    QVector<quint8> defaultPixel(pixelSize, 0);
+    KisTiledDataManager dm(pixelSize, defaultPixel.data());
+    fillDataManager(dm, pixelSize);
+
+    KisTileCompressor2 compressor(compression);
+    KisNullPaintDeviceWriter writer;
+
+    QBENCHMARK {
+        for (int row = 0; row < NUM_TILES_Y; row++) {
+            for (int col = 0; col < NUM_TILES_X; col++) {
+                KisTileSP tile = dm.getTile(col, row, false);
+                compressor.writeTile(tile, writer);
+            }
+        }
+    }
+}
+
+QTEST_MAIN(KisTileCompressionBenchmark)
@@ -4,6 +4,8 @@
 #  FFTW3_FOUND - system has fftw3
 #  FFTW3_INCLUDE_DIRS - the fftw3 include directories
 #  FFTW3_LIBRARIES - the libraries needed to use fftw3
+#  FFTW3F_FOUND - the single precision fftw3f library is found too
+#                 (its path is appended to FFTW3_LIBRARIES)
 # Redistribution and use is allowed according to the terms of the BSD license.
 # For details see the accompanying COPYING-CMAKE-SCRIPTS file.
 #
@@ -30,6 +32,11 @@ if(FFTW3_FOUND)
     message(STATUS "FFTW Found Version: " ${FFTW_VERSION})
 endif()
 
+find_library(FFTW3F_LIBRARY
+    NAMES fftw3f
+    HINTS ${FFTW3_PKGCONF_LIBRARY_DIRS} ${FFTW3_PKGCONF_LIBDIR}
+)
+
 else()
 
 find_path(FFTW3_INCLUDE_DIR
@@ -42,6 +49,11 @@ find_library(
     NAMES libfftw3-3 libfftw3f-3 libfftw3l-3
     DOC "Libraries to link against for FFT Support")
 
+find_library(
+    FFTW3F_LIBRARY
+    NAMES libfftw3f-3
+    DOC "Single precision library to link against for FFT Support")
+
 if (FFTW3_LIBRARY)
     set(FFTW3_LIBRARY_DIR ${FFTW3_LIBRARY})
 endif()
@@ -55,3 +67,9 @@ else()
   message(STATUS "Could not find FFTW3")
 endif()
 endif()
+
+if(FFTW3_FOUND AND FFTW3F_LIBRARY AND NOT FFTW3F_LIBRARY STREQUAL FFTW3_LIBRARY)
+    set(FFTW3F_FOUND TRUE)
+    set(FFTW3_LIBRARIES ${FFTW3_LIBRARIES} ${FFTW3F_LIBRARY})
+    message(STATUS "Found single precision FFTW3: " ${FFTW3F_LIBRARY})
+endif()
@@ -21,6 +21,8 @@
 
 #include "kis_global.h"
 
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
 template <class BaseFade>
 class KisAntialiasingFadeMaker1D
 {
@@ -83,6 +85,30 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). The \p value should contain
+     * the values of the base fade normalized into [0, 1] range. The
+     * values of the pixels lying in the antialiasing area or outside
+     * the mask are overwritten.
+     */
+    inline void applyFade(const Vc::float_v &dist, Vc::float_v &value) const {
+        const Vc::float_v vOne(Vc::One);
+        const Vc::float_m outsideMask = dist > Vc::float_v(m_radius);
+
+        if (m_enableAntialiasing) {
+            const Vc::float_v vFadeStart(m_antialiasingFadeStart);
+            const Vc::float_m fadeMask = dist > vFadeStart;
+
+            value(fadeMask) =
+                (Vc::float_v(float(m_fadeStartValue)) +
+                 (dist - vFadeStart) * Vc::float_v(m_antialiasingFadeCoeff)) / Vc::float_v(255.0f);
+        }
+
+        value(outsideMask) = vOne;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_radius;
     quint8 m_fadeStartValue;
@@ -174,6 +200,37 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). The \p value should contain
+     * the values of the base fade normalized into [0, 1] range. The
+     * values of the pixels lying in the antialiasing area or outside
+     * the mask are overwritten.
+     */
+    inline void applyFade(Vc::float_v xr, Vc::float_v yr, Vc::float_v &value) const {
+        const Vc::float_v vOne(Vc::One);
+
+        xr = Vc::abs(xr);
+        yr = Vc::abs(yr);
+
+        const Vc::float_m outsideMask =
+            (xr > Vc::float_v(m_xLimit)) || (yr > Vc::float_v(m_yLimit));
+
+        if (m_enableAntialiasing) {
+            const Vc::float_v vXFadeLimitStart(m_xFadeLimitStart);
+            const Vc::float_v vYFadeLimitStart(m_yFadeLimitStart);
+
+            const Vc::float_m xFadeMask = xr > vXFadeLimitStart;
+            value(xFadeMask) = value + (vOne - value) * (xr - vXFadeLimitStart) * Vc::float_v(m_xFadeCoeff);
+
+            const Vc::float_m yFadeMask = yr > vYFadeLimitStart;
+            value(yFadeMask) = value + (vOne - value) * (yr - vYFadeLimitStart) * Vc::float_v(m_yFadeCoeff);
+        }
+
+        value(outsideMask) = vOne;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_xLimit;
     qreal m_yLimit;
@@ -16,6 +16,7 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <compositeops/KoVcMultiArchBuildSupport.h> //MSVC requires that Vc come first
 #include "kis_convolution_painter.h"
 
 #include <stdlib.h>
@@ -50,6 +51,7 @@
 
 #include "kis_convolution_worker.h"
 #include "kis_convolution_worker_spatial.h"
+#include "kis_convolution_worker_planar.h"
 
 #include "config_convolution.h"
 
@@ -60,29 +62,37 @@
 
 template<class factory>
 KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConvolutionKernelSP kernel,
+                                                                   const KoColorSpace *colorSpace,
                                                                    KisPainter *painter,
                                                                    KoUpdater *progress)
 {
-    KisConvolutionWorker<factory> *worker;
+    KisConvolutionWorker<factory> *worker = 0;
 
 #ifdef HAVE_FFTW3
     #define THRESHOLD_SIZE 5
 
-    if(m_enginePreference == SPATIAL ||
-       (m_enginePreference != FFTW &&
-        kernel->width() <= THRESHOLD_SIZE &&
-        kernel->height() <= THRESHOLD_SIZE)) {
+    if(m_enginePreference == FFTW ||
+       (m_enginePreference == NONE &&
+        (kernel->width() > THRESHOLD_SIZE ||
+         kernel->height() > THRESHOLD_SIZE))) {
 
-        worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
-    }
-    else {
         worker = new KisConvolutionWorkerFFT<factory>(painter, progress);
     }
 #else
     Q_UNUSED(kernel);
-    worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
 #endif
 
+    if (!worker) {
+        if (m_enginePreference == PLANAR ||
+            (m_enginePreference != SPATIAL &&
+             KisConvolutionWorkerPlanar<factory>::isApplicable(colorSpace))) {
+
+            worker = new KisConvolutionWorkerPlanar<factory>(painter, progress);
+        } else {
+            worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
+        }
+    }
+
     return worker;
 }
 
@@ -141,7 +151,7 @@ void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, con
 
         if(dataRect.isValid()) {
             KisConvolutionWorker<RepeatIteratorFactory> *worker;
-            worker = createWorker<RepeatIteratorFactory>(kernel, this, progressUpdater());
+            worker = createWorker<RepeatIteratorFactory>(kernel, src->colorSpace(), this, progressUpdater());
             worker->execute(kernel, src, srcPos, dstPos, areaSize, dataRect);
             delete worker;
         }
@@ -150,7 +160,7 @@ void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, con
     case BORDER_IGNORE:
     default: {
         KisConvolutionWorker<StandardIteratorFactory> *worker;
-        worker = createWorker<StandardIteratorFactory>(kernel, this, progressUpdater());
+        worker = createWorker<StandardIteratorFactory>(kernel, src->colorSpace(), this, progressUpdater());
         worker->execute(kernel, src, srcPos, dstPos, areaSize, QRect());
         delete worker;
     }
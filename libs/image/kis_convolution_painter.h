@@ -72,6 +72,7 @@ protected:
     enum TestingEnginePreference {
         NONE,
         SPATIAL,
+        PLANAR,
         FFTW
     };
 
@@ -82,6 +83,7 @@ protected:
 private:
     template<class factory>
         KisConvolutionWorker<factory>* createWorker(const KisConvolutionKernelSP kernel,
+                                                    const KoColorSpace *colorSpace,
                                                     KisPainter *painter,
                                                     KoUpdater *progress);
 
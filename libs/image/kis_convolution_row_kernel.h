@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_CONVOLUTION_ROW_KERNEL_H
+#define __KIS_CONVOLUTION_ROW_KERNEL_H
+
+#include <QtGlobal>
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
+
+/**
+ * Applies a 2D kernel to one row of a single channel stored as a plane of
+ * doubles. The kernel is passed as a list of taps, so sparse kernels like
+ * emboss or edge detection may drop their zero weights.
+ *
+ * Every destination value is accumulated tap by tap in the order of the
+ * list with separate multiplications and additions, so the result doesn't
+ * depend on the instruction set. That is why the file is built with
+ * floating point contraction disabled.
+ *
+ * The implementations are built for every instruction set supported by Vc
+ * and the best one is selected in runtime with createOptimizedClass().
+ */
+class KisConvolutionRowKernel
+{
+public:
+    struct Tap {
+        /**
+         * Index of the source row in the array passed to convolveRow()
+         */
+        int row;
+
+        /**
+         * Horizontal offset of the source pixel from the first pixel
+         * of the source row
+         */
+        int offset;
+
+        qreal weight;
+    };
+
+public:
+    virtual ~KisConvolutionRowKernel() {}
+
+    /**
+     * Calculates dst[i] = sum(tap.weight * rows[tap.row][i + tap.offset])
+     * for all i in [0, width). The source rows should therefore contain at
+     * least width + max(tap.offset) samples.
+     */
+    virtual void convolveRow(const qreal * const *rows,
+                             const Tap *taps, int numTaps,
+                             qreal *dst, int width) const = 0;
+};
+
+struct KisConvolutionRowKernelFactory
+{
+    typedef int ParamType;
+    typedef KisConvolutionRowKernel* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType);
+};
+
+#endif /* __KIS_CONVOLUTION_ROW_KERNEL_H */
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_convolution_row_kernel.h"
+
+#include <algorithm>
+
+
+#if defined(__clang__)
+#pragma GCC diagnostic ignored "-Wlocal-type-template-args"
+#endif
+
+template<Vc::Implementation _impl>
+class KisConvolutionRowKernelImpl : public KisConvolutionRowKernel
+{
+public:
+    void convolveRow(const qreal * const *rows,
+                     const Tap *taps, int numTaps,
+                     qreal *dst, int width) const override
+    {
+        if (!numTaps) {
+            std::fill(dst, dst + width, 0.0);
+            return;
+        }
+
+        int i = 0;
+
+#ifdef HAVE_VC
+        /**
+         * Keep the accumulator in a register for all the taps, so every
+         * vector of the destination is written only once
+         */
+        typedef Vc::Vector<qreal> qreal_v;
+        const int vectorSize = qreal_v::size();
+
+        for (; i + vectorSize <= width; i += vectorSize) {
+            qreal_v acc(Vc::Zero);
+
+            for (int t = 0; t < numTaps; t++) {
+                const Tap &tap = taps[t];
+                const qreal_v src(rows[tap.row] + tap.offset + i, Vc::Unaligned);
+                acc += qreal_v(tap.weight) * src;
+            }
+
+            acc.store(dst + i, Vc::Unaligned);
+        }
+#endif /* HAVE_VC */
+
+        for (; i < width; i++) {
+            qreal acc = 0.0;
+
+            for (int t = 0; t < numTaps; t++) {
+                const Tap &tap = taps[t];
+                acc += tap.weight * rows[tap.row][tap.offset + i];
+            }
+
+            dst[i] = acc;
+        }
+    }
+};
+
+template<>
+KisConvolutionRowKernelFactory::ReturnType
+KisConvolutionRowKernelFactory::create<Vc::CurrentImplementation::current()>(ParamType)
+{
+    return new KisConvolutionRowKernelImpl<Vc::CurrentImplementation::current()>();
+}
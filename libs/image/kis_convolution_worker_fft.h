@@ -28,23 +28,188 @@
 #include "kis_math_toolbox.h"
 
 #include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QPair>
+#include <QList>
+#include <QSharedPointer>
 #include <QVector>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
 
 #include <fftw3.h>
 
+#include "config_convolution.h"
+
 template<class _IteratorFactory_> class KisConvolutionWorkerFFT;
+template<typename T> class KisFFTWPlanCache;
 class KisConvolutionWorkerFFTLock
 {
 private:
     static QMutex fftwMutex;
     template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
+    template<typename T> friend class KisFFTWPlanCache;
 };
 
 QMutex KisConvolutionWorkerFFTLock::fftwMutex;
 
+/**
+ * Maps the precision of the transform to the corresponding FFTW API
+ */
+template<typename T>
+struct KisFFTWTraits;
+
+template<>
+struct KisFFTWTraits<double>
+{
+    typedef fftw_complex complex_type;
+    typedef fftw_plan plan_type;
+
+    static complex_type* allocate(size_t length) {
+        return (complex_type*)fftw_malloc(sizeof(complex_type) * length);
+    }
+    static void release(complex_type *data) {
+        fftw_free(data);
+    }
+    static plan_type planForward(int height, int width, complex_type *data) {
+        return fftw_plan_dft_r2c_2d(height, width, (double*)data, data, FFTW_ESTIMATE);
+    }
+    static plan_type planBackward(int height, int width, complex_type *data) {
+        return fftw_plan_dft_c2r_2d(height, width, data, (double*)data, FFTW_ESTIMATE);
+    }
+    static void executeForward(plan_type plan, complex_type *data) {
+        fftw_execute_dft_r2c(plan, (double*)data, data);
+    }
+    static void executeBackward(plan_type plan, complex_type *data) {
+        fftw_execute_dft_c2r(plan, data, (double*)data);
+    }
+    static void destroyPlan(plan_type plan) {
+        fftw_destroy_plan(plan);
+    }
+};
+
+#ifdef HAVE_FFTW3F
+template<>
+struct KisFFTWTraits<float>
+{
+    typedef fftwf_complex complex_type;
+    typedef fftwf_plan plan_type;
+
+    static complex_type* allocate(size_t length) {
+        return (complex_type*)fftwf_malloc(sizeof(complex_type) * length);
+    }
+    static void release(complex_type *data) {
+        fftwf_free(data);
+    }
+    static plan_type planForward(int height, int width, complex_type *data) {
+        return fftwf_plan_dft_r2c_2d(height, width, (float*)data, data, FFTW_ESTIMATE);
+    }
+    static plan_type planBackward(int height, int width, complex_type *data) {
+        return fftwf_plan_dft_c2r_2d(height, width, data, (float*)data, FFTW_ESTIMATE);
+    }
+    static void executeForward(plan_type plan, complex_type *data) {
+        fftwf_execute_dft_r2c(plan, (float*)data, data);
+    }
+    static void executeBackward(plan_type plan, complex_type *data) {
+        fftwf_execute_dft_c2r(plan, data, (float*)data);
+    }
+    static void destroyPlan(plan_type plan) {
+        fftwf_destroy_plan(plan);
+    }
+};
+#endif /* HAVE_FFTW3F */
+
+/**
+ * Creating a plan is not thread-safe in FFTW, so it is done under
+ * the global lock. Executing a plan on new arrays is thread-safe
+ * though, so the plans are cached by the transform size and shared
+ * between all the workers and channels.
+ *
+ * The plans are in-place and expect the arrays to be allocated with
+ * KisFFTWTraits::allocate(), which guarantees the alignment.
+ */
+template<typename T>
+class KisFFTWPlanCache
+{
+    typedef KisFFTWTraits<T> Traits;
+
+public:
+    struct Plans {
+        Plans(int width, int height) {
+            const size_t length = height * (width / 2 + 1);
+            typename Traits::complex_type *data = Traits::allocate(length);
+
+            // the lock is held by plans()
+            forward = Traits::planForward(height, width, data);
+            backward = Traits::planBackward(height, width, data);
+
+            Traits::release(data);
+        }
+
+        ~Plans() {
+            QMutexLocker l(&KisConvolutionWorkerFFTLock::fftwMutex);
+            Traits::destroyPlan(forward);
+            Traits::destroyPlan(backward);
+        }
+
+        typename Traits::plan_type forward;
+        typename Traits::plan_type backward;
+    };
+
+    typedef QSharedPointer<Plans> PlansSP;
+
+    static PlansSP plans(int width, int height) {
+        Cache *cache = instance();
+
+        PlansSP evictedPlans;
+        PlansSP result;
+
+        {
+            QMutexLocker l(&KisConvolutionWorkerFFTLock::fftwMutex);
+
+            const QPair<int, int> key(width, height);
+            result = cache->plans.value(key);
+
+            if (result) {
+                cache->lruKeys.removeOne(key);
+            } else {
+                result = PlansSP(new Plans(width, height));
+                cache->plans.insert(key, result);
+
+                if (cache->lruKeys.size() >= maxCachedPlans) {
+                    evictedPlans = cache->plans.take(cache->lruKeys.takeFirst());
+                }
+            }
+
+            cache->lruKeys.append(key);
+        }
+
+        // the evicted plans (if not used anymore) take the lock on destruction
+        evictedPlans.clear();
+
+        return result;
+    }
+
+private:
+    static const int maxCachedPlans = 16;
+
+    struct Cache {
+        QHash<QPair<int, int>, PlansSP> plans;
+        QList<QPair<int, int>> lruKeys;
+    };
+
+    static Cache* instance() {
+        /**
+         * The cache is never deleted, because destroying the plans
+         * needs the lock, which might be already gone on exit
+         */
+        static Cache *cache = new Cache();
+        return cache;
+    }
+};
+
 
 template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
@@ -52,8 +217,7 @@ class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 public:
     KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
         : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
-          m_currentProgress(0),
-          m_kernelFFT(0)
+          m_currentProgress(0)
     {
     }
 
@@ -95,17 +259,106 @@ public:
         m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
         m_extraMem = (m_fftWidth % 2) ? 1 : 2;
 
-        // create and fill kernel
-        m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
-        fftFillKernelMatrix(kernel, m_kernelFFT);
-
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+#ifdef HAVE_FFTW3F
+        if (isSinglePrecisionEnough(convChannelList)) {
+            executeImpl<float>(kernel, src, srcPos, dstPos, areaSize, dataRect,
+                               convChannelList, halfKernelWidth, halfKernelHeight);
+            return;
+        }
+#endif
+
+        executeImpl<double>(kernel, src, srcPos, dstPos, areaSize, dataRect,
+                            convChannelList, halfKernelWidth, halfKernelHeight);
+    }
+
+private:
+    /**
+     * Frees the transform arrays on any return from executeImpl()
+     */
+    template<typename T>
+    struct FFTBuffers {
+        typedef KisFFTWTraits<T> Traits;
+
+        FFTBuffers() : kernel(0) {}
+
+        ~FFTBuffers() {
+            if (kernel) {
+                Traits::release(kernel);
+            }
+
+            Q_FOREACH (typename Traits::complex_type *channel, channels) {
+                Traits::release(channel);
+            }
+        }
+
+        typename Traits::complex_type *kernel;
+        QVector<typename Traits::complex_type*> channels;
+    };
+
+    template<typename T>
+    struct ChannelProcessor {
+        typedef KisFFTWTraits<T> Traits;
+
+        ChannelProcessor(const typename KisFFTWPlanCache<T>::Plans *_plans,
+                         const typename Traits::complex_type *_kernel,
+                         quint32 _length)
+            : plans(_plans), kernel(_kernel), length(_length)
+        {
+        }
+
+        void operator() (typename Traits::complex_type *channel) const {
+            Traits::executeForward(plans->forward, channel);
+            fftMultiply<T>(channel, kernel, length);
+            Traits::executeBackward(plans->backward, channel);
+        }
+
+        const typename KisFFTWPlanCache<T>::Plans *plans;
+        const typename Traits::complex_type *kernel;
+        quint32 length;
+    };
+
+    /**
+     * The values of the integer channels of up to 16 bits fit into
+     * the float mantissa with enough margin for the transform error
+     */
+    static bool isSinglePrecisionEnough(const QList<KoChannelInfo*> &convChannelList) {
+        Q_FOREACH (KoChannelInfo *channel, convChannelList) {
+            switch (channel->channelValueType()) {
+            case KoChannelInfo::UINT8:
+            case KoChannelInfo::UINT16:
+            case KoChannelInfo::INT8:
+            case KoChannelInfo::INT16:
+                break;
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template<typename T>
+    void executeImpl(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src,
+                     QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect,
+                     const QList<KoChannelInfo*> &convChannelList,
+                     quint32 halfKernelWidth, quint32 halfKernelHeight)
+    {
+        typedef KisFFTWTraits<T> Traits;
+        typedef typename Traits::complex_type complex_type;
+
+        FFTBuffers<T> buffers;
+
+        // create and fill kernel
+        buffers.kernel = Traits::allocate(m_fftLength);
+        memset(buffers.kernel, 0, sizeof(complex_type) * m_fftLength);
+        fftFillKernelMatrix<T>(kernel, buffers.kernel);
+
+        buffers.channels.resize(convChannelList.count());
+        for (auto i = buffers.channels.begin(); i != buffers.channels.end(); ++i) {
+            *i = Traits::allocate(m_fftLength);
         }
 
         const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
@@ -114,57 +367,41 @@ public:
         FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
         int cacheRowStride = m_fftWidth + m_extraMem;
 
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
+        fillCacheFromDevice<T>(src,
+                               QRect(srcPos.x() - halfKernelWidth,
+                                     srcPos.y() - halfKernelHeight,
+                                     m_fftWidth,
+                                     m_fftHeight),
+                               cacheRowStride,
+                               info, dataRect,
+                               buffers.channels);
 
         addToProgress(10);
         if (isInterrupted()) return;
 
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
+        typename KisFFTWPlanCache<T>::PlansSP plans =
+            KisFFTWPlanCache<T>::plans(m_fftWidth, m_fftHeight);
 
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
-
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
-
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
+        Traits::executeForward(plans->forward, buffers.kernel);
+        addToProgress(10);
         if (isInterrupted()) return;
 
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
-
-            fftMultiply(*k, m_kernelFFT);
-
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
-        }
-
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        /**
+         * Executing the plans on new arrays is thread-safe, so the
+         * channels are transformed concurrently
+         */
+        QtConcurrent::blockingMap(buffers.channels,
+                                  ChannelProcessor<T>(plans.data(), buffers.kernel, m_fftLength));
 
+        addToProgress(60);
+        if (isInterrupted()) return;
 
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
+        writeResultToDevice<T>(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
+                               cacheRowStride, halfKernelWidth, halfKernelHeight,
+                               info, dataRect,
+                               buffers.channels);
 
         addToProgress(20);
-        cleanUp();
     }
 
     struct FFTInfo {
@@ -218,11 +455,13 @@ public:
         int alphaRealPos;
     };
 
+    template<typename T>
     void fillCacheFromDevice(KisPaintDeviceSP src,
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<typename KisFFTWTraits<T>::complex_type*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -230,22 +469,22 @@ public:
                                                         dataRect);
 
         const int channelCount = info.numChannels();
-        QVector<double*> channelPtr(channelCount);
+        QVector<T*> channelPtr(channelCount);
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
-            *i = (double*)*iFFt;
+            *i = (T*)*iFFt;
         }
 
         // prepare cache, reused in all loops
-        QVector<double*> cacheRowStart(channelCount);
+        QVector<T*> cacheRowStart(channelCount);
         const auto cacheRowStartBegin = cacheRowStart.begin();
 
         for (int y = 0; y < rect.height(); ++y) {
             // cache current channelPtr in cacheRowStart
-            memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(double*));
+            memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(T*));
 
             for (int x = 0; x < rect.width(); ++x) {
                 const quint8 *data = hitSrc->oldRawData();
@@ -287,11 +526,11 @@ public:
         }
     }
 
-    template <bool additionalMultiplierActive>
+    template <bool additionalMultiplierActive, typename T>
     inline qreal writeOneChannelFromCache(quint8* dstPtr,
                                           const quint32 channel,
                                           const FFTInfo &info,
-                                          double* channelValuePtr,
+                                          T* channelValuePtr,
                                           const qreal additionalMultiplier = 0.0) {
         qreal channelPixelValue;
 
@@ -308,12 +547,14 @@ public:
         return channelPixelValue;
     }
 
+    template<typename T>
     void writeResultToDevice(const QRect &rect,
                              const int cacheRowStride,
                              const int halfKernelWidth,
                              const int halfKernelHeight,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<typename KisFFTWTraits<T>::complex_type*> &channelFFT) {
 
         typename _IteratorFactory_::HLineIterator hitDst =
             _IteratorFactory_::createHLineIterator(this->m_painter->device(),
@@ -323,22 +564,22 @@ public:
         int initialOffset = cacheRowStride * halfKernelHeight + halfKernelWidth;
 
         const int channelCount = info.numChannels();
-        QVector<double*> channelPtr(channelCount);
+        QVector<T*> channelPtr(channelCount);
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
-            *i = (double*)*iFFt + initialOffset;
+            *i = (T*)*iFFt + initialOffset;
         }
 
         // prepare cache, reused in all loops
-        QVector<double*> cacheRowStart(channelCount);
+        QVector<T*> cacheRowStart(channelCount);
         const auto cacheRowStartBegin = cacheRowStart.begin();
 
         for (int y = 0; y < rect.height(); ++y) {
             // cache current channelPtr in cacheRowStart
-            memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(double*));
+            memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(T*));
 
             for (int x = 0; x < rect.width(); ++x) {
                 quint8 *dstPtr = hitDst->rawData();
@@ -399,8 +640,8 @@ public:
 
     }
 
-private:
-    void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, fftw_complex *m_kernelFFT)
+    template<typename T>
+    void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, typename KisFFTWTraits<T>::complex_type *m_kernelFFT)
     {
         // find central item
         QPoint offset((kernel->width() - 1) / 2, (kernel->height() - 1) / 2);
@@ -422,20 +663,23 @@ private:
                 if (absXpos >= m_fftWidth)
                     absXpos -= m_fftWidth;
 
-                ((double*)m_kernelFFT)[(m_fftWidth + m_extraMem) * absYpos + absXpos] = kernel->data()->coeff(y, x);
+                ((T*)m_kernelFFT)[(m_fftWidth + m_extraMem) * absYpos + absXpos] = kernel->data()->coeff(y, x);
             }
         }
     }
 
-    void fftMultiply(fftw_complex* channel, fftw_complex* kernel)
+    template<typename T>
+    static void fftMultiply(typename KisFFTWTraits<T>::complex_type* channel,
+                            const typename KisFFTWTraits<T>::complex_type* kernel,
+                            quint32 fftLength)
     {
         // perform complex multiplication
-        fftw_complex *channelPtr = channel;
-        fftw_complex *kernelPtr = kernel;
+        typename KisFFTWTraits<T>::complex_type *channelPtr = channel;
+        const typename KisFFTWTraits<T>::complex_type *kernelPtr = kernel;
 
-        fftw_complex tmp;
+        T tmp[2];
 
-        for (quint32 pixelPos = 0; pixelPos < m_fftLength; ++pixelPos)
+        for (quint32 pixelPos = 0; pixelPos < fftLength; ++pixelPos)
         {
             tmp[0] = ((*channelPtr)[0] * (*kernelPtr)[0]) - ((*channelPtr)[1] * (*kernelPtr)[1]);
             tmp[1] = ((*channelPtr)[0] * (*kernelPtr)[1]) + ((*channelPtr)[1] * (*kernelPtr)[0]);
@@ -470,7 +714,8 @@ private:
         }
     }
 
-    void fftLogMatrix(double* channel, const QString &f)
+    template<typename T>
+    void fftLogMatrix(T* channel, const QString &f)
     {
         KisConvolutionWorkerFFTLock::fftwMutex.lock();
         QString filename(QDir::homePath() + "/log_" + f + ".txt");
@@ -510,32 +755,12 @@ private:
 
     bool isInterrupted()
     {
-        if (this->m_progress && this->m_progress->interrupted()) {
-            cleanUp();
-            return true;
-        }
-
-        return false;
+        return this->m_progress && this->m_progress->interrupted();
     }
 
-    void cleanUp()
-    {
-        // free kernel fft data
-        if (m_kernelFFT) {
-            fftw_free(m_kernelFFT);
-        }
-
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
-    }
 private:
     quint32 m_fftWidth, m_fftHeight, m_fftLength, m_extraMem;
     float m_currentProgress;
-
-    fftw_complex* m_kernelFFT;
-    QVector<fftw_complex*> m_channelFFT;
 };
 
 #endif
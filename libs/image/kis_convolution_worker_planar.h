@@ -0,0 +1,326 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_CONVOLUTION_WORKER_PLANAR_H
+#define __KIS_CONVOLUTION_WORKER_PLANAR_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include "kis_convolution_worker.h"
+#include "kis_convolution_row_kernel.h"
+#include "kis_math_toolbox.h"
+
+
+/**
+ * Spatial convolution worker that converts every source row into planar
+ * double buffers only once, keeps a ring of the kernel-height rows per
+ * channel and lets the vectorized KisConvolutionRowKernel produce the
+ * whole destination row of a channel at once.
+ *
+ * The result is bit-exact with KisConvolutionWorkerSpatial: the color
+ * channels are premultiplied by alpha the same way, the taps are summed
+ * in the same order and the final scaling repeats its operations one by
+ * one. Keep the two workers in sync when changing either of them.
+ */
+template <class _IteratorFactory_>
+class KisConvolutionWorkerPlanar : public KisConvolutionWorker<_IteratorFactory_>
+{
+public:
+    KisConvolutionWorkerPlanar(KisPainter *painter, KoUpdater *progress)
+        : KisConvolutionWorker<_IteratorFactory_>(painter, progress)
+        , m_alphaIndex(-1)
+        , m_alphaPos(-1)
+        , m_kernelFactor(1.0)
+    {
+    }
+
+    /**
+     * The channel types KisMathToolbox can convert to and from doubles
+     */
+    static bool isApplicable(const KoColorSpace *cs) {
+        Q_FOREACH (KoChannelInfo *channel, cs->channels()) {
+            switch (channel->channelValueType()) {
+            case KoChannelInfo::UINT8:
+            case KoChannelInfo::UINT16:
+            case KoChannelInfo::INT8:
+            case KoChannelInfo::INT16:
+            case KoChannelInfo::FLOAT16:
+            case KoChannelInfo::FLOAT32:
+                break;
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) override {
+        const int kw = kernel->width();
+        const int kh = kernel->height();
+        const int khalfWidth = (kw - 1) / 2;
+        const int khalfHeight = (kh - 1) / 2;
+        const int pixelSize = src->colorSpace()->pixelSize();
+
+        // Make the area we cover as small as possible
+        if (this->m_painter->selection()) {
+            QRect r = this->m_painter->selection()->selectedRect().intersect(QRect(srcPos, areaSize));
+            dstPos += r.topLeft() - srcPos;
+            srcPos = r.topLeft();
+            areaSize = r.size();
+        }
+
+        if (areaSize.width() == 0 || areaSize.height() == 0)
+            return;
+
+        // Don't convolve with an even sized kernel
+        Q_ASSERT((kw & 0x01) == 1 || (kh & 0x01) == 1 || kernel->factor() != 0);
+
+        m_convChannelList = this->convolvableChannelList(src);
+        const int numChannels = m_convChannelList.size();
+
+        m_alphaIndex = -1;
+        m_alphaPos = -1;
+        for (int i = 0; i < numChannels; i++) {
+            if (m_convChannelList[i]->channelType() == KoChannelInfo::ALPHA) {
+                m_alphaIndex = i;
+                m_alphaPos = m_convChannelList[i]->pos();
+            }
+        }
+
+        KisMathToolbox mathToolbox;
+        m_toDoubleFuncPtr = QVector<PtrToDouble>(numChannels);
+        if (!mathToolbox.getToDoubleChannelPtr(m_convChannelList, m_toDoubleFuncPtr))
+            return;
+
+        m_fromDoubleFuncPtr = QVector<PtrFromDouble>(numChannels);
+        if (!mathToolbox.getFromDoubleChannelPtr(m_convChannelList, m_fromDoubleFuncPtr))
+            return;
+
+        m_kernelFactor = kernel->factor() ? 1.0 / kernel->factor() : 1;
+        m_minClamp.resize(numChannels);
+        m_maxClamp.resize(numChannels);
+        m_absoluteOffset.resize(numChannels);
+        for (int i = 0; i < numChannels; ++i) {
+            m_minClamp[i] = mathToolbox.minChannelValue(m_convChannelList[i]);
+            m_maxClamp[i] = mathToolbox.maxChannelValue(m_convChannelList[i]);
+            m_absoluteOffset[i] = (m_maxClamp[i] - m_minClamp[i]) * kernel->offset();
+        }
+
+        /**
+         * Zero weights of sparse kernels can be skipped only when all the
+         * values are finite, otherwise 0 * inf would have produced a NaN
+         * in KisConvolutionWorkerSpatial
+         */
+        const bool skipZeroTaps = hasOnlyIntegerChannels();
+
+        /**
+         * The kernel is mirrored, pixel (c, r) of the source window
+         * is multiplied by the kernel value (kw - 1 - c, kh - 1 - r).
+         * The taps go in the order of the source window, because that
+         * is the order KisConvolutionWorkerSpatial sums them in.
+         */
+        QVector<KisConvolutionRowKernel::Tap> taps;
+        for (int r = 0; r < kh; r++) {
+            for (int c = 0; c < kw; c++) {
+                const qreal weight = (*(kernel->data()))(kh - 1 - r, kw - 1 - c);
+                if (skipZeroTaps && weight == 0.0) continue;
+
+                KisConvolutionRowKernel::Tap tap;
+                tap.row = r;
+                tap.offset = c;
+                tap.weight = weight;
+                taps.append(tap);
+            }
+        }
+
+        QScopedPointer<KisConvolutionRowKernel> rowKernel(
+            createOptimizedClass<KisConvolutionRowKernelFactory>(0));
+
+        const int dstWidth = areaSize.width();
+        const int srcWidth = dstWidth + kw - 1;
+
+        /**
+         * m_rows[channel * kh + i] points to the i-th row of the kernel
+         * window of the channel. Moving the window down is just a rotation
+         * of these pointers.
+         */
+        QVector<qreal> rowsStorage(numChannels * kh * srcWidth);
+        m_rows.resize(numChannels * kh);
+        for (int i = 0; i < m_rows.size(); i++) {
+            m_rows[i] = rowsStorage.data() + i * srcWidth;
+        }
+
+        QVector<qreal> dstRows(numChannels * dstWidth);
+
+        bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setProgress(0);
+            this->m_progress->setRange(0, areaSize.height());
+        }
+
+        typename _IteratorFactory_::HLineConstIterator kitSrc = _IteratorFactory_::createHLineConstIterator(src, srcPos.x() - khalfWidth, srcPos.y() - khalfHeight, srcWidth, dataRect);
+        for (int i = 0; i < kh; i++) {
+            loadRow(kitSrc, i, kh);
+            kitSrc->nextRow();
+        }
+
+        typename _IteratorFactory_::HLineIterator hitDst = _IteratorFactory_::createHLineIterator(this->m_painter->device(), dstPos.x(), dstPos.y(), dstWidth, dataRect);
+        typename _IteratorFactory_::HLineConstIterator hitSrc = _IteratorFactory_::createHLineConstIterator(src, srcPos.x(), srcPos.y(), dstWidth, dataRect);
+
+        for (int prow = 0; prow < areaSize.height(); prow++) {
+            for (int k = 0; k < numChannels; k++) {
+                rowKernel->convolveRow(m_rows.constData() + k * kh,
+                                       taps.constData(), taps.size(),
+                                       dstRows.data() + k * dstWidth, dstWidth);
+            }
+
+            const qreal *dstRowsPtr = dstRows.constData();
+            int x = 0;
+            do {
+                // write original channel values
+                memcpy(hitDst->rawData(), hitSrc->oldRawData(), pixelSize);
+                writePixel(hitDst->rawData(), dstRowsPtr + x, dstWidth);
+                x++;
+                hitSrc->nextPixel();
+            } while (hitDst->nextPixel());
+
+            hitDst->nextRow();
+            hitSrc->nextRow();
+
+            if (prow < areaSize.height() - 1) {
+                for (int k = 0; k < numChannels; k++) {
+                    qreal **channelRows = m_rows.data() + k * kh;
+                    qreal *first = channelRows[0];
+                    memmove(channelRows, channelRows + 1, (kh - 1) * sizeof(qreal*));
+                    channelRows[kh - 1] = first;
+                }
+
+                loadRow(kitSrc, kh - 1, kh);
+                kitSrc->nextRow();
+            }
+
+            if (hasProgressUpdater) {
+                this->m_progress->setValue(prow);
+
+                if (this->m_progress->interrupted()) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    bool hasOnlyIntegerChannels() const {
+        Q_FOREACH (KoChannelInfo *channel, m_convChannelList) {
+            switch (channel->channelValueType()) {
+            case KoChannelInfo::UINT8:
+            case KoChannelInfo::UINT16:
+            case KoChannelInfo::INT8:
+            case KoChannelInfo::INT16:
+                break;
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    inline void loadRow(typename _IteratorFactory_::HLineConstIterator &it, int rowIndex, int kh) {
+        const int numChannels = m_convChannelList.size();
+
+        int x = 0;
+        do {
+            const quint8 *data = it->oldRawData();
+
+            // no alpha is rare case, so just multiply by 1.0 in that case
+            const qreal alphaValue = m_alphaIndex >= 0 ?
+                m_toDoubleFuncPtr[m_alphaIndex](data, m_alphaPos) : 1.0;
+
+            for (int k = 0; k < numChannels; k++) {
+                m_rows[k * kh + rowIndex][x] = k != m_alphaIndex ?
+                    m_toDoubleFuncPtr[k](data, m_convChannelList[k]->pos()) * alphaValue :
+                    alphaValue;
+            }
+
+            x++;
+        } while (it->nextPixel());
+    }
+
+    inline qreal limitValue(qreal value, int channel) const {
+        if (value > m_maxClamp[channel]) {
+            return m_maxClamp[channel];
+        } else if (!(value >= m_minClamp[channel])) {  // value < lowBound or value == NaN
+            return m_minClamp[channel];
+        }
+        return value;
+    }
+
+    inline void writePixel(quint8 *dstPtr, const qreal *sums, int channelStride) const {
+        const int numChannels = m_convChannelList.size();
+
+        if (m_alphaIndex >= 0) {
+            const qreal alphaValue =
+                limitValue(sums[m_alphaIndex * channelStride] * m_kernelFactor + m_absoluteOffset[m_alphaIndex],
+                           m_alphaIndex);
+            m_fromDoubleFuncPtr[m_alphaIndex](dstPtr, m_alphaPos, alphaValue);
+
+            if (alphaValue != 0.0) {
+                const qreal alphaValueInv = 1.0 / alphaValue;
+
+                for (int k = 0; k < numChannels; k++) {
+                    if (k == m_alphaIndex) continue;
+
+                    const qreal value =
+                        limitValue((sums[k * channelStride] * m_kernelFactor) * alphaValueInv + m_absoluteOffset[k], k);
+                    m_fromDoubleFuncPtr[k](dstPtr, m_convChannelList[k]->pos(), value);
+                }
+            } else {
+                for (int k = 0; k < numChannels; k++) {
+                    if (k == m_alphaIndex) continue;
+                    m_fromDoubleFuncPtr[k](dstPtr, m_convChannelList[k]->pos(), 0.0);
+                }
+            }
+        } else {
+            for (int k = 0; k < numChannels; k++) {
+                const qreal value =
+                    limitValue(sums[k * channelStride] * m_kernelFactor + m_absoluteOffset[k], k);
+                m_fromDoubleFuncPtr[k](dstPtr, m_convChannelList[k]->pos(), value);
+            }
+        }
+    }
+
+private:
+    QList<KoChannelInfo *> m_convChannelList;
+    int m_alphaIndex;
+    int m_alphaPos;
+
+    QVector<PtrToDouble> m_toDoubleFuncPtr;
+    QVector<PtrFromDouble> m_fromDoubleFuncPtr;
+
+    qreal m_kernelFactor;
+    QVector<qreal> m_minClamp;
+    QVector<qreal> m_maxClamp;
+    QVector<qreal> m_absoluteOffset;
+
+    QVector<qreal*> m_rows;
+};
+
+#endif /* __KIS_CONVOLUTION_WORKER_PLANAR_H */
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_IIR_GAUSSIAN_BLUR_H
+#define __KIS_IIR_GAUSSIAN_BLUR_H
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+class QRect;
+class QBitArray;
+class KoUpdater;
+
+/**
+ * Recursive (IIR) approximation of the gaussian blur by Deriche. The
+ * blur is done by a fourth order causal and anticausal filter, so the
+ * cost per pixel doesn't depend on the radius, unlike the explicit
+ * kernel of KisGaussianKernel.
+ *
+ * The result differs from the explicit kernel by a couple of levels
+ * of an 8-bit channel at most, so for small radii, where the recursion
+ * is not faster, the exact kernel is still used.
+ */
+class KRITAIMAGE_EXPORT KisIIRGaussianBlur
+{
+public:
+    /**
+     * @return true if the radii are large enough for the recursive blur
+     *         to be faster than the convolution with the exact kernel
+     */
+    static bool isPreferable(qreal xRadius, qreal yRadius);
+
+    /**
+     * Has the same semantics as KisGaussianKernel::applyGaussian():
+     * reads the rect extended by the kernel size, repeats the border
+     * pixels of the device and writes back only \p rect.
+     */
+    static void applyGaussian(KisPaintDeviceSP device,
+                              const QRect& rect,
+                              qreal xRadius, qreal yRadius,
+                              const QBitArray &channelFlags,
+                              KoUpdater *progressUpdater);
+
+    /**
+     * Blurs \p numLanes interleaved lines in place: i-th sample of the
+     * lane k is stored at data[i * stride + k]. Processing the lanes
+     * together keeps the inner loop free from dependencies, so it can
+     * be vectorized.
+     */
+    static void blurLanes(float *data, int numLanes, int length, int stride, qreal sigma);
+};
+
+#endif /* __KIS_IIR_GAUSSIAN_BLUR_H */
@@ -33,6 +33,7 @@
 #include <QDir>
 
 #include "kis_global.h"
+#include "tiles3/swap/kis_abstract_compression.h"
 #include <cmath>
 
 #ifdef Q_OS_OSX
@@ -163,6 +164,32 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+QString KisImageConfig::swapCompression(bool requestDefault) const
+{
+    const QString defaultCompression = KisAbstractCompression::fastestCompression();
+
+    return !requestDefault ?
+        m_config.readEntry("swapCompression", defaultCompression) : defaultCompression;
+}
+
+void KisImageConfig::setSwapCompression(const QString &value)
+{
+    m_config.writeEntry("swapCompression", value);
+}
+
+QString KisImageConfig::saveTilesCompression(bool requestDefault) const
+{
+    const QString defaultCompression = "LZF";
+
+    return !requestDefault ?
+        m_config.readEntry("saveTilesCompression", defaultCompression) : defaultCompression;
+}
+
+void KisImageConfig::setSaveTilesCompression(const QString &value)
+{
+    m_config.writeEntry("saveTilesCompression", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
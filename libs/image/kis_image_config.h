@@ -58,6 +58,21 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    /**
+     * The algorithm used for compressing tiles in the swap file,
+     * see KisAbstractCompression::availableCompressions()
+     */
+    QString swapCompression(bool requestDefault = false) const;
+    void setSwapCompression(const QString &value);
+
+    /**
+     * The algorithm used for compressing tiles when saving .kra
+     * files. Default is LZF, which can be read by any version of
+     * Krita.
+     */
+    QString saveTilesCompression(bool requestDefault = false) const;
+    void setSaveTilesCompression(const QString &value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_merge_jobs_index.h"
+
+#include <algorithm>
+#include <limits>
+
+
+void KisMergeJobsIndex::setJob(int slot, const QRect &accessRect, const QRect &changeRect)
+{
+    removeJob(slot);
+
+    Job job;
+    job.slot = slot;
+    job.bounds = accessRect | changeRect;
+    job.accessRect = accessRect;
+    job.changeRect = changeRect;
+
+    // a job with empty rects cannot conflict with anything
+    if (job.bounds.isEmpty()) return;
+
+    auto it = std::upper_bound(m_jobs.begin(), m_jobs.end(), job,
+                               [] (const Job &lhs, const Job &rhs) {
+                                   return lhs.bounds.left() < rhs.bounds.left();
+                               });
+
+    const int index = it - m_jobs.begin();
+    m_jobs.insert(index, job);
+    m_maxRight.insert(index, 0);
+    updateMaxRight(index);
+}
+
+void KisMergeJobsIndex::removeJob(int slot)
+{
+    for (int i = 0; i < m_jobs.size(); i++) {
+        if (m_jobs[i].slot == slot) {
+            m_jobs.remove(i);
+            m_maxRight.remove(i);
+            updateMaxRight(i);
+            return;
+        }
+    }
+}
+
+void KisMergeJobsIndex::clear()
+{
+    m_jobs.clear();
+    m_maxRight.clear();
+}
+
+void KisMergeJobsIndex::updateMaxRight(int start)
+{
+    int maxRight = start > 0 ? m_maxRight[start - 1] : std::numeric_limits<int>::min();
+
+    for (int i = start; i < m_jobs.size(); i++) {
+        maxRight = qMax(maxRight, m_jobs[i].bounds.right());
+        m_maxRight[i] = maxRight;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_MERGE_JOBS_INDEX_H
+#define __KIS_MERGE_JOBS_INDEX_H
+
+#include <algorithm>
+
+#include <QRect>
+#include <QVector>
+
+#include "kritaimage_export.h"
+
+
+/**
+ * Keeps the rects of the merge jobs running in KisUpdaterContext,
+ * sorted by the left edge of their bounds. The conflicts of a new
+ * walker are checked only against the jobs whose bounds overlap the
+ * walker's bounds horizontally, instead of scanning all the slots of
+ * the context for every walker in the updates queue.
+ *
+ * The index is not thread-safe, all the calls should happen under
+ * the lock of the context.
+ */
+class KRITAIMAGE_EXPORT KisMergeJobsIndex
+{
+public:
+    /**
+     * Registers the merge job running in \p slot. The previous
+     * job of the slot, if any, is replaced.
+     */
+    void setJob(int slot, const QRect &accessRect, const QRect &changeRect);
+
+    /**
+     * Forgets the job of \p slot, e.g. when the slot
+     * gets a stroke job
+     */
+    void removeJob(int slot);
+
+    void clear();
+
+    /**
+     * Returns true if \p accessRect intersects the change rect of any
+     * of the jobs or \p changeRect intersects any of their access rects.
+     *
+     * The slots don't remove their jobs from the index when they finish,
+     * so the jobs are considered only when \p isRunning(slot) is true.
+     */
+    template <class IsRunningPredicate>
+    bool intersects(const QRect &accessRect, const QRect &changeRect,
+                    IsRunningPredicate isRunning) const;
+
+private:
+    struct Job {
+        int slot;
+        QRect bounds;
+        QRect accessRect;
+        QRect changeRect;
+    };
+
+    void updateMaxRight(int start);
+
+private:
+    QVector<Job> m_jobs;
+
+    /**
+     * m_maxRight[i] is the maximum right edge of the
+     * bounds of m_jobs[0]...m_jobs[i]
+     */
+    QVector<int> m_maxRight;
+};
+
+template <class IsRunningPredicate>
+bool KisMergeJobsIndex::intersects(const QRect &accessRect, const QRect &changeRect,
+                                   IsRunningPredicate isRunning) const
+{
+    const QRect bounds = accessRect | changeRect;
+    if (bounds.isEmpty()) return false;
+
+    int i = std::upper_bound(m_jobs.begin(), m_jobs.end(), bounds.right(),
+                             [] (int right, const Job &job) {
+                                 return right < job.bounds.left();
+                             }) - m_jobs.begin();
+
+    /**
+     * All the jobs from i on start to the right of the bounds. Go
+     * backwards until none of the remaining jobs reaches the bounds.
+     */
+    for (i--; i >= 0 && m_maxRight[i] >= bounds.left(); i--) {
+        const Job &job = m_jobs[i];
+
+        if ((accessRect.intersects(job.changeRect) ||
+             job.accessRect.intersects(changeRect)) &&
+            isRunning(job.slot)) {
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif /* __KIS_MERGE_JOBS_INDEX_H */
@@ -37,6 +37,7 @@
 #include <QRect>
 #include <QString>
 #include <QStringList>
+#include <QtConcurrent>
 #include <kundo2command.h>
 
 #include <kis_debug.h>
@@ -64,6 +65,7 @@
 #include "kis_paintop_registry.h"
 #include "kis_perspective_math.h"
 #include "tiles3/kis_random_accessor.h"
+#include "tiles3/kis_tile_data.h"
 #include <kis_distance_information.h>
 #include <KoColorSpaceMaths.h>
 #include "kis_lod_transform.h"
@@ -133,6 +135,19 @@ struct Q_DECL_HIDDEN KisPainter::Private {
                              qint32 *dstY);
 
     void fillPainterPathImpl(const QPainterPath& path, const QRect &requestedRect);
+
+    /**
+     * Does the actual job of bltFixed(). All the compositing state is
+     * passed in \p paramInfo, so the method can be called concurrently
+     * for non-overlapping areas. The dirty rect is \em not added.
+     */
+    void bltFixedImpl(qint32 dstX, qint32 dstY,
+                      const KisFixedPaintDeviceSP srcDev,
+                      qint32 srcX, qint32 srcY,
+                      qint32 srcWidth, qint32 srcHeight,
+                      KoCompositeOp::ParameterInfo &paramInfo);
+
+    struct BltFixedStripProcessor;
 };
 
 KisPainter::KisPainter()
@@ -915,52 +930,41 @@ void KisPainter::fill(qint32 x, qint32 y, qint32 width, qint32 height, const KoC
 }
 
 
-void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
-                          const KisFixedPaintDeviceSP srcDev,
-                          qint32 srcX, qint32 srcY,
-                          qint32 srcWidth, qint32 srcHeight)
+void KisPainter::Private::bltFixedImpl(qint32 dstX, qint32 dstY,
+                                       const KisFixedPaintDeviceSP srcDev,
+                                       qint32 srcX, qint32 srcY,
+                                       qint32 srcWidth, qint32 srcHeight,
+                                       KoCompositeOp::ParameterInfo &paramInfo)
 {
-    /* This check for nonsense ought to be a Q_ASSERT. However, when paintops are just
-    initializing they perform some dummy passes with those parameters, and it must not crash */
-    if (srcWidth == 0 || srcHeight == 0) return;
-    if (srcDev.isNull()) return;
-    if (d->device.isNull()) return;
-
-    QRect srcRect = QRect(srcX, srcY, srcWidth, srcHeight);
     QRect srcBounds = srcDev->bounds();
 
-    /* Trying to read outside a KisFixedPaintDevice is inherently wrong and shouldn't be done,
-    so crash if someone attempts to do this. Don't resize as it would obfuscate the mistake. */
-    Q_ASSERT(srcBounds.contains(srcRect));
-    Q_UNUSED(srcRect); // only used in above assertion
-
     /* Create an intermediate byte array to hold information before it is written
-    to the current paint device (aka: d->device) */
+    to the current paint device (aka: device) */
     quint8* dstBytes = 0;
     try {
-         dstBytes = new quint8[srcWidth * srcHeight * d->device->pixelSize()];
+         dstBytes = new quint8[srcWidth * srcHeight * device->pixelSize()];
     } catch (std::bad_alloc) {
-        warnKrita << "KisPainter::bltFixed std::bad_alloc for " << srcWidth << " * " << srcHeight << " * " << d->device->pixelSize() << "total bytes";
+        warnKrita << "KisPainter::bltFixed std::bad_alloc for " << srcWidth << " * " << srcHeight << " * " << device->pixelSize() << "total bytes";
         return;
     }
-    d->device->readBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
+    device->readBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
 
     const quint8 *srcRowStart = srcDev->data() +
         (srcBounds.width() * (srcY - srcBounds.top()) + (srcX - srcBounds.left())) * srcDev->pixelSize();
 
-    d->paramInfo.dstRowStart   = dstBytes;
-    d->paramInfo.dstRowStride  = srcWidth * d->device->pixelSize();
-    d->paramInfo.srcRowStart   = srcRowStart;
-    d->paramInfo.srcRowStride  = srcBounds.width() * srcDev->pixelSize();
-    d->paramInfo.maskRowStart  = 0;
-    d->paramInfo.maskRowStride = 0;
-    d->paramInfo.rows          = srcHeight;
-    d->paramInfo.cols          = srcWidth;
-
-    if (d->selection) {
-        /* d->selection is a KisPaintDevice, so first a readBytes is performed to
+    paramInfo.dstRowStart   = dstBytes;
+    paramInfo.dstRowStride  = srcWidth * device->pixelSize();
+    paramInfo.srcRowStart   = srcRowStart;
+    paramInfo.srcRowStride  = srcBounds.width() * srcDev->pixelSize();
+    paramInfo.maskRowStart  = 0;
+    paramInfo.maskRowStride = 0;
+    paramInfo.rows          = srcHeight;
+    paramInfo.cols          = srcWidth;
+
+    if (selection) {
+        /* selection is a KisPaintDevice, so first a readBytes is performed to
         get the area of interest... */
-        KisPaintDeviceSP selectionProjection(d->selection->projection());
+        KisPaintDeviceSP selectionProjection(selection->projection());
         quint8* selBytes = 0;
         try {
             selBytes = new quint8[srcWidth * srcHeight * selectionProjection->pixelSize()];
@@ -971,20 +975,109 @@ void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
         }
 
         selectionProjection->readBytes(selBytes, dstX, dstY, srcWidth, srcHeight);
-        d->paramInfo.maskRowStart = selBytes;
-        d->paramInfo.maskRowStride = srcWidth * selectionProjection->pixelSize();
+        paramInfo.maskRowStart = selBytes;
+        paramInfo.maskRowStride = srcWidth * selectionProjection->pixelSize();
     }
 
     // ...and then blit.
-    d->colorSpace->bitBlt(srcDev->colorSpace(), d->paramInfo, d->compositeOp, d->renderingIntent, d->conversionFlags);
-    d->device->writeBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
+    colorSpace->bitBlt(srcDev->colorSpace(), paramInfo, compositeOp, renderingIntent, conversionFlags);
+    device->writeBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
 
-    delete[] d->paramInfo.maskRowStart;
+    delete[] paramInfo.maskRowStart;
     delete[] dstBytes;
+}
+
+void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
+                          const KisFixedPaintDeviceSP srcDev,
+                          qint32 srcX, qint32 srcY,
+                          qint32 srcWidth, qint32 srcHeight)
+{
+    /* This check for nonsense ought to be a Q_ASSERT. However, when paintops are just
+    initializing they perform some dummy passes with those parameters, and it must not crash */
+    if (srcWidth == 0 || srcHeight == 0) return;
+    if (srcDev.isNull()) return;
+    if (d->device.isNull()) return;
+
+    QRect srcRect = QRect(srcX, srcY, srcWidth, srcHeight);
+    QRect srcBounds = srcDev->bounds();
+
+    /* Trying to read outside a KisFixedPaintDevice is inherently wrong and shouldn't be done,
+    so crash if someone attempts to do this. Don't resize as it would obfuscate the mistake. */
+    Q_ASSERT(srcBounds.contains(srcRect));
+    Q_UNUSED(srcRect); // only used in above assertion
+    Q_UNUSED(srcBounds);
+
+    d->bltFixedImpl(dstX, dstY, srcDev, srcX, srcY, srcWidth, srcHeight, d->paramInfo);
 
     addDirtyRect(QRect(dstX, dstY, srcWidth, srcHeight));
 }
 
+struct KisPainter::Private::BltFixedStripProcessor
+{
+    BltFixedStripProcessor(KisPainter::Private *_d,
+                           KisFixedPaintDeviceSP _srcDev,
+                           const QPoint &_srcOffset)
+        : d(_d), srcDev(_srcDev), srcOffset(_srcOffset)
+    {
+    }
+
+    void operator() (const QRect &dstRect) {
+        // every strip gets its own copy of the compositing parameters
+        KoCompositeOp::ParameterInfo paramInfo(d->paramInfo);
+
+        d->bltFixedImpl(dstRect.x(), dstRect.y(), srcDev,
+                        dstRect.x() + srcOffset.x(), dstRect.y() + srcOffset.y(),
+                        dstRect.width(), dstRect.height(),
+                        paramInfo);
+    }
+
+    KisPainter::Private *d;
+    KisFixedPaintDeviceSP srcDev;
+    QPoint srcOffset;
+};
+
+void KisPainter::bltFixedConcurrent(const QPoint &pos, const KisFixedPaintDeviceSP srcDev, const QRect &srcRect)
+{
+    if (srcRect.isEmpty()) return;
+    if (srcDev.isNull()) return;
+    if (d->device.isNull()) return;
+
+    Q_ASSERT(srcDev->bounds().contains(srcRect));
+
+    const QRect dstRect(pos, srcRect.size());
+
+    /**
+     * Split the area into strips along the tile rows of the destination
+     * device. The strips never share a tile, so the workers don't fight
+     * for the tile locks, and every pixel is still composited exactly
+     * once, so the result doesn't depend on the order of the jobs.
+     */
+    const int tileHeight = KisTileData::HEIGHT;
+    const int offsetY = d->device->y();
+
+    QVector<QRect> strips;
+    int stripTop = dstRect.top();
+    while (stripTop <= dstRect.bottom()) {
+        const int tileRow = std::floor(qreal(stripTop - offsetY) / tileHeight);
+        const int tileBottom = offsetY + (tileRow + 1) * tileHeight - 1;
+        const int stripBottom = qMin(tileBottom, dstRect.bottom());
+
+        strips << QRect(dstRect.left(), stripTop, dstRect.width(), stripBottom - stripTop + 1);
+        stripTop = stripBottom + 1;
+    }
+
+    if (strips.size() > 1) {
+        Private::BltFixedStripProcessor processor(d, srcDev, srcRect.topLeft() - pos);
+        QtConcurrent::blockingMap(strips, processor);
+    } else {
+        d->bltFixedImpl(pos.x(), pos.y(), srcDev,
+                        srcRect.x(), srcRect.y(), srcRect.width(), srcRect.height(),
+                        d->paramInfo);
+    }
+
+    addDirtyRect(dstRect);
+}
+
 void KisPainter::bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev, const QRect & srcRect)
 {
     bltFixed(pos.x(), pos.y(), srcDev, srcRect.x(), srcRect.y(), srcRect.width(), srcRect.height());
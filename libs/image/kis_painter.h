@@ -306,6 +306,17 @@ public:
      */
     void bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev, const QRect & srcRect);
 
+    /**
+     * Does the same as bltFixed(), but splits the area into horizontal
+     * strips aligned to the tile rows of the destination device and
+     * composites the strips concurrently in the global thread pool.
+     * The result is exactly the same as the one of bltFixed().
+     *
+     * Thread synchronization is not free, so the method makes sense
+     * for big areas (e.g. huge dabs) only.
+     */
+    void bltFixedConcurrent(const QPoint &pos, const KisFixedPaintDeviceSP srcDev, const QRect &srcRect);
+
     /**
      * Blasts a @param selection of srcWidth @param srcWidth and srcHeight @param srcHeight
      * of @param srcDev on the current paint device. There is parameters to control
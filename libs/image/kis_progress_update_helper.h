@@ -42,9 +42,11 @@ public:
         }
     }
 
-    void step() {
+    void step(int numSteps = 1) {
+        m_currentStep += numSteps;
+
         int localProgress = m_numSteps ?
-            m_portion * (++m_currentStep) / m_numSteps : m_portion;
+            m_portion * m_currentStep / m_numSteps : m_portion;
 
         if (m_progressUpdater) {
             m_progressUpdater->setProgress(m_baseProgress + localProgress);
@@ -20,9 +20,12 @@
 
 #include <QMutexLocker>
 
+#include <algorithm>
+
 #include "kis_image_config.h"
 #include "kis_full_refresh_walker.h"
 #include "kis_spontaneous_job.h"
+#include "kis_update_time_monitor.h"
 
 
 //#define ENABLE_DEBUG_JOIN
@@ -53,7 +56,8 @@
 
 
 KisSimpleUpdateQueue::KisSimpleUpdateQueue()
-    : m_overrideLevelOfDetail(-1)
+    : m_nextSeqNo(0),
+      m_overrideLevelOfDetail(-1)
 {
     updateSettings();
 }
@@ -79,6 +83,8 @@ void KisSimpleUpdateQueue::updateSettings()
     m_maxCollectAlpha = config.maxCollectAlpha();
     m_maxMergeAlpha = config.maxMergeAlpha();
     m_maxMergeCollectAlpha = config.maxMergeCollectAlpha();
+
+    rebuildWalkersIndex();
 }
 
 int KisSimpleUpdateQueue::overrideLevelOfDetail() const
@@ -101,13 +107,12 @@ bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
     QMutexLocker locker(&m_lock);
 
     KisBaseRectsWalkerSP item;
-    KisMutableWalkersListIterator iter(m_updatesList);
     bool jobAdded = false;
 
     int currentLevelOfDetail = updaterContext.currentLevelOfDetail();
 
-    while(iter.hasNext()) {
-        item = iter.next();
+    for (int i = 0; i < m_updatesList.size(); i++) {
+        item = m_updatesList[i];
 
         if ((currentLevelOfDetail < 0 || currentLevelOfDetail == item->levelOfDetail()) &&
             !item->checksumValid()) {
@@ -121,7 +126,7 @@ bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
             updaterContext.isJobAllowed(item)) {
 
             updaterContext.addMergeJob(item);
-            iter.remove();
+            removeWalkerAt(i);
             jobAdded = true;
             break;
         }
@@ -193,7 +198,7 @@ void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QRect& rc,
     walker->collectRects(node, rc);
 
     m_lock.lock();
-    m_updatesList.append(walker);
+    appendWalker(walker);
     m_lock.unlock();
 }
 
@@ -267,32 +272,38 @@ bool KisSimpleUpdateQueue::tryMergeJob(KisNodeSP node, const QRect& rc,
     QRect baseRect = rc;
 
     KisBaseRectsWalkerSP goodCandidate;
-    KisBaseRectsWalkerSP item;
-    KisWalkersListIterator iter(m_updatesList);
+    quint64 goodCandidateSeqNo = 0;
+
+    QVector<KisWalkersGridIndex::Entry> candidates =
+        m_walkersIndex.candidates(node.data(), rc);
 
     /**
      * We add new jobs to the tail of the list,
      * so it's more probable to find a good candidate here.
      */
+    std::sort(candidates.begin(), candidates.end(),
+              [] (const KisWalkersGridIndex::Entry &lhs, const KisWalkersGridIndex::Entry &rhs) {
+                  return lhs.seqNo > rhs.seqNo;
+              });
 
-    iter.toBack();
-
-    while(iter.hasPrevious()) {
-        item = iter.previous();
+    Q_FOREACH (const KisWalkersGridIndex::Entry &entry, candidates) {
+        const KisBaseRectsWalkerSP &item = entry.walker;
 
-        if(item->startNode() != node) continue;
         if(item->type() != type) continue;
         if(item->cropRect() != cropRect) continue;
         if(item->levelOfDetail() != levelOfDetail) continue;
 
         if(joinRects(baseRect, item->requestedRect(), m_maxMergeAlpha)) {
             goodCandidate = item;
+            goodCandidateSeqNo = entry.seqNo;
             break;
         }
     }
 
+    KisUpdateTimeMonitor::instance()->reportUpdatesMergeCandidates(candidates.size());
+
     if(goodCandidate)
-        collectJobs(goodCandidate, baseRect, m_maxMergeCollectAlpha);
+        collectJobs(goodCandidate, goodCandidateSeqNo, baseRect, m_maxMergeCollectAlpha);
 
     return (bool)goodCandidate;
 }
@@ -306,32 +317,50 @@ void KisSimpleUpdateQueue::optimize()
     KisBaseRectsWalkerSP baseWalker = m_updatesList.first();
     QRect baseRect = baseWalker->requestedRect();
 
-    collectJobs(baseWalker, baseRect, m_maxCollectAlpha);
+    collectJobs(baseWalker, m_updatesSeqNos.first(), baseRect, m_maxCollectAlpha);
 }
 
 void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
+                                       quint64 baseSeqNo,
                                        QRect baseRect,
                                        const qreal maxAlpha)
 {
-    KisBaseRectsWalkerSP item;
-    KisMutableWalkersListIterator iter(m_updatesList);
+    QVector<KisWalkersGridIndex::Entry> candidates =
+        m_walkersIndex.candidates(baseWalker->startNode().data(), baseRect);
 
-    while(iter.hasNext()) {
-        item = iter.next();
+    /**
+     * The rects are joined in the order of the queue. The united rect
+     * only grows, so the walkers lying outside the candidates area of
+     * the original rect cannot be joined later either.
+     */
+    std::sort(candidates.begin(), candidates.end(),
+              [] (const KisWalkersGridIndex::Entry &lhs, const KisWalkersGridIndex::Entry &rhs) {
+                  return lhs.seqNo < rhs.seqNo;
+              });
+
+    Q_FOREACH (const KisWalkersGridIndex::Entry &entry, candidates) {
+        const KisBaseRectsWalkerSP &item = entry.walker;
 
         if(item == baseWalker) continue;
         if(item->type() != baseWalker->type()) continue;
-        if(item->startNode() != baseWalker->startNode()) continue;
         if(item->cropRect() != baseWalker->cropRect()) continue;
         if(item->levelOfDetail() != baseWalker->levelOfDetail()) continue;
 
         if(joinRects(baseRect, item->requestedRect(), maxAlpha)) {
-            iter.remove();
+            QVector<quint64>::iterator it =
+                std::lower_bound(m_updatesSeqNos.begin(), m_updatesSeqNos.end(), entry.seqNo);
+
+            KIS_SAFE_ASSERT_RECOVER(it != m_updatesSeqNos.end() && *it == entry.seqNo) { continue; }
+            removeWalkerAt(it - m_updatesSeqNos.begin());
         }
     }
 
+    KisUpdateTimeMonitor::instance()->reportUpdatesMergeCandidates(candidates.size());
+
     if(baseWalker->requestedRect() != baseRect) {
+        m_walkersIndex.remove(baseSeqNo, baseWalker);
         baseWalker->collectRects(baseWalker->startNode(), baseRect);
+        m_walkersIndex.add(baseSeqNo, baseWalker);
     }
 }
 
@@ -364,6 +393,33 @@ bool KisSimpleUpdateQueue::joinRects(QRect& baseRect,
     return result;
 }
 
+void KisSimpleUpdateQueue::appendWalker(KisBaseRectsWalkerSP walker)
+{
+    const quint64 seqNo = m_nextSeqNo++;
+
+    m_updatesList.append(walker);
+    m_updatesSeqNos.append(seqNo);
+    m_walkersIndex.add(seqNo, walker);
+
+    KisUpdateTimeMonitor::instance()->reportUpdatesQueueLength(m_updatesList.size());
+}
+
+void KisSimpleUpdateQueue::removeWalkerAt(int index)
+{
+    m_walkersIndex.remove(m_updatesSeqNos[index], m_updatesList[index]);
+    m_updatesList.removeAt(index);
+    m_updatesSeqNos.remove(index);
+}
+
+void KisSimpleUpdateQueue::rebuildWalkersIndex()
+{
+    m_walkersIndex.setCellSize(QSize(m_patchWidth, m_patchHeight));
+
+    for (int i = 0; i < m_updatesList.size(); i++) {
+        m_walkersIndex.add(m_updatesSeqNos[i], m_updatesList[i]);
+    }
+}
+
 KisWalkersList& KisTestableSimpleUpdateQueue::getWalkersList()
 {
     return m_updatesList;
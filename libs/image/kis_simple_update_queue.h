@@ -21,6 +21,7 @@
 
 #include <QMutex>
 #include "kis_updater_context.h"
+#include "kis_walkers_grid_index.h"
 
 typedef QList<KisBaseRectsWalkerSP> KisWalkersList;
 typedef QListIterator<KisBaseRectsWalkerSP> KisWalkersListIterator;
@@ -62,16 +63,34 @@ protected:
     bool trySplitJob(KisNodeSP node, const QRect& rc, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
     bool tryMergeJob(KisNodeSP node, const QRect& rc, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
 
-    void collectJobs(KisBaseRectsWalkerSP &baseWalker, QRect baseRect,
-                     const qreal maxAlpha);
+    void collectJobs(KisBaseRectsWalkerSP &baseWalker, quint64 baseSeqNo,
+                     QRect baseRect, const qreal maxAlpha);
     bool joinRects(QRect& baseRect, const QRect& newRect, qreal maxAlpha);
 
+    void appendWalker(KisBaseRectsWalkerSP walker);
+    void removeWalkerAt(int index);
+    void rebuildWalkersIndex();
+
 protected:
 
     mutable QMutex m_lock;
     KisWalkersList m_updatesList;
     KisSpontaneousJobsList m_spontaneousJobsList;
 
+    /**
+     * Sequence numbers of the walkers in m_updatesList. They grow
+     * monotonically along the list, so the position of a walker can
+     * be found with a binary search.
+     */
+    QVector<quint64> m_updatesSeqNos;
+    quint64 m_nextSeqNo;
+
+    /**
+     * Lets tryMergeJob() and collectJobs() check only the walkers
+     * lying close enough to be merged instead of the whole list
+     */
+    KisWalkersGridIndex m_walkersIndex;
+
     /**
      * Parameters of optimization
      * (loaded from a configuration file)
@@ -26,6 +26,9 @@
 #include <klocalizedstring.h>
 
 #include <QTransform>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrent>
 
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -42,6 +45,7 @@
 #include "kis_progress_update_helper.h"
 #include "kis_pixel_selection.h"
 #include "kis_image.h"
+#include "tiles3/kis_tile_data.h"
 
 
 KisTransformWorker::KisTransformWorker(KisPaintDeviceSP dev,
@@ -177,6 +181,58 @@ template <> void calcDimensions <KisVLineIteratorSP>
 
 }
 
+template <class iter> int lineTileOffset(const KisPaintDevice *dev);
+
+template <> int lineTileOffset <KisHLineIteratorSP>(const KisPaintDevice *dev)
+{
+    return dev->y();
+}
+
+template <> int lineTileOffset <KisVLineIteratorSP>(const KisPaintDevice *dev)
+{
+    return dev->x();
+}
+
+template <class iter> int lineTileSize();
+
+template <> int lineTileSize <KisHLineIteratorSP>()
+{
+    return KisTileData::HEIGHT;
+}
+
+template <> int lineTileSize <KisVLineIteratorSP>()
+{
+    return KisTileData::WIDTH;
+}
+
+/**
+ * Splits lines [firstLine, firstLine + numLines) into bands that
+ * follow the tile borders of \p dev, so that two bands never share
+ * a tile. Every band is stored as (first line, number of lines).
+ */
+template <class iter>
+QVector<QPair<int, int>> splitIntoLineBands(const KisPaintDevice *dev, int firstLine, int numLines)
+{
+    const int tileSize = lineTileSize<iter>();
+    const int offset = lineTileOffset<iter>(dev);
+
+    QVector<QPair<int, int>> bands;
+
+    const int lastLine = firstLine + numLines - 1;
+    int bandStart = firstLine;
+
+    while (bandStart <= lastLine) {
+        const int tileIndex = std::floor(qreal(bandStart - offset) / tileSize);
+        const int tileEnd = offset + (tileIndex + 1) * tileSize - 1;
+        const int bandEnd = qMin(tileEnd, lastLine);
+
+        bands << qMakePair(bandStart, bandEnd - bandStart + 1);
+        bandStart = bandEnd + 1;
+    }
+
+    return bands;
+}
+
 template <class iter>
 void updateBounds(QRect &boundRect,
                   const KisFilterWeightsApplicator::LinePos &newBounds);
@@ -210,16 +266,42 @@ void KisTransformWorker::transformPass(KisPaintDevice *src, KisPaintDevice *dst,
     KisFilterWeightsBuffer buf(filterStrategy, qAbs(floatscale));
     KisFilterWeightsApplicator applicator(src, dst, floatscale, shear, dx, clampToEdge);
 
-    KisFilterWeightsApplicator::LinePos dstBounds;
+    /**
+     * The applicator reads and writes back every line independently
+     * from the others, so the lines can be processed concurrently.
+     * The lines are grouped into bands along the tile borders, so the
+     * workers never fight for the same tile. The weights buffer is
+     * read-only and is shared by all the bands.
+     *
+     * The positions of the lines are united in the original order
+     * afterwards, because LinePos::unite() is sensitive to the order
+     * of empty lines and the result must stay exactly the same.
+     */
+    QVector<KisFilterWeightsApplicator::LinePos> dstPositions(numLines);
+    QMutex progressMutex;
 
-    for (int i = firstLine; i < firstLine + numLines; i++) {
-        KisFilterWeightsApplicator::LinePos dstPos;
-        KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+    auto processBand = [&] (const QPair<int, int> &band) {
+        for (int i = band.first; i < band.first + band.second; i++) {
+            KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+            dstPositions[i - firstLine] = applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
+        }
 
-        dstPos = applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
-        dstBounds.unite(dstPos);
+        QMutexLocker l(&progressMutex);
+        progressHelper.step(band.second);
+    };
 
-        progressHelper.step();
+    QVector<QPair<int, int>> bands = splitIntoLineBands<T>(dst, firstLine, numLines);
+
+    if (bands.size() > 1) {
+        QtConcurrent::blockingMap(bands, processBand);
+    } else if (!bands.isEmpty()) {
+        processBand(bands.first());
+    }
+
+    KisFilterWeightsApplicator::LinePos dstBounds;
+
+    Q_FOREACH (const KisFilterWeightsApplicator::LinePos &dstPos, dstPositions) {
+        dstBounds.unite(dstPos);
     }
 
     updateBounds<T>(m_boundRect, dstBounds);
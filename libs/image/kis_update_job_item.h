@@ -19,7 +19,7 @@
 #ifndef __KIS_UPDATE_JOB_ITEM_H
 #define __KIS_UPDATE_JOB_ITEM_H
 
-#include <QRunnable>
+#include <QObject>
 #include <QReadWriteLock>
 
 #include "kis_stroke_job.h"
@@ -28,7 +28,12 @@
 #include "kis_async_merger.h"
 
 
-class KisUpdateJobItem :  public QObject, public QRunnable
+/**
+ * A slot of KisUpdaterContext. The item holds one job at a time, the
+ * job is executed by one of the workers of the context, see
+ * KisUpdaterContext::runWorker().
+ */
+class KisUpdateJobItem :  public QObject
 {
     Q_OBJECT
 public:
@@ -45,57 +50,43 @@ public:
           m_type(EMPTY),
           m_runnableJob(0)
     {
-        setAutoDelete(false);
     }
     ~KisUpdateJobItem() override
     {
         delete m_runnableJob;
     }
 
-    void run() override {
+    /**
+     * Executes the job of the item. In sigJobFinished() signal (which is
+     * DirectConnection), the context may add a new job to the item
+     * again. That job may start on another worker before this call
+     * returns, so nothing but the lock is touched after the signals.
+     */
+    void run() {
         if (!isRunning()) return;
 
-        /**
-         * Here we break the idea of QThreadPool a bit. Ideally, we should split the
-         * jobs into distinct QRunnable objects and pass all of them to QThreadPool.
-         * That is a nice idea, but it doesn't work well when the jobs are small enough
-         * and the number of available cores is high (>4 cores). It this case the
-         * threads just tend to execute the job very quickly and go to sleep, which is
-         * an expencive operation.
-         *
-         * To overcome this problem we try to bulk-process the jobs. In sigJobFinished()
-         * signal (which is DirectConnection), the context may add the job to ourselves(!!!),
-         * so we switch from "done" state into "running" again.
-         */
-
-        while (isRunning()) {
-            m_isExecuting.ref();
-
-            if(m_exclusive) {
-                m_exclusiveJobLock->lockForWrite();
-            } else {
-                m_exclusiveJobLock->lockForRead();
-            }
-
-            if(m_type == MERGE) {
-                runMergeJob();
-            } else {
-                Q_ASSERT(m_type == STROKE || m_type == SPONTANEOUS);
-                m_runnableJob->run();
-                delete m_runnableJob;
-                m_runnableJob = 0;
-            }
-
-            setDone();
-
-
-            emit sigDoSomeUsefulWork();
-            emit sigJobFinished();
-
-            m_exclusiveJobLock->unlock();
-
-            m_isExecuting.deref();
+        if(m_exclusive) {
+            m_exclusiveJobLock->lockForWrite();
+        } else {
+            m_exclusiveJobLock->lockForRead();
         }
+
+        if(m_type == MERGE) {
+            runMergeJob();
+        } else {
+            Q_ASSERT(m_type == STROKE || m_type == SPONTANEOUS);
+            m_runnableJob->run();
+            delete m_runnableJob;
+            m_runnableJob = 0;
+        }
+
+        setDone();
+
+
+        emit sigDoSomeUsefulWork();
+        emit sigJobFinished();
+
+        m_exclusiveJobLock->unlock();
     }
 
     inline void runMergeJob() {
@@ -158,10 +149,6 @@ public:
         return m_changeRect;
     }
 
-    inline bool hasThreadAttached() const {
-        return m_isExecuting;
-    }
-
 Q_SIGNALS:
     void sigContinueUpdate(const QRect& rc);
     void sigDoSomeUsefulWork();
@@ -224,8 +211,6 @@ private:
      */
     QRect m_accessRect;
     QRect m_changeRect;
-
-    QAtomicInt m_isExecuting;
 };
 
 
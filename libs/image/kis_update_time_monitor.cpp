@@ -84,6 +84,11 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
           responseTime(0),
           numTickets(0),
           numUpdates(0),
+          maxQueueLength(0),
+          totalQueueLength(0),
+          numQueueLengthSamples(0),
+          numMergeAttempts(0),
+          numMergeCandidates(0),
           mousePath(0.0),
           loggingEnabled(false)
     {
@@ -97,6 +102,13 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
     qint64 responseTime;
     qint32 numTickets;
     qint32 numUpdates;
+
+    qint32 maxQueueLength;
+    qint64 totalQueueLength;
+    qint32 numQueueLengthSamples;
+    qint32 numMergeAttempts;
+    qint64 numMergeCandidates;
+
     QMutex mutex;
 
     qreal mousePath;
@@ -139,6 +151,11 @@ void KisUpdateTimeMonitor::startStrokeMeasure()
     m_d->responseTime = 0;
     m_d->numTickets = 0;
     m_d->numUpdates = 0;
+    m_d->maxQueueLength = 0;
+    m_d->totalQueueLength = 0;
+    m_d->numQueueLengthSamples = 0;
+    m_d->numMergeAttempts = 0;
+    m_d->numMergeCandidates = 0;
     m_d->mousePath = 0;
 
     m_d->lastMousePos = QPointF();
@@ -185,6 +202,10 @@ void KisUpdateTimeMonitor::printValues()
     qreal nonUpdateTime = qreal(m_d->jobsTime) / m_d->numTickets;
     qreal jobsPerUpdate = qreal(m_d->numTickets) / m_d->numUpdates;    
     qreal mouseSpeed = qreal(m_d->mousePath) / strokeTime;
+    qreal queueLength = m_d->numQueueLengthSamples ?
+        qreal(m_d->totalQueueLength) / m_d->numQueueLengthSamples : 0.0;
+    qreal mergeCost = m_d->numMergeAttempts ?
+        qreal(m_d->numMergeCandidates) / m_d->numMergeAttempts : 0.0;
 
     QString prefix;
 
@@ -203,6 +224,9 @@ void KisUpdateTimeMonitor::printValues()
            << i18n("Mouse Speed:") << QString::number( mouseSpeed, 'f', 3 ) << "\t"
            << i18n("Jobs/Update:") << QString::number( jobsPerUpdate, 'f', 3 ) << "\t"
            << i18n("Non Update Time:") << QString::number( nonUpdateTime, 'f', 3 ) << "\t"
+           << i18n("Queue Length:") << QString::number( queueLength, 'f', 3 ) << "\t"
+           << i18n("Max Queue Length:") << m_d->maxQueueLength << "\t"
+           << i18n("Merge Candidates:") << QString::number( mergeCost, 'f', 3 ) << "\t"
            << i18n("Response Time:") << responseTime << endl; // 'endl' will use the correct OS line ending
     logFile.close();
 }
@@ -256,3 +280,24 @@ void KisUpdateTimeMonitor::reportUpdateFinished(const QRect &rect)
     }
     m_d->numUpdates++;
 }
+
+void KisUpdateTimeMonitor::reportUpdatesQueueLength(int length)
+{
+    if (!m_d->loggingEnabled) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    m_d->maxQueueLength = qMax(m_d->maxQueueLength, length);
+    m_d->totalQueueLength += length;
+    m_d->numQueueLengthSamples++;
+}
+
+void KisUpdateTimeMonitor::reportUpdatesMergeCandidates(int numCandidates)
+{
+    if (!m_d->loggingEnabled) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    m_d->numMergeAttempts++;
+    m_d->numMergeCandidates += numCandidates;
+}
@@ -46,6 +46,14 @@ public:
     void reportJobFinished(void *key, const QVector<QRect> &rects);
     void reportUpdateFinished(const QRect &rect);
 
+    /**
+     * Statistics of KisSimpleUpdateQueue: the length of the queue
+     * after a walker has been added and the number of the walkers
+     * checked while looking for a merge
+     */
+    void reportUpdatesQueueLength(int length);
+    void reportUpdatesMergeCandidates(int numCandidates);
+
 
 private:
     struct Private;
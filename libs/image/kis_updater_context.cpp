@@ -20,14 +20,73 @@
 
 #include <QThread>
 #include <QThreadPool>
+#include <QMutexLocker>
+#include <QAtomicPointer>
 
 #include "kis_update_job_item.h"
 #include "kis_stroke_job.h"
 
+
+/**
+ * Here we break the idea of QThreadPool a bit. Ideally, we should split the
+ * jobs into distinct QRunnable objects and pass all of them to QThreadPool.
+ * That is a nice idea, but it doesn't work well when the jobs are small enough
+ * and the number of available cores is high (>4 cores). It this case the
+ * threads just tend to execute the job very quickly and go to sleep, which is
+ * an expencive operation.
+ *
+ * To overcome this problem every thread of the pool runs a worker that keeps
+ * executing the jobs of its own deque and, when the deque is empty, steals the
+ * jobs of the other workers. It goes to sleep only when there is nothing left
+ * to do.
+ */
+class KisUpdateWorker : public QRunnable
+{
+public:
+    KisUpdateWorker(KisUpdaterContext *context, int index)
+        : index(index),
+          isActive(false),
+          currentItem(0),
+          m_context(context)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override {
+        m_context->runWorker(this);
+    }
+
+    const int index;
+
+    /**
+     * The deque and the activity flag are protected by the mutex.
+     * An active worker is either running or is queued in the pool,
+     * so every job in the deque is guaranteed to be executed.
+     */
+    QMutex mutex;
+    QVector<KisUpdateJobItem*> jobs;
+    bool isActive;
+
+    /**
+     * The thread the worker is running on, if any
+     */
+    QAtomicPointer<QThread> thread;
+
+    /**
+     * The item being executed, accessed by the worker's thread only
+     */
+    KisUpdateJobItem *currentItem;
+
+private:
+    KisUpdaterContext *m_context;
+};
+
+
 const int KisUpdaterContext::useIdealThreadCountTag = -1;
 
 KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      m_nextWorker(0)
 {
     if(threadCount <= 0) {
         threadCount = QThread::idealThreadCount();
@@ -42,6 +101,8 @@ KisUpdaterContext::~KisUpdaterContext()
     m_threadPool.waitForDone();
     for(qint32 i = 0; i < m_jobs.size(); i++)
         delete m_jobs[i];
+
+    qDeleteAll(m_workers);
 }
 
 void KisUpdaterContext::getJobsSnapshot(qint32 &numMergeJobs,
@@ -84,16 +145,10 @@ bool KisUpdaterContext::isJobAllowed(KisBaseRectsWalkerSP walker)
     int lod = this->currentLevelOfDetail();
     if (lod >= 0 && walker->levelOfDetail() != lod) return false;
 
-    bool intersects = false;
-
-    Q_FOREACH (const KisUpdateJobItem *item, m_jobs) {
-        if(item->isRunning() && walkerIntersectsJob(walker, item)) {
-            intersects = true;
-            break;
-        }
-    }
-
-    return !intersects;
+    return !m_mergeJobsIndex.intersects(walker->accessRect(), walker->changeRect(),
+                                        [this] (int slot) {
+                                            return m_jobs[slot]->isRunning();
+                                        });
 }
 
 /**
@@ -111,12 +166,8 @@ void KisUpdaterContext::addMergeJob(KisBaseRectsWalkerSP walker)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setWalker(walker);
-
-    // it might happen that we call this function from within
-    // the thread itself, right when it finished its work
-    if (!m_jobs[jobIndex]->hasThreadAttached()) {
-        m_threadPool.start(m_jobs[jobIndex]);
-    }
+    m_mergeJobsIndex.setJob(jobIndex, walker->accessRect(), walker->changeRect());
+    scheduleJob(m_jobs[jobIndex]);
 }
 
 /**
@@ -129,6 +180,7 @@ void KisTestableUpdaterContext::addMergeJob(KisBaseRectsWalkerSP walker)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setWalker(walker);
+    m_mergeJobsIndex.setJob(jobIndex, walker->accessRect(), walker->changeRect());
     // HINT: Not calling start() here
 }
 
@@ -139,12 +191,8 @@ void KisUpdaterContext::addStrokeJob(KisStrokeJob *strokeJob)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setStrokeJob(strokeJob);
-
-    // it might happen that we call this function from within
-    // the thread itself, right when it finished its work
-    if (!m_jobs[jobIndex]->hasThreadAttached()) {
-        m_threadPool.start(m_jobs[jobIndex]);
-    }
+    m_mergeJobsIndex.removeJob(jobIndex);
+    scheduleJob(m_jobs[jobIndex]);
 }
 
 /**
@@ -157,6 +205,7 @@ void KisTestableUpdaterContext::addStrokeJob(KisStrokeJob *strokeJob)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setStrokeJob(strokeJob);
+    m_mergeJobsIndex.removeJob(jobIndex);
     // HINT: Not calling start() here
 }
 
@@ -167,12 +216,8 @@ void KisUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneousJob)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setSpontaneousJob(spontaneousJob);
-
-    // it might happen that we call this function from within
-    // the thread itself, right when it finished its work
-    if (!m_jobs[jobIndex]->hasThreadAttached()) {
-        m_threadPool.start(m_jobs[jobIndex]);
-    }
+    m_mergeJobsIndex.removeJob(jobIndex);
+    scheduleJob(m_jobs[jobIndex]);
 }
 
 /**
@@ -185,6 +230,7 @@ void KisTestableUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneous
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setSpontaneousJob(spontaneousJob);
+    m_mergeJobsIndex.removeJob(jobIndex);
     // HINT: Not calling start() here
 }
 
@@ -193,13 +239,6 @@ void KisUpdaterContext::waitForDone()
     m_threadPool.waitForDone();
 }
 
-bool KisUpdaterContext::walkerIntersectsJob(KisBaseRectsWalkerSP walker,
-                                            const KisUpdateJobItem* job)
-{
-    return (walker->accessRect().intersects(job->changeRect())) ||
-        (job->accessRect().intersects(walker->changeRect()));
-}
-
 qint32 KisUpdaterContext::findSpareThread()
 {
     for(qint32 i=0; i < m_jobs.size(); i++)
@@ -209,6 +248,120 @@ qint32 KisUpdaterContext::findSpareThread()
     return -1;
 }
 
+void KisUpdaterContext::scheduleJob(KisUpdateJobItem *item)
+{
+    KisUpdateWorker *currentWorker = 0;
+    QThread *currentThread = QThread::currentThread();
+
+    Q_FOREACH (KisUpdateWorker *worker, m_workers) {
+        if (worker->thread.loadAcquire() == currentThread) {
+            currentWorker = worker;
+            break;
+        }
+    }
+
+    /**
+     * Most of the jobs are added by a worker right after it has finished
+     * its own job, from sigJobFinished(). Such a worker takes the first of
+     * the new jobs itself instead of going to sleep and waking up another
+     * thread. The rest of the jobs are given to the sleeping workers.
+     */
+    if (currentWorker &&
+        (!currentWorker->currentItem ||
+         currentWorker->currentItem == item ||
+         !currentWorker->currentItem->isRunning())) {
+
+        QMutexLocker l(&currentWorker->mutex);
+        if (currentWorker->jobs.isEmpty()) {
+            currentWorker->jobs.append(item);
+            return;
+        }
+    }
+
+    Q_FOREACH (KisUpdateWorker *worker, m_workers) {
+        QMutexLocker l(&worker->mutex);
+        if (!worker->isActive) {
+            l.unlock();
+            pushJob(worker, item);
+            return;
+        }
+    }
+
+    /**
+     * All the workers are busy, the job will be
+     * stolen by the first one to get free
+     */
+    pushJob(m_workers[m_nextWorker], item);
+    m_nextWorker = (m_nextWorker + 1) % m_workers.size();
+}
+
+void KisUpdaterContext::pushJob(KisUpdateWorker *worker, KisUpdateJobItem *item)
+{
+    bool needsStart = false;
+
+    {
+        QMutexLocker l(&worker->mutex);
+        worker->jobs.append(item);
+
+        // the worker might have gone to sleep since we checked it
+        needsStart = !worker->isActive;
+        worker->isActive = true;
+    }
+
+    if (needsStart) {
+        m_threadPool.start(worker);
+    }
+}
+
+KisUpdateJobItem* KisUpdaterContext::takeJob(KisUpdateWorker *worker)
+{
+    {
+        QMutexLocker l(&worker->mutex);
+        if (!worker->jobs.isEmpty()) {
+            return worker->jobs.takeLast();
+        }
+    }
+
+    /**
+     * Steal the oldest job of another worker. All the jobs in the deques
+     * have already been checked for conflicts, so any worker may run them.
+     */
+    for (int i = 1; i < m_workers.size(); i++) {
+        KisUpdateWorker *victim = m_workers[(worker->index + i) % m_workers.size()];
+
+        QMutexLocker l(&victim->mutex);
+        if (!victim->jobs.isEmpty()) {
+            return victim->jobs.takeFirst();
+        }
+    }
+
+    return 0;
+}
+
+void KisUpdaterContext::runWorker(KisUpdateWorker *worker)
+{
+    worker->thread.storeRelease(QThread::currentThread());
+
+    forever {
+        KisUpdateJobItem *item = takeJob(worker);
+
+        if (!item) {
+            QMutexLocker l(&worker->mutex);
+
+            // a job might have been added after we checked the deque
+            if (!worker->jobs.isEmpty()) continue;
+
+            worker->thread.storeRelease(0);
+            worker->isActive = false;
+            break;
+        }
+
+        worker->currentItem = item;
+        item->run();
+        worker->currentItem = 0;
+    }
+}
+
 void KisUpdaterContext::slotJobFinished()
 {
     m_lodCounter.removeLod();
@@ -241,6 +394,19 @@ void KisUpdaterContext::setThreadsLimit(int value)
     }
 
     m_jobs.resize(value);
+    m_mergeJobsIndex.clear();
+
+    /**
+     * The scheduler has waited for the pool to finish,
+     * so none of the workers is running now
+     */
+    qDeleteAll(m_workers);
+    m_workers.resize(value);
+    m_nextWorker = 0;
+
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i] = new KisUpdateWorker(this, i);
+    }
 
     for(qint32 i = 0; i < m_jobs.size(); i++) {
         m_jobs[i] = new KisUpdateJobItem(&m_exclusiveJobLock);
@@ -282,6 +448,7 @@ void KisTestableUpdaterContext::clear()
         item->testingSetDone();
     }
 
+    m_mergeJobsIndex.clear();
     m_lodCounter.testingClear();
 }
 
@@ -27,9 +27,11 @@
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
 #include "kis_lock_free_lod_counter.h"
+#include "kis_merge_jobs_index.h"
 
 
 class KisUpdateJobItem;
+class KisUpdateWorker;
 class KisSpontaneousJob;
 class KisStrokeJob;
 
@@ -145,10 +147,21 @@ protected Q_SLOTS:
     void slotJobFinished();
 
 protected:
-    static bool walkerIntersectsJob(KisBaseRectsWalkerSP walker,
-                                    const KisUpdateJobItem* job);
     qint32 findSpareThread();
 
+    /**
+     * Passes the job of the item to one of the workers. Should be
+     * called with the lock held, right after the job is set.
+     */
+    void scheduleJob(KisUpdateJobItem *item);
+
+private:
+    friend class KisUpdateWorker;
+
+    void pushJob(KisUpdateWorker *worker, KisUpdateJobItem *item);
+    KisUpdateJobItem* takeJob(KisUpdateWorker *worker);
+    void runWorker(KisUpdateWorker *worker);
+
 protected:
     /**
      * The lock is shared by all the child update job items.
@@ -162,6 +175,19 @@ protected:
     QVector<KisUpdateJobItem*> m_jobs;
     QThreadPool m_threadPool;
     KisLockFreeLodCounter m_lodCounter;
+
+    /**
+     * The rects of the running merge jobs, see isJobAllowed()
+     */
+    KisMergeJobsIndex m_mergeJobsIndex;
+
+    /**
+     * One worker per thread of the pool. Every worker has its own
+     * deque of jobs and steals the jobs of the others when its own
+     * deque is empty.
+     */
+    QVector<KisUpdateWorker*> m_workers;
+    int m_nextWorker;
 };
 
 class KRITAIMAGE_EXPORT KisTestableUpdaterContext : public KisUpdaterContext
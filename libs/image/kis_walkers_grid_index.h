@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_WALKERS_GRID_INDEX_H
+#define __KIS_WALKERS_GRID_INDEX_H
+
+#include <climits>
+
+#include <QHash>
+#include <QSize>
+#include <QVector>
+
+#include "kis_assert.h"
+#include "kis_base_rects_walker.h"
+
+
+struct KisWalkersGridCellKey {
+    const KisNode *node;
+    int col;
+    int row;
+
+    bool operator==(const KisWalkersGridCellKey &rhs) const {
+        return node == rhs.node && col == rhs.col && row == rhs.row;
+    }
+};
+
+inline uint qHash(const KisWalkersGridCellKey &key, uint seed = 0)
+{
+    return qHash(key.node, seed) ^ qHash(key.col, seed) ^ qHash(key.row * 3163, seed);
+}
+
+/**
+ * A uniform grid over the requested rects of the queued walkers, used by
+ * KisSimpleUpdateQueue to find the candidates for merging. Two walkers
+ * may be merged only when their united rect fits into a patch, so with
+ * the cell size equal to the patch size all the candidates of a rect are
+ * stored in at most 3x3 cells around it.
+ *
+ * Every walker is stored together with its sequence number in the queue,
+ * so the caller can restore the order of the queue for the candidates.
+ */
+class KisWalkersGridIndex
+{
+public:
+    struct Entry {
+        quint64 seqNo;
+        KisBaseRectsWalkerSP walker;
+    };
+
+public:
+    KisWalkersGridIndex()
+        : m_cellSize(512, 512)
+    {
+    }
+
+    /**
+     * Changes the size of the cells. The index must be refilled
+     * after that.
+     */
+    void setCellSize(const QSize &size) {
+        m_cellSize = size;
+        m_cells.clear();
+    }
+
+    void clear() {
+        m_cells.clear();
+    }
+
+    void add(quint64 seqNo, KisBaseRectsWalkerSP walker) {
+        Entry entry;
+        entry.seqNo = seqNo;
+        entry.walker = walker;
+
+        m_cells[keyForWalker(walker)].append(entry);
+    }
+
+    /**
+     * Removes the walker from the index. Should be called before the
+     * requested rect of the walker is changed.
+     */
+    void remove(quint64 seqNo, KisBaseRectsWalkerSP walker) {
+        QHash<KisWalkersGridCellKey, QVector<Entry>>::iterator it = m_cells.find(keyForWalker(walker));
+        KIS_SAFE_ASSERT_RECOVER_RETURN(it != m_cells.end());
+
+        QVector<Entry> &entries = it.value();
+
+        for (int i = 0; i < entries.size(); i++) {
+            if (entries[i].seqNo == seqNo) {
+                entries.remove(i);
+                break;
+            }
+        }
+
+        if (entries.isEmpty()) {
+            m_cells.erase(it);
+        }
+    }
+
+    /**
+     * Returns the walkers of \p node that can be united with \p rc
+     * without exceeding the cell size. The order of the entries is
+     * undefined.
+     */
+    QVector<Entry> candidates(const KisNode *node, const QRect &rc) const {
+        QVector<Entry> result;
+
+        // an empty rect can be united with anything
+        if (rc.isEmpty()) {
+            for (QHash<KisWalkersGridCellKey, QVector<Entry>>::const_iterator it = m_cells.constBegin();
+                 it != m_cells.constEnd(); ++it) {
+
+                if (it.key().node == node) {
+                    result += it.value();
+                }
+            }
+            return result;
+        }
+
+        /**
+         * The top-left corner of a candidate may lie only in the range
+         * [rc.right() - size + 1, rc.left() + size - 1], otherwise the
+         * united rect would be bigger than the cell
+         */
+        const int firstCol = cellIndex(rc.right() - m_cellSize.width() + 1, m_cellSize.width());
+        const int lastCol = cellIndex(rc.left() + m_cellSize.width() - 1, m_cellSize.width());
+        const int firstRow = cellIndex(rc.bottom() - m_cellSize.height() + 1, m_cellSize.height());
+        const int lastRow = cellIndex(rc.top() + m_cellSize.height() - 1, m_cellSize.height());
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int col = firstCol; col <= lastCol; col++) {
+                appendCell(node, col, row, &result);
+            }
+        }
+
+        appendCell(node, emptyRectIndex, emptyRectIndex, &result);
+
+        return result;
+    }
+
+private:
+    static const int emptyRectIndex = INT_MIN;
+
+    static inline int cellIndex(int x, int size) {
+        return x >= 0 ? x / size : -((-x - 1) / size) - 1;
+    }
+
+    inline KisWalkersGridCellKey keyForWalker(KisBaseRectsWalkerSP walker) const {
+        const QRect rc = walker->requestedRect();
+
+        KisWalkersGridCellKey key;
+        key.node = walker->startNode().data();
+        key.col = rc.isEmpty() ? emptyRectIndex : cellIndex(rc.left(), m_cellSize.width());
+        key.row = rc.isEmpty() ? emptyRectIndex : cellIndex(rc.top(), m_cellSize.height());
+        return key;
+    }
+
+    inline void appendCell(const KisNode *node, int col, int row, QVector<Entry> *result) const {
+        KisWalkersGridCellKey key;
+        key.node = node;
+        key.col = col;
+        key.row = row;
+
+        QHash<KisWalkersGridCellKey, QVector<Entry>>::const_iterator it = m_cells.constFind(key);
+        if (it != m_cells.constEnd()) {
+            *result += it.value();
+        }
+    }
+
+private:
+    QSize m_cellSize;
+    QHash<KisWalkersGridCellKey, QVector<Entry>> m_cells;
+};
+
+#endif /* __KIS_WALKERS_GRID_INDEX_H */
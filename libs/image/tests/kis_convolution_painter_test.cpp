@@ -27,6 +27,7 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <KoColorSpaceTraits.h>
+#include <KoColorModelStandardIds.h>
 
 #include "kis_paint_device.h"
 #include "kis_convolution_painter.h"
@@ -437,4 +438,105 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testEngineMatchesSpatial(const QString &depthId,
+                                                         KisConvolutionKernelSP kernel,
+                                                         bool useFftw)
+{
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, "");
+    QVERIFY(cs);
+
+    QImage referenceImage(TestUtil::fetchDataFileLazy("resolution_test.png"));
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->convertFromQImage(referenceImage, 0, 0, 0);
+
+    const QRect applyRect = dev->exactBounds();
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(*dev);
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+    KisPaintDeviceSP engineDev = new KisPaintDevice(*dev);
+    KisConvolutionPainter enginePainter(engineDev,
+                                        useFftw ? KisConvolutionPainter::FFTW :
+                                                  KisConvolutionPainter::PLANAR);
+    enginePainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+    if (useFftw) {
+        QPoint errorPoint;
+        QVERIFY(TestUtil::compareQImages(errorPoint,
+                                         spatialDev->convertToQImage(0, applyRect),
+                                         engineDev->convertToQImage(0, applyRect),
+                                         1, 1));
+    } else {
+        // the planar worker should give exactly the same bytes
+        const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+
+        QByteArray spatialBytes(numBytes, 0);
+        spatialDev->readBytes(reinterpret_cast<quint8*>(spatialBytes.data()), applyRect);
+
+        QByteArray engineBytes(numBytes, 0);
+        engineDev->readBytes(reinterpret_cast<quint8*>(engineBytes.data()), applyRect);
+
+        QVERIFY(engineBytes == spatialBytes);
+    }
+}
+
+KisConvolutionKernelSP createGaussianKernel()
+{
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(5) *
+        KisGaussianKernel::createHorizontalMatrix(5);
+    return KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+}
+
+void KisConvolutionPainterTest::testFFTWMatchesSpatial_data()
+{
+    QTest::addColumn<QString>("depthId");
+
+    // integer channels go through the single precision transform
+    QTest::newRow("u8") << Integer8BitsColorDepthID.id();
+    QTest::newRow("u16") << Integer16BitsColorDepthID.id();
+    QTest::newRow("f32") << Float32BitsColorDepthID.id();
+}
+
+void KisConvolutionPainterTest::testFFTWMatchesSpatial()
+{
+    QFETCH(QString, depthId);
+
+    testEngineMatchesSpatial(depthId, createGaussianKernel(), true);
+}
+
+void KisConvolutionPainterTest::testPlanarMatchesSpatial_data()
+{
+    QTest::addColumn<QString>("depthId");
+    QTest::addColumn<bool>("useGaussian");
+
+    QTest::newRow("u8-emboss") << Integer8BitsColorDepthID.id() << false;
+    QTest::newRow("u8-gaussian") << Integer8BitsColorDepthID.id() << true;
+    QTest::newRow("u16-emboss") << Integer16BitsColorDepthID.id() << false;
+    QTest::newRow("u16-gaussian") << Integer16BitsColorDepthID.id() << true;
+    QTest::newRow("f32-emboss") << Float32BitsColorDepthID.id() << false;
+    QTest::newRow("f32-gaussian") << Float32BitsColorDepthID.id() << true;
+}
+
+void KisConvolutionPainterTest::testPlanarMatchesSpatial()
+{
+    QFETCH(QString, depthId);
+    QFETCH(bool, useGaussian);
+
+    KisConvolutionKernelSP kernel;
+
+    if (useGaussian) {
+        kernel = createGaussianKernel();
+    } else {
+        qreal offset = 0.0;
+        qreal factor = 1.0;
+        Eigen::Matrix<qreal, 3, 3> filter = initAsymmFilter(offset, factor);
+        kernel = KisConvolutionKernel::fromMatrix(filter, 0.5, factor);
+    }
+
+    testEngineMatchesSpatial(depthId, kernel, false);
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
@@ -35,6 +35,7 @@ private:
     void testGaussian(bool useFftw);
     void testGaussianSmall(bool useFftw);
     void testGaussianDetails(bool useFftw);
+    void testEngineMatchesSpatial(const QString &depthId, KisConvolutionKernelSP kernel, bool useFftw);
 
 private Q_SLOTS:
 
@@ -56,6 +57,12 @@ private Q_SLOTS:
 
     void testGaussianDetailsSpatial();
     void testGaussianDetailsFFTW();
+
+    void testFFTWMatchesSpatial_data();
+    void testFFTWMatchesSpatial();
+
+    void testPlanarMatchesSpatial_data();
+    void testPlanarMatchesSpatial();
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include "kis_paint_device.h"
+#include "kis_sequential_iterator.h"
+#include "kis_transform_worker.h"
 
 //#define DEBUG_ENABLED
 #include "kis_filter_weights_applicator.h"
@@ -435,6 +437,75 @@ void KisFilterWeightsApplicatorTest::testProcessLine_Scale_0_5_Shift_0_125_Mirro
     testLine(scale, dx, r, a, -6, 10);
 }
 
+QRect processPassSequentially(KisPaintDeviceSP dev, QRect rc, qreal scale, bool horizontal, KisFilterStrategy *filter)
+{
+    KisFilterWeightsBuffer buf(filter, qAbs(scale));
+    KisFilterWeightsApplicator applicator(dev, dev, scale, 0.0, 0.0, true);
+    KisFilterWeightsApplicator::LinePos dstBounds;
+
+    if (horizontal) {
+        for (int y = rc.top(); y <= rc.bottom(); y++) {
+            KisFilterWeightsApplicator::LinePos srcPos(rc.x(), rc.width());
+            dstBounds.unite(applicator.processLine<KisHLineIteratorSP>(srcPos, y, &buf, filter->support()));
+        }
+        rc.setLeft(dstBounds.start());
+        rc.setWidth(dstBounds.size());
+    } else {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            KisFilterWeightsApplicator::LinePos srcPos(rc.y(), rc.height());
+            dstBounds.unite(applicator.processLine<KisVLineIteratorSP>(srcPos, x, &buf, filter->support()));
+        }
+        rc.setTop(dstBounds.start());
+        rc.setHeight(dstBounds.size());
+    }
+
+    return rc;
+}
+
+void KisFilterWeightsApplicatorTest::testTransformWorkerMatchesSequentialPasses()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    KisFilterStrategy *filter = new KisBicubicFilterStrategy();
+
+    /**
+     * The device spans several tile rows and columns, and doesn't
+     * start at a tile border, so the worker splits the passes into
+     * several bands of different size
+     */
+    const QRect rc(-37, 21, 300, 500);
+    const qreal xScale = 1.7;
+    const qreal yScale = 0.6;
+
+    qsrand(1);
+    KisSequentialIterator it(dev, rc);
+    do {
+        quint8 *pixel = it.rawData();
+        for (int i = 0; i < 4; i++) {
+            pixel[i] = qrand() & 0xff;
+        }
+    } while (it.nextPixel());
+
+    KisPaintDeviceSP refDev = new KisPaintDevice(*dev);
+
+    KisTransformWorker tw(dev, xScale, yScale,
+                          0.0, 0.0,
+                          0.0, 0.0,
+                          0.0,
+                          0, 0, 0, filter);
+    tw.run();
+
+    QRect refRect = refDev->exactBounds();
+    refRect = processPassSequentially(refDev, refRect, xScale, true, filter);
+    refRect = processPassSequentially(refDev, refRect, yScale, false, filter);
+    refDev->purgeDefaultPixels();
+
+    QCOMPARE(dev->exactBounds(), refDev->exactBounds());
+
+    const QRect resultRect = dev->exactBounds();
+    QVERIFY(dev->convertToQImage(0, resultRect) == refDev->convertToQImage(0, resultRect));
+}
+
 void KisFilterWeightsApplicatorTest::benchmarkProcesssLine()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -64,6 +64,8 @@ private Q_SLOTS:
     void testProcessLine_Scale_0_5_Aligned_Mirrored_Clamped();
     void testProcessLine_Scale_0_5_Shift_0_125_Mirrored();
 
+    void testTransformWorkerMatchesSequentialPasses();
+
     void benchmarkProcesssLine();
 };
 
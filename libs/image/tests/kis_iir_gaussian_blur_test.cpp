@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_iir_gaussian_blur_test.h"
+
+#include <QTest>
+#include <QBitArray>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_sequential_iterator.h"
+#include "kis_gaussian_kernel.h"
+#include "kis_iir_gaussian_blur.h"
+
+
+void KisIIRGaussianBlurTest::testConstantSignal()
+{
+    const int numLanes = 3;
+    const int length = 200;
+
+    QVector<float> data(numLanes * length);
+    for (int i = 0; i < length; i++) {
+        data[i * numLanes + 0] = 0.0f;
+        data[i * numLanes + 1] = 1.0f;
+        data[i * numLanes + 2] = 255.0f;
+    }
+
+    KisIIRGaussianBlur::blurLanes(data.data(), numLanes, length, numLanes,
+                                  KisGaussianKernel::sigmaFromRadius(30));
+
+    // the kernel is normalized and the borders are in the steady state
+    for (int i = 0; i < length; i++) {
+        QVERIFY(qAbs(data[i * numLanes + 0]) < 1e-4);
+        QVERIFY(qAbs(data[i * numLanes + 1] - 1.0f) < 1e-4);
+        QVERIFY(qAbs(data[i * numLanes + 2] - 255.0f) < 1e-2);
+    }
+}
+
+void KisIIRGaussianBlurTest::testMatchesExactKernel_data()
+{
+    QTest::addColumn<qreal>("radius");
+
+    // the recursive blur is used from this radius on
+    QTest::newRow("threshold") << 20.0;
+    QTest::newRow("50") << 50.0;
+}
+
+void KisIIRGaussianBlurTest::testMatchesExactKernel()
+{
+    QFETCH(qreal, radius);
+
+    QVERIFY(KisIIRGaussianBlur::isPreferable(radius, radius));
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    /**
+     * Random noise is smoothed out almost completely by large radii,
+     * so the blurs are compared on sharp edges
+     */
+    const QRect rect(0, 0, 512, 512);
+    const int blockSize = 64;
+
+    KisPaintDeviceSP source = new KisPaintDevice(cs);
+    source->fill(rect, KoColor(Qt::black, cs));
+
+    for (int y = 0; y < rect.height(); y += blockSize) {
+        for (int x = (y / blockSize % 2) * blockSize; x < rect.width(); x += 2 * blockSize) {
+            source->fill(QRect(x, y, blockSize, blockSize), KoColor(Qt::white, cs));
+        }
+    }
+
+    const QBitArray channelFlags(cs->channelCount(), true);
+
+    KisPaintDeviceSP exact = new KisPaintDevice(*source);
+    KisGaussianKernel::applyGaussian(exact, rect, radius, radius, channelFlags, 0);
+
+    KisPaintDeviceSP recursive = new KisPaintDevice(*source);
+    KisIIRGaussianBlur::applyGaussian(recursive, rect, radius, radius, channelFlags, 0);
+
+    KisSequentialConstIterator exactIt(exact, rect);
+    KisSequentialConstIterator recursiveIt(recursive, rect);
+
+    const int pixelSize = cs->pixelSize();
+    int maxDifference = 0;
+    qint64 totalDifference = 0;
+
+    do {
+        const quint8 *exactPixel = exactIt.oldRawData();
+        const quint8 *recursivePixel = recursiveIt.oldRawData();
+
+        for (int i = 0; i < pixelSize; i++) {
+            const int difference = qAbs(int(exactPixel[i]) - int(recursivePixel[i]));
+            maxDifference = qMax(maxDifference, difference);
+            totalDifference += difference;
+        }
+    } while (exactIt.nextPixel() && recursiveIt.nextPixel());
+
+    const qreal meanDifference = qreal(totalDifference) / (rect.width() * rect.height() * pixelSize);
+
+    /**
+     * The exact kernel is cut at three sigmas, while the recursive one
+     * is not, so the results differ by a couple of levels near the
+     * edges at most
+     */
+    QVERIFY2(maxDifference <= 2,
+             qPrintable(QString("max difference is %1").arg(maxDifference)));
+    QVERIFY2(meanDifference <= 0.5,
+             qPrintable(QString("mean difference is %1").arg(meanDifference)));
+}
+
+QTEST_MAIN(KisIIRGaussianBlurTest)
@@ -26,6 +26,11 @@
 #include <QDomDocument>
 #include <QImage>
 
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include "kis_fixed_paint_device.h"
+#include "kis_brush_mask_applicator_base.h"
+
 QImage createQImageFromMask(const KisMaskGenerator& generator)
 {
     QImage image(10, 10, QImage::Format_ARGB32);
@@ -181,5 +186,60 @@ void KisMaskGeneratorTest::testCopyCtorGaussRect()
     testCopyCtor(&gen);
 }
 
+Q_DECLARE_METATYPE(KisMaskGenerator*)
+
+void KisMaskGeneratorTest::testVectorApplicator_data()
+{
+    QTest::addColumn<KisMaskGenerator*>("generator");
+
+    QTest::newRow("circle") << (KisMaskGenerator*) new KisCircleMaskGenerator(47, 0.8, 0.75, 0.85, 2, true);
+    QTest::newRow("rect") << (KisMaskGenerator*) new KisRectangleMaskGenerator(47, 0.8, 0.75, 0.85, 2, true);
+    QTest::newRow("gauss-circle") << (KisMaskGenerator*) new KisGaussCircleMaskGenerator(47, 0.8, 0.75, 0.85, 2, true);
+    QTest::newRow("gauss-rect") << (KisMaskGenerator*) new KisGaussRectangleMaskGenerator(47, 0.8, 0.75, 0.85, 2, true);
+    QTest::newRow("curve-circle") << (KisMaskGenerator*) new KisCurveCircleMaskGenerator(47, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+    QTest::newRow("curve-rect") << (KisMaskGenerator*) new KisCurveRectangleMaskGenerator(47, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+}
+
+void KisMaskGeneratorTest::testVectorApplicator()
+{
+    QFETCH(KisMaskGenerator*, generator);
+    QScopedPointer<KisMaskGenerator> gen(generator);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect bounds(0, 0, 53, 53);
+    const qreal angle = 0.3;
+
+    KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
+    dev->setRect(bounds);
+    dev->initialize();
+    dev->fill(bounds, KoColor(Qt::black, cs));
+
+    MaskProcessingData data(dev, cs, 0.0, 1.0,
+                            0.5 * bounds.width(), 0.5 * bounds.height(), angle);
+
+    KisBrushMaskApplicatorBase *applicator = gen->applicator();
+    applicator->initializeData(&data);
+    applicator->process(bounds);
+
+    const quint8 *pixel = dev->data();
+
+    for (int y = bounds.top(); y <= bounds.bottom(); y++) {
+        for (int x = bounds.left(); x <= bounds.right(); x++) {
+            const qreal x_ = x - data.centerX;
+            const qreal y_ = y - data.centerY;
+            const qreal maskX = data.cosa * x_ - data.sina * y_;
+            const qreal maskY = data.sina * x_ + data.cosa * y_;
+
+            const int expected = 255 - gen->valueAt(maskX, maskY);
+            const int actual = cs->opacityU8(pixel);
+
+            QVERIFY2(qAbs(expected - actual) <= 3,
+                     qPrintable(QString("Vectorized mask differs from KisMaskGenerator::valueAt() at (%1, %2): %3 vs %4")
+                                .arg(x).arg(y).arg(actual).arg(expected)));
+
+            pixel += cs->pixelSize();
+        }
+    }
+}
 
 QTEST_MAIN(KisMaskGeneratorTest)
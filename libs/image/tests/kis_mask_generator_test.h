@@ -37,6 +37,9 @@ private Q_SLOTS:
 
     void testCopyCtorGaussCircle();
     void testCopyCtorGaussRect();
+
+    void testVectorApplicator_data();
+    void testVectorApplicator();
 };
 
 #endif
@@ -479,6 +479,49 @@ void KisPainterTest::testBitBltOldData()
     srcGc.deleteTransaction();
 }
 
+void KisPainterTest::testBltFixedConcurrent()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the dab is intentionally not aligned to the tiles
+    const QRect dabRect(37, 21, 700, 500);
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(QRect(QPoint(), dabRect.size()));
+    dab->initialize();
+
+    quint8 *pixel = dab->data();
+    for (int y = 0; y < dabRect.height(); y++) {
+        for (int x = 0; x < dabRect.width(); x++) {
+            KoColor c(QColor(x % 256, y % 256, (x + y) % 256, (x * y) % 256), cs);
+            memcpy(pixel, c.data(), cs->pixelSize());
+            pixel += cs->pixelSize();
+        }
+    }
+
+    KisPaintDeviceSP dst1 = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst2 = new KisPaintDevice(cs);
+    dst2->setY(13); // shift the tile grid of the second device
+
+    KoColor background(Qt::blue, cs);
+    background.setOpacity(quint8(100));
+    dst1->fill(QRect(0, 0, 800, 600), background);
+    dst2->fill(QRect(0, 0, 800, 600), background);
+
+    KisPainter gc1(dst1);
+    gc1.setOpacity(200);
+    gc1.bltFixed(dabRect.topLeft(), dab, dab->bounds());
+
+    KisPainter gc2(dst2);
+    gc2.setOpacity(200);
+    gc2.bltFixedConcurrent(dabRect.topLeft(), dab, dab->bounds());
+
+    QCOMPARE(gc2.takeDirtyRegion(), gc1.takeDirtyRegion());
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, dst1, dst2));
+}
+
 void KisPainterTest::benchmarkBitBlt()
 {
     quint8 p = 128;
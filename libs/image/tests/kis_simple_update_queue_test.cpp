@@ -277,5 +277,47 @@ void KisSimpleUpdateQueueTest::testSpontaneousJobsCompression()
     QCOMPARE(jobsList[0], job3);
 }
 
+void KisSimpleUpdateQueueTest::testMergeManySmallRects()
+{
+    QRect imageRect(0,0,1024,1024);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "merge test");
+
+    KisPaintLayerSP paintLayer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+
+    image->lock();
+    image->addNode(paintLayer);
+    image->unlock();
+
+    KisTestableSimpleUpdateQueue queue;
+    KisWalkersList& walkersList = queue.getWalkersList();
+
+    /**
+     * Two interleaved strokes of small overlapping dabs, the way
+     * a brush generates them. Each stroke should collapse into
+     * a single walker, but the strokes should not be joined with
+     * each other, because they don't fit into one patch.
+     */
+    for (int y = 0; y <= 480; y += 16) {
+        for (int x = 0; x <= 480; x += 16) {
+            queue.addUpdateJob(paintLayer, QRect(x, y, 24, 24), imageRect, 0);
+            queue.addUpdateJob(paintLayer, QRect(x + 520, y + 520, 24, 24), imageRect, 0);
+        }
+    }
+
+    QCOMPARE(walkersList.size(), 2);
+    QVERIFY(checkWalker(walkersList[0], QRect(0,0,504,504)));
+    QVERIFY(checkWalker(walkersList[1], QRect(520,520,504,504)));
+
+    queue.optimize();
+
+    //must change nothing
+
+    QCOMPARE(walkersList.size(), 2);
+    QVERIFY(checkWalker(walkersList[0], QRect(0,0,504,504)));
+    QVERIFY(checkWalker(walkersList[1], QRect(520,520,504,504)));
+}
+
 QTEST_MAIN(KisSimpleUpdateQueueTest)
 
@@ -36,6 +36,7 @@ private Q_SLOTS:
     void testChecksum();
     void testMixingTypes();
     void testSpontaneousJobsCompression();
+    void testMergeManySmallRects();
 };
 
 #endif /* KIS_SIMPLE_UPDATE_QUEUE_TEST_H */
@@ -95,6 +95,62 @@ void KisUpdaterContextTest::testJobInterference()
     }
 }
 
+void KisUpdaterContextTest::testJobInterferenceManyJobs()
+{
+    KisTestableUpdaterContext context(8);
+
+    QRect imageRect(0,0,100,100);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "merge test");
+
+    KisPaintLayerSP paintLayer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+
+    image->lock();
+    image->addNode(paintLayer);
+    image->unlock();
+
+    // the jobs are added in random order to check the index sorting
+    const int stripes[] = {50, 0, 75, 25};
+
+    context.lock();
+    for (int x : stripes) {
+        KisBaseRectsWalkerSP walker = new KisMergeWalker(imageRect);
+        walker->collectRects(paintLayer, QRect(x,0,20,100));
+        context.addMergeJob(walker);
+    }
+    context.unlock();
+
+    auto isAllowed = [&] (const QRect &dirtyRect) {
+        KisBaseRectsWalkerSP walker = new KisMergeWalker(imageRect);
+        walker->collectRects(paintLayer, dirtyRect);
+
+        context.lock();
+        const bool result = context.isJobAllowed(walker);
+        context.unlock();
+
+        return result;
+    };
+
+    // gaps between the stripes --- allowed
+    QVERIFY(isAllowed(QRect(20,0,5,100)));
+    QVERIFY(isAllowed(QRect(70,0,5,100)));
+    QVERIFY(isAllowed(QRect(95,0,5,100)));
+
+    // overlapping one of the stripes --- forbidden
+    QVERIFY(!isAllowed(QRect(0,0,1,1)));
+    QVERIFY(!isAllowed(QRect(30,50,5,5)));
+    QVERIFY(!isAllowed(QRect(94,0,6,100)));
+
+    // overlapping all the stripes --- forbidden
+    QVERIFY(!isAllowed(QRect(0,40,100,20)));
+
+    // the finished jobs do not interfere
+    context.clear();
+    QVERIFY(isAllowed(QRect(30,50,5,5)));
+    QVERIFY(isAllowed(imageRect));
+}
+
 void KisUpdaterContextTest::testSnapshot()
 {
     KisTestableUpdaterContext context(3);
@@ -27,6 +27,7 @@ class KisUpdaterContextTest : public QObject
 
 private Q_SLOTS:
     void testJobInterference();
+    void testJobInterferenceManyJobs();
     void testSnapshot();
     void stressTestExclusiveJobs();
 };
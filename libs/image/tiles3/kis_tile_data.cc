@@ -38,6 +38,7 @@ const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
 KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store)
     : m_state(NORMAL),
+      m_storeShard(-1),
       m_mementoFlag(0),
       m_age(0),
       m_usersCount(0),
@@ -65,6 +66,7 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
  */
 KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
     : m_state(NORMAL),
+      m_storeShard(-1),
       m_mementoFlag(0),
       m_age(0),
       m_usersCount(0),
@@ -164,6 +166,11 @@ void KisTileData::releaseInternalPools()
         QVector<QByteArray> memoryChunks;
         bool failedToLock = false;
 
+        /**
+         * The iterator unlocks the shards it has passed, but the
+         * collected tile data cannot be freed while we hold their
+         * swap locks, freeTileData() waits for them
+         */
         KisTileDataStoreIterator *iter = KisTileDataStore::instance()->beginIteration();
 
         while(iter->hasNext()) {
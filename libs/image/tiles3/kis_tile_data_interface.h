@@ -204,6 +204,13 @@ private:
      */
     KisTileDataListIterator m_listIterator;
 
+    /**
+     * The shard of the store the tile data is registered in. It is
+     * assigned on the first registration and is kept unchanged when
+     * the tile data is swapped out and in again.
+     */
+    qint32 m_storeShard;
+
 private:
     /**
      * The chunk of the swap file, that corresponds
@@ -194,28 +194,37 @@ void KisTileDataPooler::run()
 
 
         KisTileDataStoreReverseIterator *iter = m_store->beginReverseIteration();
-        QList<KisTileData*> beggers;
-        QList<KisTileData*> donors;
-        qint32 memoryOccupied;
-
-        qint32 statRealMemory;
-        qint32 statHistoricalMemory;
-
-
-        getLists(iter, beggers, donors,
-                 memoryOccupied,
-                 statRealMemory,
-                 statHistoricalMemory);
-
-        m_lastCycleHadWork =
-            processLists(beggers, donors, memoryOccupied);
-
-        m_lastPoolMemoryMetric = memoryOccupied;
-        m_lastRealMemoryMetric = statRealMemory;
-        m_lastHistoricalMemoryMetric = statHistoricalMemory;
+        qint32 memoryOccupied = 0;
+
+        qint32 statRealMemory = 0;
+        qint32 statHistoricalMemory = 0;
+
+        m_lastCycleHadWork = false;
+
+        /**
+         * The iterator locks only one shard of the store at a time,
+         * so the tile data of a shard are processed before the
+         * iterator switches to the next one. The memory occupied
+         * by the shards not visited yet is accounted for in the
+         * next cycle.
+         */
+        while (iter->hasNext()) {
+            QList<KisTileData*> beggers;
+            QList<KisTileData*> donors;
+
+            getLists(iter, beggers, donors,
+                     memoryOccupied,
+                     statRealMemory,
+                     statHistoricalMemory);
+
+            m_lastCycleHadWork |=
+                processLists(beggers, donors, memoryOccupied);
+        }
 
         m_store->endIteration(iter);
 
+        setLastMemoryMetrics(memoryOccupied, statRealMemory, statHistoricalMemory);
+
         DEBUG_TILE_STATISTICS();
         DEBUG_SIMPLE_ACTION("cycle finished");
     }
@@ -226,39 +235,46 @@ void KisTileDataPooler::forceUpdateMemoryStats()
     KIS_SAFE_ASSERT_RECOVER_RETURN(!isRunning());
 
     KisTileDataStoreReverseIterator *iter = m_store->beginReverseIteration();
-    QList<KisTileData*> beggers;
-    QList<KisTileData*> donors;
-    qint32 memoryOccupied;
-
-    qint32 statRealMemory;
-    qint32 statHistoricalMemory;
+    qint32 memoryOccupied = 0;
 
+    qint32 statRealMemory = 0;
+    qint32 statHistoricalMemory = 0;
 
-    getLists(iter, beggers, donors,
-             memoryOccupied,
-             statRealMemory,
-             statHistoricalMemory);
+    while (iter->hasNext()) {
+        QList<KisTileData*> beggers;
+        QList<KisTileData*> donors;
 
-    m_lastPoolMemoryMetric = memoryOccupied;
-    m_lastRealMemoryMetric = statRealMemory;
-    m_lastHistoricalMemoryMetric = statHistoricalMemory;
+        getLists(iter, beggers, donors,
+                 memoryOccupied,
+                 statRealMemory,
+                 statHistoricalMemory);
+    }
 
     m_store->endIteration(iter);
-}
 
-qint64 KisTileDataPooler::lastPoolMemoryMetric() const
-{
-    return m_lastPoolMemoryMetric;
+    setLastMemoryMetrics(memoryOccupied, statRealMemory, statHistoricalMemory);
 }
 
-qint64 KisTileDataPooler::lastRealMemoryMetric() const
+void KisTileDataPooler::setLastMemoryMetrics(qint32 poolMetric,
+                                             qint32 realMetric,
+                                             qint32 historicalMetric)
 {
-    return m_lastRealMemoryMetric;
+    QMutexLocker l(&m_statisticsLock);
+
+    m_lastPoolMemoryMetric = poolMetric;
+    m_lastRealMemoryMetric = realMetric;
+    m_lastHistoricalMemoryMetric = historicalMetric;
 }
 
-qint64 KisTileDataPooler::lastHistoricalMemoryMetric() const
+void KisTileDataPooler::lastMemoryMetrics(qint64 *poolMetric,
+                                          qint64 *realMetric,
+                                          qint64 *historicalMetric) const
 {
-    return m_lastHistoricalMemoryMetric;
+    QMutexLocker l(&m_statisticsLock);
+
+    *poolMetric = m_lastPoolMemoryMetric;
+    *realMetric = m_lastRealMemoryMetric;
+    *historicalMetric = m_lastHistoricalMemoryMetric;
 }
 
 inline int KisTileDataPooler::clonesMetric(KisTileData *td, int numClones) {
@@ -297,9 +313,10 @@ void KisTileDataPooler::getLists(Iter *iter,
                                  qint32 &statRealMemory,
                                  qint32 &statHistoricalMemory)
 {
-    memoryOccupied = 0;
-    statRealMemory = 0;
-    statHistoricalMemory = 0;
+    /**
+     * Collects the tile data of the current shard of the store only,
+     * the counters are accumulated over the calls
+     */
 
     qint32 needMemoryTotal = 0;
     qint32 canDonorMemoryTotal = 0;
@@ -331,6 +348,9 @@ void KisTileDataPooler::getLists(Iter *iter,
         } else {
             statRealMemory += item->pixelSize();
         }
+
+        // the lists must not outlive the lock of the shard
+        if (iter->isShardFinished()) break;
     }
 
     DEBUG_LISTS(memoryOccupied,
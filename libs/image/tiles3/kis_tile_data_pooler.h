@@ -21,6 +21,7 @@
 #include <QObject>
 #include <QThread>
 #include <QSemaphore>
+#include <QMutex>
 
 class KisTileDataStore;
 class KisTileData;
@@ -40,9 +41,13 @@ public:
 
     void testingRereadConfig();
 
-    qint64 lastPoolMemoryMetric() const;
-    qint64 lastRealMemoryMetric() const;
-    qint64 lastHistoricalMemoryMetric() const;
+    /**
+     * Returns the statistics gathered by the last cycle of the pooler.
+     * All three values always belong to the same cycle.
+     */
+    void lastMemoryMetrics(qint64 *poolMetric,
+                           qint64 *realMetric,
+                           qint64 *historicalMetric) const;
 
 
     /**
@@ -77,6 +82,10 @@ protected:
                       qint32 &statRealMemory,
                       qint32 &statHistoricalMemory);
 
+    void setLastMemoryMetrics(qint32 poolMetric,
+                              qint32 realMetric,
+                              qint32 historicalMetric);
+
     bool processLists(QList<KisTileData*> &beggers,
                       QList<KisTileData*> &donors,
                       qint32 &memoryOccupied);
@@ -90,6 +99,7 @@ protected:
     qint32 m_timeout;
     bool m_lastCycleHadWork;
     qint32 m_memoryLimit;
+    mutable QMutex m_statisticsLock;
     qint32 m_lastPoolMemoryMetric;
     qint32 m_lastRealMemoryMetric;
     qint32 m_lastHistoricalMemoryMetric;
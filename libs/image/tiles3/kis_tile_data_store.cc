@@ -20,6 +20,7 @@
 #include "config-memory-leak-tracker.h"
 
 #include <QGlobalStatic>
+#include <QThread>
 
 #include "kis_tile_data_store.h"
 #include "kis_tile_data.h"
@@ -69,10 +70,10 @@ qint64 __preclone_miss_age = 0;
 KisTileDataStore::KisTileDataStore()
     : m_pooler(this),
       m_swapper(this),
+      m_clockShard(0),
       m_numTiles(0),
       m_memoryMetric(0)
 {
-    m_clockIterator = m_tileDataList.end();
     m_pooler.start();
     m_swapper.start();
 }
@@ -102,15 +103,23 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
         m_pooler.forceUpdateMemoryStats();
     }
 
-    QMutexLocker lock(&m_listLock);
-
     MemoryStatistics stats;
 
     const qint64 metricCoeff = KisTileData::WIDTH * KisTileData::HEIGHT;
 
-    stats.realMemorySize = m_pooler.lastRealMemoryMetric() * metricCoeff;
-    stats.historicalMemorySize = m_pooler.lastHistoricalMemoryMetric() * metricCoeff;
-    stats.poolSize = m_pooler.lastPoolMemoryMetric() * metricCoeff;
+    qint64 poolMetric;
+    qint64 realMetric;
+    qint64 historicalMetric;
+
+    /**
+     * The pooler doesn't lock the whole store anymore, so its
+     * statistics are guarded by a lock of their own
+     */
+    m_pooler.lastMemoryMetrics(&poolMetric, &realMetric, &historicalMetric);
+
+    stats.realMemorySize = realMetric * metricCoeff;
+    stats.historicalMemorySize = historicalMetric * metricCoeff;
+    stats.poolSize = poolMetric * metricCoeff;
 
     stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize;
 
@@ -119,36 +128,65 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
     return stats;
 }
 
+qint32 KisTileDataStore::currentThreadShard()
+{
+    /**
+     * Tile data objects created by the same thread go to the same
+     * shard, so the threads doing copy-on-write concurrently
+     * rarely meet on the same lock.
+     */
+    const quint64 id = quint64(quintptr(QThread::currentThreadId()));
+    quint32 h = quint32(id ^ (id >> 32));
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+
+    return h & (NUM_SHARDS - 1);
+}
+
+inline KisTileDataStoreShard* KisTileDataStore::shardForTileData(KisTileData *td)
+{
+    if (td->m_storeShard < 0) {
+        td->m_storeShard = currentThreadShard();
+    }
+
+    return &m_shards[td->m_storeShard];
+}
+
 inline void KisTileDataStore::registerTileDataImp(KisTileData *td)
 {
-    td->m_listIterator = m_tileDataList.insert(m_tileDataList.end(), td);
-    m_numTiles++;
-    m_memoryMetric += td->pixelSize();
+    KisTileDataStoreShard *shard = &m_shards[td->m_storeShard];
+
+    td->m_listIterator = shard->list.insert(shard->list.end(), td);
+    m_numTiles.ref();
+    m_memoryMetric.fetchAndAddOrdered(td->pixelSize());
 }
 
 void KisTileDataStore::registerTileData(KisTileData *td)
 {
-    QMutexLocker lock(&m_listLock);
+    QMutexLocker lock(&shardForTileData(td)->lock);
     registerTileDataImp(td);
 }
 
 inline void KisTileDataStore::unregisterTileDataImp(KisTileData *td)
 {
+    KisTileDataStoreShard *shard = &m_shards[td->m_storeShard];
     KisTileDataListIterator tempIterator = td->m_listIterator;
 
-    if(m_clockIterator == tempIterator) {
-        m_clockIterator = tempIterator + 1;
+    if(shard->clockIterator == tempIterator) {
+        shard->clockIterator = tempIterator + 1;
     }
 
-    td->m_listIterator = m_tileDataList.end();
-    m_tileDataList.erase(tempIterator);
-    m_numTiles--;
-    m_memoryMetric -= td->pixelSize();
+    td->m_listIterator = shard->list.end();
+    shard->list.erase(tempIterator);
+    m_numTiles.deref();
+    m_memoryMetric.fetchAndAddOrdered(-td->pixelSize());
 }
 
 void KisTileDataStore::unregisterTileData(KisTileData *td)
 {
-    QMutexLocker lock(&m_listLock);
+    QMutexLocker lock(&shardForTileData(td)->lock);
     unregisterTileDataImp(td);
 }
 
@@ -184,7 +222,9 @@ void KisTileDataStore::freeTileData(KisTileData *td)
 
     DEBUG_FREE_ACTION(td);
 
-    m_listLock.lock();
+    QMutex *shardLock = &shardForTileData(td)->lock;
+
+    shardLock->lock();
     td->m_swapLock.lockForWrite();
 
     if(!td->data()) {
@@ -195,7 +235,7 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     }
 
     td->m_swapLock.unlock();
-    m_listLock.unlock();
+    shardLock->unlock();
 
     delete td;
 }
@@ -205,6 +245,8 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
 //    dbgKrita << "#### SWAP MISS! ####" << td << ppVar(td->mementoed()) << ppVar(td->age()) << ppVar(td->numUsers());
     checkFreeMemory();
 
+    QMutex *shardLock = &shardForTileData(td)->lock;
+
     td->m_swapLock.lockForRead();
 
     while(!td->data()) {
@@ -214,19 +256,19 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
          * The order of this heavy locking is very important.
          * Change it only in case, you really know what you are doing.
          */
-        m_listLock.lock();
+        shardLock->lock();
 
         /**
          * If someone has managed to load the td from swap, then, most
          * probably, they have already taken the swap lock. This may
          * lead to a deadlock, because COW mechanism breaks lock
-         * ordering rules in duplicateTileData() (it takes m_listLock
-         * while the swap lock is held). In our case it is enough just
-         * to check whether the other thread has already fetched the
-         * data. Please notice that we do not take both of the locks
-         * while checking this, because holding m_listLock is
-         * enough. Nothing can happen to the tile while we hold
-         * m_listLock.
+         * ordering rules in duplicateTileData() (it takes the shard
+         * lock while the swap lock is held). In our case it is enough
+         * just to check whether the other thread has already fetched
+         * the data. Please notice that we do not take both of the
+         * locks while checking this, because holding the shard lock
+         * is enough. Nothing can happen to the tile while we hold
+         * the lock of its shard.
          */
 
         if(!td->data()) {
@@ -238,7 +280,7 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
             td->m_swapLock.unlock();
         }
 
-        m_listLock.unlock();
+        shardLock->unlock();
 
         /**
          * <-- In theory, livelock is possible here...
@@ -251,7 +293,7 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
 bool KisTileDataStore::trySwapTileData(KisTileData *td)
 {
     /**
-     * This function is called with m_listLock acquired
+     * This function is called with the lock of td's shard acquired
      */
 
     bool result = false;
@@ -267,48 +309,49 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+/**
+ * All the iterators lock only one shard at a time, so walking
+ * through the store doesn't stop the world for the other threads
+ */
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
-    m_listLock.lock();
-    return new KisTileDataStoreIterator(m_tileDataList, this);
+    return new KisTileDataStoreIterator(m_shards, NUM_SHARDS, this);
 }
 void KisTileDataStore::endIteration(KisTileDataStoreIterator* iterator)
 {
     delete iterator;
-    m_listLock.unlock();
 }
 
 KisTileDataStoreReverseIterator* KisTileDataStore::beginReverseIteration()
 {
-    m_listLock.lock();
-    return new KisTileDataStoreReverseIterator(m_tileDataList, this);
+    return new KisTileDataStoreReverseIterator(m_shards, NUM_SHARDS, this);
 }
 void KisTileDataStore::endIteration(KisTileDataStoreReverseIterator* iterator)
 {
     delete iterator;
-    m_listLock.unlock();
     DEBUG_REPORT_PRECLONE_EFFICIENCY();
 }
 
 KisTileDataStoreClockIterator* KisTileDataStore::beginClockIteration()
 {
-    m_listLock.lock();
-    return new KisTileDataStoreClockIterator(m_clockIterator, m_tileDataList, this);
+    return new KisTileDataStoreClockIterator(m_clockShard, m_shards, NUM_SHARDS, this);
 }
 void KisTileDataStore::endIteration(KisTileDataStoreClockIterator* iterator)
 {
-    m_clockIterator = iterator->getFinalPosition();
+    m_clockShard = iterator->finish();
     delete iterator;
-    m_listLock.unlock();
 }
 
 void KisTileDataStore::debugPrintList()
 {
-    KisTileData *item;
-    Q_FOREACH (item, m_tileDataList) {
-        dbgTiles << "-------------------------\n"
-                 << "TileData:\t\t\t" << item
-                 << "\n  refCount:\t" << item->m_refCount;
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        Q_FOREACH (KisTileData *item, m_shards[i].list) {
+            dbgTiles << "-------------------------\n"
+                     << "TileData:\t\t\t" << item
+                     << "\n  shard:\t" << i
+                     << "\n  refCount:\t" << item->m_refCount;
+        }
     }
 }
 
@@ -329,17 +372,21 @@ void KisTileDataStore::debugSwapAll()
 
 void KisTileDataStore::debugClear()
 {
-    QMutexLocker lock(&m_listLock);
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        KisTileDataStoreShard &shard = m_shards[i];
+        QMutexLocker lock(&shard.lock);
+
+        Q_FOREACH (KisTileData *item, shard.list) {
+            m_numTiles.deref();
+            m_memoryMetric.fetchAndAddOrdered(-item->pixelSize());
+            delete item;
+        }
 
-    Q_FOREACH (KisTileData *item, m_tileDataList) {
-        delete item;
+        shard.list.clear();
+        shard.clockIterator = shard.list.end();
     }
 
-    m_tileDataList.clear();
-    m_clockIterator = m_tileDataList.end();
-
-    m_numTiles = 0;
-    m_memoryMetric = 0;
+    m_clockShard = 0;
 }
 
 void KisTileDataStore::testingRereadConfig() {
@@ -21,6 +21,8 @@
 #include "kritaimage_export.h"
 
 #include <QReadWriteLock>
+#include <QMutex>
+#include <QAtomicInt>
 #include "kis_tile_data_interface.h"
 
 #include "kis_tile_data_pooler.h"
@@ -31,6 +33,22 @@ class KisTileDataStoreIterator;
 class KisTileDataStoreReverseIterator;
 class KisTileDataStoreClockIterator;
 
+/**
+ * A part of the list of the tile data objects registered in
+ * the store. Every shard has its own lock, so the threads
+ * allocating and freeing tiles do not contend on a single mutex.
+ */
+struct KisTileDataStoreShard
+{
+    KisTileDataStoreShard() {
+        clockIterator = list.end();
+    }
+
+    QMutex lock;
+    KisTileDataList list;
+    KisTileDataListIterator clockIterator;
+};
+
 /**
  * Stores tileData objects. When needed compresses them and swaps.
  */
@@ -60,14 +78,14 @@ public:
      * or in a swap file
      */
     inline qint32 numTiles() const {
-        return m_numTiles + m_swappedStore.numTiles();
+        return m_numTiles.load() + m_swappedStore.numTiles();
     }
 
     /**
      * Returns the number of tiles present in memory only
      */
     inline qint32 numTilesInMemory() const {
-        return m_numTiles;
+        return m_numTiles.load();
     }
 
     inline void checkFreeMemory() {
@@ -78,7 +96,7 @@ public:
      * \see m_memoryMetric
      */
     inline qint64 memoryMetric() const {
-        return m_memoryMetric;
+        return m_memoryMetric.load();
     }
 
     KisTileDataStoreIterator* beginIteration();
@@ -124,10 +142,10 @@ public:
      * and it's swapping is blocked by holding td->m_swapLock
      * in a read mode.
      * PRECONDITIONS: td->m_swapLock is *unlocked*
-     *                m_listRWLock is *unlocked*
+     *                the lock of td's shard is *unlocked*
      * POSTCONDITIONS: td->m_data is in memory and
      *                 td->m_swapLock is locked
-     *                 m_listRWLock is unlocked
+     *                 the lock of td's shard is unlocked
      */
     void ensureTileDataLoaded(KisTileData *td);
 
@@ -140,6 +158,13 @@ private:
     inline void unregisterTileDataImp(KisTileData *td);
     void freeRegisteredTiles();
 
+    inline KisTileDataStoreShard* shardForTileData(KisTileData *td);
+    static inline qint32 currentThreadShard();
+
+    friend class KisTileDataStoreIterator;
+    friend class KisTileDataStoreReverseIterator;
+    friend class KisTileDataStoreClockIterator;
+
     friend class DeadlockyThread;
     friend class KisLowMemoryTests;
     void debugSwapAll();
@@ -159,18 +184,25 @@ private:
     friend class KisTileDataPoolerTest;
     KisSwappedDataStore m_swappedStore;
 
-    KisTileDataListIterator m_clockIterator;
+    /**
+     * The number of shards should be a power of two
+     */
+    static const qint32 NUM_SHARDS = 16;
+    KisTileDataStoreShard m_shards[NUM_SHARDS];
+
+    /**
+     * The shard the clock iterator has stopped at
+     */
+    qint32 m_clockShard;
 
-    QMutex m_listLock;
-    KisTileDataList m_tileDataList;
-    qint32 m_numTiles;
+    QAtomicInt m_numTiles;
 
     /**
      * This metric is used for computing the volume
      * of memory occupied by tile data objects.
      * metric = num_bytes / (KisTileData::WIDTH * KisTileData::HEIGHT)
      */
-    qint64 m_memoryMetric;
+    QAtomicInteger<qint64> m_memoryMetric;
 };
 
 template<typename T>
@@ -23,24 +23,38 @@
  * KisTileDataStoreReverseIterator,
  * KisTileDataStoreClockIterator
  * - are general iterators for the contents of KisTileDataStore.
- * The store starts holding a lock when returns one of such
- * iterators, so noone will be able to change the list while
- * you are iterating.
+ *
+ * The store keeps its tile data objects in several shards. The
+ * iterators lock only the shard they are currently walking through.
+ * It means that the tile data objects returned from one shard may be
+ * freed as soon as the iterator has switched to the next one. Use
+ * isShardFinished() to find out when the pointers collected from the
+ * current shard are still valid.
  *
  * But be careful! You can't change the list while iterating either,
  * because it can invalidate the iterator. This is a general rule.
  */
 
+#include "kis_assert.h"
+#include "kis_tile_data_store.h"
+
 
 class KisTileDataStoreIterator
 {
 public:
-    KisTileDataStoreIterator(KisTileDataList &list, KisTileDataStore *store)
-        : m_list(list),
+    KisTileDataStoreIterator(KisTileDataStoreShard *shards, qint32 numShards, KisTileDataStore *store)
+        : m_shards(shards),
+          m_numShards(numShards),
+          m_shardIndex(0),
           m_store(store)
     {
-        m_iterator = m_list.begin();
-        m_end = m_list.end();
+        enterShard();
+    }
+
+    ~KisTileDataStoreIterator() {
+        if (m_shard) {
+            leaveShard();
+        }
     }
 
     inline KisTileData* peekNext() {
@@ -51,11 +65,33 @@ public:
         return *(m_iterator++);
     }
 
-    inline bool hasNext() const {
-        return m_iterator != m_end;
+    /**
+     * Switches to the next shard when the current one is finished,
+     * that is why the method is not const
+     */
+    inline bool hasNext() {
+        while (m_shard && isShardFinished()) {
+            leaveShard();
+
+            if (++m_shardIndex < m_numShards) {
+                enterShard();
+            }
+        }
+
+        return m_shard;
+    }
+
+    /**
+     * Returns true when all the items of the current shard have
+     * been visited. The shard is still locked at this moment.
+     */
+    inline bool isShardFinished() const {
+        return m_iterator == m_shard->list.end();
     }
 
     inline bool trySwapOut(KisTileData *td) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(td->m_storeShard == m_shardIndex, false);
+
         if(td->m_listIterator == m_iterator)
             m_iterator++;
 
@@ -63,21 +99,41 @@ public:
     }
 
 private:
-    KisTileDataList &m_list;
+    inline void enterShard() {
+        m_shard = &m_shards[m_shardIndex];
+        m_shard->lock.lock();
+        m_iterator = m_shard->list.begin();
+    }
+
+    inline void leaveShard() {
+        m_shard->lock.unlock();
+        m_shard = 0;
+    }
+
+private:
+    KisTileDataStoreShard *m_shards;
+    qint32 m_numShards;
+    qint32 m_shardIndex;
+    KisTileDataStoreShard *m_shard;
     KisTileDataListIterator m_iterator;
-    KisTileDataListIterator m_end;
     KisTileDataStore *m_store;
 };
 
 class KisTileDataStoreReverseIterator
 {
 public:
-    KisTileDataStoreReverseIterator(KisTileDataList &list, KisTileDataStore *store)
-        : m_list(list),
+    KisTileDataStoreReverseIterator(KisTileDataStoreShard *shards, qint32 numShards, KisTileDataStore *store)
+        : m_shards(shards),
+          m_shardIndex(numShards - 1),
           m_store(store)
     {
-        m_iterator = m_list.end();
-        m_begin = m_list.begin();
+        enterShard();
+    }
+
+    ~KisTileDataStoreReverseIterator() {
+        if (m_shard) {
+            leaveShard();
+        }
     }
 
     inline KisTileData* peekNext() {
@@ -88,11 +144,33 @@ public:
         return *(--m_iterator);
     }
 
-    inline bool hasNext() const {
-        return m_iterator != m_begin;
+    /**
+     * Switches to the previous shard when the current one is
+     * finished, that is why the method is not const
+     */
+    inline bool hasNext() {
+        while (m_shard && isShardFinished()) {
+            leaveShard();
+
+            if (--m_shardIndex >= 0) {
+                enterShard();
+            }
+        }
+
+        return m_shard;
+    }
+
+    /**
+     * Returns true when all the items of the current shard have
+     * been visited. The shard is still locked at this moment.
+     */
+    inline bool isShardFinished() const {
+        return m_iterator == m_shard->list.begin();
     }
 
     inline bool trySwapOut(KisTileData *td) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(td->m_storeShard == m_shardIndex, false);
+
         if(td->m_listIterator == m_iterator)
             m_iterator++;
 
@@ -100,57 +178,89 @@ public:
     }
 
 private:
-    KisTileDataList &m_list;
+    inline void enterShard() {
+        m_shard = &m_shards[m_shardIndex];
+        m_shard->lock.lock();
+        m_iterator = m_shard->list.end();
+    }
+
+    inline void leaveShard() {
+        m_shard->lock.unlock();
+        m_shard = 0;
+    }
+
+private:
+    KisTileDataStoreShard *m_shards;
+    qint32 m_shardIndex;
+    KisTileDataStoreShard *m_shard;
     KisTileDataListIterator m_iterator;
-    KisTileDataListIterator m_begin;
     KisTileDataStore *m_store;
 };
 
 class KisTileDataStoreClockIterator
 {
 public:
-    KisTileDataStoreClockIterator(KisTileDataListIterator startItem, KisTileDataList &list, KisTileDataStore *store)
-        : m_list(list),
+    KisTileDataStoreClockIterator(qint32 startShard, KisTileDataStoreShard *shards, qint32 numShards, KisTileDataStore *store)
+        : m_shards(shards),
+          m_numShards(numShards),
+          m_shardIndex(startShard),
+          m_shardsLeft(numShards),
           m_store(store)
     {
-        m_end = m_list.end();
+        enterShard();
+    }
 
-        if(startItem == m_list.begin() ||
-           startItem == m_end) {
-            m_iterator = m_list.begin();
-            m_startItem = m_end;
-            m_endReached = true;
-        }
-        else  {
-            m_startItem = startItem;
-            m_iterator = startItem;
-            m_endReached = false;
-        }
+    ~KisTileDataStoreClockIterator() {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(!m_shard);
     }
 
     inline KisTileData* peekNext() {
-        if(m_iterator == m_end) {
-            m_iterator = m_list.begin();
-            m_endReached = true;
+        if(m_iterator == m_shard->list.end()) {
+            m_iterator = m_shard->list.begin();
         }
 
         return *m_iterator;
     }
 
     inline KisTileData* next() {
-        if(m_iterator == m_end) {
-            m_iterator = m_list.begin();
-            m_endReached = true;
+        if(m_iterator == m_shard->list.end()) {
+            m_iterator = m_shard->list.begin();
         }
 
+        m_itemsLeft--;
         return *(m_iterator++);
     }
 
-    inline bool hasNext() const {
-        return !(m_endReached && m_iterator == m_startItem);
+    /**
+     * Switches to the next shard when the current one is finished,
+     * that is why the method is not const
+     */
+    inline bool hasNext() {
+        while (m_shard && isShardFinished()) {
+            leaveShard();
+
+            if (--m_shardsLeft > 0) {
+                m_shardIndex = (m_shardIndex + 1) & (m_numShards - 1);
+                enterShard();
+            }
+        }
+
+        return m_shard;
+    }
+
+    /**
+     * Returns true when all the items of the current shard have
+     * been visited. The shard is still locked at this moment, so all
+     * the tile data returned since the last switch are still valid
+     * and can be passed to trySwapOut().
+     */
+    inline bool isShardFinished() const {
+        return !m_itemsLeft;
     }
 
     inline bool trySwapOut(KisTileData *td) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(td->m_storeShard == m_shardIndex, false);
+
         if(td->m_listIterator == m_iterator)
             m_iterator++;
 
@@ -159,18 +269,46 @@ public:
 
 private:
     friend class KisTileDataStore;
-    inline KisTileDataListIterator getFinalPosition() {
-        return m_iterator;
+
+    /**
+     * Unlocks the current shard and returns the shard
+     * the next clock iteration should start from
+     */
+    inline qint32 finish() {
+        if (m_shard) {
+            leaveShard();
+        }
+
+        return m_shardIndex;
+    }
+
+    inline void enterShard() {
+        m_shard = &m_shards[m_shardIndex];
+        m_shard->lock.lock();
+
+        m_iterator = m_shard->clockIterator;
+        if (m_iterator == m_shard->list.end()) {
+            m_iterator = m_shard->list.begin();
+        }
+
+        m_itemsLeft = m_shard->list.size();
+    }
+
+    inline void leaveShard() {
+        m_shard->clockIterator = m_iterator;
+        m_shard->lock.unlock();
+        m_shard = 0;
     }
 
 private:
-    KisTileDataList &m_list;
-    bool m_endReached;
+    KisTileDataStoreShard *m_shards;
+    qint32 m_numShards;
+    qint32 m_shardIndex;
+    qint32 m_shardsLeft;
+    KisTileDataStoreShard *m_shard;
+    qint32 m_itemsLeft;
     KisTileDataListIterator m_iterator;
-    KisTileDataListIterator m_startItem;
-    KisTileDataListIterator m_end;
     KisTileDataStore *m_store;
 };
 
 #endif /* KIS_TILE_DATA_STORE_ITERATORS_H_ */
-
@@ -20,6 +20,10 @@
 #ifndef KIS_TILEHASHTABLE_H_
 #define KIS_TILEHASHTABLE_H_
 
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QVector>
+
 #include "kis_tile.h"
 
 
@@ -30,6 +34,20 @@
  * col()/row() methods and be able to answer setNext()/next() requests to
  * be   stored   here.    It   is   used   in   KisTiledDataManager   and
  * KisMementoManager.
+ *
+ * The table is growable. All the modifications are serialized by a
+ * write lock, but the lookups are done lock-free in the first place
+ * (see getTileMinefieldWalk()). When the average chain length exceeds
+ * MAX_LOAD_FACTOR, the bucket array is doubled and the old array is
+ * "retired" to KisTileHashTableReclaimer.
+ *
+ * Every lock-free reader enters an epoch with a
+ * KisTileHashTableReclaimer::ReadGuard before loading the table pointer
+ * and leaves it when the guard is destroyed. A retired array is stamped
+ * with the epoch current at the moment of retiring, and it is freed by
+ * the first reclaim() (done by any table on growing, changing its tiles
+ * or destruction) after all the readers, which entered at that epoch or
+ * earlier, have left.
  */
 
 template<class T>
@@ -96,12 +114,41 @@ public:
     void debugPrintInfo();
     void debugMaxListLength(qint32 &min, qint32 &max);
 
+    /**
+     * The current number of buckets in the table. Used for
+     * debugging and benchmarking only.
+     */
+    qint32 debugTableSize() const;
+
 private:
+    struct Table {
+        Table(qint32 _size)
+            : size(_size),
+              mask(_size - 1),
+              buckets(new TileTypeSP[_size])
+        {
+            Q_ASSERT(!(size & mask));
+        }
+
+        ~Table() {
+            delete[] buckets;
+        }
 
-    TileTypeSP getTileMinefieldWalk(qint32 col, qint32 row, qint32 idx);
-    TileTypeSP getTile(qint32 col, qint32 row, qint32 idx);
-    void linkTile(TileTypeSP tile, qint32 idx);
-    TileTypeSP unlinkTile(qint32 col, qint32 row, qint32 idx);
+        const qint32 size;
+        const quint32 mask;
+        TileTypeSP *buckets;
+
+    private:
+        Q_DISABLE_COPY(Table)
+    };
+
+    TileTypeSP getTileMinefieldWalk(qint32 col, qint32 row, quint32 hash);
+    TileTypeSP getTile(qint32 col, qint32 row, quint32 hash);
+    void linkTile(TileTypeSP tile, quint32 hash);
+    TileTypeSP unlinkTile(qint32 col, qint32 row, quint32 hash);
+
+    void resizeTable(qint32 newSize);
+    static void deleteTable(void *table);
 
     inline void setDefaultTileDataImp(KisTileData *defaultTileData);
     inline KisTileData* defaultTileDataImp() const;
@@ -114,8 +161,14 @@ private:
 private:
     template<class U, class LockerType> friend class KisTileHashTableIteratorTraits;
 
-    static const qint32 TABLE_SIZE = 1024;
-    TileTypeSP *m_hashTable;
+    static const qint32 INITIAL_TABLE_SIZE = 1024;
+    static const qint32 MAX_LOAD_FACTOR = 2;
+
+    /**
+     * The pointer is changed only under the write lock, but
+     * it is read without any locks by the minefield walkers
+     */
+    QAtomicPointer<Table> m_table;
     qint32 m_numTiles;
 
     KisTileData *m_defaultTileData;
@@ -148,9 +201,10 @@ public:
         : m_locker(&ht->m_lock)
     {
         m_hashTable = ht;
+        m_table = ht->m_table.loadAcquire();
         m_index = nextNonEmptyList(0);
-        if (m_index < KisTileHashTableTraits<T>::TABLE_SIZE)
-            m_tile = m_hashTable->m_hashTable[m_index];
+        if (m_index < m_table->size)
+            m_tile = m_table->buckets[m_index];
     }
 
     ~KisTileHashTableIteratorTraits() {
@@ -161,9 +215,9 @@ public:
             m_tile = m_tile->next();
             if (!m_tile) {
                 qint32 idx = nextNonEmptyList(m_index + 1);
-                if (idx < KisTileHashTableTraits<T>::TABLE_SIZE) {
+                if (idx < m_table->size) {
                     m_index = idx;
-                    m_tile = m_hashTable->m_hashTable[idx];
+                    m_tile = m_table->buckets[idx];
                 } else {
                     //EOList reached
                     m_index = -1;
@@ -187,8 +241,8 @@ public:
         TileTypeSP tile = m_tile;
         next();
 
-        const qint32 idx = m_hashTable->calculateHash(tile->col(), tile->row());
-        m_hashTable->unlinkTile(tile->col(), tile->row(), idx);
+        const quint32 hash = m_hashTable->calculateHash(tile->col(), tile->row());
+        m_hashTable->unlinkTile(tile->col(), tile->row(), hash);
     }
 
     // disable the method if we didn't lock for writing
@@ -198,8 +252,8 @@ public:
         TileTypeSP tile = m_tile;
         next();
 
-        const qint32 idx = m_hashTable->calculateHash(tile->col(), tile->row());
-        m_hashTable->unlinkTile(tile->col(), tile->row(), idx);
+        const quint32 hash = m_hashTable->calculateHash(tile->col(), tile->row());
+        m_hashTable->unlinkTile(tile->col(), tile->row(), hash);
 
         newHashTable->addTile(tile);
     }
@@ -210,12 +264,18 @@ protected:
     KisTileHashTableTraits<T> *m_hashTable;
     LockerType m_locker;
 
+    /**
+     * The table cannot be resized while we hold the lock, so
+     * it is safe to cache the bucket array
+     */
+    typename KisTileHashTableTraits<T>::Table *m_table;
+
 protected:
     qint32 nextNonEmptyList(qint32 startIdx) {
         qint32 idx = startIdx;
 
-        while (idx < KisTileHashTableTraits<T>::TABLE_SIZE &&
-                !m_hashTable->m_hashTable[idx]) {
+        while (idx < m_table->size &&
+                !m_table->buckets[idx]) {
             idx++;
         }
 
@@ -20,6 +20,7 @@
 #include <QtGlobal>
 #include "kis_debug.h"
 #include "kis_global.h"
+#include "kis_tile_hash_table_reclaimer.h"
 
 //#define SHARED_TILES_SANITY_CHECK
 
@@ -28,8 +29,9 @@ template<class T>
 KisTileHashTableTraits<T>::KisTileHashTableTraits(KisMementoManager *mm)
         : m_lock(QReadWriteLock::NonRecursive)
 {
-    m_hashTable = new TileTypeSP [TABLE_SIZE];
-    Q_CHECK_PTR(m_hashTable);
+    Table *table = new Table(INITIAL_TABLE_SIZE);
+    Q_CHECK_PTR(table);
+    m_table.store(table);
 
     m_numTiles = 0;
     m_defaultTileData = 0;
@@ -47,17 +49,18 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T
     m_defaultTileData = 0;
     setDefaultTileDataImp(ht.m_defaultTileData);
 
-    m_hashTable = new TileTypeSP [TABLE_SIZE];
-    Q_CHECK_PTR(m_hashTable);
+    const Table *foreignTable = ht.m_table.loadAcquire();
+    Table *table = new Table(foreignTable->size);
+    Q_CHECK_PTR(table);
 
 
     TileTypeSP foreignTile;
     TileTypeSP nativeTile;
     TileTypeSP nativeTileHead;
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
+    for (qint32 i = 0; i < foreignTable->size; i++) {
         nativeTileHead = 0;
 
-        foreignTile = ht.m_hashTable[i];
+        foreignTile = foreignTable->buckets[i];
         while (foreignTile) {
             nativeTile = TileTypeSP(new TileType(*foreignTile, m_mementoManager));
             nativeTile->setNext(nativeTileHead);
@@ -66,8 +69,10 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T
             foreignTile = foreignTile->next();
         }
 
-        m_hashTable[i] = nativeTileHead;
+        table->buckets[i] = nativeTileHead;
     }
+
+    m_table.store(table);
     m_numTiles = ht.m_numTiles;
 }
 
@@ -75,19 +80,36 @@ template<class T>
 KisTileHashTableTraits<T>::~KisTileHashTableTraits()
 {
     clear();
-    delete[] m_hashTable;
+
+    delete m_table.load();
     setDefaultTileDataImp(0);
+
+    KisTileHashTableReclaimer::reclaim();
 }
 
 template<class T>
 quint32 KisTileHashTableTraits<T>::calculateHash(qint32 col, qint32 row)
 {
-    return ((row << 5) + (col & 0x1F)) & 0x3FF;
+    /**
+     * The table size is not fixed anymore, so we cannot just fold
+     * the coordinates into the lower bits. Use the finalizer of
+     * MurmurHash3 to spread the neighbouring tiles uniformly
+     * over the buckets of any power-of-two sized table.
+     */
+    quint32 h = (quint32(row) << 16) ^ quint32(col);
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+
+    return h;
 }
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, quint32 hash)
 {
     /**
      * This is a special method for dangerous and unsafe access to
@@ -96,16 +118,29 @@ KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 i
      * having any locks help. In the worst case, we will miss the needed
      * tile. In that case, the higher level code will do the proper
      * locking and do the second try with all the needed locks held.
+     *
+     * The table itself may be resized concurrently. The old buckets
+     * array is not freed while the read guard exists, so we can
+     * safely walk it, though the chains might have already been
+     * relinked into the new array. In such a case we will just
+     * miss the tile and fall back to the locked path.
      */
 
-    TileTypeSP headTile = m_hashTable[idx];
+    KisTileHashTableReclaimer::ReadGuard guard;
+
+    Table *table = m_table.loadAcquire();
+    const qint32 idx = hash & table->mask;
+
+    TileTypeSP headTile = table->buckets[idx];
     TileTypeSP tile = headTile;
 
     for (; tile; tile = tile->next()) {
         if (tile->col() == col &&
             tile->row() == row) {
 
-            if (m_hashTable[idx] != headTile) {
+            if (m_table.loadAcquire() != table ||
+                table->buckets[idx] != headTile) {
+
                 tile.clear();
             }
 
@@ -118,9 +153,10 @@ KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 i
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, quint32 hash)
 {
-    TileTypeSP tile = m_hashTable[idx];
+    Table *table = m_table.loadAcquire();
+    TileTypeSP tile = table->buckets[hash & table->mask];
 
     for (; tile; tile = tile->next()) {
         if (tile->col() == col &&
@@ -134,9 +170,12 @@ KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, qint32 idx)
 }
 
 template<class T>
-void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, qint32 idx)
+void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, quint32 hash)
 {
-    TileTypeSP firstTile = m_hashTable[idx];
+    Table *table = m_table.loadAcquire();
+    const qint32 idx = hash & table->mask;
+
+    TileTypeSP firstTile = table->buckets[idx];
 
 #ifdef SHARED_TILES_SANITY_CHECK
     Q_ASSERT_X(!tile->next(), "KisTileHashTableTraits<T>::linkTile",
@@ -144,15 +183,24 @@ void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, qint32 idx)
 #endif
 
     tile->setNext(firstTile);
-    m_hashTable[idx] = tile;
+    table->buckets[idx] = tile;
     m_numTiles++;
+
+    if (m_numTiles > table->size * MAX_LOAD_FACTOR) {
+        resizeTable(2 * table->size);
+    } else {
+        KisTileHashTableReclaimer::reclaim();
+    }
 }
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, quint32 hash)
 {
-    TileTypeSP tile = m_hashTable[idx];
+    Table *table = m_table.loadAcquire();
+    const qint32 idx = hash & table->mask;
+
+    TileTypeSP tile = table->buckets[idx];
     TileTypeSP prevTile;
 
     for (; tile; tile = tile->next()) {
@@ -163,7 +211,7 @@ KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, qint32 idx)
                 prevTile->setNext(tile->next());
             else
                 /* optimize here*/
-                m_hashTable[idx] = tile->next();
+                table->buckets[idx] = tile->next();
 
             /**
              * The shared pointer may still be accessed by someone, so
@@ -183,6 +231,49 @@ KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, qint32 idx)
     return TileTypeSP();
 }
 
+template<class T>
+void KisTileHashTableTraits<T>::resizeTable(qint32 newSize)
+{
+    /**
+     * We assume the write lock is already held. The tiles are
+     * relinked into the new array before it is published, so the
+     * lock-free readers of the old array may miss some tiles, but
+     * never get a wrong one.
+     */
+
+    Table *oldTable = m_table.loadAcquire();
+    Table *newTable = new Table(newSize);
+    Q_CHECK_PTR(newTable);
+
+    for (qint32 i = 0; i < oldTable->size; i++) {
+        TileTypeSP tile = oldTable->buckets[i];
+
+        while (tile) {
+            TileTypeSP nextTile = tile->next();
+
+            const qint32 idx = calculateHash(tile->col(), tile->row()) & newTable->mask;
+            tile->setNext(newTable->buckets[idx]);
+            newTable->buckets[idx] = tile;
+
+            tile = nextTile;
+        }
+    }
+
+    /**
+     * The new table is published with an ordered operation, so
+     * every walker that enters after the retirement will see the
+     * new table only.
+     */
+    m_table.fetchAndStoreOrdered(newTable);
+    KisTileHashTableReclaimer::retire(oldTable, &KisTileHashTableTraits<T>::deleteTable);
+}
+
+template<class T>
+void KisTileHashTableTraits<T>::deleteTable(void *table)
+{
+    delete static_cast<Table*>(table);
+}
+
 template<class T>
 inline void KisTileHashTableTraits<T>::setDefaultTileDataImp(KisTileData *defaultTileData)
 {
@@ -204,6 +295,13 @@ inline KisTileData* KisTileHashTableTraits<T>::defaultTileDataImp() const
 }
 
 
+template<class T>
+qint32 KisTileHashTableTraits<T>::debugTableSize() const
+{
+    QReadLocker locker(&m_lock);
+    return m_table.loadAcquire()->size;
+}
+
 template<class T>
 bool KisTileHashTableTraits<T>::tileExists(qint32 col, qint32 row)
 {
@@ -214,15 +312,15 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getExistingTile(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
     if (tile) return tile;
 
     // then try with a proper locking
     QReadLocker locker(&m_lock);
-    return getTile(col, row, idx);
+    return getTile(col, row, hash);
 }
 
 template<class T>
@@ -230,20 +328,20 @@ typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getTileLazy(qint32 col, qint32 row,
                                        bool& newTile)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
     newTile = false;
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
 
     // then try with a proper locking
     if (!tile) {
         QWriteLocker locker(&m_lock);
-        tile = getTile(col, row, idx);
+        tile = getTile(col, row, hash);
 
         if (!tile) {
             tile = new TileType(col, row, m_defaultTileData, m_mementoManager);
-            linkTile(tile, idx);
+            linkTile(tile, hash);
             newTile = true;
         }
     }
@@ -255,10 +353,10 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
     if (tile) return tile;
 
 
@@ -266,7 +364,7 @@ KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
     {
         QReadLocker locker(&m_lock);
 
-        tile = getTile(col, row, idx);
+        tile = getTile(col, row, hash);
         if (!tile) {
             tile = new TileType(col, row, m_defaultTileData, 0);
         }
@@ -278,19 +376,19 @@ KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 template<class T>
 void KisTileHashTableTraits<T>::addTile(TileTypeSP tile)
 {
-    const qint32 idx = calculateHash(tile->col(), tile->row());
+    const quint32 hash = calculateHash(tile->col(), tile->row());
 
     QWriteLocker locker(&m_lock);
-    linkTile(tile, idx);
+    linkTile(tile, hash);
 }
 
 template<class T>
 void KisTileHashTableTraits<T>::deleteTile(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     QWriteLocker locker(&m_lock);
-    TileTypeSP tile = unlinkTile(col, row, idx);
+    TileTypeSP tile = unlinkTile(col, row, hash);
 
     /* Done by KisSharedPtr */
     //if(tile)
@@ -311,8 +409,10 @@ void KisTileHashTableTraits<T>::clear()
     TileTypeSP tile = TileTypeSP();
     qint32 i;
 
-    for (i = 0; i < TABLE_SIZE; i++) {
-        tile = m_hashTable[i];
+    Table *table = m_table.loadAcquire();
+
+    for (i = 0; i < table->size; i++) {
+        tile = table->buckets[i];
 
         while (tile) {
             TileTypeSP tmp = tile;
@@ -329,10 +429,21 @@ void KisTileHashTableTraits<T>::clear()
             m_numTiles--;
         }
 
-        m_hashTable[i] = 0;
+        table->buckets[i] = 0;
     }
 
     Q_ASSERT(!m_numTiles);
+
+    /**
+     * Shrink the table back to its initial size, the cleared
+     * device is not going to need that many buckets anymore
+     */
+    if (table->size > INITIAL_TABLE_SIZE) {
+        m_table.fetchAndStoreOrdered(new Table(INITIAL_TABLE_SIZE));
+        KisTileHashTableReclaimer::retire(table, &KisTileHashTableTraits<T>::deleteTable);
+    } else {
+        KisTileHashTableReclaimer::reclaim();
+    }
 }
 
 template<class T>
@@ -360,7 +471,8 @@ void KisTileHashTableTraits<T>::debugPrintInfo()
     qDebug() << "==========================\n"
              << "TileHashTable:"
              << "\n   def. data:\t\t" << m_defaultTileData
-             << "\n   numTiles:\t\t" << m_numTiles;
+             << "\n   numTiles:\t\t" << m_numTiles
+             << "\n   tableSize:\t\t" << m_table.loadAcquire()->size;
     debugListLengthDistibution();
     qDebug() << "==========================\n";
 }
@@ -369,7 +481,7 @@ template<class T>
 qint32 KisTileHashTableTraits<T>::debugChainLen(qint32 idx)
 {
     qint32 len = 0;
-    for (TileTypeSP it = m_hashTable[idx]; it; it = it->next(), len++) ;
+    for (TileTypeSP it = m_table.loadAcquire()->buckets[idx]; it; it = it->next(), len++) ;
     return len;
 }
 
@@ -381,7 +493,9 @@ void KisTileHashTableTraits<T>::debugMaxListLength(qint32 &min, qint32 &max)
     qint32 minLen = m_numTiles;
     qint32 tmp = 0;
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
+    const qint32 tableSize = m_table.loadAcquire()->size;
+
+    for (qint32 i = 0; i < tableSize; i++) {
         tmp = debugChainLen(i);
         if (tmp > maxLen)
             maxLen = tmp;
@@ -406,7 +520,9 @@ void KisTileHashTableTraits<T>::debugListLengthDistibution()
     qint32 *array = new qint32[arraySize];
     memset(array, 0, sizeof(qint32)*arraySize);
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
+    const qint32 tableSize = m_table.loadAcquire()->size;
+
+    for (qint32 i = 0; i < tableSize; i++) {
         tmp = debugChainLen(i);
         array[tmp-min]++;
     }
@@ -433,8 +549,10 @@ void KisTileHashTableTraits<T>::sanityChecksumCheck()
     TileTypeSP tile = 0;
     qint32 exactNumTiles = 0;
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
-        tile = m_hashTable[i];
+    Table *table = m_table.loadAcquire();
+
+    for (qint32 i = 0; i < table->size; i++) {
+        tile = table->buckets[i];
         while (tile) {
             exactNumTiles++;
             tile = tile->next();
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_hash_table_reclaimer.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+#include <QVector>
+
+#include "kis_debug.h"
+
+
+/**
+ * Zero means the thread is not inside a read section, otherwise it is
+ * the epoch the section was entered at. The padding keeps the slots of
+ * different threads in different cache lines.
+ */
+struct KisTileHashTableReclaimer::Slot
+{
+    Slot() : inUse(false) {}
+
+    QAtomicInt epoch;
+    bool inUse;
+    char padding[64 - sizeof(QAtomicInt) - sizeof(bool)];
+};
+
+namespace {
+
+struct RetiredObject {
+    void *object;
+    KisTileHashTableReclaimer::Deleter deleter;
+    int epoch;
+};
+
+struct SlotHolder;
+
+struct Registry {
+    Registry() : epoch(1) {}
+
+    ~Registry() {
+        Q_FOREACH (const RetiredObject &retired, retiredObjects) {
+            retired.deleter(retired.object);
+        }
+        qDeleteAll(slots);
+    }
+
+    QMutex lock;
+    QAtomicInt epoch;
+    QVector<KisTileHashTableReclaimer::Slot*> slots;
+    QVector<RetiredObject> retiredObjects;
+    QThreadStorage<SlotHolder*> threadSlots;
+};
+
+Q_GLOBAL_STATIC(Registry, s_registry)
+
+/**
+ * Returns the slot to the registry when the thread finishes
+ */
+struct SlotHolder {
+    SlotHolder(KisTileHashTableReclaimer::Slot *_slot) : slot(_slot) {}
+
+    ~SlotHolder() {
+        if (s_registry.isDestroyed()) return;
+
+        QMutexLocker l(&s_registry->lock);
+        slot->inUse = false;
+    }
+
+    KisTileHashTableReclaimer::Slot *slot;
+};
+
+KisTileHashTableReclaimer::Slot* threadSlot()
+{
+    Registry *registry = s_registry;
+    SlotHolder *holder = registry->threadSlots.localData();
+
+    if (!holder) {
+        QMutexLocker l(&registry->lock);
+
+        KisTileHashTableReclaimer::Slot *slot = 0;
+
+        Q_FOREACH (KisTileHashTableReclaimer::Slot *freeSlot, registry->slots) {
+            if (!freeSlot->inUse) {
+                slot = freeSlot;
+                break;
+            }
+        }
+
+        if (!slot) {
+            slot = new KisTileHashTableReclaimer::Slot();
+            registry->slots.append(slot);
+        }
+
+        slot->inUse = true;
+        holder = new SlotHolder(slot);
+        registry->threadSlots.setLocalData(holder);
+    }
+
+    return holder->slot;
+}
+
+void reclaimImpl(Registry *registry)
+{
+    int minActiveEpoch = -1;
+
+    Q_FOREACH (KisTileHashTableReclaimer::Slot *slot, registry->slots) {
+        const int epoch = slot->epoch.loadAcquire();
+        if (epoch && (minActiveEpoch < 0 || epoch < minActiveEpoch)) {
+            minActiveEpoch = epoch;
+        }
+    }
+
+    QVector<RetiredObject> stillRetired;
+
+    Q_FOREACH (const RetiredObject &retired, registry->retiredObjects) {
+        if (minActiveEpoch < 0 || retired.epoch < minActiveEpoch) {
+            retired.deleter(retired.object);
+        } else {
+            stillRetired.append(retired);
+        }
+    }
+
+    registry->retiredObjects.swap(stillRetired);
+}
+
+}
+
+QAtomicInt KisTileHashTableReclaimer::s_hasRetiredObjects;
+
+KisTileHashTableReclaimer::ReadGuard::ReadGuard()
+    : m_slot(threadSlot())
+{
+    /**
+     * The ordered exchange makes the slot visible to the reclaiming
+     * thread before the reader loads any pointer to the table
+     */
+    m_slot->epoch.fetchAndStoreOrdered(s_registry->epoch.loadAcquire());
+}
+
+KisTileHashTableReclaimer::ReadGuard::~ReadGuard()
+{
+    m_slot->epoch.storeRelease(0);
+}
+
+void KisTileHashTableReclaimer::retire(void *object, Deleter deleter)
+{
+    Registry *registry = s_registry;
+    QMutexLocker l(&registry->lock);
+
+    RetiredObject retired;
+    retired.object = object;
+    retired.deleter = deleter;
+    retired.epoch = registry->epoch.fetchAndAddOrdered(1);
+
+    registry->retiredObjects.append(retired);
+    reclaimImpl(registry);
+
+    s_hasRetiredObjects.storeRelease(!registry->retiredObjects.isEmpty());
+}
+
+void KisTileHashTableReclaimer::reclaim()
+{
+    if (!s_hasRetiredObjects.loadAcquire()) return;
+
+    Registry *registry = s_registry;
+    QMutexLocker l(&registry->lock);
+
+    reclaimImpl(registry);
+    s_hasRetiredObjects.storeRelease(!registry->retiredObjects.isEmpty());
+}
+
+int KisTileHashTableReclaimer::numRetiredObjects()
+{
+    Registry *registry = s_registry;
+    QMutexLocker l(&registry->lock);
+
+    return registry->retiredObjects.size();
+}
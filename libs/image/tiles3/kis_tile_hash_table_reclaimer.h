@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_TILE_HASH_TABLE_RECLAIMER_H
+#define KIS_TILE_HASH_TABLE_RECLAIMER_H
+
+#include <QAtomicInt>
+
+#include "kritaimage_export.h"
+
+/**
+ * Epoch-based reclamation of the bucket arrays of the tile hash tables.
+ *
+ * The lock-free readers of the tables (the minefield walkers) enter a
+ * read section with ReadGuard. Every thread has its own slot, which
+ * lives in its own cache line, so entering and leaving the section
+ * doesn't touch any memory shared with other readers.
+ *
+ * A retired object is stamped with the current global epoch, then the
+ * epoch is incremented. The object is deleted when no thread is inside
+ * a read section, which was entered at the stamped epoch or earlier.
+ *
+ * The retired objects are shared by all the tables, so any table that
+ * retires an object, changes its tiles, or is destroyed reclaims the
+ * objects retired by the others as well.
+ */
+class KRITAIMAGE_EXPORT KisTileHashTableReclaimer
+{
+public:
+    struct Slot;
+
+    /**
+     * Keeps the retired objects alive while the guard exists. The
+     * guards should not be nested.
+     */
+    class KRITAIMAGE_EXPORT ReadGuard
+    {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+
+    private:
+        Q_DISABLE_COPY(ReadGuard)
+        Slot *m_slot;
+    };
+
+    typedef void (*Deleter)(void *object);
+
+    /**
+     * Deletes \p object with \p deleter, when no reader may access it
+     * anymore. The object should already be unreachable for the readers
+     * that will enter their sections after this call.
+     */
+    static void retire(void *object, Deleter deleter);
+
+    /**
+     * Deletes the retired objects, which are not accessible by the
+     * readers anymore. It is cheap when nothing is retired.
+     */
+    static void reclaim();
+
+    /**
+     * The number of objects waiting for deletion. Used for testing only.
+     */
+    static int numRetiredObjects();
+
+private:
+    static QAtomicInt s_hasRetiredObjects;
+};
+
+#endif // KIS_TILE_HASH_TABLE_RECLAIMER_H
@@ -20,6 +20,8 @@
 
 #include <QRect>
 #include <QVector>
+#include <QThread>
+#include <QtConcurrent>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
@@ -28,8 +30,10 @@
 #include "kis_memento_manager.h"
 #include "swap/kis_legacy_tile_compressor.h"
 #include "swap/kis_tile_compressor_factory.h"
+#include "swap/kis_tile_compressor_2.h"
 
 #include "kis_paint_device_writer.h"
+#include "kis_image_config.h"
 
 #include "kis_global.h"
 
@@ -114,6 +118,110 @@ void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
 }
 
+namespace {
+
+/**
+ * The number of tiles compressed by a single job of the parallel
+ * save. The jobs are big enough to amortize the creation of the
+ * compressor and small enough to keep all the cores busy.
+ */
+const int TILES_PER_SAVE_JOB = 16;
+
+/**
+ * A writer that collects the compressed tiles in memory, so that
+ * they could be streamed to the real store in the original order
+ */
+class KisBufferPaintDeviceWriter : public KisPaintDeviceWriter {
+public:
+    bool write(const QByteArray &data) override {
+        m_buffer.append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_buffer.append(data, length);
+        return true;
+    }
+
+    QByteArray m_buffer;
+};
+
+struct KisTileSaveJob {
+    QVector<KisTileSP> tiles;
+    QByteArray data;
+    bool result = true;
+};
+
+struct KisTileSaveJobProcessor {
+    KisTileSaveJobProcessor(const QString &compressionName)
+        : m_compressionName(compressionName)
+    {
+    }
+
+    void operator() (KisTileSaveJob &job) {
+        /**
+         * Compressors keep their work buffers inside, so every job
+         * needs its own instance
+         */
+        KisAbstractTileCompressorSP compressor =
+            KisTileCompressorFactory::create(KisTiledDataManager::CURRENT_VERSION, m_compressionName);
+
+        KisBufferPaintDeviceWriter writer;
+        Q_FOREACH (KisTileSP tile, job.tiles) {
+            job.result = compressor->writeTile(tile, writer);
+            if (!job.result) break;
+        }
+
+        job.tiles.clear();
+        job.data.swap(writer.m_buffer);
+    }
+
+    QString m_compressionName;
+};
+
+/**
+ * The number of tiles decompressed by a single job of the parallel load
+ */
+const int TILES_PER_LOAD_JOB = 16;
+
+struct KisTileLoadJob {
+    QVector<KisTileCompressor2::TileRecord> records;
+    bool result = true;
+};
+
+struct KisTileLoadJobProcessor {
+    void operator() (KisTileLoadJob &job) {
+        KisTileCompressor2 compressor;
+
+        for (auto it = job.records.begin(); it != job.records.end(); ++it) {
+            if (!compressor.decompressTileRecord(*it)) {
+                job.result = false;
+            }
+        }
+    }
+};
+
+/**
+ * The tiles are locked by the reading thread, so they should
+ * be unlocked by it as well
+ */
+bool finishTileLoadJobs(QVector<KisTileLoadJob> &jobs)
+{
+    bool result = true;
+
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        Q_FOREACH (const KisTileCompressor2::TileRecord &record, it->records) {
+            record.tile->unlock();
+        }
+        result &= it->result;
+    }
+
+    jobs.clear();
+    return result;
+}
+
+}
+
 bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
 {
     QReadLocker locker(&m_lock);
@@ -129,24 +237,91 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
         retval = writeTilesHeader(store, m_hashTable->numTiles());
     }
 
+    const QString compressionName = KisImageConfig(true).saveTilesCompression();
+
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
 
     KisTileHashTableConstIterator iter(m_hashTable);
     KisTileSP tile;
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
-
     while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
-        }
+        tiles.append(tile);
         iter.next();
     }
 
+    const int numThreads = QThread::idealThreadCount();
+
+    if (numThreads <= 1 || tiles.size() < 2 * TILES_PER_SAVE_JOB) {
+        KisAbstractTileCompressorSP compressor =
+            KisTileCompressorFactory::create(CURRENT_VERSION, compressionName);
+
+        Q_FOREACH (KisTileSP tile, tiles) {
+            retval = compressor->writeTile(tile, store);
+            if (!retval) {
+                warnFile << "Failed to write tile";
+                break;
+            }
+        }
+
+        return retval;
+    }
+
+    /**
+     * The tiles are compressed by the pool of workers in batches, each
+     * job into its own buffer. While one batch is being compressed, the
+     * previous one is streamed into the store in the original order, so
+     * the output is byte-for-byte the same as the one of the sequential
+     * save. Only two batches are kept in memory at a time.
+     */
+    const int jobsPerBatch = 2 * numThreads;
+    const int tilesPerBatch = jobsPerBatch * TILES_PER_SAVE_JOB;
+
+    KisTileSaveJobProcessor processor(compressionName);
+
+    QVector<KisTileSaveJob> currentBatch;
+    QVector<KisTileSaveJob> nextBatch;
+    QFuture<void> nextBatchFuture;
+
+    auto prepareBatch = [&tiles, tilesPerBatch] (int batchStart, QVector<KisTileSaveJob> &batch) {
+        batch.clear();
+        const int batchEnd = qMin(batchStart + tilesPerBatch, tiles.size());
+
+        for (int i = batchStart; i < batchEnd; i += TILES_PER_SAVE_JOB) {
+            KisTileSaveJob job;
+            job.tiles = tiles.mid(i, qMin(TILES_PER_SAVE_JOB, batchEnd - i));
+            batch.append(job);
+        }
+    };
+
+    prepareBatch(0, nextBatch);
+    nextBatchFuture = QtConcurrent::map(nextBatch, processor);
+
+    for (int batchStart = 0; batchStart < tiles.size(); batchStart += tilesPerBatch) {
+        nextBatchFuture.waitForFinished();
+        currentBatch.swap(nextBatch);
+
+        const int nextBatchStart = batchStart + tilesPerBatch;
+        if (retval && nextBatchStart < tiles.size()) {
+            prepareBatch(nextBatchStart, nextBatch);
+            nextBatchFuture = QtConcurrent::map(nextBatch, processor);
+        }
+
+        for (auto it = currentBatch.begin(); retval && it != currentBatch.end(); ++it) {
+            retval = it->result && store.write(it->data);
+            if (!retval) {
+                warnFile << "Failed to write tile";
+            }
+        }
+
+        if (!retval) break;
+    }
+
+    nextBatchFuture.waitForFinished();
+
     return retval;
 }
+
 bool KisTiledDataManager::read(QIODevice *stream)
 {
     if (!stream) return false;
@@ -182,16 +357,71 @@ bool KisTiledDataManager::read(QIODevice *stream)
         numTiles = line.toUInt();
     }
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(tilesVersion);
-
     bool readSuccess = true;
-    for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
-            readSuccess = false;
+    const int numThreads = QThread::idealThreadCount();
+
+    if (tilesVersion != CURRENT_VERSION ||
+        numThreads <= 1 || numTiles < 2 * TILES_PER_LOAD_JOB) {
+
+        KisAbstractTileCompressorSP compressor =
+            KisTileCompressorFactory::create(tilesVersion);
+
+        for (quint32 i = 0; i < numTiles; i++) {
+            if (!compressor->readTile(stream, this)) {
+                readSuccess = false;
+            }
+        }
+
+        m_mementoManager->commit();
+        return readSuccess;
+    }
+
+    /**
+     * Parsing the stream and creating the tiles is done by the
+     * current thread, because neither the stream, nor the memento
+     * manager are thread-safe. The decompression of the tiles is
+     * done by the pool of workers. While one batch of tiles is being
+     * decompressed, the next one is read from the stream.
+     */
+    const int jobsPerBatch = 2 * numThreads;
+
+    KisTileCompressor2 compressor;
+    KisTileLoadJobProcessor processor;
+
+    QVector<KisTileLoadJob> currentBatch;
+    QVector<KisTileLoadJob> decodedBatch;
+    QFuture<void> decodedBatchFuture;
+
+    quint32 tilesRead = 0;
+
+    while (tilesRead < numTiles) {
+        currentBatch.clear();
+
+        for (int i = 0; i < jobsPerBatch && tilesRead < numTiles; i++) {
+            KisTileLoadJob job;
+
+            for (int j = 0; j < TILES_PER_LOAD_JOB && tilesRead < numTiles; j++, tilesRead++) {
+                KisTileCompressor2::TileRecord record;
+                if (compressor.readTileRecord(stream, this, record)) {
+                    job.records.append(record);
+                } else {
+                    readSuccess = false;
+                }
+            }
+
+            currentBatch.append(job);
         }
+
+        decodedBatchFuture.waitForFinished();
+        readSuccess &= finishTileLoadJobs(decodedBatch);
+
+        decodedBatch.swap(currentBatch);
+        decodedBatchFuture = QtConcurrent::map(decodedBatch, processor);
     }
 
+    decodedBatchFuture.waitForFinished();
+    readSuccess &= finishTileLoadJobs(decodedBatch);
+
     m_mementoManager->commit();
     return readSuccess;
 }
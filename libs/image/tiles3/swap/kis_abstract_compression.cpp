@@ -18,6 +18,14 @@
 
 #include "kis_abstract_compression.h"
 
+#include <config-lz4.h>
+
+#include "kis_lzf_compression.h"
+
+#ifdef HAVE_LZ4
+#include "kis_lz4_compression.h"
+#endif
+
 KisAbstractCompression::KisAbstractCompression()
 {
 }
@@ -31,9 +39,90 @@ void KisAbstractCompression::adjustForDataSize(qint32 dataSize)
     Q_UNUSED(dataSize);
 }
 
+KisAbstractCompression* KisAbstractCompression::create(const QString &name)
+{
+    if (name == "LZF") {
+        return new KisLzfCompression();
+    }
+
+#ifdef HAVE_LZ4
+    if (name == "LZ4") {
+        return new KisLz4Compression();
+    }
+#endif
+
+    return 0;
+}
+
+QStringList KisAbstractCompression::availableCompressions()
+{
+    QStringList result;
+    result << "LZF";
+
+#ifdef HAVE_LZ4
+    result << "LZ4";
+#endif
+
+    return result;
+}
+
+QString KisAbstractCompression::fastestCompression()
+{
+#ifdef HAVE_LZ4
+    return "LZ4";
+#else
+    return "LZF";
+#endif
+}
+
+template <int pixelSize>
+inline void linearizeColorsImpl(const quint8 *input, quint8 *output, qint32 dataSize)
+{
+    const qint32 strideSize = dataSize / pixelSize;
+
+    for (qint32 i = 0; i < strideSize; i++) {
+        for (qint32 ch = 0; ch < pixelSize; ch++) {
+            output[ch * strideSize + i] = input[ch];
+        }
+        input += pixelSize;
+    }
+}
+
+template <int pixelSize>
+inline void delinearizeColorsImpl(const quint8 *input, quint8 *output, qint32 dataSize)
+{
+    const qint32 strideSize = dataSize / pixelSize;
+
+    for (qint32 i = 0; i < strideSize; i++) {
+        for (qint32 ch = 0; ch < pixelSize; ch++) {
+            output[ch] = input[ch * strideSize + i];
+        }
+        output += pixelSize;
+    }
+}
+
 void KisAbstractCompression::linearizeColors(quint8 *input, quint8 *output,
                                              qint32 dataSize, qint32 pixelSize)
 {
+    /**
+     * The pixel sizes of the most popular color spaces are unrolled
+     * in compile time, which lets the compiler keep the whole pixel
+     * in registers. The result is exactly the same.
+     */
+    switch (pixelSize) {
+    case 4:
+        linearizeColorsImpl<4>(input, output, dataSize);
+        return;
+    case 8:
+        linearizeColorsImpl<8>(input, output, dataSize);
+        return;
+    case 16:
+        linearizeColorsImpl<16>(input, output, dataSize);
+        return;
+    default:
+        break;
+    }
+
     quint8 *outputByte = output;
     quint8 *lastByte = input + dataSize -1;
 
@@ -50,6 +139,20 @@ void KisAbstractCompression::linearizeColors(quint8 *input, quint8 *output,
 void KisAbstractCompression::delinearizeColors(quint8 *input, quint8 *output,
                                                qint32 dataSize, qint32 pixelSize)
 {
+    switch (pixelSize) {
+    case 4:
+        delinearizeColorsImpl<4>(input, output, dataSize);
+        return;
+    case 8:
+        delinearizeColorsImpl<8>(input, output, dataSize);
+        return;
+    case 16:
+        delinearizeColorsImpl<16>(input, output, dataSize);
+        return;
+    default:
+        break;
+    }
+
     /**
      * In the beginning, i wrote "delinearization" in a way,
      * that looks like a "linearization", but it turned to be quite
@@ -21,6 +21,7 @@
 
 #include "kritaimage_export.h"
 #include <QtGlobal>
+#include <QStringList>
 
 /**
  * Base class for compression operations
@@ -65,6 +66,30 @@ public:
      */
     virtual void adjustForDataSize(qint32 dataSize);
 
+    /**
+     * The name of the algorithm. It is written into the header of
+     * every tile, so the reader knows how to decompress it. The name
+     * should not be longer than 5 characters.
+     */
+    virtual QString name() const = 0;
+
+public:
+    /**
+     * Creates an algorithm with a given \p name. Returns null if
+     * the algorithm is not supported by the current build of Krita.
+     */
+    static KisAbstractCompression* create(const QString &name);
+
+    /**
+     * The list of the algorithms supported by the current build
+     */
+    static QStringList availableCompressions();
+
+    /**
+     * The fastest algorithm supported by the current build
+     */
+    static QString fastestCompression();
+
 public:
     /**
      * Additional interface for jumbling color channels order
@@ -277,3 +277,8 @@ qint32 KisLzfCompression::outputBufferSize(qint32 dataSize)
     // WARNING: Copy-pasted from LZO samples, do not know how to prove it
     return dataSize + dataSize / 16 + 64 + 3;
 }
+
+QString KisLzfCompression::name() const
+{
+    return "LZF";
+}
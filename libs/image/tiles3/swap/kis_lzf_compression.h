@@ -32,6 +32,8 @@ public:
 
     qint32 outputBufferSize(qint32 dataSize) override;
 
+    QString name() const override;
+
     //void adjustForDataSize(qint32 dataSize);
 };
 
@@ -36,8 +36,12 @@ KisSwappedDataStore::KisSwappedDataStore()
     m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
     m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
-    // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    /**
+     * The swap file never outlives the session, so we can use
+     * the fastest algorithm available without caring about
+     * compatibility
+     */
+    m_compressor = new KisTileCompressor2(config.swapCompression());
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
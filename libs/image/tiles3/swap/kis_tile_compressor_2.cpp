@@ -17,22 +17,48 @@
  */
 
 #include "kis_tile_compressor_2.h"
-#include "kis_lzf_compression.h"
+#include "kis_abstract_compression.h"
 #include <QIODevice>
 #include "kis_paint_device_writer.h"
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
-const QString KisTileCompressor2::m_compressionName = "LZF";
 
-
-KisTileCompressor2::KisTileCompressor2()
+KisTileCompressor2::KisTileCompressor2(const QString &compressionName)
 {
-    m_compression = new KisLzfCompression();
+    m_compression = KisAbstractCompression::create(compressionName);
+
+    if (!m_compression) {
+        warnTiles << "Tile compression" << compressionName
+                  << "is not supported, falling back to LZF";
+        m_compression = KisAbstractCompression::create("LZF");
+    }
 }
 
 KisTileCompressor2::~KisTileCompressor2()
 {
     delete m_compression;
+    qDeleteAll(m_readCompressions);
+}
+
+QString KisTileCompressor2::compressionName() const
+{
+    return m_compression->name();
+}
+
+KisAbstractCompression* KisTileCompressor2::compressionForName(const QString &name)
+{
+    if (name == m_compression->name()) return m_compression;
+
+    KisAbstractCompression *compression = m_readCompressions.value(name, 0);
+
+    if (!compression) {
+        compression = KisAbstractCompression::create(name);
+        if (compression) {
+            m_readCompressions.insert(name, compression);
+        }
+    }
+
+    return compression;
 }
 
 bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
@@ -62,9 +88,17 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 
 bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
-    prepareStreamingBuffer(tileDataSize);
+    TileRecord record;
+    if (!readTileRecord(stream, dm, record)) return false;
 
+    const bool res = decompressTileRecord(record);
+    record.tile->unlock();
+
+    return res;
+}
+
+bool KisTileCompressor2::readTileRecord(QIODevice *stream, KisTiledDataManager *dm, TileRecord &record)
+{
     QByteArray header = stream->readLine(maxHeaderLength());
 
     QList<QByteArray> headerItems = header.trimmed().split(',');
@@ -75,23 +109,54 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         qint32 dataSize = headerItems.takeFirst().toInt();
 
         Q_ASSERT(headerItems.isEmpty());
-        Q_ASSERT(compressionName == m_compressionName);
+
+        const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
+        if (dataSize < 0 || dataSize > tileDataSize + 1) {
+            warnFile << "Invalid size of the tile data:" << dataSize;
+            return false;
+        }
 
         qint32 row = yToRow(dm, y);
         qint32 col = xToCol(dm, x);
 
-        KisTileSP tile = dm->getTile(col, row, true);
+        record.tile = dm->getTile(col, row, true);
+        record.compressionName = compressionName;
+        record.data = stream->read(dataSize);
 
-        stream->read(m_streamingBuffer.data(), dataSize);
-
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlock();
-        return res;
+        /**
+         * Locking the tile for write does copy-on-write and registers
+         * the tile in the memento manager, which is not thread-safe,
+         * so it is done here, not in decompressTileRecord()
+         */
+        record.tile->lockForWrite();
+        return true;
     }
     return false;
 }
 
+bool KisTileCompressor2::decompressTileRecord(TileRecord &record)
+{
+    KisAbstractCompression *compression = compressionForName(record.compressionName);
+    if (!compression) {
+        warnFile << "Unsupported tile compression:" << record.compressionName;
+        return false;
+    }
+
+    /**
+     * The tiles written with different algorithms may be freely
+     * mixed in the same stream, so we just switch the algorithm
+     * for the duration of the decompression
+     */
+    KisAbstractCompression *savedCompression = m_compression;
+    m_compression = compression;
+
+    bool res = !record.data.isEmpty() &&
+        decompressTileData((quint8*)record.data.data(), record.data.size(), record.tile->tileData());
+
+    m_compression = savedCompression;
+    return res;
+}
+
 void KisTileCompressor2::prepareStreamingBuffer(qint32 tileDataSize)
 {
     /**
@@ -191,5 +256,5 @@ inline QString KisTileCompressor2::getHeader(KisTileSP tile,
     qint32 width, height;
     tile->extent().getRect(&x, &y, &width, &height);
 
-    return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(m_compressionName).arg(compressedSize);
+    return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(m_compression->name()).arg(compressedSize);
 }
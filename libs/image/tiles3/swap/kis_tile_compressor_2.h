@@ -21,17 +21,56 @@
 
 #include "kis_abstract_tile_compressor.h"
 
+#include <QHash>
+
 class KisAbstractCompression;
 
 class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
-    KisTileCompressor2();
+    /**
+     * \param compressionName the algorithm used for compressing
+     *        the tiles (see KisAbstractCompression::create()).
+     *        The tiles compressed with any supported algorithm
+     *        can be read, because the name of the algorithm is
+     *        stored in the header of every tile.
+     */
+    KisTileCompressor2(const QString &compressionName = "LZF");
     ~KisTileCompressor2() override;
 
+    QString compressionName() const;
+
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
     bool readTile(QIODevice *io, KisTiledDataManager *dm) override;
 
+    /**
+     * A tile that has been read from the stream, but
+     * has not been decompressed yet
+     */
+    struct TileRecord {
+        KisTileSP tile;
+        QString compressionName;
+        QByteArray data;
+    };
+
+    /**
+     * Reads the header and the compressed data of the next tile
+     * from the \p stream without decompressing it. The tile is
+     * created in \p dm and locked for writing. The caller should
+     * unlock it on the same thread after decompressTileRecord()
+     * has finished.
+     *
+     * Reading the records and creating the tiles should be done
+     * sequentially, but the records themselves may be decompressed
+     * concurrently by different compressor objects.
+     */
+    bool readTileRecord(QIODevice *stream, KisTiledDataManager *dm, TileRecord &record);
+
+    /**
+     * Decompresses the data of the \p record into its tile. The tile
+     * stays locked, it is the caller who unlocks it.
+     */
+    bool decompressTileRecord(TileRecord &record);
 
     void compressTileData(KisTileData *tileData,quint8 *buffer,
                           qint32 bufferSize, qint32 &bytesWritten) override;
@@ -49,6 +88,8 @@ private:
     void prepareWorkBuffers(qint32 tileDataSize);
     void prepareStreamingBuffer(qint32 tileDataSize);
 
+    KisAbstractCompression* compressionForName(const QString &name);
+
 private:
     static const qint8 RAW_DATA_FLAG = 0;
     static const qint8 COMPRESSED_DATA_FLAG = 1;
@@ -58,7 +99,12 @@ private:
     QByteArray m_compressionBuffer;
     QByteArray m_streamingBuffer;
     KisAbstractCompression *m_compression;
-    static const QString m_compressionName;
+
+    /**
+     * The algorithms met in the headers of the tiles
+     * read by this compressor, lazily created
+     */
+    QHash<QString, KisAbstractCompression*> m_readCompressions;
 };
 
 #endif /* __KIS_TILE_COMPRESSOR_2_H */
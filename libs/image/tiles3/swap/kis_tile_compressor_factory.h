@@ -25,13 +25,24 @@
 class KRITAIMAGE_EXPORT KisTileCompressorFactory
 {
 public:
-    static KisAbstractTileCompressorSP create(qint32 version) {
+    /**
+     * Creates a compressor for the tiles of a given \p version.
+     * \p compressionName selects the algorithm used for writing
+     * the tiles (it is ignored for the legacy tiles). The empty
+     * name means the default algorithm, compatible with all the
+     * versions of Krita able to read tiles of this version.
+     */
+    static KisAbstractTileCompressorSP create(qint32 version,
+                                              const QString &compressionName = QString()) {
         switch(version) {
         case 1:
             return KisAbstractTileCompressorSP(new KisLegacyTileCompressor());
             break;
         case 2:
-            return KisAbstractTileCompressorSP(new KisTileCompressor2());
+            return KisAbstractTileCompressorSP(
+                compressionName.isEmpty() ?
+                    new KisTileCompressor2() :
+                    new KisTileCompressor2(compressionName));
             break;
         default:
             qFatal("Unknown version of the tiles");
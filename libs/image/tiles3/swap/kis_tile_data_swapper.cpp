@@ -165,6 +165,11 @@ public:
     static inline bool swapOutFirst(KisTileData *td) {
         return td->age() > 0;
     }
+
+    static inline bool canSwapCandidates(iterator *iter) {
+        // the candidates are valid while their shard is locked only
+        return iter->isShardFinished();
+    }
 };
 
 class AggressiveSwapStrategy
@@ -189,6 +194,11 @@ public:
     static inline bool swapOutFirst(KisTileData *td) {
         return td->age() > 0;
     }
+
+    static inline bool canSwapCandidates(iterator *iter) {
+        // the candidates are valid while their shard is locked only
+        return iter->isShardFinished();
+    }
 };
 
 
@@ -209,21 +219,40 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
         if(freedMetric >= needToFreeMetric) break;
 
 
-        if(!strategy::isInteresting(item)) continue;
-
-        if(strategy::swapOutFirst(item)) {
-            if(iter->trySwapOut(item)) {
-                freedMetric += item->pixelSize();
+        if(strategy::isInteresting(item)) {
+            if(strategy::swapOutFirst(item)) {
+                if(iter->trySwapOut(item)) {
+                    freedMetric += item->pixelSize();
+                }
+            }
+            else {
+                item->markOld();
+                additionalCandidates.append(item);
             }
-        }
-        else {
-            item->markOld();
-            additionalCandidates.append(item);
         }
 
+        if(strategy::canSwapCandidates(iter)) {
+            freedMetric += swapCandidates(iter, additionalCandidates,
+                                          needToFreeMetric - freedMetric);
+        }
     }
 
-    Q_FOREACH (item, additionalCandidates) {
+    freedMetric += swapCandidates(iter, additionalCandidates,
+                                  needToFreeMetric - freedMetric);
+
+    strategy::endIteration(m_d->store, iter);
+
+    return freedMetric;
+}
+
+template<class iterator>
+qint64 KisTileDataSwapper::swapCandidates(iterator *iter,
+                                         QList<KisTileData*> &candidates,
+                                         qint64 needToFreeMetric)
+{
+    qint64 freedMetric = 0;
+
+    Q_FOREACH (KisTileData *item, candidates) {
         if(freedMetric >= needToFreeMetric) break;
 
         if(iter->trySwapOut(item)) {
@@ -231,8 +260,7 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
         }
     }
 
-    strategy::endIteration(m_d->store, iter);
-
+    candidates.clear();
     return freedMetric;
 }
 
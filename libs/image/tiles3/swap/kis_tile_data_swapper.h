@@ -49,6 +49,11 @@ private:
     void doJob();
     template<class strategy> qint64 pass(qint64 needToFreeMetric);
 
+    template<class iterator>
+    qint64 swapCandidates(iterator *iter,
+                          QList<KisTileData*> &candidates,
+                          qint64 needToFreeMetric);
+
 private:
     static const qint32 TIMEOUT;
     static const qint32 DELAY;
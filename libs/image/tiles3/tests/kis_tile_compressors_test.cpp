@@ -22,6 +22,7 @@
 #include "tiles3/kis_tiled_data_manager.h"
 #include "tiles3/swap/kis_legacy_tile_compressor.h"
 #include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/swap/kis_abstract_compression.h"
 
 #include "tiles_test_utils.h"
 
@@ -179,6 +180,55 @@ void KisTileCompressorsTest::testLowLevelRoundTripIncompressible2()
     delete compressor;
 }
 
+void KisTileCompressorsTest::testRoundTripAllCompressions()
+{
+    Q_FOREACH (const QString &name, KisAbstractCompression::availableCompressions()) {
+        KisTileCompressor2 *compressor = new KisTileCompressor2(name);
+        QCOMPARE(compressor->compressionName(), name);
+
+        doRoundTrip(compressor);
+        doLowLevelRoundTrip(compressor);
+        doLowLevelRoundTripIncompressible(compressor);
+
+        delete compressor;
+    }
+}
+
+void KisTileCompressorsTest::testReadMixedCompressions()
+{
+    /**
+     * Every tile carries the name of its codec in the header, so a
+     * reader must be able to load tiles written by any available
+     * algorithm, regardless of the one it uses itself
+     */
+    Q_FOREACH (const QString &writerName, KisAbstractCompression::availableCompressions()) {
+        Q_FOREACH (const QString &readerName, KisAbstractCompression::availableCompressions()) {
+            quint8 defaultPixel = 0;
+            quint8 oddPixel1 = 128;
+            KisTiledDataManager dm(1, &defaultPixel);
+            dm.clear(64, 64, 64, 64, &oddPixel1);
+
+            KisTileCompressor2 writerCompressor(writerName);
+            KisTileCompressor2 readerCompressor(readerName);
+
+            KoStoreFake fakeStore;
+            KisFakePaintDeviceWriter writer(&fakeStore);
+
+            KisTileSP tile11 = dm.getTile(1, 1, false);
+            QVERIFY(writerCompressor.writeTile(tile11, writer));
+            tile11 = 0;
+
+            fakeStore.startReading();
+            dm.clear();
+
+            QVERIFY(readerCompressor.readTile(fakeStore.device(), &dm));
+
+            tile11 = dm.getTile(1, 1, false);
+            QVERIFY(memoryIsFilled(oddPixel1, tile11->data(), TILESIZE));
+            QCOMPARE(readerCompressor.compressionName(), readerName);
+        }
+    }
+}
 
 QTEST_MAIN(KisTileCompressorsTest)
 
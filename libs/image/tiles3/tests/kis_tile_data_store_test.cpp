@@ -181,5 +181,85 @@ void KisTileDataStoreTest::testSwapping()
     }
 }
 
+class KisTileDataAllocJob : public QRunnable
+{
+public:
+    KisTileDataAllocJob(QList<KisTileData*> &tileDataList, int numTiles)
+        : m_tileDataList(tileDataList), m_numTiles(numTiles)
+    {
+    }
+
+    void run() override {
+        quint8 defaultPixel = 128;
+
+        for (int i = 0; i < m_numTiles; i++) {
+            KisTileData *td = KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel);
+
+            // free every second tile data concurrently with the other threads
+            if (i & 0x1) {
+                KisTileDataStore::instance()->freeTileData(td);
+            } else {
+                m_tileDataList.append(td);
+            }
+        }
+    }
+
+private:
+    QList<KisTileData*> &m_tileDataList;
+    int m_numTiles;
+};
+
+void KisTileDataStoreTest::testShardedRegistration()
+{
+    KisTileDataStore::instance()->debugClear();
+
+    const int numThreads = 8;
+    const int numTilesPerThread = 1000;
+
+    QVector<QList<KisTileData*>> tileDataLists(numThreads);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    for (int i = 0; i < numThreads; i++) {
+        pool.start(new KisTileDataAllocJob(tileDataLists[i], numTilesPerThread));
+    }
+    pool.waitForDone();
+
+    const int numTilesExpected = numThreads * numTilesPerThread / 2;
+
+    QCOMPARE(KisTileDataStore::instance()->numTilesInMemory(), numTilesExpected);
+    QCOMPARE(KisTileDataStore::instance()->memoryMetric(), qint64(numTilesExpected));
+
+    QSet<KisTileData*> visitedTileData;
+
+    KisTileDataStoreIterator *iter = KisTileDataStore::instance()->beginIteration();
+    while (iter->hasNext()) {
+        visitedTileData.insert(iter->next());
+    }
+    KisTileDataStore::instance()->endIteration(iter);
+
+    QCOMPARE(visitedTileData.size(), numTilesExpected);
+
+    int numClockVisited = 0;
+    KisTileDataStoreClockIterator *clockIter = KisTileDataStore::instance()->beginClockIteration();
+    while (clockIter->hasNext()) {
+        QVERIFY(visitedTileData.contains(clockIter->next()));
+        numClockVisited++;
+    }
+    KisTileDataStore::instance()->endIteration(clockIter);
+
+    QCOMPARE(numClockVisited, numTilesExpected);
+
+    for (int i = 0; i < numThreads; i++) {
+        Q_FOREACH (KisTileData *td, tileDataLists[i]) {
+            KisTileDataStore::instance()->freeTileData(td);
+        }
+    }
+
+    QCOMPARE(KisTileDataStore::instance()->numTilesInMemory(), 0);
+    QCOMPARE(KisTileDataStore::instance()->memoryMetric(), qint64(0));
+}
+
 QTEST_MAIN(KisTileDataStoreTest)
 
@@ -18,8 +18,13 @@
 
 #include "kis_tiled_data_manager_test.h"
 #include <QTest>
+#include <QSemaphore>
+#include <QThreadPool>
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/kis_tile_hash_table_reclaimer.h"
+#include "kis_image_config.h"
 
 #include "tiles_test_utils.h"
 
@@ -644,6 +649,252 @@ void KisTiledDataManagerTest::benchmarkCOWWithPooler()
     benchmarkCOWImpl();
 }
 
+void KisTiledDataManagerTest::testHashTableGrowth()
+{
+    quint8 defaultPixel = 0;
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel));
+
+    const qint32 initialTableSize = ht.debugTableSize();
+    const qint32 numRows = 100;
+    const qint32 numCols = 100;
+
+    for (qint32 row = 0; row < numRows; row++) {
+        for (qint32 col = 0; col < numCols; col++) {
+            bool newTile = false;
+            KisTileSP tile = ht.getTileLazy(col, row, newTile);
+            QVERIFY(newTile);
+        }
+    }
+
+    QCOMPARE(ht.numTiles(), numRows * numCols);
+    QVERIFY(ht.debugTableSize() > initialTableSize);
+
+    for (qint32 row = 0; row < numRows; row++) {
+        for (qint32 col = 0; col < numCols; col++) {
+            KisTileSP tile = ht.getExistingTile(col, row);
+            QVERIFY(tile);
+            QCOMPARE(tile->col(), col);
+            QCOMPARE(tile->row(), row);
+        }
+    }
+
+    {
+        qint32 numIteratedTiles = 0;
+        KisTileHashTableConstIterator iter(&ht);
+        for (; !iter.isDone(); iter.next()) {
+            numIteratedTiles++;
+        }
+        QCOMPARE(numIteratedTiles, numRows * numCols);
+    }
+
+    ht.clear();
+
+    QVERIFY(ht.isEmpty());
+    QCOMPARE(ht.debugTableSize(), initialTableSize);
+}
+
+void deleteReclaimerTestObject(void *object)
+{
+    *static_cast<bool*>(object) = true;
+}
+
+class KisReclaimerReaderJob : public QRunnable
+{
+public:
+    KisReclaimerReaderJob(QSemaphore &entered, QSemaphore &release)
+        : m_entered(entered), m_release(release)
+    {
+    }
+
+    void run() override {
+        KisTileHashTableReclaimer::ReadGuard guard;
+        m_entered.release();
+        m_release.acquire();
+    }
+
+private:
+    QSemaphore &m_entered;
+    QSemaphore &m_release;
+};
+
+void KisTiledDataManagerTest::testHashTableReclamation()
+{
+    KisTileHashTableReclaimer::reclaim();
+    QCOMPARE(KisTileHashTableReclaimer::numRetiredObjects(), 0);
+
+    // without readers the object is deleted right away
+    bool deleted = false;
+    KisTileHashTableReclaimer::retire(&deleted, deleteReclaimerTestObject);
+    QVERIFY(deleted);
+
+    // a reader that entered before the retirement keeps the object alive
+    QSemaphore entered;
+    QSemaphore release;
+
+    QThreadPool pool;
+    pool.start(new KisReclaimerReaderJob(entered, release));
+    entered.acquire();
+
+    deleted = false;
+    KisTileHashTableReclaimer::retire(&deleted, deleteReclaimerTestObject);
+    QVERIFY(!deleted);
+
+    // a reader that entered after the retirement doesn't block it
+    {
+        KisTileHashTableReclaimer::ReadGuard guard;
+        KisTileHashTableReclaimer::reclaim();
+        QVERIFY(!deleted);
+    }
+
+    release.release();
+    pool.waitForDone();
+
+    {
+        KisTileHashTableReclaimer::ReadGuard guard;
+        KisTileHashTableReclaimer::reclaim();
+        QVERIFY(deleted);
+    }
+
+    // the tables retired by the growth are reclaimed when the walkers are gone
+    quint8 defaultPixel = 0;
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel));
+
+    for (qint32 i = 0; i < 10000; i++) {
+        bool newTile = false;
+        ht.getTileLazy(i % 100, i / 100, newTile);
+    }
+
+    QVERIFY(ht.debugTableSize() > 1024);
+    QCOMPARE(KisTileHashTableReclaimer::numRetiredObjects(), 0);
+}
+
+class KisHashTableGrowthJob : public QRunnable
+{
+public:
+    KisHashTableGrowthJob(KisTileHashTable &ht, qint32 numRows, qint32 numCols,
+                          QVector<KisTileSP> &tiles)
+        : m_ht(ht), m_numRows(numRows), m_numCols(numCols), m_tiles(tiles)
+    {
+    }
+
+    void run() override {
+        /**
+         * All the jobs request the same set of tiles, so the
+         * table is being resized while the others are walking
+         * through it
+         */
+        for (qint32 row = 0; row < m_numRows; row++) {
+            for (qint32 col = 0; col < m_numCols; col++) {
+                bool newTile = false;
+                m_tiles[row * m_numCols + col] = m_ht.getTileLazy(col, row, newTile);
+            }
+        }
+    }
+
+private:
+    KisTileHashTable &m_ht;
+    qint32 m_numRows;
+    qint32 m_numCols;
+    QVector<KisTileSP> &m_tiles;
+};
+
+void KisTiledDataManagerTest::stressTestHashTableGrowth()
+{
+    quint8 defaultPixel = 0;
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel));
+
+    const qint32 numThreads = 8;
+    const qint32 numRows = 150;
+    const qint32 numCols = 150;
+
+    QVector<QVector<KisTileSP>> tiles(numThreads);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    for (qint32 i = 0; i < numThreads; i++) {
+        tiles[i].resize(numRows * numCols);
+        pool.start(new KisHashTableGrowthJob(ht, numRows, numCols, tiles[i]));
+    }
+    pool.waitForDone();
+
+    QCOMPARE(ht.numTiles(), numRows * numCols);
+
+    for (qint32 i = 0; i < numRows * numCols; i++) {
+        KisTileSP tile = ht.getExistingTile(i % numCols, i / numCols);
+        QVERIFY(tile);
+
+        for (qint32 j = 0; j < numThreads; j++) {
+            QCOMPARE(tiles[j][i].data(), tile.data());
+        }
+    }
+}
+
+void KisTiledDataManagerTest::testParallelWrite()
+{
+    /**
+     * The device is big enough to be saved by the pool of
+     * workers. The result must be byte-for-byte the same as
+     * the one of the plain sequential save.
+     */
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+    KisTiledDataManager dm(pixelSize, defaultPixel);
+
+    const QRect rc(-100, -100, 40 * KisTileData::WIDTH, 30 * KisTileData::HEIGHT);
+    QVector<quint8> row(rc.width() * pixelSize);
+
+    for (qint32 y = rc.top(); y <= rc.bottom(); y++) {
+        for (qint32 i = 0; i < row.size(); i++) {
+            row[i] = quint8((i / 7) ^ (y * 3) ^ (i % pixelSize == 3 ? 0xff : 0));
+        }
+        dm.writeBytes(row.data(), rc.x(), y, rc.width(), 1);
+    }
+
+    KoStoreFake parallelStore;
+    KisFakePaintDeviceWriter parallelWriter(&parallelStore);
+    QVERIFY(dm.write(parallelWriter));
+
+    KoStoreFake sequentialStore;
+    KisFakePaintDeviceWriter sequentialWriter(&sequentialStore);
+    {
+        QVERIFY(dm.writeTilesHeader(sequentialWriter, dm.m_hashTable->numTiles()));
+
+        KisTileCompressor2 compressor(KisImageConfig(true).saveTilesCompression());
+        KisTileHashTableConstIterator iter(dm.m_hashTable);
+        KisTileSP tile;
+
+        while ((tile = iter.tile())) {
+            QVERIFY(compressor.writeTile(tile, sequentialWriter));
+            iter.next();
+        }
+    }
+
+    parallelStore.startReading();
+    sequentialStore.startReading();
+
+    const QByteArray parallelData = parallelStore.device()->readAll();
+    const QByteArray sequentialData = sequentialStore.device()->readAll();
+
+    QVERIFY(!parallelData.isEmpty());
+    QCOMPARE(parallelData.size(), sequentialData.size());
+    QVERIFY(parallelData == sequentialData);
+
+    parallelStore.device()->seek(0);
+
+    KisTiledDataManager dm2(pixelSize, defaultPixel);
+    QVERIFY(dm2.read(parallelStore.device()));
+
+    QVector<quint8> buf1(rc.width() * rc.height() * pixelSize);
+    QVector<quint8> buf2(rc.width() * rc.height() * pixelSize);
+    dm.readBytes(buf1.data(), rc.x(), rc.y(), rc.width(), rc.height());
+    dm2.readBytes(buf2.data(), rc.x(), rc.y(), rc.width(), rc.height());
+    QVERIFY(buf1 == buf2);
+}
+
 /******************* Stress job ***********************/
 
 //#define NUM_CYCLES 9000
@@ -53,6 +53,12 @@ private Q_SLOTS:
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
 
+    void testHashTableGrowth();
+    void stressTestHashTableGrowth();
+    void testHashTableReclamation();
+
+    void testParallelWrite();
+
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
 
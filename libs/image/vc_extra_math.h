@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VC_EXTRA_MATH_H
+#define VC_EXTRA_MATH_H
+
+#include <config-vc.h>
+
+#if defined HAVE_VC
+
+#include <Vc/Vc>
+
+/**
+ * Math functions missing in Vc. The header should be included
+ * only by the sources compiled for every architecture, see
+ * ko_compile_for_all_implementations()
+ */
+class VcExtraMath
+{
+public:
+    /**
+     * Vectorized erf() function, Abramowitz and Stegun 7.1.26.
+     * The absolute error is less than 1.5e-7, which is more than
+     * enough for 8-bit masks.
+     */
+    static inline Vc::float_v erf(Vc::float_v x) {
+        const Vc::float_v a1(0.254829592f);
+        const Vc::float_v a2(-0.284496736f);
+        const Vc::float_v a3(1.421413741f);
+        const Vc::float_v a4(-1.453152027f);
+        const Vc::float_v a5(1.061405429f);
+        const Vc::float_v p(0.3275911f);
+        const Vc::float_v vOne(Vc::One);
+
+        Vc::float_v sign(Vc::One);
+        sign(x < Vc::Zero) = -vOne;
+
+        x = Vc::abs(x);
+
+        const Vc::float_v t = vOne / (vOne + p * x);
+        const Vc::float_v poly = ((((a5 * t + a4) * t + a3) * t + a2) * t + a1) * t;
+        const Vc::float_v y = vOne - poly * Vc::exp(-x * x);
+
+        return sign * y;
+    }
+};
+
+#endif /* defined HAVE_VC */
+
+#endif /* VC_EXTRA_MATH_H */
@@ -30,7 +30,6 @@
 #include <KisView.h>
 
 #include <strokes/kis_filter_stroke_strategy.h>
-#include <krita_utils.h>
 
 #include "Krita.h"
 #include "Document.h"
@@ -149,14 +148,10 @@ bool Filter::startFilter(Node *node, int x, int y, int w, int h)
     QRect processRect = filter->changedRect(applyRect, filterConfig.data(), 0);
     processRect &= image->bounds();
 
-    if (filter->supportsThreading()) {
-        QSize size = KritaUtils::optimalPatchSize();
-        QVector<QRect> rects = KritaUtils::splitRectIntoPatches(processRect, size);
-        Q_FOREACH (const QRect &rc, rects) {
-            image->addJob(currentStrokeId, new KisFilterStrokeStrategy::Data(rc, true));
-        }
-    } else {
-        image->addJob(currentStrokeId, new KisFilterStrokeStrategy::Data(processRect, false));
+    Q_FOREACH (KisStrokeJobData *jobData,
+               KisFilterStrokeStrategy::createJobsData(filter, filterConfig, processRect,
+                                                       image->currentLevelOfDetail())) {
+        image->addJob(currentStrokeId, jobData);
     }
 
     image->endStroke(currentStrokeId);
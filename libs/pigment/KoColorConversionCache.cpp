@@ -19,6 +19,10 @@
 
 #include "KoColorConversionCache.h"
 
+#include <algorithm>
+#include <vector>
+
+#include <QAtomicInt>
 #include <QHash>
 #include <QList>
 #include <QMutex>
@@ -45,6 +49,18 @@ struct KoColorConversionCacheKey {
                 && (conversionFlags == rhs.conversionFlags);
     }
 
+    /**
+     * Compares the color space pointers instead of the color spaces
+     * themselves. That is what the per-thread cache uses: it never
+     * dereferences the color spaces and never has to rebind the
+     * transformation to another pair of color space objects.
+     */
+    bool isSameObjects(const KoColorConversionCacheKey& rhs) const {
+        return src == rhs.src && dst == rhs.dst
+                && renderingIntent == rhs.renderingIntent
+                && conversionFlags == rhs.conversionFlags;
+    }
+
     const KoColorSpace* src;
     const KoColorSpace* dst;
     KoColorConversionTransformation::Intent renderingIntent;
@@ -56,10 +72,17 @@ uint qHash(const KoColorConversionCacheKey& key)
     return qHash(key.src) + qHash(key.dst) + qHash(key.renderingIntent) + qHash(key.conversionFlags);
 }
 
+/**
+ * The transformation is reference counted. The pool (the hash in
+ * KoColorConversionCache::Private) holds one reference, every
+ * KoCachedColorConversionTransformation holds one more. Therefore,
+ * the transformation is available for reuse when only the pool
+ * references it.
+ */
 struct KoColorConversionCache::CachedTransformation {
 
     CachedTransformation(KoColorConversionTransformation* _transfo)
-        : transfo(_transfo), use(0)
+        : transfo(_transfo), ref(1)
     {}
 
     ~CachedTransformation() {
@@ -67,20 +90,47 @@ struct KoColorConversionCache::CachedTransformation {
     }
 
     bool available() {
-        return use == 0;
+        return ref.load() == 1;
     }
 
     KoColorConversionTransformation* transfo;
-    int use;
+    QAtomicInt ref;
 };
 
 typedef QPair<KoColorConversionCacheKey, KoCachedColorConversionTransformation> FastPathCacheItem;
 
+/**
+ * A small most-recently-used list of the converters used by a thread.
+ * It is accessed by its owner thread only, so it needs no locking.
+ *
+ * The capacity bounds the memory pinned by every thread, see the
+ * documentation of KoColorConversionCache.
+ */
+struct ThreadLocalCache {
+    static const int capacity = 8;
+
+    ThreadLocalCache(int _generation)
+        : generation(_generation)
+    {
+        items.reserve(capacity);
+    }
+
+    int generation;
+    std::vector<FastPathCacheItem> items;
+};
+
 struct KoColorConversionCache::Private {
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*> cache;
     QMutex cacheMutex;
 
-    QThreadStorage<FastPathCacheItem*> fastStorage;
+    /**
+     * Incremented every time a color space is destroyed. The threads
+     * compare it with the generation of their local cache and drop
+     * the local cache when it is outdated.
+     */
+    QAtomicInt generation;
+
+    QThreadStorage<ThreadLocalCache*> fastStorage;
 };
 
 
@@ -90,6 +140,8 @@ KoColorConversionCache::KoColorConversionCache() : d(new Private)
 
 KoColorConversionCache::~KoColorConversionCache()
 {
+    d->fastStorage.setLocalData(0);
+
     Q_FOREACH (CachedTransformation* transfo, d->cache) {
         delete transfo;
     }
@@ -103,51 +155,78 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
 {
     KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags);
 
-    FastPathCacheItem *cacheItem =
-        d->fastStorage.localData();
+    const int generation = d->generation.loadAcquire();
+    ThreadLocalCache *localCache = d->fastStorage.localData();
+
+    if (!localCache || localCache->generation != generation) {
+        localCache = new ThreadLocalCache(generation);
+        d->fastStorage.setLocalData(localCache);
+    }
+
+    std::vector<FastPathCacheItem> &items = localCache->items;
 
-    if (cacheItem) {
-        if (cacheItem->first == key) {
-            return cacheItem->second;
+    for (auto it = items.begin(); it != items.end(); ++it) {
+        if (it->first.isSameObjects(key)) {
+            std::rotate(items.begin(), it, it + 1);
+            return items.front().second;
         }
     }
 
-    cacheItem = 0;
+    CachedTransformation *cachedTransfo = 0;
 
-    QMutexLocker lock(&d->cacheMutex);
-    QList< CachedTransformation* > cachedTransfos = d->cache.values(key);
-    if (cachedTransfos.size() != 0) {
+    {
+        QMutexLocker lock(&d->cacheMutex);
+        QList< CachedTransformation* > cachedTransfos = d->cache.values(key);
         Q_FOREACH (CachedTransformation* ct, cachedTransfos) {
             if (ct->available()) {
                 ct->transfo->setSrcColorSpace(src);
                 ct->transfo->setDstColorSpace(dst);
 
-                cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
+                cachedTransfo = ct;
                 break;
             }
         }
-    }
-    if (!cacheItem) {
-        KoColorConversionTransformation* transfo = src->createColorConverter(dst, _renderingIntent, _conversionFlags);
-        CachedTransformation* ct = new CachedTransformation(transfo);
-        d->cache.insert(key, ct);
-        cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
+        if (!cachedTransfo) {
+            KoColorConversionTransformation* transfo = src->createColorConverter(dst, _renderingIntent, _conversionFlags);
+            cachedTransfo = new CachedTransformation(transfo);
+            d->cache.insert(key, cachedTransfo);
+        }
+
+        /**
+         * The reference must be taken while the lock is held, otherwise
+         * some other thread might consider the transformation available
+         */
+        KoCachedColorConversionTransformation cct(cachedTransfo);
+
+        if (items.size() >= ThreadLocalCache::capacity) {
+            items.pop_back();
+        }
+        items.insert(items.begin(), FastPathCacheItem(key, cct));
     }
 
-    d->fastStorage.setLocalData(cacheItem);
-    return cacheItem->second;
+    return items.front().second;
 }
 
 void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
 {
     d->fastStorage.setLocalData(0);
+    d->generation.ref();
 
     QMutexLocker lock(&d->cacheMutex);
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator endIt = d->cache.end();
     for (QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator it = d->cache.begin(); it != endIt;) {
         if (it.key().src == cs || it.key().dst == cs) {
-            Q_ASSERT(it.value()->available()); // That's terribely evil, if that assert fails, that means that someone is using a color transformation with a color space which is currently being deleted
-            delete it.value();
+            /**
+             * The transformation may still be referenced by the local
+             * caches of other threads. They will never return it again,
+             * since their generation is outdated now, so the last of
+             * them will delete the transformation when dropping its
+             * local cache.
+             */
+            CachedTransformation *ct = it.value();
+            if (!ct->ref.deref()) {
+                delete ct;
+            }
             it = d->cache.erase(it);
         } else {
             ++it;
@@ -157,34 +236,39 @@ void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
 
 //--------- KoCachedColorConversionTransformation ----------//
 
-struct KoCachedColorConversionTransformation::Private {
-    KoColorConversionCache* cache;
-    KoColorConversionCache::CachedTransformation* transfo;
-};
-
-
-KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(KoColorConversionCache* cache, KoColorConversionCache::CachedTransformation* transfo) : d(new Private)
+KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(KoColorConversionCache::CachedTransformation* transfo)
+    : m_transfo(transfo)
 {
     Q_ASSERT(transfo->available());
-    d->cache = cache;
-    d->transfo = transfo;
-    d->transfo->use++;
+    m_transfo->ref.ref();
 }
 
-KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(const KoCachedColorConversionTransformation& rhs) : d(new Private(*rhs.d))
+KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(const KoCachedColorConversionTransformation& rhs)
+    : m_transfo(rhs.m_transfo)
 {
-    d->transfo->use++;
+    m_transfo->ref.ref();
+}
+
+KoCachedColorConversionTransformation& KoCachedColorConversionTransformation::operator=(const KoCachedColorConversionTransformation& rhs)
+{
+    if (m_transfo != rhs.m_transfo) {
+        rhs.m_transfo->ref.ref();
+        if (!m_transfo->ref.deref()) {
+            delete m_transfo;
+        }
+        m_transfo = rhs.m_transfo;
+    }
+    return *this;
 }
 
 KoCachedColorConversionTransformation::~KoCachedColorConversionTransformation()
 {
-    d->transfo->use--;
-    Q_ASSERT(d->transfo->use >= 0);
-    delete d;
+    if (!m_transfo->ref.deref()) {
+        delete m_transfo;
+    }
 }
 
 const KoColorConversionTransformation* KoCachedColorConversionTransformation::transformation() const
 {
-    return d->transfo->transfo;
+    return m_transfo->transfo;
 }
-
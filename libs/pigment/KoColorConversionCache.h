@@ -24,13 +24,27 @@ class KoCachedColorConversionTransformation;
 class KoColorSpace;
 
 #include "KoColorConversionTransformation.h"
+#include "kritapigment_export.h"
 
 /**
  * This class holds a cache of KoColorConversionTransformations.
  *
+ * Every thread keeps a small most-recently-used list of the converters
+ * it has used, so repeated lookups are served without taking any lock
+ * and without allocating memory. The global mutex-protected pool is
+ * only consulted on a miss.
+ *
+ * The converters in the list of a thread stay taken from the pool until
+ * the thread exits, a color space is destroyed or they are pushed out by
+ * the ones used more recently, so every thread that did any conversions
+ * pins up to ThreadLocalCache::capacity converters. The largest of them
+ * (a 16-bit matrix-shaper converter with its linearization tables, or
+ * an lcms transform with a 4D grid) take about 1 MiB each, so the cost is
+ * bounded by several MiB per thread, and is usually much less.
+ *
  * This class is not part of public API, and can be changed without notice.
  */
-class KoColorConversionCache
+class KRITAPIGMENT_EXPORT KoColorConversionCache
 {
 public:
     struct CachedTransformation;
@@ -53,6 +67,10 @@ public:
      * This function is called by the destructor of the color space to
      * warn the cache that any pointers to this color space is going to
      * be invalid and that the cache needs to stop using those pointers.
+     *
+     * The per-thread caches of all the threads are invalidated as well,
+     * so no subsequent lookup will return a transformation bound to \p src.
+     *
      * @param src source color space
      */
     void colorSpaceIsDestroyed(const KoColorSpace* src);
@@ -66,22 +84,24 @@ private:
  * by the cache and when it's deleted it return the transformation to
  * the pool of available color convertion transformation.
  *
+ * The object is just a reference-counted handle, copying it doesn't
+ * allocate any memory.
+ *
  * This class is not part of public API, and can be changed without notice.
  */
-class KoCachedColorConversionTransformation
+class KRITAPIGMENT_EXPORT KoCachedColorConversionTransformation
 {
     friend class KoColorConversionCache;
 private:
-    KoCachedColorConversionTransformation(KoColorConversionCache* cache,
-                                          KoColorConversionCache::CachedTransformation* transfo);
+    KoCachedColorConversionTransformation(KoColorConversionCache::CachedTransformation* transfo);
 public:
     KoCachedColorConversionTransformation(const KoCachedColorConversionTransformation&);
+    KoCachedColorConversionTransformation& operator=(const KoCachedColorConversionTransformation&);
     ~KoCachedColorConversionTransformation();
 public:
     const KoColorConversionTransformation* transformation() const;
 private:
-    struct Private;
-    Private* const d;
+    KoColorConversionCache::CachedTransformation *m_transfo;
 };
 
 
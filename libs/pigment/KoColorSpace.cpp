@@ -388,6 +388,17 @@ const KoColorConversionTransformation* KoColorSpace::fromRgbA16Converter() const
     return d->transfoFromRGBA16;
 }
 
+void KoColorSpace::toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile *profile) const
+{
+    const quint32 pixelSize = this->pixelSize();
+
+    for (quint32 i = 0; i < nPixels; i++) {
+        toQColor(src, colors, profile);
+        src += pixelSize;
+        colors++;
+    }
+}
+
 void KoColorSpace::toLabA16(const quint8 * src, quint8 * dst, quint32 nPixels) const
 {
     toLabA16Converter()->transform(src, dst, nPixels);
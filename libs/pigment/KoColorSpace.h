@@ -298,6 +298,20 @@ public:
      */
     virtual void toQColor(const quint8 *src, QColor *c, const KoColorProfile * profile = 0) const = 0;
 
+    /**
+     * Batched version of toQColor(). Converts \p nPixels pixels stored
+     * contiguously in \p src into the \p colors array, which should be
+     * able to hold at least \p nPixels values. The default implementation
+     * just calls toQColor() for every pixel, the color spaces may
+     * reimplement it in a more efficient way.
+     *
+     * @param src a pointer to the first source pixel
+     * @param colors the array of QColor that will be filled with the colors of src
+     * @param nPixels the number of pixels to convert
+     * @param profile the optional profile that describes the colors, for instance the monitor profile
+     */
+    virtual void toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile * profile = 0) const;
+
     /**
      * Convert the pixels in data to (8-bit BGRA) QImage using the specified profiles.
      *
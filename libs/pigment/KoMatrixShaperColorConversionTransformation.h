@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _KO_MATRIX_SHAPER_COLOR_CONVERSION_TRANSFORMATION_H_
+#define _KO_MATRIX_SHAPER_COLOR_CONVERSION_TRANSFORMATION_H_
+
+#include <cmath>
+
+#include <QVector>
+
+#include <KoColorConversionTransformation.h>
+#include <KoColorSpaceMaths.h>
+
+/**
+ * Description of a conversion between two RGB matrix-shaper profiles. Such
+ * a conversion is nothing more than linearization of the source channels,
+ * a 3x3 matrix and delinearization into the destination channels. The
+ * color engine fills it in from the profiles' tags.
+ */
+struct KoMatrixShaperConversionData
+{
+    /**
+     * The destination curve is sampled at x = (i / delinearizationSize)^2,
+     * which keeps the steep part of gamma-like curves precise near black.
+     */
+    static const int delinearizationSize = 4096;
+
+    /**
+     * Linear value of every code value of the source channel, that is,
+     * unitValue + 1 entries per each of R, G and B
+     */
+    QVector<float> linearization[3];
+
+    /**
+     * Row-major matrix from linear source RGB into linear destination RGB
+     */
+    float matrix[9];
+
+    /**
+     * delinearizationSize + 1 samples of each of the destination curves, in [0, 1]
+     */
+    QVector<float> delinearization[3];
+};
+
+/**
+ * Converts integer RGB pixels between two matrix-shaper profiles without
+ * calling into the color engine. The pixels are processed in chunks in a
+ * structure-of-arrays manner, so the matrix and the curve addressing,
+ * which have no dependencies between the pixels, get vectorized by the
+ * compiler.
+ */
+template<typename _src_CSTraits_, typename _dst_CSTraits_>
+class KoMatrixShaperColorConversionTransformation : public KoColorConversionTransformation
+{
+    typedef typename _src_CSTraits_::channels_type src_channels_type;
+    typedef typename _dst_CSTraits_::channels_type dst_channels_type;
+
+    static const int chunkSize = 256;
+
+public:
+    KoMatrixShaperColorConversionTransformation(const KoColorSpace *srcCs, const KoColorSpace *dstCs,
+                                                Intent renderingIntent,
+                                                ConversionFlags conversionFlags,
+                                                const KoMatrixShaperConversionData &data)
+        : KoColorConversionTransformation(srcCs, dstCs, renderingIntent, conversionFlags),
+          m_data(data)
+    {
+        const float dstUnitValue = KoColorSpaceMathsTraits<dst_channels_type>::unitValue;
+
+        for (int ch = 0; ch < 3; ch++) {
+            Q_ASSERT(m_data.linearization[ch].size() == int(KoColorSpaceMathsTraits<src_channels_type>::unitValue) + 1);
+            Q_ASSERT(m_data.delinearization[ch].size() == KoMatrixShaperConversionData::delinearizationSize + 1);
+
+            // prescale the curves to save a multiplication per channel
+            for (auto it = m_data.delinearization[ch].begin(); it != m_data.delinearization[ch].end(); ++it) {
+                *it *= dstUnitValue;
+            }
+        }
+    }
+
+    void transform(const quint8 *srcU8, quint8 *dstU8, qint32 nPixels) const override {
+        const src_channels_type *src = _src_CSTraits_::nativeArray(srcU8);
+        dst_channels_type *dst = _dst_CSTraits_::nativeArray(dstU8);
+
+        const float *linR = m_data.linearization[0].constData();
+        const float *linG = m_data.linearization[1].constData();
+        const float *linB = m_data.linearization[2].constData();
+
+        const float *delinR = m_data.delinearization[0].constData();
+        const float *delinG = m_data.delinearization[1].constData();
+        const float *delinB = m_data.delinearization[2].constData();
+
+        const float *m = m_data.matrix;
+        const float tableScale = KoMatrixShaperConversionData::delinearizationSize;
+
+        float r[chunkSize];
+        float g[chunkSize];
+        float b[chunkSize];
+
+        while (nPixels > 0) {
+            const int numChunkPixels = qMin(nPixels, qint32(chunkSize));
+
+            for (int i = 0; i < numChunkPixels; i++) {
+                const src_channels_type *pixel = src + i * _src_CSTraits_::channels_nb;
+                r[i] = linR[pixel[_src_CSTraits_::red_pos]];
+                g[i] = linG[pixel[_src_CSTraits_::green_pos]];
+                b[i] = linB[pixel[_src_CSTraits_::blue_pos]];
+            }
+
+            for (int i = 0; i < numChunkPixels; i++) {
+                const float newR = m[0] * r[i] + m[1] * g[i] + m[2] * b[i];
+                const float newG = m[3] * r[i] + m[4] * g[i] + m[5] * b[i];
+                const float newB = m[6] * r[i] + m[7] * g[i] + m[8] * b[i];
+
+                r[i] = std::sqrt(qBound(0.0f, newR, 1.0f)) * tableScale;
+                g[i] = std::sqrt(qBound(0.0f, newG, 1.0f)) * tableScale;
+                b[i] = std::sqrt(qBound(0.0f, newB, 1.0f)) * tableScale;
+            }
+
+            for (int i = 0; i < numChunkPixels; i++) {
+                const src_channels_type *srcPixel = src + i * _src_CSTraits_::channels_nb;
+                dst_channels_type *dstPixel = dst + i * _dst_CSTraits_::channels_nb;
+
+                dstPixel[_dst_CSTraits_::red_pos] = delinearize(delinR, r[i]);
+                dstPixel[_dst_CSTraits_::green_pos] = delinearize(delinG, g[i]);
+                dstPixel[_dst_CSTraits_::blue_pos] = delinearize(delinB, b[i]);
+                dstPixel[_dst_CSTraits_::alpha_pos] =
+                    KoColorSpaceMaths<src_channels_type, dst_channels_type>::scaleToA(srcPixel[_src_CSTraits_::alpha_pos]);
+            }
+
+            src += numChunkPixels * _src_CSTraits_::channels_nb;
+            dst += numChunkPixels * _dst_CSTraits_::channels_nb;
+            nPixels -= numChunkPixels;
+        }
+    }
+
+private:
+    static inline dst_channels_type delinearize(const float *table, float pos) {
+        const int index = qMin(int(pos), KoMatrixShaperConversionData::delinearizationSize - 1);
+        const float fraction = pos - index;
+        return dst_channels_type(table[index] + fraction * (table[index + 1] - table[index]) + 0.5f);
+    }
+
+private:
+    KoMatrixShaperConversionData m_data;
+};
+
+#endif
@@ -19,6 +19,9 @@
 #include "KoColorSpacesBenchmark.h"
 
 #include <QTest>
+#include <QColor>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <KoColorSpaceRegistry.h>
 #include <KoColorSpace.h>
 
@@ -146,4 +149,113 @@ void KoColorSpacesBenchmark::benchmarkSetAlpha2IndividualCall()
     END_BENCHMARK
 }
 
+void KoColorSpacesBenchmark::createThreadedRowsColumns()
+{
+    QTest::addColumn<QString>("modelID");
+    QTest::addColumn<QString>("depthID");
+    QTest::addColumn<int>("threads");
+
+    QList<const KoColorSpace*> colorSpaces = KoColorSpaceRegistry::instance()->allColorSpaces(KoColorSpaceRegistry::AllColorSpaces, KoColorSpaceRegistry::OnlyDefaultProfile);
+    Q_FOREACH (const KoColorSpace* colorSpace, colorSpaces) {
+        Q_FOREACH (int threads, QList<int>({1, 16})) {
+            QTest::newRow(QString("%1, %2 threads").arg(colorSpace->name()).arg(threads).toLatin1().data())
+                << colorSpace->colorModelId().id() << colorSpace->colorDepthId().id() << threads;
+        }
+    }
+}
+
+/**
+ * Splits NB_PIXELS into \p threads equal parts and calls \p func for
+ * every part in a separate thread. The color pickers and dockers call
+ * the QColor conversions concurrently in the same way.
+ */
+template <class Func>
+void runInThreads(int threads, Func func)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    const int pixelsPerThread = NB_PIXELS / threads;
+
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < threads; i++) {
+        futures << QtConcurrent::run(&pool, func, i * pixelsPerThread, pixelsPerThread);
+    }
+
+    Q_FOREACH (QFuture<void> future, futures) {
+        future.waitForFinished();
+    }
+}
+
+#define START_THREADED_BENCHMARK \
+    QFETCH(int, threads); \
+    START_BENCHMARK
+
+void KoColorSpacesBenchmark::benchmarkToQColor_data()
+{
+    createThreadedRowsColumns();
+}
+
+void KoColorSpacesBenchmark::benchmarkToQColor()
+{
+    START_THREADED_BENCHMARK
+    QBENCHMARK {
+        runInThreads(threads, [=] (int start, int numPixels) {
+            QColor color;
+            const quint8 *data_it = data + start * pixelSize;
+            for (int i = 0; i < numPixels; ++i) {
+                colorSpace->toQColor(data_it, &color);
+                data_it += pixelSize;
+            }
+        });
+    }
+    END_BENCHMARK
+}
+
+void KoColorSpacesBenchmark::benchmarkToQColors_data()
+{
+    createThreadedRowsColumns();
+}
+
+void KoColorSpacesBenchmark::benchmarkToQColors()
+{
+    START_THREADED_BENCHMARK
+    QBENCHMARK {
+        runInThreads(threads, [=] (int start, int numPixels) {
+            const int chunkSize = 4096;
+            QVector<QColor> colors(chunkSize);
+
+            const quint8 *data_it = data + start * pixelSize;
+            while (numPixels > 0) {
+                const int chunk = qMin(numPixels, chunkSize);
+                colorSpace->toQColors(data_it, colors.data(), chunk);
+                data_it += chunk * pixelSize;
+                numPixels -= chunk;
+            }
+        });
+    }
+    END_BENCHMARK
+}
+
+void KoColorSpacesBenchmark::benchmarkFromQColor_data()
+{
+    createThreadedRowsColumns();
+}
+
+void KoColorSpacesBenchmark::benchmarkFromQColor()
+{
+    START_THREADED_BENCHMARK
+    QBENCHMARK {
+        runInThreads(threads, [=] (int start, int numPixels) {
+            const QColor color(Qt::red);
+            quint8 *data_it = data + start * pixelSize;
+            for (int i = 0; i < numPixels; ++i) {
+                colorSpace->fromQColor(color, data_it);
+                data_it += pixelSize;
+            }
+        });
+    }
+    END_BENCHMARK
+}
+
 QTEST_MAIN(KoColorSpacesBenchmark)
@@ -26,6 +26,7 @@ class KoColorSpacesBenchmark : public QObject
     Q_OBJECT
 private:
     void createRowsColumns();
+    void createThreadedRowsColumns();
 private Q_SLOTS:
     void benchmarkAlpha_data();
     void benchmarkAlpha();
@@ -39,6 +40,12 @@ private Q_SLOTS:
     void benchmarkSetAlphaIndividualCall();
     void benchmarkSetAlpha2IndividualCall_data();
     void benchmarkSetAlpha2IndividualCall();
+    void benchmarkToQColor_data();
+    void benchmarkToQColor();
+    void benchmarkToQColors_data();
+    void benchmarkToQColors();
+    void benchmarkFromQColor_data();
+    void benchmarkFromQColor();
 };
 
 #endif
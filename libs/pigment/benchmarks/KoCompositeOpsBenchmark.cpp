@@ -24,8 +24,11 @@
 
 #include <KoColorSpaceTraits.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include <KoCompositeOp.h>
 
 #include <QTest>
+#include <QColor>
 
 const int TILE_WIDTH = 64;
 const int TILE_HEIGHT = 64;
@@ -38,6 +41,9 @@ const quint8 OPACITY_HALF = 128;
 const int TILES_IN_WIDTH = IMG_WIDTH / TILE_WIDTH;
 const int TILES_IN_HEIGHT = IMG_HEIGHT / TILE_HEIGHT;
 
+// big enough for the float RGBA pixels
+const int MAX_PIXEL_SIZE = 16;
+
 
 #define COMPOSITE_BENCHMARK \
         for (int y = 0; y < TILES_IN_HEIGHT; y++){                                              \
@@ -52,15 +58,15 @@ const int TILES_IN_HEIGHT = IMG_HEIGHT / TILE_HEIGHT;
 
 void KoCompositeOpsBenchmark::initTestCase()
 {
-    m_dstBuffer = new quint8[ TILE_WIDTH * TILE_HEIGHT * KoBgrU16Traits::pixelSize ];
-    m_srcBuffer = new quint8[ TILE_WIDTH * TILE_HEIGHT * KoBgrU16Traits::pixelSize ];
+    m_dstBuffer = new quint8[ TILE_WIDTH * TILE_HEIGHT * MAX_PIXEL_SIZE ];
+    m_srcBuffer = new quint8[ TILE_WIDTH * TILE_HEIGHT * MAX_PIXEL_SIZE ];
 }
 
 // this is called before every benchmark
 void KoCompositeOpsBenchmark::init()
 {
-    memset(m_dstBuffer, 42 , TILE_WIDTH * TILE_HEIGHT * KoBgrU16Traits::pixelSize);
-    memset(m_srcBuffer, 42 , TILE_WIDTH * TILE_HEIGHT * KoBgrU16Traits::pixelSize);
+    memset(m_dstBuffer, 42 , TILE_WIDTH * TILE_HEIGHT * MAX_PIXEL_SIZE);
+    memset(m_srcBuffer, 42 , TILE_WIDTH * TILE_HEIGHT * MAX_PIXEL_SIZE);
 }
 
 
@@ -87,5 +93,53 @@ void KoCompositeOpsBenchmark::benchmarkCompositeAlphaDarken()
     }
 }
 
+void KoCompositeOpsBenchmark::benchmarkCompositeAllModes_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+    QTest::addColumn<QString>("compositeOpId");
+
+    const QStringList depths({Integer8BitsColorDepthID.id(), Float32BitsColorDepthID.id()});
+
+    Q_FOREACH (const QString &depth, depths) {
+        const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depth, 0);
+        if (!cs) continue;
+
+        Q_FOREACH (KoCompositeOp *op, cs->compositeOps()) {
+            QTest::newRow(QString("%1-%2").arg(depth).arg(op->id()).toLatin1()) << depth << op->id();
+        }
+    }
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeAllModes()
+{
+    QFETCH(QString, colorDepthId);
+    QFETCH(QString, compositeOpId);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+    const KoCompositeOp *compositeOp = cs->compositeOp(compositeOpId);
+    const int pixelSize = cs->pixelSize();
+
+    /**
+     * Semi-transparent pixels of different colors, so that all the
+     * branches of the blending functions are taken
+     */
+    qsrand(1);
+    for (int i = 0; i < TILE_WIDTH * TILE_HEIGHT; i++) {
+        cs->fromQColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256), m_srcBuffer + i * pixelSize);
+        cs->fromQColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256), m_dstBuffer + i * pixelSize);
+    }
+
+    QBENCHMARK{
+        for (int y = 0; y < TILES_IN_HEIGHT; y++){
+            for (int x = 0; x < TILES_IN_WIDTH; x++){
+                compositeOp->composite(m_dstBuffer, TILE_WIDTH * pixelSize,
+                                       m_srcBuffer, TILE_WIDTH * pixelSize,
+                                       0, 0,
+                                       TILE_WIDTH, TILE_HEIGHT,
+                                       OPACITY_HALF);
+            }
+        }
+    }
+}
 
 QTEST_GUILESS_MAIN(KoCompositeOpsBenchmark)
@@ -58,6 +58,9 @@ struct OptimizedOpsSelector
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return new KoCompositeOpOver<Traits>(cs);
     }
+    static KoCompositeOp* createGenericOp(KoCompositeOp *op) {
+        return op;
+    }
 };
 
 template<>
@@ -69,6 +72,23 @@ struct OptimizedOpsSelector<KoBgrU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createGenericOp(KoCompositeOp *op) {
+        return KoOptimizedCompositeOpFactory::createGenericOp32(op);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoBgrU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createGenericOp(KoCompositeOp *op) {
+        return KoOptimizedCompositeOpFactory::createGenericOp64(op);
+    }
 };
 
 template<>
@@ -80,6 +100,9 @@ struct OptimizedOpsSelector<KoLabU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createGenericOp(KoCompositeOp *op) {
+        return op;
+    }
 };
 
 template<>
@@ -91,6 +114,9 @@ struct OptimizedOpsSelector<KoRgbF32Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp128(cs);
     }
+    static KoCompositeOp* createGenericOp(KoCompositeOp *op) {
+        return KoOptimizedCompositeOpFactory::createGenericOp128(op);
+    }
 };
 
 template<class Traits>
@@ -102,7 +128,7 @@ struct AddGeneralOps<Traits, true>
 
      template<CompositeFunc func>
      static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-         cs->addCompositeOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createGenericOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category)));
      }
 
      static void add(KoColorSpace* cs) {
@@ -35,6 +35,16 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp32(const KoColorSpace
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32> >(cs);
 }
 
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64> >(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64> >(cs);
+}
+
 KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOp128(const KoColorSpace *cs)
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken128> >(cs);
@@ -44,3 +54,18 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp128(const KoColorSpace
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128> >(cs);
 }
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericOp32(KoCompositeOp *fallbackOp)
+{
+    return createOptimizedClass<KoOptimizedGenericCompositeOpFactoryPerArch<4> >(fallbackOp);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericOp64(KoCompositeOp *fallbackOp)
+{
+    return createOptimizedClass<KoOptimizedGenericCompositeOpFactoryPerArch<8> >(fallbackOp);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createGenericOp128(KoCompositeOp *fallbackOp)
+{
+    return createOptimizedClass<KoOptimizedGenericCompositeOpFactoryPerArch<16> >(fallbackOp);
+}
@@ -42,8 +42,23 @@ class KRITAPIGMENT_EXPORT KoOptimizedCompositeOpFactory
 public:
     static KoCompositeOp* createAlphaDarkenOp32(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp32(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOp64(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOp64(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOp128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    /**
+     * Wraps a scalar KoCompositeOpGenericSC for a 8-bit BGRA (16-bit
+     * BGRA and float RGBA for the 64 and 128 versions) color space
+     * into a vectorized op, if the blending function of the op,
+     * defined by its id, has a vectorized implementation. The returned
+     * op takes the ownership of \p fallbackOp and uses it for the
+     * unusual channel flags combinations. If there is no vectorized
+     * implementation available, \p fallbackOp itself is returned.
+     */
+    static KoCompositeOp* createGenericOp32(KoCompositeOp *fallbackOp);
+    static KoCompositeOp* createGenericOp64(KoCompositeOp *fallbackOp);
+    static KoCompositeOp* createGenericOp128(KoCompositeOp *fallbackOp);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
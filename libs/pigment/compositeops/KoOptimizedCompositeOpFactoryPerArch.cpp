@@ -23,9 +23,12 @@
 
 #include "KoOptimizedCompositeOpFactoryPerArch.h"
 #include "KoOptimizedCompositeOpAlphaDarken32.h"
+#include "KoOptimizedCompositeOpAlphaDarken64.h"
 #include "KoOptimizedCompositeOpAlphaDarken128.h"
 #include "KoOptimizedCompositeOpOver32.h"
+#include "KoOptimizedCompositeOpOver64.h"
 #include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpGeneric.h"
 
 #include <QString>
 #include "DebugPigment.h"
@@ -52,6 +55,22 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32>::create<Vc::C
     return new KoOptimizedCompositeOpOver32<Vc::CurrentImplementation::current()>(param);
 }
 
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarken64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpOver64<Vc::CurrentImplementation::current()>(param);
+}
+
 template<>
 template<>
 KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken128>::ReturnType
@@ -67,3 +86,27 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoOptimizedCompositeOpOver128<Vc::CurrentImplementation::current()>(param);
 }
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createOptimizedGenericCompositeOp<KoOptimizedCompositeOpGeneric32, Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<8>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<8>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createOptimizedGenericCompositeOp<KoOptimizedCompositeOpGeneric64, Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createOptimizedGenericCompositeOp<KoOptimizedCompositeOpGeneric128, Vc::CurrentImplementation::current()>(param);
+}
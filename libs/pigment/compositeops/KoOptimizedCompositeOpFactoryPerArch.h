@@ -34,6 +34,12 @@ class KoOptimizedCompositeOpAlphaDarken32;
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver32;
 
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarken64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOver64;
+
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpAlphaDarken128;
 
@@ -50,5 +56,20 @@ struct KoOptimizedCompositeOpFactoryPerArch
     static ReturnType create(ParamType param);
 };
 
+/**
+ * Wraps a scalar KoCompositeOpGenericSC into a vectorized op for
+ * the pixels of \p pixelSize bytes, see
+ * KoOptimizedCompositeOpFactory::createGenericOp32()
+ */
+template<int pixelSize>
+struct KoOptimizedGenericCompositeOpFactoryPerArch
+{
+    typedef KoCompositeOp* ParamType;
+    typedef KoCompositeOp* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType param);
+};
+
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORYPERARCH_H */
@@ -40,6 +40,22 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32>::create<Vc::S
     return new KoCompositeOpOver<KoBgrU8Traits>(param);
 }
 
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpAlphaDarken<KoBgrU16Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpOver<KoBgrU16Traits>(param);
+}
+
 template<>
 template<>
 KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken128>::ReturnType
@@ -55,3 +71,27 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoCompositeOpOver<KoRgbF32Traits>(param);
 }
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return param;
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<8>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<8>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return param;
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return param;
+}
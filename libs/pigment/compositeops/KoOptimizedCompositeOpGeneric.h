@@ -0,0 +1,764 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERIC_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERIC_H
+
+#include <QScopedPointer>
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+#include <cmath>
+
+
+/**
+ * Overloads that let the blending functions below be written once and
+ * be instantiated both for Vc::float_v (vectorized part of a row) and
+ * for plain float (unaligned head and tail of a row)
+ */
+namespace KoStreamedBlendMath {
+
+ALWAYS_INLINE float selectValue(bool condition, float trueValue, float falseValue) {
+    return condition ? trueValue : falseValue;
+}
+
+ALWAYS_INLINE Vc::float_v selectValue(const Vc::float_m &condition, Vc::float_v::AsArg trueValue, Vc::float_v::AsArg falseValue) {
+    return Vc::iif(condition, trueValue, falseValue);
+}
+
+ALWAYS_INLINE float minValue(float a, float b) { return qMin(a, b); }
+ALWAYS_INLINE float maxValue(float a, float b) { return qMax(a, b); }
+ALWAYS_INLINE float absValue(float a) { return std::abs(a); }
+ALWAYS_INLINE float sqrtValue(float a) { return std::sqrt(a); }
+
+ALWAYS_INLINE Vc::float_v minValue(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::min(a, b); }
+ALWAYS_INLINE Vc::float_v maxValue(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::max(a, b); }
+ALWAYS_INLINE Vc::float_v absValue(Vc::float_v::AsArg a) { return Vc::abs(a); }
+ALWAYS_INLINE Vc::float_v sqrtValue(Vc::float_v::AsArg a) { return Vc::sqrt(a); }
+
+}
+
+/**
+ * Vectorized counterparts of the separable cf* functions from
+ * KoCompositeOpFunctions.h. All the values are normalized into [0, 1]
+ * range, the result is *not* clamped, that is done by the compositor
+ * for integer color spaces only (the same way as Arithmetic::clamp()
+ * behaves for the scalar versions).
+ *
+ * Functions that need pow() or atan() (Gamma Dark, Gamma Light and
+ * Arcus Tangent) are not vectorized and stay in the scalar
+ * KoCompositeOpGenericSC.
+ */
+namespace KoStreamedBlendFunctions {
+
+using namespace KoStreamedBlendMath;
+
+struct Multiply {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src * dst;
+    }
+};
+
+struct Screen {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src + dst - src * dst;
+    }
+};
+
+struct HardLight {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T src2 = src + src;
+        const T src2m1 = src2 - T(1.0f);
+        return selectValue(src > T(0.5f), src2m1 + dst - src2m1 * dst, src2 * dst);
+    }
+};
+
+struct Overlay {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return HardLight::blend(dst, src);
+    }
+};
+
+struct ColorDodge {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T invSrc = T(1.0f) - src;
+        return selectValue(dst == T(0.0f), T(0.0f),
+                      selectValue(invSrc < dst, T(1.0f), dst / invSrc));
+    }
+};
+
+struct ColorBurn {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T invDst = T(1.0f) - dst;
+        return selectValue(dst == T(1.0f), T(1.0f),
+                      selectValue(src < invDst, T(0.0f), T(1.0f) - invDst / src));
+    }
+};
+
+struct Addition {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src + dst;
+    }
+};
+
+struct LinearBurn {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src + dst - T(1.0f);
+    }
+};
+
+struct Subtract {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return dst - src;
+    }
+};
+
+struct InverseSubtract {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return dst - (T(1.0f) - src);
+    }
+};
+
+struct Exclusion {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T x = src * dst;
+        return dst + src - (x + x);
+    }
+};
+
+struct Divide {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return selectValue(src == T(0.0f),
+                      selectValue(dst == T(0.0f), T(0.0f), T(1.0f)),
+                      dst / src);
+    }
+};
+
+struct SoftLightSvg {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T d = selectValue(dst > T(0.25f),
+                           sqrtValue(dst),
+                           ((T(16.0f) * dst - T(12.0f)) * dst + T(4.0f)) * dst);
+
+        return selectValue(src > T(0.5f),
+                      dst + (T(2.0f) * src - T(1.0f)) * (d - dst),
+                      dst - (T(1.0f) - T(2.0f) * src) * dst * (T(1.0f) - dst));
+    }
+};
+
+struct SoftLight {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return selectValue(src > T(0.5f),
+                      dst + (T(2.0f) * src - T(1.0f)) * (sqrtValue(dst) - dst),
+                      dst - (T(1.0f) - T(2.0f) * src) * dst * (T(1.0f) - dst));
+    }
+};
+
+struct VividLight {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T burn =
+            selectValue(src == T(0.0f),
+                   selectValue(dst == T(1.0f), T(1.0f), T(0.0f)),
+                   T(1.0f) - (T(1.0f) - dst) / (src + src));
+
+        const T invSrc = T(1.0f) - src;
+        const T dodge =
+            selectValue(src == T(1.0f),
+                   selectValue(dst == T(0.0f), T(0.0f), T(1.0f)),
+                   dst / (invSrc + invSrc));
+
+        return selectValue(src < T(0.5f), burn, dodge);
+    }
+};
+
+struct PinLight {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T src2 = src + src;
+        return maxValue(src2 - T(1.0f), minValue(dst, src2));
+    }
+};
+
+struct Allanon {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return (src + dst) * T(0.5f);
+    }
+};
+
+struct LinearLight {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src + src + dst - T(1.0f);
+    }
+};
+
+struct Parallel {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T s = selectValue(src != T(0.0f), T(1.0f) / src, T(1.0f));
+        const T d = selectValue(dst != T(0.0f), T(1.0f) / dst, T(1.0f));
+        return T(2.0f) / (d + s);
+    }
+};
+
+struct Equivalence {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return absValue(dst - src);
+    }
+};
+
+struct GrainMerge {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return dst + src - T(0.5f);
+    }
+};
+
+struct GrainExtract {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return dst - src + T(0.5f);
+    }
+};
+
+struct HardMix {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return selectValue(dst > T(0.5f), ColorDodge::blend(src, dst), ColorBurn::blend(src, dst));
+    }
+};
+
+struct AdditiveSubtractive {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return absValue(sqrtValue(dst) - sqrtValue(src));
+    }
+};
+
+struct GeometricMean {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return sqrtValue(dst * src);
+    }
+};
+
+struct HardOverlay {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return selectValue(src > T(0.5f),
+                      Divide::blend(T(2.0f) - (src + src), dst),
+                      (src + src) * dst);
+    }
+};
+
+struct Difference {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return absValue(src - dst);
+    }
+};
+
+struct DarkenOnly {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return minValue(src, dst);
+    }
+};
+
+struct LightenOnly {
+    template<typename T> static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return maxValue(src, dst);
+    }
+};
+
+}
+
+/**
+ * The math of KoCompositeOpGenericSC::composeColorChannels() written
+ * for normalized float values. \p T is either float or Vc::float_v.
+ */
+template<class BlendFunc, bool alphaLocked, bool clampResult>
+struct GenericSCCompositeMath {
+    template<typename T>
+    static ALWAYS_INLINE T blendChannel(const T &src, const T &dst) {
+        using namespace KoStreamedBlendMath;
+
+        T result = BlendFunc::blend(src, dst);
+
+        if (clampResult) {
+            result = minValue(maxValue(result, T(0.0f)), T(1.0f));
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    static ALWAYS_INLINE void compose(const T *srcColor, const T &srcAlpha, T *dstColor, T &dstAlpha) {
+        using namespace KoStreamedBlendMath;
+
+        const T zeroValue(0.0f);
+        const T oneValue(1.0f);
+
+        if (alphaLocked) {
+            for (int i = 0; i < 3; i++) {
+                const T result = blendChannel(srcColor[i], dstColor[i]);
+
+                /**
+                 * KoCompositeOpBase clears the transparent pixels
+                 * when some of the channels are locked
+                 */
+                dstColor[i] = selectValue(dstAlpha == zeroValue, zeroValue,
+                                     dstColor[i] + srcAlpha * (result - dstColor[i]));
+            }
+        } else {
+            const T newDstAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha;
+            const T srcOnly = (oneValue - dstAlpha) * srcAlpha;
+            const T dstOnly = (oneValue - srcAlpha) * dstAlpha;
+            const T both = srcAlpha * dstAlpha;
+
+            for (int i = 0; i < 3; i++) {
+                const T result = blendChannel(srcColor[i], dstColor[i]);
+                const T value = (dstOnly * dstColor[i] + srcOnly * srcColor[i] + both * result) / newDstAlpha;
+
+                dstColor[i] = selectValue(newDstAlpha == zeroValue, dstColor[i], value);
+            }
+
+            dstAlpha = newDstAlpha;
+        }
+    }
+};
+
+/**
+ * Compositor for 8-bit 4-channel pixels with alpha stored in the
+ * most significant byte. The colors are processed in any order, since
+ * all the supported blending functions are separable.
+ */
+template<class BlendFunc, bool alphaLocked>
+struct GenericSCCompositor32 {
+    typedef GenericSCCompositeMath<BlendFunc, alphaLocked, true> Math;
+
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint8Max((float)255.0);
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+
+        Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        src_alpha *= Vc::float_v(opacity) * uint8MaxRec1;
+
+        if (haveMask) {
+            src_alpha *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        const bool srcIsTransparent = (src_alpha == zeroValue).isFull();
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if (!alphaLocked && srcIsTransparent) {
+            return;
+        }
+
+        Vc::float_v dst_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<true>(dst) * uint8MaxRec1;
+
+        if (alphaLocked && srcIsTransparent && (dst_alpha == zeroValue).isEmpty()) {
+            return;
+        }
+
+        Vc::float_v src_c[3];
+        Vc::float_v dst_c[3];
+
+        KoStreamedMath<_impl>::template fetch_colors_32<src_aligned>(src, src_c[0], src_c[1], src_c[2]);
+        KoStreamedMath<_impl>::template fetch_colors_32<true>(dst, dst_c[0], dst_c[1], dst_c[2]);
+
+        for (int i = 0; i < 3; i++) {
+            src_c[i] *= uint8MaxRec1;
+            dst_c[i] *= uint8MaxRec1;
+        }
+
+        Math::compose(src_c, src_alpha, dst_c, dst_alpha);
+
+        KoStreamedMath<_impl>::write_channels_32(dst,
+                                                 dst_alpha * uint8Max,
+                                                 dst_c[0] * uint8Max,
+                                                 dst_c[1] * uint8Max,
+                                                 dst_c[2] * uint8Max);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const qint32 alpha_pos = 3;
+        const float uint8Rec1 = 1.0 / 255.0;
+        const float uint8Max = 255.0;
+
+        float srcAlpha = src[alpha_pos] * opacity * uint8Rec1;
+
+        if (haveMask) {
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (!alphaLocked && srcAlpha == 0.0f) {
+            return;
+        }
+
+        float dstAlpha = dst[alpha_pos] * uint8Rec1;
+
+        float srcColor[3];
+        float dstColor[3];
+
+        for (int i = 0; i < 3; i++) {
+            srcColor[i] = src[i] * uint8Rec1;
+            dstColor[i] = dst[i] * uint8Rec1;
+        }
+
+        Math::compose(srcColor, srcAlpha, dstColor, dstAlpha);
+
+        for (int i = 0; i < 3; i++) {
+            dst[i] = KoStreamedMath<_impl>::round_float_to_uint(dstColor[i] * uint8Max);
+        }
+
+        if (!alphaLocked) {
+            dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_uint(dstAlpha * uint8Max);
+        }
+    }
+};
+
+/**
+ * Compositor for 16-bit integer 4-channel pixels: C1_C2_C3_A
+ */
+template<class BlendFunc, bool alphaLocked>
+struct GenericSCCompositor64 {
+    typedef GenericSCCompositeMath<BlendFunc, alphaLocked, true> Math;
+
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint16Max((float)65535.0);
+        const Vc::float_v uint16MaxRec1((float)1.0 / 65535.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+
+        Vc::float_v src_c[3];
+        Vc::float_v src_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(src, src_c[0], src_c[1], src_c[2], src_alpha);
+        src_alpha *= Vc::float_v(opacity) * uint16MaxRec1;
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+            src_alpha *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        const bool srcIsTransparent = (src_alpha == zeroValue).isFull();
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if (!alphaLocked && srcIsTransparent) {
+            return;
+        }
+
+        Vc::float_v dst_c[3];
+        Vc::float_v dst_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(dst, dst_c[0], dst_c[1], dst_c[2], dst_alpha);
+        dst_alpha *= uint16MaxRec1;
+
+        if (alphaLocked && srcIsTransparent && (dst_alpha == zeroValue).isEmpty()) {
+            return;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            src_c[i] *= uint16MaxRec1;
+            dst_c[i] *= uint16MaxRec1;
+        }
+
+        Math::compose(src_c, src_alpha, dst_c, dst_alpha);
+
+        KoStreamedMath<_impl>::write_channels_64(dst,
+                                                 dst_alpha * uint16Max,
+                                                 dst_c[0] * uint16Max,
+                                                 dst_c[1] * uint16Max,
+                                                 dst_c[2] * uint16Max);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const qint32 alpha_pos = 3;
+        const float uint16Rec1 = 1.0 / 65535.0;
+        const float uint16Max = 65535.0;
+
+        const quint16 *s = reinterpret_cast<const quint16*>(src);
+        quint16 *d = reinterpret_cast<quint16*>(dst);
+
+        float srcAlpha = s[alpha_pos] * opacity * uint16Rec1;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255.0;
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (!alphaLocked && srcAlpha == 0.0f) {
+            return;
+        }
+
+        float dstAlpha = d[alpha_pos] * uint16Rec1;
+
+        float srcColor[3];
+        float dstColor[3];
+
+        for (int i = 0; i < 3; i++) {
+            srcColor[i] = s[i] * uint16Rec1;
+            dstColor[i] = d[i] * uint16Rec1;
+        }
+
+        Math::compose(srcColor, srcAlpha, dstColor, dstAlpha);
+
+        for (int i = 0; i < 3; i++) {
+            d[i] = KoStreamedMath<_impl>::round_float_to_u16(dstColor[i] * uint16Max);
+        }
+
+        if (!alphaLocked) {
+            d[alpha_pos] = KoStreamedMath<_impl>::round_float_to_u16(dstAlpha * uint16Max);
+        }
+    }
+};
+
+/**
+ * Compositor for 32-bit float 4-channel pixels: C1_C2_C3_A
+ */
+template<class BlendFunc, bool alphaLocked>
+struct GenericSCCompositor128 {
+    typedef GenericSCCompositeMath<BlendFunc, alphaLocked, false> Math;
+
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    struct Pixel {
+        float red;
+        float green;
+        float blue;
+        float alpha;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Pixel *sp = reinterpret_cast<const Pixel*>(src);
+        Pixel *dp = reinterpret_cast<Pixel*>(dst);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+
+        Vc::float_v src_c[3];
+        Vc::float_v src_alpha;
+
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> data(const_cast<Pixel*>(sp));
+        tie(src_c[0], src_c[1], src_c[2], src_alpha) = data[indexes];
+
+        src_alpha *= Vc::float_v(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            src_alpha *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        const bool srcIsTransparent = (src_alpha == zeroValue).isFull();
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if (!alphaLocked && srcIsTransparent) {
+            return;
+        }
+
+        Vc::float_v dst_c[3];
+        Vc::float_v dst_alpha;
+
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> dataDest(dp);
+        tie(dst_c[0], dst_c[1], dst_c[2], dst_alpha) = dataDest[indexes];
+
+        if (alphaLocked && srcIsTransparent && (dst_alpha == zeroValue).isEmpty()) {
+            return;
+        }
+
+        Math::compose(src_c, src_alpha, dst_c, dst_alpha);
+
+        dataDest[indexes] = tie(dst_c[0], dst_c[1], dst_c[2], dst_alpha);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const qint32 alpha_pos = 3;
+
+        const float *s = reinterpret_cast<const float*>(src);
+        float *d = reinterpret_cast<float*>(dst);
+
+        float srcAlpha = s[alpha_pos] * opacity;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255;
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (!alphaLocked && srcAlpha == 0.0f) {
+            return;
+        }
+
+        float dstAlpha = d[alpha_pos];
+
+        Math::compose(s, srcAlpha, d, dstAlpha);
+
+        if (!alphaLocked) {
+            d[alpha_pos] = dstAlpha;
+        }
+    }
+};
+
+/**
+ * A vectorized version of KoCompositeOpGenericSC for the 4-channel
+ * color spaces with alpha channel placed at the last position. The
+ * \p Compositor defines the pixel format.
+ *
+ * The vectorized code handles the cases when all the channels are
+ * enabled and when only alpha is locked. All the other combinations of
+ * the channel flags are passed to the scalar \p fallbackOp, which is
+ * also used to get the id, description and category of the op. The op
+ * takes ownership of \p fallbackOp.
+ */
+template<Vc::Implementation _impl, class BlendFunc, template<class, bool> class Compositor, int pixelSize>
+class KoOptimizedCompositeOpGeneric : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpGeneric(KoCompositeOp *fallbackOp)
+        : KoCompositeOp(fallbackOp->colorSpace(), fallbackOp->id(), fallbackOp->description(), fallbackOp->category()),
+          m_fallbackOp(fallbackOp)
+    {
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        const QBitArray &flags = params.channelFlags;
+
+        if (flags.isEmpty() || flags == QBitArray(4, true)) {
+            compositeImpl<false>(params);
+        } else if (flags.size() == 4 && !flags.testBit(3) && flags.count(true) == 3) {
+            compositeImpl<true>(params);
+        } else {
+            m_fallbackOp->composite(params);
+        }
+    }
+
+private:
+    template <bool alphaLocked>
+    inline void compositeImpl(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.maskRowStart) {
+            KoStreamedMath<_impl>::template genericComposite<true, false, Compositor<BlendFunc, alphaLocked>, pixelSize>(params);
+        } else {
+            KoStreamedMath<_impl>::template genericComposite<false, false, Compositor<BlendFunc, alphaLocked>, pixelSize>(params);
+        }
+    }
+
+private:
+    QScopedPointer<KoCompositeOp> m_fallbackOp;
+};
+
+template<Vc::Implementation _impl, class BlendFunc>
+using KoOptimizedCompositeOpGeneric32 = KoOptimizedCompositeOpGeneric<_impl, BlendFunc, GenericSCCompositor32, 4>;
+
+template<Vc::Implementation _impl, class BlendFunc>
+using KoOptimizedCompositeOpGeneric64 = KoOptimizedCompositeOpGeneric<_impl, BlendFunc, GenericSCCompositor64, 8>;
+
+template<Vc::Implementation _impl, class BlendFunc>
+using KoOptimizedCompositeOpGeneric128 = KoOptimizedCompositeOpGeneric<_impl, BlendFunc, GenericSCCompositor128, 16>;
+
+/**
+ * Wraps \p fallbackOp into a vectorized op if its id is one of the
+ * supported separable blending modes. Otherwise returns \p fallbackOp
+ * itself.
+ */
+template<template<Vc::Implementation, class> class CompositeOp, Vc::Implementation _impl>
+KoCompositeOp* createOptimizedGenericCompositeOp(KoCompositeOp *fallbackOp)
+{
+    using namespace KoStreamedBlendFunctions;
+
+    const QString id = fallbackOp->id();
+
+    if (id == COMPOSITE_OVERLAY) return new CompositeOp<_impl, Overlay>(fallbackOp);
+    if (id == COMPOSITE_GRAIN_MERGE) return new CompositeOp<_impl, GrainMerge>(fallbackOp);
+    if (id == COMPOSITE_GRAIN_EXTRACT) return new CompositeOp<_impl, GrainExtract>(fallbackOp);
+    if (id == COMPOSITE_HARD_MIX) return new CompositeOp<_impl, HardMix>(fallbackOp);
+    if (id == COMPOSITE_GEOMETRIC_MEAN) return new CompositeOp<_impl, GeometricMean>(fallbackOp);
+    if (id == COMPOSITE_PARALLEL) return new CompositeOp<_impl, Parallel>(fallbackOp);
+    if (id == COMPOSITE_ALLANON) return new CompositeOp<_impl, Allanon>(fallbackOp);
+    if (id == COMPOSITE_HARD_OVERLAY) return new CompositeOp<_impl, HardOverlay>(fallbackOp);
+
+    if (id == COMPOSITE_SCREEN) return new CompositeOp<_impl, Screen>(fallbackOp);
+    if (id == COMPOSITE_DODGE) return new CompositeOp<_impl, ColorDodge>(fallbackOp);
+    if (id == COMPOSITE_LINEAR_DODGE) return new CompositeOp<_impl, Addition>(fallbackOp);
+    if (id == COMPOSITE_LIGHTEN) return new CompositeOp<_impl, LightenOnly>(fallbackOp);
+    if (id == COMPOSITE_HARD_LIGHT) return new CompositeOp<_impl, HardLight>(fallbackOp);
+    if (id == COMPOSITE_SOFT_LIGHT_SVG) return new CompositeOp<_impl, SoftLightSvg>(fallbackOp);
+    if (id == COMPOSITE_SOFT_LIGHT_PHOTOSHOP) return new CompositeOp<_impl, SoftLight>(fallbackOp);
+    if (id == COMPOSITE_VIVID_LIGHT) return new CompositeOp<_impl, VividLight>(fallbackOp);
+    if (id == COMPOSITE_PIN_LIGHT) return new CompositeOp<_impl, PinLight>(fallbackOp);
+    if (id == COMPOSITE_LINEAR_LIGHT) return new CompositeOp<_impl, LinearLight>(fallbackOp);
+
+    if (id == COMPOSITE_BURN) return new CompositeOp<_impl, ColorBurn>(fallbackOp);
+    if (id == COMPOSITE_LINEAR_BURN) return new CompositeOp<_impl, LinearBurn>(fallbackOp);
+    if (id == COMPOSITE_DARKEN) return new CompositeOp<_impl, DarkenOnly>(fallbackOp);
+
+    if (id == COMPOSITE_ADD) return new CompositeOp<_impl, Addition>(fallbackOp);
+    if (id == COMPOSITE_SUBTRACT) return new CompositeOp<_impl, Subtract>(fallbackOp);
+    if (id == COMPOSITE_INVERSE_SUBTRACT) return new CompositeOp<_impl, InverseSubtract>(fallbackOp);
+    if (id == COMPOSITE_MULT) return new CompositeOp<_impl, Multiply>(fallbackOp);
+    if (id == COMPOSITE_DIVIDE) return new CompositeOp<_impl, Divide>(fallbackOp);
+
+    if (id == COMPOSITE_DIFF) return new CompositeOp<_impl, Difference>(fallbackOp);
+    if (id == COMPOSITE_EXCLUSION) return new CompositeOp<_impl, Exclusion>(fallbackOp);
+    if (id == COMPOSITE_EQUIVALENCE) return new CompositeOp<_impl, Equivalence>(fallbackOp);
+    if (id == COMPOSITE_ADDITIVE_SUBTRACTIVE) return new CompositeOp<_impl, AdditiveSubtractive>(fallbackOp);
+
+    return fallbackOp;
+}
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERIC_H
@@ -96,6 +96,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite_novector<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64_novector(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite_novector<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128_novector(const KoCompositeOp::ParameterInfo& params)
 {
@@ -110,6 +116,14 @@ static inline quint8 lerp_mixed_u8_float(quint8 a, quint8 b, float alpha) {
     return round_float_to_uint(qint16(b - a) * alpha + a);
 }
 
+static inline quint16 round_float_to_u16(float value) {
+    return quint16(value + float(0.5));
+}
+
+static inline quint16 lerp_mixed_u16_float(quint16 a, quint16 b, float alpha) {
+    return round_float_to_u16(qint32(b - a) * alpha + a);
+}
+
 /**
  * Get a vector containing first Vc::float_v::size() values of mask.
  * Each source mask element is considered to be a 8-bit integer
@@ -208,6 +222,57 @@ static inline void write_channels_32(quint8 *data,
     (v1 | v3).store((quint32*)data, Vc::Aligned);
 }
 
+/**
+ * Get color and alpha values from Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The alpha value is considered to be
+ * stored in the last channel of the pixel. The values are not
+ * normalized, that is they are returned in [0, 65535] range.
+ *
+ * The pixels are gathered with 32-bit words, so \p data may be
+ * unaligned to the vector boundary.
+ */
+static inline void fetch_channels_64(const quint8 *data,
+                                     Vc::float_v &c1,
+                                     Vc::float_v &c2,
+                                     Vc::float_v &c3,
+                                     Vc::float_v &alpha) {
+    const quint32 *words = reinterpret_cast<const quint32*>(data);
+    const int_v indexes = int_v::IndexesFromZero() * 2;
+
+    const uint_v lowWords(words, indexes);
+    const uint_v highWords(words + 1, indexes);
+
+    const quint32 lowWordMask = 0xFFFF;
+    uint_v mask(lowWordMask);
+
+    c1 = Vc::float_v(int_v(lowWords & mask));
+    c2 = Vc::float_v(int_v(lowWords >> 16));
+    c3 = Vc::float_v(int_v(highWords & mask));
+    alpha = Vc::float_v(int_v(highWords >> 16));
+}
+
+/**
+ * Pack color and alpha values to Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The values are expected to be in
+ * [0, 65535] range.
+ */
+static inline void write_channels_64(quint8 *data,
+                                     Vc::float_v::AsArg alpha,
+                                     Vc::float_v::AsArg c1,
+                                     Vc::float_v::AsArg c2,
+                                     Vc::float_v::AsArg c3) {
+    quint32 *words = reinterpret_cast<quint32*>(data);
+    const int_v indexes = int_v::IndexesFromZero() * 2;
+
+    const uint_v lowWords =
+        uint_v(int_v(Vc::round(c1))) | (uint_v(int_v(Vc::round(c2))) << 16);
+    const uint_v highWords =
+        uint_v(int_v(Vc::round(c3))) | (uint_v(int_v(Vc::round(alpha))) << 16);
+
+    lowWords.scatter(words, indexes);
+    highWords.scatter(words + 1, indexes);
+}
+
 /**
  * Composes src pixels into dst pixles. Is optimized for 32-bit-per-pixel
  * colorspaces. Uses \p Compositor strategy parameter for doing actual
@@ -375,6 +440,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128(const KoCompositeOp::ParameterInfo& params)
 {
@@ -395,6 +466,13 @@ ALWAYS_INLINE void clearPixel<4>(quint8* dst)
     *d = 0;
 }
 
+template<>
+ALWAYS_INLINE void clearPixel<8>(quint8* dst)
+{
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = 0;
+}
+
 template<>
 ALWAYS_INLINE void clearPixel<16>(quint8* dst)
 {
@@ -414,6 +492,14 @@ ALWAYS_INLINE void copyPixel<4>(const quint8 *src, quint8* dst)
     *d = *s;
 }
 
+template<>
+ALWAYS_INLINE void copyPixel<8>(const quint8 *src, quint8* dst)
+{
+    const quint64 *s = reinterpret_cast<const quint64*>(src);
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = *s;
+}
+
 template<>
 ALWAYS_INLINE void copyPixel<16>(const quint8 *src, quint8* dst)
 {
@@ -0,0 +1,225 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestKoColorConversionCache.h"
+
+#include <functional>
+
+#include <QTest>
+#include <QThread>
+#include <QSemaphore>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorConversionCache.h>
+
+namespace {
+
+class FunctionThread : public QThread
+{
+public:
+    FunctionThread(std::function<void()> func)
+        : m_func(func)
+    {
+    }
+
+protected:
+    void run() override {
+        m_func();
+    }
+
+private:
+    std::function<void()> m_func;
+};
+
+KoCachedColorConversionTransformation lookup(const KoColorSpace *src, const KoColorSpace *dst)
+{
+    return KoColorSpaceRegistry::instance()->colorConversionCache()->
+        cachedConverter(src, dst,
+                        KoColorConversionTransformation::internalRenderingIntent(),
+                        KoColorConversionTransformation::internalConversionFlags());
+}
+
+}
+
+void TestKoColorConversionCache::testReuseInSameThread()
+{
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+
+    const KoColorConversionTransformation *transfo = 0;
+
+    {
+        KoCachedColorConversionTransformation cct1 = lookup(rgb8, rgb16);
+        transfo = cct1.transformation();
+
+        QCOMPARE(transfo->srcColorSpace(), rgb8);
+        QCOMPARE(transfo->dstColorSpace(), rgb16);
+
+        // the thread may reuse its converter while still holding it
+        KoCachedColorConversionTransformation cct2 = lookup(rgb8, rgb16);
+        QCOMPARE(cct2.transformation(), transfo);
+
+        // a different conversion should not evict the first one
+        KoCachedColorConversionTransformation cct3 = lookup(rgb16, rgb8);
+        QVERIFY(cct3.transformation() != transfo);
+        QCOMPARE(cct3.transformation()->srcColorSpace(), rgb16);
+    }
+
+    KoCachedColorConversionTransformation cct4 = lookup(rgb8, rgb16);
+    QCOMPARE(cct4.transformation(), transfo);
+}
+
+void TestKoColorConversionCache::testConcurrentLookups_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("2") << 2;
+    QTest::newRow("4") << 4;
+    QTest::newRow("8") << 8;
+}
+
+void TestKoColorConversionCache::testConcurrentLookups()
+{
+    QFETCH(int, numThreads);
+
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+
+    /**
+     * Small conversions, so that the threads spend most of the time
+     * looking up the converter concurrently
+     */
+    const int numPixels = 16;
+    const int numIterations = 10000;
+
+    QVector<quint8> srcPixels(numPixels * rgb8->pixelSize());
+    for (int i = 0; i < srcPixels.size(); i++) {
+        srcPixels[i] = quint8(i * 37);
+    }
+
+    QVector<quint8> referencePixels(numPixels * rgb16->pixelSize());
+    rgb8->convertPixelsTo(srcPixels.constData(), referencePixels.data(), rgb16, numPixels,
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags());
+
+    QVector<bool> results(numThreads, false);
+    QVector<const KoColorConversionTransformation*> usedTransfos(numThreads, 0);
+    QSemaphore allLookedUp;
+    QSemaphore canFinish;
+
+    QList<QThread*> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads << new FunctionThread([&, i] () {
+            QVector<quint8> dstPixels(numPixels * rgb16->pixelSize());
+            bool result = true;
+
+            for (int j = 0; j < numIterations; j++) {
+                rgb8->convertPixelsTo(srcPixels.constData(), dstPixels.data(), rgb16, numPixels,
+                                      KoColorConversionTransformation::internalRenderingIntent(),
+                                      KoColorConversionTransformation::internalConversionFlags());
+                result &= dstPixels == referencePixels;
+            }
+            results[i] = result;
+
+            /**
+             * Hold the converter until all the threads got theirs, so
+             * we can check that no converter is shared between threads
+             */
+            KoCachedColorConversionTransformation cct = lookup(rgb8, rgb16);
+            usedTransfos[i] = cct.transformation();
+            allLookedUp.release();
+            canFinish.acquire();
+        });
+    }
+
+    Q_FOREACH (QThread *thread, threads) {
+        thread->start();
+    }
+
+    allLookedUp.acquire(numThreads);
+    canFinish.release(numThreads);
+
+    Q_FOREACH (QThread *thread, threads) {
+        thread->wait();
+    }
+    qDeleteAll(threads);
+
+    for (int i = 0; i < numThreads; i++) {
+        QVERIFY(results[i]);
+        QVERIFY(usedTransfos[i]);
+
+        for (int j = i + 1; j < numThreads; j++) {
+            QVERIFY(usedTransfos[i] != usedTransfos[j]);
+        }
+    }
+}
+
+void TestKoColorConversionCache::testColorSpaceIsDestroyed()
+{
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+
+    KoColorSpace *clone1 = KoColorSpaceRegistry::instance()->rgb8()->clone();
+    KoColorSpace *clone2 = 0;
+
+    QSemaphore cloneDestroyed;
+    QSemaphore lookedUp;
+
+    const KoColorSpace *firstSrc = 0;
+    const KoColorSpace *secondSrc = 0;
+
+    FunctionThread thread([&] () {
+        {
+            KoCachedColorConversionTransformation cct = lookup(clone1, rgb16);
+            firstSrc = cct.transformation()->srcColorSpace();
+        }
+
+        /**
+         * The converter is still kept in the local cache of the
+         * thread while the color space is being destroyed
+         */
+        lookedUp.release();
+        cloneDestroyed.acquire();
+
+        KoCachedColorConversionTransformation cct = lookup(clone2, rgb16);
+        secondSrc = cct.transformation()->srcColorSpace();
+    });
+
+    thread.start();
+    lookedUp.acquire();
+
+    delete clone1;
+    clone2 = KoColorSpaceRegistry::instance()->rgb8()->clone();
+
+    cloneDestroyed.release();
+    thread.wait();
+
+    QCOMPARE(firstSrc, static_cast<const KoColorSpace*>(clone1));
+    QCOMPARE(secondSrc, static_cast<const KoColorSpace*>(clone2));
+
+    {
+        KoCachedColorConversionTransformation cct = lookup(clone2, rgb16);
+        QCOMPARE(cct.transformation()->srcColorSpace(), static_cast<const KoColorSpace*>(clone2));
+    }
+
+    delete clone2;
+}
+
+QTEST_GUILESS_MAIN(TestKoColorConversionCache)
@@ -0,0 +1,254 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestKoOptimizedCompositeOps.h"
+
+#include <QTest>
+#include <QBitArray>
+
+#include <KoColorSpaceTraits.h>
+#include <KoOptimizedCompositeOpFactory.h>
+#include <KoCompositeOpRegistry.h>
+#include "../compositeops/KoCompositeOpGeneric.h"
+#include "../compositeops/KoCompositeOpOver.h"
+#include "../compositeops/KoCompositeOpAlphaDarken.h"
+
+namespace {
+
+template<class Traits>
+QVector<KoCompositeOp*> createScalarGenericOps()
+{
+    typedef typename Traits::channels_type Arg;
+
+    QVector<KoCompositeOp*> ops;
+
+#define ADD_GENERIC_OP(func, id) \
+    ops << new KoCompositeOpGenericSC<Traits, &func<Arg> >(0, id, id, QString())
+
+    ADD_GENERIC_OP(cfOverlay, COMPOSITE_OVERLAY);
+    ADD_GENERIC_OP(cfGrainMerge, COMPOSITE_GRAIN_MERGE);
+    ADD_GENERIC_OP(cfGrainExtract, COMPOSITE_GRAIN_EXTRACT);
+    ADD_GENERIC_OP(cfHardMix, COMPOSITE_HARD_MIX);
+    ADD_GENERIC_OP(cfGeometricMean, COMPOSITE_GEOMETRIC_MEAN);
+    ADD_GENERIC_OP(cfParallel, COMPOSITE_PARALLEL);
+    ADD_GENERIC_OP(cfAllanon, COMPOSITE_ALLANON);
+    ADD_GENERIC_OP(cfHardOverlay, COMPOSITE_HARD_OVERLAY);
+    ADD_GENERIC_OP(cfScreen, COMPOSITE_SCREEN);
+    ADD_GENERIC_OP(cfColorDodge, COMPOSITE_DODGE);
+    ADD_GENERIC_OP(cfAddition, COMPOSITE_LINEAR_DODGE);
+    ADD_GENERIC_OP(cfLightenOnly, COMPOSITE_LIGHTEN);
+    ADD_GENERIC_OP(cfHardLight, COMPOSITE_HARD_LIGHT);
+    ADD_GENERIC_OP(cfSoftLightSvg, COMPOSITE_SOFT_LIGHT_SVG);
+    ADD_GENERIC_OP(cfSoftLight, COMPOSITE_SOFT_LIGHT_PHOTOSHOP);
+    ADD_GENERIC_OP(cfVividLight, COMPOSITE_VIVID_LIGHT);
+    ADD_GENERIC_OP(cfPinLight, COMPOSITE_PIN_LIGHT);
+    ADD_GENERIC_OP(cfLinearLight, COMPOSITE_LINEAR_LIGHT);
+    ADD_GENERIC_OP(cfColorBurn, COMPOSITE_BURN);
+    ADD_GENERIC_OP(cfLinearBurn, COMPOSITE_LINEAR_BURN);
+    ADD_GENERIC_OP(cfDarkenOnly, COMPOSITE_DARKEN);
+    ADD_GENERIC_OP(cfAddition, COMPOSITE_ADD);
+    ADD_GENERIC_OP(cfSubtract, COMPOSITE_SUBTRACT);
+    ADD_GENERIC_OP(cfInverseSubtract, COMPOSITE_INVERSE_SUBTRACT);
+    ADD_GENERIC_OP(cfMultiply, COMPOSITE_MULT);
+    ADD_GENERIC_OP(cfDivide, COMPOSITE_DIVIDE);
+    ADD_GENERIC_OP(cfDifference, COMPOSITE_DIFF);
+    ADD_GENERIC_OP(cfExclusion, COMPOSITE_EXCLUSION);
+    ADD_GENERIC_OP(cfEquivalence, COMPOSITE_EQUIVALENCE);
+    ADD_GENERIC_OP(cfAdditiveSubtractive, COMPOSITE_ADDITIVE_SUBTRACTIVE);
+
+#undef ADD_GENERIC_OP
+
+    return ops;
+}
+
+template<typename channels_type>
+void compareOps(const QVector<KoCompositeOp*> &scalarOps,
+                const QVector<KoCompositeOp*> &optimizedOps,
+                float tolerance)
+{
+    const float unitValue = KoColorSpaceMathsTraits<channels_type>::unitValue;
+
+    /**
+     * The number of pixels is not a multiple of the vector size, so
+     * both vector and scalar parts of the rows are checked
+     */
+    const int numPixels = 1013;
+    const int rowStride = numPixels * 4 * sizeof(channels_type);
+
+    QVector<channels_type> src(numPixels * 4);
+    QVector<channels_type> dst(numPixels * 4);
+    QVector<quint8> mask(numPixels);
+
+    qsrand(1);
+    for (int i = 0; i < numPixels * 4; i++) {
+        src[i] = channels_type(qrand() % 256 * unitValue / 255);
+        dst[i] = channels_type(qrand() % 256 * unitValue / 255);
+    }
+
+    for (int i = 0; i < numPixels; i++) {
+        mask[i] = qrand() % 256;
+    }
+
+    QBitArray alphaLockedFlags(4, true);
+    alphaLockedFlags.clearBit(3);
+
+    const QVector<QBitArray> flagsList({QBitArray(), alphaLockedFlags});
+    const QVector<const quint8*> masks({0, mask.constData()});
+
+    /**
+     * The opacities are representable in 8 bits, so that the scalar
+     * integer ops, which round the opacity to the channel type, get
+     * the same value as the vectorized ones
+     */
+    const QVector<float> opacities({1.0f, 128.0f / 255.0f, 51.0f / 255.0f});
+    const QVector<float> flows({1.0f, 0.4f});
+
+    for (int opIndex = 0; opIndex < scalarOps.size(); opIndex++) {
+        Q_FOREACH (const QBitArray &flags, flagsList) {
+            Q_FOREACH (const quint8 *maskRowStart, masks) {
+                Q_FOREACH (float opacity, opacities) {
+                    Q_FOREACH (float flow, flows) {
+                        QVector<channels_type> scalarDst(dst);
+                        QVector<channels_type> optimizedDst(dst);
+
+                        KoCompositeOp::ParameterInfo params;
+                        params.srcRowStart = reinterpret_cast<const quint8*>(src.constData());
+                        params.srcRowStride = rowStride;
+                        params.maskRowStart = maskRowStart;
+                        params.maskRowStride = numPixels;
+                        params.rows = 1;
+                        params.cols = numPixels;
+                        params.opacity = opacity;
+                        params.flow = flow;
+                        params.channelFlags = flags;
+                        params.dstRowStride = rowStride;
+
+                        params.dstRowStart = reinterpret_cast<quint8*>(scalarDst.data());
+                        scalarOps[opIndex]->composite(params);
+
+                        params.dstRowStart = reinterpret_cast<quint8*>(optimizedDst.data());
+                        optimizedOps[opIndex]->composite(params);
+
+                        const QString caseName =
+                            QString("%1 (opacity %2, flow %3%4%5)")
+                            .arg(scalarOps[opIndex]->id()).arg(opacity).arg(flow)
+                            .arg(maskRowStart ? ", masked" : "")
+                            .arg(flags.isEmpty() ? "" : ", alpha locked");
+
+                        for (int i = 0; i < numPixels; i++) {
+                            const float scalarAlpha = scalarDst[i * 4 + 3] / unitValue;
+                            const float optimizedAlpha = optimizedDst[i * 4 + 3] / unitValue;
+
+                            QVERIFY2(qAbs(scalarAlpha - optimizedAlpha) <= tolerance,
+                                     qPrintable(QString("%1: alpha of pixel %2 differs: %3 vs %4")
+                                                .arg(caseName).arg(i)
+                                                .arg(scalarAlpha).arg(optimizedAlpha)));
+
+                            // the colors are compared premultiplied, since the
+                            // precision of the unpremultiplied ones is lower for
+                            // semi-transparent pixels
+                            for (int ch = 0; ch < 3; ch++) {
+                                const float scalarValue = scalarDst[i * 4 + ch] / unitValue * scalarAlpha;
+                                const float optimizedValue = optimizedDst[i * 4 + ch] / unitValue * optimizedAlpha;
+
+                                QVERIFY2(qAbs(scalarValue - optimizedValue) <= tolerance,
+                                         qPrintable(QString("%1: channel %2 of pixel %3 differs: %4 vs %5")
+                                                    .arg(caseName).arg(ch).arg(i)
+                                                    .arg(scalarValue).arg(optimizedValue)));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+void TestKoOptimizedCompositeOps::testGenericOps32()
+{
+    QVector<KoCompositeOp*> scalarOps = createScalarGenericOps<KoBgrU8Traits>();
+    QVector<KoCompositeOp*> optimizedOps;
+
+    Q_FOREACH (KoCompositeOp *op, createScalarGenericOps<KoBgrU8Traits>()) {
+        optimizedOps << KoOptimizedCompositeOpFactory::createGenericOp32(op);
+    }
+
+    /**
+     * The scalar ops round every intermediate product to 8 bits: the
+     * source alpha times opacity and mask, the blended color, each of
+     * the three terms of the compositing formula and the division by the
+     * new alpha. The vectorized ones keep all of them in float and round
+     * only the result, so the difference accumulates up to about half a
+     * code value per rounding, that is 3 code values in total.
+     */
+    compareOps<quint8>(scalarOps, optimizedOps, 3.0 / 255.0);
+
+    qDeleteAll(scalarOps);
+    qDeleteAll(optimizedOps);
+}
+
+void TestKoOptimizedCompositeOps::testGenericOps64()
+{
+    QVector<KoCompositeOp*> scalarOps = createScalarGenericOps<KoBgrU16Traits>();
+    QVector<KoCompositeOp*> optimizedOps;
+
+    Q_FOREACH (KoCompositeOp *op, createScalarGenericOps<KoBgrU16Traits>()) {
+        optimizedOps << KoOptimizedCompositeOpFactory::createGenericOp64(op);
+    }
+
+    compareOps<quint16>(scalarOps, optimizedOps, 4.0 / 65535.0);
+
+    qDeleteAll(scalarOps);
+    qDeleteAll(optimizedOps);
+}
+
+void TestKoOptimizedCompositeOps::testOverAndAlphaDarken64()
+{
+    QVector<KoCompositeOp*> scalarOps;
+    scalarOps << new KoCompositeOpOver<KoBgrU16Traits>(0);
+    scalarOps << new KoCompositeOpAlphaDarken<KoBgrU16Traits>(0);
+
+    QVector<KoCompositeOp*> optimizedOps;
+    optimizedOps << KoOptimizedCompositeOpFactory::createOverOp64(0);
+    optimizedOps << KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(0);
+
+    compareOps<quint16>(scalarOps, optimizedOps, 5.0 / 65535.0);
+
+    qDeleteAll(scalarOps);
+    qDeleteAll(optimizedOps);
+}
+
+void TestKoOptimizedCompositeOps::testGenericOps128()
+{
+    QVector<KoCompositeOp*> scalarOps = createScalarGenericOps<KoRgbF32Traits>();
+    QVector<KoCompositeOp*> optimizedOps;
+
+    Q_FOREACH (KoCompositeOp *op, createScalarGenericOps<KoRgbF32Traits>()) {
+        optimizedOps << KoOptimizedCompositeOpFactory::createGenericOp128(op);
+    }
+
+    compareOps<float>(scalarOps, optimizedOps, 1e-4);
+
+    qDeleteAll(scalarOps);
+    qDeleteAll(optimizedOps);
+}
+
+QTEST_GUILESS_MAIN(TestKoOptimizedCompositeOps)
@@ -25,6 +25,7 @@
 #include "KisDocument.h"
 #include "kis_time_range.h"
 #include "kis_paint_layer.h"
+#include "KisAsyncAnimationFramesSequencer.h"
 
 
 struct KisAsyncAnimationFramesSavingRenderer::Private
@@ -35,6 +36,15 @@ struct KisAsyncAnimationFramesSavingRenderer::Private
           sequenceNumberingOffset(_sequenceNumberingOffset),
           exportConfiguration(_exportConfiguration)
     {
+        initSavingDocument(image);
+    }
+
+    Private(KisAsyncAnimationFramesSequencer *_sequencer)
+        : sequencer(_sequencer)
+    {
+    }
+
+    void initSavingDocument(KisImageSP image) {
         savingDoc->setAutoSaveDelay(0);
         savingDoc->setFileBatchMode(true);
 
@@ -64,6 +74,8 @@ struct KisAsyncAnimationFramesSavingRenderer::Private
 
     QByteArray outputMimeType;
     KisPropertiesConfigurationSP exportConfiguration;
+
+    KisAsyncAnimationFramesSequencer *sequencer = 0;
 };
 
 KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(KisImageSP image,
@@ -83,6 +95,13 @@ KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(Kis
     connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
 }
 
+KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(KisAsyncAnimationFramesSequencer *sequencer)
+    : m_d(new Private(sequencer))
+{
+    connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(notifyFrameCompleted(int)));
+    connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
+}
+
 KisAsyncAnimationFramesSavingRenderer::~KisAsyncAnimationFramesSavingRenderer()
 {
 }
@@ -92,6 +111,22 @@ void KisAsyncAnimationFramesSavingRenderer::frameCompletedCallback(int frame)
     KisImageSP image = requestedImage();
     if (!image) return;
 
+    if (m_d->sequencer) {
+        /**
+         * The clone shares the tiles with the projection, so it is
+         * cheap to keep it until the preceding frames are ready.
+         */
+        KisPaintDeviceSP frameDevice = new KisPaintDevice(image->colorSpace());
+        frameDevice->makeCloneFromRough(image->projection(), image->bounds());
+
+        if (m_d->sequencer->addFrame(frame, frameDevice)) {
+            emit sigCompleteRegenerationInternal(frame);
+        } else {
+            emit sigCancelRegenerationInternal(frame);
+        }
+        return;
+    }
+
     m_d->savingDevice->makeCloneFromRough(image->projection(), image->bounds());
 
     KisTimeRange range(frame, 1);
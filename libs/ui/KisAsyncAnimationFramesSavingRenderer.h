@@ -23,6 +23,7 @@
 
 class KisDocument;
 class KisTimeRange;
+class KisAsyncAnimationFramesSequencer;
 
 class KisAsyncAnimationFramesSavingRenderer : public KisAsyncAnimationRendererBase
 {
@@ -35,6 +36,15 @@ public:
                                           const KisTimeRange &range,
                                           int sequenceNumberingOffset,
                                           KisPropertiesConfigurationSP exportConfiguration);
+
+    /**
+     * Creates a renderer that doesn't save the frames itself, but
+     * passes them to \p sequencer, which delivers them in order. The
+     * sequencer is usually shared by the renderers of all the clones
+     * of the image.
+     */
+    KisAsyncAnimationFramesSavingRenderer(KisAsyncAnimationFramesSequencer *sequencer);
+
     ~KisAsyncAnimationFramesSavingRenderer();
 
 protected:
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationFramesSequencer.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "kis_paint_device.h"
+
+
+struct KisAsyncAnimationFramesSequencer::Private
+{
+    Private(const QList<int> &_frames, FrameConsumer _consumer)
+        : frames(_frames),
+          consumer(_consumer)
+    {
+    }
+
+    QList<int> frames;
+    FrameConsumer consumer;
+
+    int nextFrameIndex = 0;
+    QMap<int, KisPaintDeviceSP> pendingFrames;
+
+    /**
+     * Set while some thread is passing the frames to the consumer.
+     * The frames added at that time are picked up by that thread.
+     */
+    bool isConsuming = false;
+    bool hasFailed = false;
+
+    mutable QMutex mutex;
+};
+
+KisAsyncAnimationFramesSequencer::KisAsyncAnimationFramesSequencer(const QList<int> &frames, FrameConsumer consumer)
+    : m_d(new Private(frames, consumer))
+{
+}
+
+KisAsyncAnimationFramesSequencer::~KisAsyncAnimationFramesSequencer()
+{
+}
+
+bool KisAsyncAnimationFramesSequencer::addFrame(int frame, KisPaintDeviceSP device)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    if (m_d->hasFailed) return false;
+
+    m_d->pendingFrames.insert(frame, device);
+
+    if (m_d->isConsuming) return true;
+    m_d->isConsuming = true;
+
+    while (!m_d->hasFailed && m_d->nextFrameIndex < m_d->frames.size()) {
+        const int nextFrame = m_d->frames[m_d->nextFrameIndex];
+
+        QMap<int, KisPaintDeviceSP>::iterator it = m_d->pendingFrames.find(nextFrame);
+        if (it == m_d->pendingFrames.end()) break;
+
+        KisPaintDeviceSP nextDevice = it.value();
+        m_d->pendingFrames.erase(it);
+        m_d->nextFrameIndex++;
+
+        l.unlock();
+        const bool result = m_d->consumer(nextFrame, nextDevice);
+        l.relock();
+
+        if (!result) {
+            m_d->hasFailed = true;
+            m_d->pendingFrames.clear();
+        }
+    }
+
+    m_d->isConsuming = false;
+
+    return !m_d->hasFailed;
+}
+
+bool KisAsyncAnimationFramesSequencer::isComplete() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return !m_d->hasFailed && m_d->nextFrameIndex == m_d->frames.size();
+}
+
+bool KisAsyncAnimationFramesSequencer::hasFailed() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->hasFailed;
+}
+
+int KisAsyncAnimationFramesSequencer::numPendingFrames() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->pendingFrames.size();
+}
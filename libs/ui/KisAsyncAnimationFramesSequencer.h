@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISASYNCANIMATIONFRAMESSEQUENCER_H
+#define KISASYNCANIMATIONFRAMESSEQUENCER_H
+
+#include <functional>
+
+#include <QList>
+#include <QScopedPointer>
+
+#include "kis_types.h"
+#include "kritaui_export.h"
+
+/**
+ * KisAsyncAnimationFramesSequencer collects the frames rendered
+ * concurrently by several clones of the image and passes them to the
+ * consumer strictly in the order of the sequence, e.g. for writing them
+ * into a video stream.
+ *
+ * The frames are passed to the consumer in the context of the thread
+ * that added the last missing frame, so no thread ever waits for its
+ * turn. The consumer is never called concurrently.
+ */
+class KRITAUI_EXPORT KisAsyncAnimationFramesSequencer
+{
+public:
+    /**
+     * Called for every frame of the sequence in order. Should return
+     * false if the frame could not be processed. In such a case the
+     * rest of the frames are dropped.
+     */
+    typedef std::function<bool (int, KisPaintDeviceSP)> FrameConsumer;
+
+public:
+    KisAsyncAnimationFramesSequencer(const QList<int> &frames, FrameConsumer consumer);
+    ~KisAsyncAnimationFramesSequencer();
+
+    /**
+     * Adds a rendered \p frame. If all the preceding frames of the
+     * sequence have already been added, the frame and all the frames
+     * waiting for it are passed to the consumer before the method
+     * returns. Otherwise the frame is kept until its turn comes.
+     *
+     * \p device should not be changed after being added.
+     *
+     * @return false if the consumer has failed on any frame
+     */
+    bool addFrame(int frame, KisPaintDeviceSP device);
+
+    /**
+     * @return true if all the frames of the sequence have been
+     *         successfully passed to the consumer
+     */
+    bool isComplete() const;
+
+    /**
+     * @return true if the consumer has failed on any frame
+     */
+    bool hasFailed() const;
+
+    /**
+     * @return the number of the frames kept for being out of order
+     */
+    int numPendingFrames() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISASYNCANIMATIONFRAMESSEQUENCER_H
@@ -746,6 +746,8 @@ void KisCanvas2::notifyZoomChanged()
     if (!m_d->currentCanvasIsOpenGL) {
         Q_ASSERT(m_d->prescaledProjection);
         m_d->prescaledProjection->notifyZoomChanged();
+    } else {
+        updateTexturesDownsampling();
     }
 
     notifyLevelOfDetailChange();
@@ -767,6 +769,54 @@ void KisCanvas2::slotTrySwitchShapeManager()
     }
 }
 
+void KisCanvas2::updateTexturesDownsampling()
+{
+    KisOpenGLCanvas2 *openGLCanvas = dynamic_cast<KisOpenGLCanvas2*>(m_d->canvasWidget);
+    if (!openGLCanvas || !openGLCanvas->openGLImageTextures()) return;
+
+    /**
+     * The downsampled tiles are shown through the fixed LoD planes of
+     * the textures, the same way as the LoD planes of the image
+     */
+    int levelOfDetail = 0;
+
+    if (KisOpenGL::supportsLoD() &&
+        (m_d->openGLFilterMode == KisOpenGL::TrilinearFilterMode ||
+         m_d->openGLFilterMode == KisOpenGL::HighQualityFiltering)) {
+
+        KisConfig cfg;
+        levelOfDetail = KisLodTransform::scaleToLod(m_d->coordinatesConverter->effectiveZoom(),
+                                                    cfg.numMipmapLevels());
+    }
+
+    openGLCanvas->openGLImageTextures()->setDownsamplingLevelOfDetail(levelOfDetail);
+    refetchCoarseTextureTiles();
+}
+
+void KisCanvas2::refetchCoarseTextureTiles()
+{
+    KisOpenGLCanvas2 *openGLCanvas = dynamic_cast<KisOpenGLCanvas2*>(m_d->canvasWidget);
+    if (!openGLCanvas || !openGLCanvas->openGLImageTextures()) return;
+
+    /**
+     * When the image has its own LoD plane, the tiles show it instead
+     */
+    KisImageSP image = this->image();
+    if (image->currentLevelOfDetail()) return;
+
+    /**
+     * Only the visible tiles are refetched after zooming in. The rest of
+     * them is refetched when the canvas is scrolled to them.
+     */
+    const QRectF widgetRect(QPointF(), m_d->canvasWidget->widget()->size());
+    const QRect visibleRect = m_d->coordinatesConverter->widgetToImage(widgetRect).toAlignedRect();
+
+    const QRect refetchRect = openGLCanvas->openGLImageTextures()->takeCoarseTilesRect(visibleRect);
+    if (!refetchRect.isEmpty()) {
+        startUpdateInPatches(refetchRect);
+    }
+}
+
 void KisCanvas2::notifyLevelOfDetailChange()
 {
     if (!m_d->effectiveLodAllowedInCanvas()) return;
@@ -821,6 +871,8 @@ void KisCanvas2::documentOffsetMoved(const QPoint &documentOffset)
 
     if (!m_d->currentCanvasIsOpenGL)
         m_d->prescaledProjection->viewportMoved(moveOffset);
+    else
+        refetchCoarseTextureTiles();
 
     emit documentOffsetUpdateFinished();
 
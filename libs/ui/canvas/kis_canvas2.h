@@ -286,6 +286,8 @@ private:
     void setCanvasWidget(QWidget *widget);
     void resetCanvas(bool useOpenGL);
 
+    void updateTexturesDownsampling();
+    void refetchCoarseTextureTiles();
     void notifyLevelOfDetailChange();
 
     // Completes construction of canvas.
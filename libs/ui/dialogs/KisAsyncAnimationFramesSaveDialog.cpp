@@ -61,6 +61,10 @@ struct KisAsyncAnimationFramesSaveDialog::Private {
 
     int sequenceNumberingOffset;
     KisPropertiesConfigurationSP exportConfiguration;
+
+    KisAsyncAnimationFramesSequencer::FrameConsumer frameConsumer;
+    std::function<bool ()> isFrameConsumerReady;
+    QScopedPointer<KisAsyncAnimationFramesSequencer> sequencer;
 };
 
 KisAsyncAnimationFramesSaveDialog::KisAsyncAnimationFramesSaveDialog(KisImageSP originalImage,
@@ -81,6 +85,20 @@ KisAsyncAnimationFramesSaveDialog::~KisAsyncAnimationFramesSaveDialog()
 
 KisAsyncAnimationRenderDialogBase::Result KisAsyncAnimationFramesSaveDialog::regenerateRange(KisViewManager *viewManager)
 {
+    if (m_d->frameConsumer) {
+        m_d->sequencer.reset(new KisAsyncAnimationFramesSequencer(calcDirtyFrames(), m_d->frameConsumer));
+
+        Result result = KisAsyncAnimationRenderDialogBase::regenerateRange(viewManager);
+
+        // the last frames might have been consumed after the rendering was reported complete
+        if (result == RenderComplete && !m_d->sequencer->isComplete()) {
+            result = RenderFailed;
+        }
+
+        m_d->sequencer.reset();
+        return result;
+    }
+
     QFileInfo info(savedFilesMaskWildcard());
 
     QDir dir(info.absolutePath());
@@ -153,6 +171,10 @@ QList<int> KisAsyncAnimationFramesSaveDialog::calcDirtyFrames() const
 
 KisAsyncAnimationRendererBase *KisAsyncAnimationFramesSaveDialog::createRenderer(KisImageSP image)
 {
+    if (m_d->sequencer) {
+        return new KisAsyncAnimationFramesSavingRenderer(m_d->sequencer.data());
+    }
+
     return new KisAsyncAnimationFramesSavingRenderer(image,
                                                      m_d->filenamePrefix,
                                                      m_d->filenameSuffix,
@@ -171,3 +193,15 @@ QString KisAsyncAnimationFramesSaveDialog::savedFilesMaskWildcard() const
 {
     return m_d->filenamePrefix + "????" + m_d->filenameSuffix;
 }
+
+void KisAsyncAnimationFramesSaveDialog::setFrameConsumer(KisAsyncAnimationFramesSequencer::FrameConsumer consumer,
+                                                         std::function<bool ()> isConsumerReady)
+{
+    m_d->frameConsumer = consumer;
+    m_d->isFrameConsumerReady = isConsumerReady;
+}
+
+bool KisAsyncAnimationFramesSaveDialog::isReadyForNextFrame() const
+{
+    return !m_d->sequencer || !m_d->isFrameConsumerReady || m_d->isFrameConsumerReady();
+}
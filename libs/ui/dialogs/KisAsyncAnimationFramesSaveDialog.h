@@ -20,6 +20,7 @@
 #define KISASYNCANIMATIONFRAMESSAVEDIALOG_H
 
 #include "KisAsyncAnimationRenderDialogBase.h"
+#include "KisAsyncAnimationFramesSequencer.h"
 #include "kis_types.h"
 
 
@@ -39,9 +40,23 @@ public:
     QString savedFilesMask() const;
     QString savedFilesMaskWildcard() const;
 
+    /**
+     * Instead of saving the frames into files, pass them to \p consumer
+     * in the order of the range. The frames are still rendered by
+     * several clones of the image concurrently. The consumer is called
+     * from the image worker threads, but never concurrently.
+     *
+     * If \p isConsumerReady is set, it is called in the GUI thread before
+     * starting every frame. When it returns false, the rendering pauses
+     * until resumeFrameRegeneration() is called.
+     */
+    void setFrameConsumer(KisAsyncAnimationFramesSequencer::FrameConsumer consumer,
+                          std::function<bool ()> isConsumerReady = std::function<bool ()>());
+
 protected:
     QList<int> calcDirtyFrames() const override;
     KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
+    bool isReadyForNextFrame() const override;
 
 private:
     struct Private;
@@ -241,7 +241,7 @@ void KisAsyncAnimationRenderDialogBase::tryInitiateFrameRegeneration()
 {
     bool hadWorkOnPreviousCycle = false;
 
-    while (!m_d->stillDirtyFrames.isEmpty()) {
+    while (!m_d->stillDirtyFrames.isEmpty() && isReadyForNextFrame()) {
         for (auto &pair : m_d->asyncRenderers) {
             if (!pair.renderer->isActive()) {
                 const int currentDirtyFrame = m_d->stillDirtyFrames.takeFirst();
@@ -257,6 +257,16 @@ void KisAsyncAnimationRenderDialogBase::tryInitiateFrameRegeneration()
     }
 }
 
+bool KisAsyncAnimationRenderDialogBase::isReadyForNextFrame() const
+{
+    return true;
+}
+
+void KisAsyncAnimationRenderDialogBase::resumeFrameRegeneration()
+{
+    tryInitiateFrameRegeneration();
+}
+
 void KisAsyncAnimationRenderDialogBase::updateProgressLabel()
 {
     const int processedFramesCount = m_d->dirtyFramesCount - m_d->numDirtyFramesLeft();
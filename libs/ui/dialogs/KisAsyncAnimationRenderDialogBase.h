@@ -100,6 +100,13 @@ public:
      */
     bool batchMode() const;
 
+public Q_SLOTS:
+    /**
+     * @brief continue feeding the workers with dirty frames after
+     *        isReadyForNextFrame() has returned false
+     */
+    void resumeFrameRegeneration();
+
 private Q_SLOTS:
     void slotFrameCompleted(int frame);
     void slotFrameCancelled(int frame);
@@ -129,6 +136,16 @@ protected:
      */
     virtual KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) = 0;
 
+    /**
+     * @brief lets the derived class to pause the regeneration, e.g. when
+     *        the consumer of the frames cannot keep up with the workers
+     *
+     * Called before every frame is sent to a worker. If returns false, no
+     * new frames are started until resumeFrameRegeneration() is called.
+     * The frames already in progress are not affected.
+     */
+    virtual bool isReadyForNextFrame() const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
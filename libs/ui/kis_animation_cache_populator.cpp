@@ -58,6 +58,7 @@ struct KisAnimationCachePopulator::Private
     static const int IDLE_COUNT_THRESHOLD = 4;
     static const int IDLE_CHECK_INTERVAL = 500;
     static const int BETWEEN_FRAMES_INTERVAL = 10;
+    static const int PREFETCH_FRAMES_COUNT = 8;
 
     int requestedFrame;
     KisAnimationFrameCacheSP requestCache;
@@ -67,6 +68,10 @@ struct KisAnimationCachePopulator::Private
     QFutureWatcher<void> infoConversionWatcher;
 
     KisAsyncAnimationCacheRenderer regenerator;
+
+    QFutureWatcher<QVector<KisOpenGLUpdateInfoSP>> prefetchWatcher;
+    KisAnimationFrameCacheSP prefetchCache;
+    QVector<KisOpenGLUpdateInfoSP> prefetchSources;
     bool calculateAnimationCacheInBackground = true;
 
 
@@ -176,6 +181,10 @@ struct KisAnimationCachePopulator::Private
         KisImageSP image = cache->image();
         if (!image) return false;
 
+        // don't let background generation push out the frames
+        // those have already been cached
+        if (cache->isMemoryLimitReached()) return false;
+
         KisImageAnimationInterface *animation = image->animationInterface();
         KisTimeRange currentRange = animation->fullClipRange();
 
@@ -270,6 +279,8 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
     connect(&m_d->regenerator, SIGNAL(sigFrameCancelled(int)), SLOT(slotRegeneratorFrameCancelled()));
     connect(&m_d->regenerator, SIGNAL(sigFrameCompleted(int)), SLOT(slotRegeneratorFrameReady()));
 
+    connect(&m_d->prefetchWatcher, SIGNAL(finished()), SLOT(slotPrefetchFinished()));
+
     connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), SLOT(slotConfigChanged()));
     slotConfigChanged();
 }
@@ -282,6 +293,41 @@ bool KisAnimationCachePopulator::regenerate(KisAnimationFrameCacheSP cache, int
     return m_d->regenerate(cache, frame);
 }
 
+void KisAnimationCachePopulator::prefetchFrames(KisAnimationFrameCacheSP cache, int time)
+{
+    if (m_d->prefetchWatcher.isRunning()) return;
+
+    const QVector<KisOpenGLUpdateInfoSP> sources =
+        cache->framesToPrefetch(time, Private::PREFETCH_FRAMES_COUNT);
+
+    if (sources.isEmpty()) return;
+
+    m_d->prefetchCache = cache;
+    m_d->prefetchSources = sources;
+
+    m_d->prefetchWatcher.setFuture(QtConcurrent::run(
+        [cache, sources] () {
+            QVector<KisOpenGLUpdateInfoSP> frames;
+            frames.reserve(sources.size());
+
+            Q_FOREACH (KisOpenGLUpdateInfoSP info, sources) {
+                frames.append(cache->decompressFrameData(info));
+            }
+
+            return frames;
+        }));
+}
+
+void KisAnimationCachePopulator::slotPrefetchFinished()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->prefetchCache);
+
+    m_d->prefetchCache->addPrefetchedFrames(m_d->prefetchSources, m_d->prefetchWatcher.result());
+
+    m_d->prefetchCache = 0;
+    m_d->prefetchSources.clear();
+}
+
 void KisAnimationCachePopulator::slotTimer()
 {
     m_d->timerTimeout();
@@ -39,6 +39,13 @@ public:
      */
     bool regenerate(KisAnimationFrameCacheSP cache, int frame);
 
+    /**
+     * Decompresses in background the cached frames those will be
+     * shown during the playback after \p time. The request will be
+     * ignored if the previous one has not been finished yet.
+     */
+    void prefetchFrames(KisAnimationFrameCacheSP cache, int time);
+
 public Q_SLOTS:
     void slotRequestRegeneration();
 
@@ -47,6 +54,7 @@ private Q_SLOTS:
 
     void slotRegeneratorFrameCancelled();
     void slotRegeneratorFrameReady();
+    void slotPrefetchFinished();
 
     void slotConfigChanged();
 
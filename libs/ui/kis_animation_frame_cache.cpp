@@ -19,6 +19,10 @@
 #include "kis_animation_frame_cache.h"
 
 #include <QMap>
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
 
 #include "kis_debug.h"
 
@@ -27,6 +31,10 @@
 #include "kis_time_range.h"
 #include "KisPart.h"
 #include "kis_animation_cache_populator.h"
+#include "kis_config.h"
+#include "kis_config_notifier.h"
+#include "kis_update_info.h"
+#include "tiles3/swap/kis_abstract_compression.h"
 
 #include "opengl/kis_opengl_image_textures.h"
 
@@ -34,9 +42,16 @@
 struct KisAnimationFrameCache::Private
 {
     Private(KisOpenGLImageTexturesSP _textures)
-        : textures(_textures)
+        : textures(_textures),
+          usageCounter(0),
+          memoryUsage(0)
     {
         image = textures->image();
+
+        KisConfig cfg;
+        compressFrames = cfg.compressAnimationCache();
+        compressionName = KisAbstractCompression::fastestCompression();
+        memoryLimit = qint64(cfg.animationCacheMemoryLimit()) * 1024 * 1024;
     }
 
     ~Private()
@@ -47,18 +62,56 @@ struct KisAnimationFrameCache::Private
     KisOpenGLImageTexturesSP textures;
     KisImageWSP image;
 
+    /**
+     * The compression settings are read only once, because the frames
+     * are compressed in the renderer's thread
+     */
+    bool compressFrames;
+    QString compressionName;
+
+    qint64 memoryLimit;
+    quint64 usageCounter;
+
+    /**
+     * The total footprint of the cached frames, every frame data is
+     * counted only once, even when it is shared by several ranges
+     */
+    qint64 memoryUsage;
+
     struct Frame
     {
         KisOpenGLUpdateInfoSP openGlFrame;
         int length;
+        qint64 memoryFootprint;
+        quint64 lastUsed;
 
-        Frame(KisOpenGLUpdateInfoSP info, int length)
-            : openGlFrame(info), length(length)
+        Frame(KisOpenGLUpdateInfoSP info, int length, qint64 memoryFootprint, quint64 lastUsed)
+            : openGlFrame(info), length(length),
+              memoryFootprint(memoryFootprint), lastUsed(lastUsed)
         {}
     };
 
     QMap<int, Frame*> frames;
 
+    /**
+     * The number of cached ranges sharing each frame data
+     */
+    QHash<KisOpenGLUpdateInfo*, int> frameUsers;
+
+    /**
+     * Frames decompressed in the background by the cache populator,
+     * keyed by the compressed frame. The record keeps a reference to
+     * the compressed frame, so its address cannot be reused while
+     * the record exists.
+     */
+    struct PrefetchedFrame
+    {
+        KisOpenGLUpdateInfoSP source;
+        KisOpenGLUpdateInfoSP frame;
+    };
+
+    QHash<KisOpenGLUpdateInfo*, PrefetchedFrame> prefetchedFrames;
+
     Frame *getFrame(int time)
     {
         if (frames.isEmpty()) return 0;
@@ -86,9 +139,122 @@ struct KisAnimationFrameCache::Private
         invalidate(range);
 
         int length = range.isInfinite() ? -1 : range.end() - range.start() + 1;
-        Frame *frame = new Frame(info, length);
+        Frame *frame = new Frame(info, length, frameMemoryFootprint(info), ++usageCounter);
 
-        frames.insert(range.start(), frame);
+        insertFrame(range.start(), frame);
+
+        evictFrames(info);
+    }
+
+    void insertFrame(int start, Frame *frame)
+    {
+        frames.insert(start, frame);
+
+        if (frameUsers[frame->openGlFrame.data()]++ == 0) {
+            memoryUsage += frame->memoryFootprint;
+        }
+    }
+
+    QMap<int, Frame*>::iterator removeFrame(QMap<int, Frame*>::iterator it)
+    {
+        Frame *frame = it.value();
+
+        QHash<KisOpenGLUpdateInfo*, int>::iterator users =
+            frameUsers.find(frame->openGlFrame.data());
+
+        KIS_SAFE_ASSERT_RECOVER_NOOP(users != frameUsers.end());
+
+        if (users != frameUsers.end() && --users.value() == 0) {
+            frameUsers.erase(users);
+            memoryUsage -= frame->memoryFootprint;
+        }
+
+        delete frame;
+        return frames.erase(it);
+    }
+
+    /**
+     * Removes all the ranges sharing \p info, so that they are
+     * regenerated the next time they are needed
+     */
+    void dropFrameData(KisOpenGLUpdateInfoSP info)
+    {
+        for (auto it = frames.begin(); it != frames.end();) {
+            if (it.value()->openGlFrame == info) {
+                it = removeFrame(it);
+            } else {
+                ++it;
+            }
+        }
+
+        dropOrphanedPrefetchedFrames();
+    }
+
+    void touchFrame(Frame *frame)
+    {
+        frame->lastUsed = ++usageCounter;
+    }
+
+    static qint64 frameMemoryFootprint(KisOpenGLUpdateInfoSP info)
+    {
+        qint64 result = 0;
+
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+            result += tileInfo->memoryFootprint();
+        }
+
+        return result;
+    }
+
+    static bool isFrameCompressed(KisOpenGLUpdateInfoSP info)
+    {
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+            if (tileInfo->isCompressed()) return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Removes the least recently used frames until the cache fits
+     * into the memory limit. \p keptFrame is never evicted, even if it
+     * alone doesn't fit into the limit.
+     */
+    void evictFrames(KisOpenGLUpdateInfoSP keptFrame)
+    {
+        if (memoryUsage > memoryLimit) {
+            QVector<QMap<int, Frame*>::iterator> victims;
+            victims.reserve(frames.size());
+
+            for (auto it = frames.begin(); it != frames.end(); ++it) {
+                if (it.value()->openGlFrame == keptFrame) continue;
+                victims.append(it);
+            }
+
+            std::sort(victims.begin(), victims.end(),
+                      [] (QMap<int, Frame*>::iterator lhs, QMap<int, Frame*>::iterator rhs) {
+                          return lhs.value()->lastUsed < rhs.value()->lastUsed;
+                      });
+
+            for (auto it = victims.begin(); it != victims.end() && memoryUsage > memoryLimit; ++it) {
+                removeFrame(*it);
+            }
+        }
+
+        dropOrphanedPrefetchedFrames();
+    }
+
+    void dropOrphanedPrefetchedFrames()
+    {
+        if (prefetchedFrames.isEmpty()) return;
+
+        for (auto it = prefetchedFrames.begin(); it != prefetchedFrames.end();) {
+            if (!frameUsers.contains(it.key())) {
+                it = prefetchedFrames.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
     /**
@@ -121,11 +287,11 @@ struct KisAnimationFrameCache::Private
                     // Reinsert with a later start
                     int newStart = range.end() + 1;
                     int newLength = frameIsInfinite ? -1 : (end - newStart + 1);
-                    frames.insert(newStart, new Frame(frame->openGlFrame, newLength));
+                    insertFrame(newStart, new Frame(frame->openGlFrame, newLength,
+                                                    frame->memoryFootprint, frame->lastUsed));
                 }
 
-                it = frames.erase(it);
-                delete frame;
+                it = removeFrame(it);
 
                 cacheChanged = true;
                 continue;
@@ -174,6 +340,7 @@ KisAnimationFrameCache::KisAnimationFrameCache(KisOpenGLImageTexturesSP textures
     : m_d(new Private(textures))
 {
     connect(m_d->image->animationInterface(), SIGNAL(sigFramesChanged(KisTimeRange,QRect)), this, SLOT(framesChanged(KisTimeRange,QRect)));
+    connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), this, SLOT(slotConfigChanged()));
 }
 
 KisAnimationFrameCache::~KisAnimationFrameCache()
@@ -188,7 +355,33 @@ bool KisAnimationFrameCache::uploadFrame(int time)
     if (!frame) {
         KisPart::instance()->cachePopulator()->regenerate(this, time);
     } else {
-        m_d->textures->recalculateCache(frame->openGlFrame);
+        m_d->touchFrame(frame);
+
+        KisOpenGLUpdateInfoSP info = frame->openGlFrame;
+
+        if (Private::isFrameCompressed(info)) {
+            auto it = m_d->prefetchedFrames.find(info.data());
+
+            if (it != m_d->prefetchedFrames.end()) {
+                info = it->frame;
+                m_d->prefetchedFrames.erase(it);
+            } else {
+                info = decompressFrameData(info);
+            }
+
+            if (!info) {
+                warnUI << "Dropping a corrupted frame from the animation cache, time:" << time;
+
+                m_d->dropFrameData(frame->openGlFrame);
+                emit changed();
+
+                KisPart::instance()->cachePopulator()->regenerate(this, time);
+                return false;
+            }
+        }
+
+        m_d->textures->recalculateCache(info);
+        KisPart::instance()->cachePopulator()->prefetchFrames(this, time);
     }
 
     return frame != 0;
@@ -214,10 +407,41 @@ void KisAnimationFrameCache::framesChanged(const KisTimeRange &range, const QRec
     bool cacheChanged = m_d->invalidate(range);
 
     if (cacheChanged) {
+        m_d->dropOrphanedPrefetchedFrames();
         emit changed();
     }
 }
 
+void KisAnimationFrameCache::slotConfigChanged()
+{
+    KisConfig cfg;
+    m_d->memoryLimit = qint64(cfg.animationCacheMemoryLimit()) * 1024 * 1024;
+
+    if (m_d->memoryUsage > m_d->memoryLimit) {
+        m_d->evictFrames(KisOpenGLUpdateInfoSP());
+        emit changed();
+    }
+}
+
+qint64 KisAnimationFrameCache::testingMemoryUsage() const
+{
+    return m_d->memoryUsage;
+}
+
+void KisAnimationFrameCache::testingSetMemoryLimit(qint64 limit)
+{
+    m_d->memoryLimit = limit;
+    m_d->evictFrames(KisOpenGLUpdateInfoSP());
+}
+
+void KisAnimationFrameCache::testingTouchFrame(int time)
+{
+    Private::Frame *frame = m_d->getFrame(time);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(frame);
+
+    m_d->touchFrame(frame);
+}
+
 KisOpenGLUpdateInfoSP KisAnimationFrameCache::fetchFrameData(int time, KisImageSP image) const
 {
     if (time != image->animationInterface()->currentTime()) {
@@ -225,7 +449,104 @@ KisOpenGLUpdateInfoSP KisAnimationFrameCache::fetchFrameData(int time, KisImageS
         qWarning() << "    "  << ppVar(image->animationInterface()->currentTime()) << ppVar(time);
     }
 
-    return m_d->textures->updateCache(image->bounds(), image);
+    KisOpenGLUpdateInfoSP info = m_d->textures->updateCache(image->bounds(), image, false);
+
+    if (m_d->compressFrames) {
+        QScopedPointer<KisAbstractCompression> compression(
+            KisAbstractCompression::create(m_d->compressionName));
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(compression, info);
+
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+            tileInfo->compress(compression.data());
+        }
+    }
+
+    return info;
+}
+
+KisOpenGLUpdateInfoSP KisAnimationFrameCache::decompressFrameData(KisOpenGLUpdateInfoSP info) const
+{
+    QScopedPointer<KisAbstractCompression> compression(
+        KisAbstractCompression::create(m_d->compressionName));
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(compression, info);
+
+    KisOpenGLUpdateInfoSP frame = new KisOpenGLUpdateInfo(ConversionOptions());
+    frame->assignDirtyImageRect(info->dirtyImageRect());
+    frame->assignLevelOfDetail(info->levelOfDetail());
+    frame->tileList.reserve(info->tileList.size());
+
+    Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+        KisTextureTileUpdateInfoSP tileCopy = tileInfo->decompressedCopy(compression.data());
+        if (!tileCopy) return KisOpenGLUpdateInfoSP();
+
+        frame->tileList.append(tileCopy);
+    }
+
+    return frame;
+}
+
+bool KisAnimationFrameCache::isMemoryLimitReached() const
+{
+    return m_d->memoryUsage >= m_d->memoryLimit;
+}
+
+QVector<KisOpenGLUpdateInfoSP> KisAnimationFrameCache::framesToPrefetch(int time, int count)
+{
+    QVector<KisOpenGLUpdateInfoSP> result;
+    QSet<KisOpenGLUpdateInfo*> prefetchWindow;
+
+    KisImageSP image = m_d->image;
+    if (!image) return result;
+
+    const KisTimeRange &range = image->animationInterface()->playbackRange();
+    const bool wrapAround = range.isValid() && !range.isInfinite();
+
+    int frameTime = time;
+
+    for (int i = 0; i < count; i++) {
+        frameTime = wrapAround && frameTime >= range.end() ? range.start() : frameTime + 1;
+
+        Private::Frame *frame = m_d->getFrame(frameTime);
+        if (!frame || prefetchWindow.contains(frame->openGlFrame.data())) continue;
+
+        prefetchWindow.insert(frame->openGlFrame.data());
+
+        if (Private::isFrameCompressed(frame->openGlFrame) &&
+            !m_d->prefetchedFrames.contains(frame->openGlFrame.data())) {
+
+            result.append(frame->openGlFrame);
+        }
+    }
+
+    for (auto it = m_d->prefetchedFrames.begin(); it != m_d->prefetchedFrames.end();) {
+        if (!prefetchWindow.contains(it.key())) {
+            it = m_d->prefetchedFrames.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return result;
+}
+
+void KisAnimationFrameCache::addPrefetchedFrames(const QVector<KisOpenGLUpdateInfoSP> &sources,
+                                                 const QVector<KisOpenGLUpdateInfoSP> &frames)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(sources.size() == frames.size());
+
+    for (int i = 0; i < sources.size(); i++) {
+        // corrupted frames are handled by uploadFrame()
+        if (!frames[i]) continue;
+
+        Private::PrefetchedFrame prefetchedFrame;
+        prefetchedFrame.source = sources[i];
+        prefetchedFrame.frame = frames[i];
+
+        m_d->prefetchedFrames.insert(sources[i].data(), prefetchedFrame);
+    }
+
+    // the frames might have been invalidated while being decompressed
+    m_d->dropOrphanedPrefetchedFrames();
 }
 
 void KisAnimationFrameCache::addConvertedFrameData(KisOpenGLUpdateInfoSP info, int time)
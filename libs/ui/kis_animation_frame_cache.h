@@ -21,6 +21,7 @@
 
 #include <QImage>
 #include <QObject>
+#include <QVector>
 
 #include "kritaui_export.h"
 #include "kis_types.h"
@@ -63,9 +64,45 @@ public:
     KisOpenGLUpdateInfoSP fetchFrameData(int time, KisImageSP image) const;
     void addConvertedFrameData(KisOpenGLUpdateInfoSP info, int time);
 
+    /**
+     * @return true if the cached frames occupy all the memory given
+     *         to the cache, so new frames can be added only by evicting
+     *         the least recently used ones
+     */
+    bool isMemoryLimitReached() const;
+
+    /**
+     * @return compressed cached frames that will be shown during the
+     *         playback in the next \p count frames after \p time and
+     *         have not been prefetched yet. The prefetched frames
+     *         outside this range are dropped.
+     */
+    QVector<KisOpenGLUpdateInfoSP> framesToPrefetch(int time, int count);
+
+    /**
+     * Decompresses the frame returned by framesToPrefetch(). The frame
+     * data is not modified, so it is safe to call from any thread.
+     * Returns a null pointer if the compressed data is corrupted.
+     */
+    KisOpenGLUpdateInfoSP decompressFrameData(KisOpenGLUpdateInfoSP info) const;
+
+    /**
+     * Saves the decompressed frames for uploadFrame(). \p sources are the
+     * frames as returned by framesToPrefetch()
+     */
+    void addPrefetchedFrames(const QVector<KisOpenGLUpdateInfoSP> &sources,
+                             const QVector<KisOpenGLUpdateInfoSP> &frames);
+
 Q_SIGNALS:
     void changed();
 
+private:
+    friend class KisAnimationFrameCacheTest;
+
+    qint64 testingMemoryUsage() const;
+    void testingSetMemoryLimit(qint64 limit);
+    void testingTouchFrame(int time);
+
 private:
 
     struct Private;
@@ -73,6 +110,7 @@ private:
 
 private Q_SLOTS:
     void framesChanged(const KisTimeRange &range, const QRect &rect);
+    void slotConfigChanged();
 };
 
 #endif
@@ -1869,6 +1869,26 @@ void KisConfig::setCalculateAnimationCacheInBackground(bool value)
     m_cfg.writeEntry("calculateAnimationCacheInBackground", value);
 }
 
+int KisConfig::animationCacheMemoryLimit(bool defaultValue) const
+{
+    return defaultValue ? 2048 : m_cfg.readEntry("animationCacheMemoryLimit", 2048);
+}
+
+void KisConfig::setAnimationCacheMemoryLimit(int value)
+{
+    m_cfg.writeEntry("animationCacheMemoryLimit", value);
+}
+
+bool KisConfig::compressAnimationCache(bool defaultValue) const
+{
+    return defaultValue ? true : m_cfg.readEntry("compressAnimationCache", true);
+}
+
+void KisConfig::setCompressAnimationCache(bool value)
+{
+    m_cfg.writeEntry("compressAnimationCache", value);
+}
+
 #include <QDomDocument>
 #include <QDomElement>
 
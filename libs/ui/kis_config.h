@@ -526,6 +526,15 @@ public:
     bool calculateAnimationCacheInBackground(bool defaultValue = false) const;
     void setCalculateAnimationCacheInBackground(bool value);
 
+    /**
+     * Memory budget of the animation frame cache of a single image in MiB
+     */
+    int animationCacheMemoryLimit(bool defaultValue = false) const;
+    void setAnimationCacheMemoryLimit(int value);
+
+    bool compressAnimationCache(bool defaultValue = false) const;
+    void setCompressAnimationCache(bool value);
+
     template<class T>
     void writeEntry(const QString& name, const T& value) {
         m_cfg.writeEntry(name, value);
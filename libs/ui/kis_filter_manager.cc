@@ -46,7 +46,6 @@
 #include "kis_canvas_resource_provider.h"
 #include "dialogs/kis_dlg_filter.h"
 #include "strokes/kis_filter_stroke_strategy.h"
-#include "krita_utils.h"
 
 
 struct KisFilterManager::Private {
@@ -284,17 +283,10 @@ void KisFilterManager::apply(KisFilterConfigurationSP filterConfig)
     QRect processRect = filter->changedRect(applyRect, filterConfig.data(), 0);
     processRect &= image->bounds();
 
-    if (filter->supportsThreading()) {
-        QSize size = KritaUtils::optimalPatchSize();
-        QVector<QRect> rects = KritaUtils::splitRectIntoPatches(processRect, size);
-
-        Q_FOREACH (const QRect &rc, rects) {
-            image->addJob(d->currentStrokeId,
-                          new KisFilterStrokeStrategy::Data(rc, true));
-        }
-    } else {
-        image->addJob(d->currentStrokeId,
-                      new KisFilterStrokeStrategy::Data(processRect, false));
+    Q_FOREACH (KisStrokeJobData *jobData,
+               KisFilterStrokeStrategy::createJobsData(filter, filterConfig, processRect,
+                                                       image->currentLevelOfDetail())) {
+        image->addJob(d->currentStrokeId, jobData);
     }
 
     d->currentlyAppliedConfiguration = filterConfig;
@@ -0,0 +1,264 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisOpenGLUpdateInfoBuilder.h"
+
+#include <QtConcurrent>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_lod_transform.h"
+#include "kis_debug.h"
+#include "opengl/kis_texture_tile.h"
+
+
+KisOpenGLUpdateInfoBuilder::KisOpenGLUpdateInfoBuilder()
+    : m_onlyOneChannelSelected(false),
+      m_selectedChannelIndex(-1),
+      m_proofingTransform(0),
+      m_proofingFlags(KoColorConversionTransformation::Empty),
+      m_downsamplingLevelOfDetail(0),
+      m_textureBorder(0),
+      m_effectiveTextureSize(256, 256)
+{
+}
+
+KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &rect, KisImageSP srcImage) const
+{
+    KisOpenGLUpdateInfoSP info = new KisOpenGLUpdateInfo(m_conversionOptions);
+
+    QRect updateRect = rect & srcImage->bounds();
+    if (updateRect.isEmpty()) return info;
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_pool, info);
+
+    /**
+     * Why the rect is artificial? That's easy!
+     * It does not represent any real piece of the image. It is
+     * intentionally stretched to get through the overlappping
+     * stripes of neutrality and poke neighbouring tiles.
+     * Thanks to the rect we get the coordinates of all the tiles
+     * involved into update process
+     */
+
+    QRect artificialRect = stretchRect(updateRect, m_textureBorder);
+    artificialRect &= srcImage->bounds();
+
+    int firstColumn = xToCol(artificialRect.left());
+    int lastColumn = xToCol(artificialRect.right());
+    int firstRow = yToRow(artificialRect.top());
+    int lastRow = yToRow(artificialRect.bottom());
+
+    qint32 numItems = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    info->tileList.reserve(numItems);
+
+    const QRect bounds = srcImage->bounds();
+    const int imageLevelOfDetail = srcImage->currentLevelOfDetail();
+
+    /**
+     * If the image has its own LoD plane, it is already downsampled,
+     * otherwise we can downsample the full-resolution projection
+     */
+    const bool downsample = !imageLevelOfDetail && m_downsamplingLevelOfDetail > 0;
+    const int levelOfDetail = downsample ? m_downsamplingLevelOfDetail : imageLevelOfDetail;
+
+    const QRect alignedUpdateRect = levelOfDetail ?
+        KisLodTransform::alignedRect(updateRect, levelOfDetail) : updateRect;
+
+    for (int col = firstColumn; col <= lastColumn; col++) {
+        for (int row = firstRow; row <= lastRow; row++) {
+            KisTextureTileUpdateInfoSP tileInfo =
+                createTileInfo(col, row, alignedUpdateRect, bounds, levelOfDetail);
+
+            // Don't update empty tiles
+            if (tileInfo->valid()) {
+                info->tileList.append(tileInfo);
+            }
+            else {
+                dbgUI << "Trying to create an empty tileinfo record" << col << row << updateRect << srcImage->bounds();
+            }
+        }
+    }
+
+    /**
+     * Reading and converting the tiles is the most expensive part of
+     * the update, and every tile writes into its own buffer only. The
+     * color conversion cache gives every thread its own converter, and
+     * the proofing transform is only read, so the tiles can be processed
+     * concurrently.
+     */
+    KisPaintDeviceSP projection = srcImage->projection();
+
+    if (info->tileList.size() > 1) {
+        QtConcurrent::blockingMap(info->tileList,
+            [this, projection, downsample] (KisTextureTileUpdateInfoSP &tileInfo) {
+                processTile(tileInfo, projection, downsample);
+            });
+    } else {
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+            processTile(tileInfo, projection, downsample);
+        }
+    }
+
+    info->assignDirtyImageRect(rect);
+    info->assignLevelOfDetail(levelOfDetail);
+    return info;
+}
+
+KisTextureTileUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildEntireTileUpdateInfo(int col, int row, int levelOfDetail, KisImageSP srcImage) const
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_pool, KisTextureTileUpdateInfoSP());
+
+    const int imageLevelOfDetail = srcImage->currentLevelOfDetail();
+
+    /**
+     * The image's own LoD plane can be read at its own level only,
+     * the full-resolution projection can be downsampled to any level
+     */
+    if (imageLevelOfDetail && imageLevelOfDetail != levelOfDetail) {
+        return KisTextureTileUpdateInfoSP();
+    }
+
+    const bool downsample = !imageLevelOfDetail && levelOfDetail > 0;
+
+    const QRect bounds = srcImage->bounds();
+    const QRect alignedBounds = levelOfDetail ?
+        KisLodTransform::alignedRect(bounds, levelOfDetail) : bounds;
+
+    KisTextureTileUpdateInfoSP tileInfo =
+        createTileInfo(col, row, alignedBounds, bounds, levelOfDetail);
+
+    if (!tileInfo->valid()) {
+        return KisTextureTileUpdateInfoSP();
+    }
+
+    processTile(tileInfo, srcImage->projection(), downsample);
+    return tileInfo;
+}
+
+bool KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(const KisTextureTileUpdateInfo &info, int currentLodPlane)
+{
+    if (info.isEntireTileUpdated()) return false;
+
+    const int levelOfDetail = info.patchLevelOfDetail();
+    return levelOfDetail != currentLodPlane &&
+        !(currentLodPlane == 0 && levelOfDetail > 0);
+}
+
+KisTextureTileUpdateInfoSP KisOpenGLUpdateInfoBuilder::createTileInfo(int col, int row,
+                                                                      const QRect &updateRect,
+                                                                      const QRect &bounds,
+                                                                      int levelOfDetail) const
+{
+    const QRect tileRect = calculateEffectiveTileRect(col, row, bounds);
+    const QRect tileTextureRect = stretchRect(tileRect, m_textureBorder);
+
+    QRect alignedTileTextureRect = tileTextureRect;
+    QRect alignedBounds = bounds;
+
+    if (levelOfDetail) {
+        alignedTileTextureRect = KisLodTransform::alignedRect(alignedTileTextureRect, levelOfDetail);
+        alignedBounds = KisLodTransform::alignedRect(alignedBounds, levelOfDetail);
+    }
+
+    return new KisTextureTileUpdateInfo(col, row,
+                                        alignedTileTextureRect,
+                                        updateRect,
+                                        alignedBounds,
+                                        levelOfDetail,
+                                        m_pool);
+}
+
+void KisOpenGLUpdateInfoBuilder::processTile(KisTextureTileUpdateInfoSP tileInfo, KisPaintDeviceSP projection, bool downsample) const
+{
+    if (downsample) {
+        tileInfo->retrieveDownsampledData(projection, m_channelFlags, m_onlyOneChannelSelected, m_selectedChannelIndex);
+    } else {
+        tileInfo->retrieveData(projection, m_channelFlags, m_onlyOneChannelSelected, m_selectedChannelIndex);
+    }
+
+    if (m_conversionOptions.m_needsConversion) {
+        const KoColorSpace *dstCS = m_conversionOptions.m_destinationColorSpace;
+
+        if (m_proofingTransform) {
+            tileInfo->proofTo(dstCS, m_proofingFlags, m_proofingTransform);
+        } else {
+            tileInfo->convertTo(dstCS,
+                                m_conversionOptions.m_renderingIntent,
+                                m_conversionOptions.m_conversionFlags);
+        }
+    }
+}
+
+QRect KisOpenGLUpdateInfoBuilder::calculateEffectiveTileRect(int col, int row, const QRect &imageBounds) const
+{
+    return imageBounds &
+            QRect(col * m_effectiveTextureSize.width(),
+                  row * m_effectiveTextureSize.height(),
+                  m_effectiveTextureSize.width(),
+                  m_effectiveTextureSize.height());
+}
+
+int KisOpenGLUpdateInfoBuilder::xToCol(int x) const
+{
+    return x / m_effectiveTextureSize.width();
+}
+
+int KisOpenGLUpdateInfoBuilder::yToRow(int y) const
+{
+    return y / m_effectiveTextureSize.height();
+}
+
+void KisOpenGLUpdateInfoBuilder::setConversionOptions(const ConversionOptions &options)
+{
+    m_conversionOptions = options;
+}
+
+void KisOpenGLUpdateInfoBuilder::setChannelFlags(const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex)
+{
+    m_channelFlags = channelFlags;
+    m_onlyOneChannelSelected = onlyOneChannelSelected;
+    m_selectedChannelIndex = selectedChannelIndex;
+}
+
+void KisOpenGLUpdateInfoBuilder::setProofingTransform(KoColorConversionTransformation *transform,
+                                                      KoColorConversionTransformation::ConversionFlags proofingFlags)
+{
+    m_proofingTransform = transform;
+    m_proofingFlags = proofingFlags;
+}
+
+void KisOpenGLUpdateInfoBuilder::setDownsamplingLevelOfDetail(int levelOfDetail)
+{
+    m_downsamplingLevelOfDetail = levelOfDetail;
+}
+
+void KisOpenGLUpdateInfoBuilder::setTextureBorder(int border)
+{
+    m_textureBorder = border;
+}
+
+void KisOpenGLUpdateInfoBuilder::setEffectiveTextureSize(const QSize &size)
+{
+    m_effectiveTextureSize = size;
+}
+
+void KisOpenGLUpdateInfoBuilder::setTextureInfoPool(KisTextureTileInfoPoolSP pool)
+{
+    m_pool = pool;
+}
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISOPENGLUPDATEINFOBUILDER_H
+#define KISOPENGLUPDATEINFOBUILDER_H
+
+#include <QBitArray>
+#include <QRect>
+#include <QSize>
+
+#include "kritaui_export.h"
+#include "kis_types.h"
+#include "canvas/kis_update_info.h"
+#include "opengl/kis_texture_tile_info_pool.h"
+
+class KoColorConversionTransformation;
+
+/**
+ * Prepares the CPU-side part of the canvas texture update: reads the
+ * pixels of all the texture tiles touched by the update from the
+ * projection and converts them into the display color space.
+ *
+ * The tiles are independent from each other, so they are processed
+ * concurrently. The builder doesn't touch any OpenGL state, so it can be
+ * used (and benchmarked) without any GL context.
+ */
+class KRITAUI_EXPORT KisOpenGLUpdateInfoBuilder
+{
+public:
+    KisOpenGLUpdateInfoBuilder();
+
+    /**
+     * Builds the update info for \p rect of \p srcImage. The pixels of
+     * all the tiles are fetched and converted before the function
+     * returns.
+     */
+    KisOpenGLUpdateInfoSP buildUpdateInfo(const QRect &rect, KisImageSP srcImage) const;
+
+    /**
+     * Builds the update of the entire tile (\p col, \p row) at
+     * \p levelOfDetail, including its border. It is used when a partial
+     * patch cannot be uploaded into the tile (see needsEntireTileUpdate()).
+     *
+     * \return null if the image is currently at a level of detail
+     *         the tile cannot be fetched at
+     */
+    KisTextureTileUpdateInfoSP buildEntireTileUpdateInfo(int col, int row, int levelOfDetail, KisImageSP srcImage) const;
+
+    /**
+     * A partial patch can be uploaded only into a texture plane, which is
+     * valid around the patch. It is the plane the tile currently shows
+     * (\p currentLodPlane), or any coarser plane, when the tile shows
+     * level 0, since the coarser planes are regenerated from it then.
+     *
+     * \return true if the tile should be updated entirely instead of
+     *         uploading the patch of \p info
+     */
+    static bool needsEntireTileUpdate(const KisTextureTileUpdateInfo &info, int currentLodPlane);
+
+    /**
+     * \return the rect of the image covered by the tile (\p col, \p row),
+     *         excluding the border
+     */
+    QRect calculateEffectiveTileRect(int col, int row, const QRect &imageBounds) const;
+
+    int xToCol(int x) const;
+    int yToRow(int y) const;
+
+    /**
+     * If the options don't need conversion, the tiles are kept in the
+     * color space of the projection
+     */
+    void setConversionOptions(const ConversionOptions &options);
+
+    /**
+     * \p channelFlags should be empty when all the channels are visible
+     */
+    void setChannelFlags(const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex);
+
+    /**
+     * Soft-proof the tiles with \p transform instead of the normal
+     * conversion. The transform is not owned by the builder and must
+     * stay alive while buildUpdateInfo() is running. Pass null to
+     * disable proofing.
+     */
+    void setProofingTransform(KoColorConversionTransformation *transform,
+                              KoColorConversionTransformation::ConversionFlags proofingFlags);
+
+    /**
+     * When the image itself is at full resolution, fetch the tiles at
+     * \p levelOfDetail anyway, by downsampling the projection on the CPU.
+     * It is used when the canvas is zoomed out, so the conversion and
+     * the upload don't process the pixels that are never displayed.
+     * Zero (default) disables downsampling.
+     */
+    void setDownsamplingLevelOfDetail(int levelOfDetail);
+
+    void setTextureBorder(int border);
+    void setEffectiveTextureSize(const QSize &size);
+    void setTextureInfoPool(KisTextureTileInfoPoolSP pool);
+
+private:
+    KisTextureTileUpdateInfoSP createTileInfo(int col, int row,
+                                              const QRect &updateRect,
+                                              const QRect &bounds,
+                                              int levelOfDetail) const;
+
+    void processTile(KisTextureTileUpdateInfoSP tileInfo, KisPaintDeviceSP projection, bool downsample) const;
+
+private:
+    ConversionOptions m_conversionOptions;
+
+    QBitArray m_channelFlags;
+    bool m_onlyOneChannelSelected;
+    int m_selectedChannelIndex;
+
+    KoColorConversionTransformation *m_proofingTransform;
+    KoColorConversionTransformation::ConversionFlags m_proofingFlags;
+
+    int m_downsamplingLevelOfDetail;
+
+    int m_textureBorder;
+    QSize m_effectiveTextureSize;
+    KisTextureTileInfoPoolSP m_pool;
+};
+
+#endif // KISOPENGLUPDATEINFOBUILDER_H
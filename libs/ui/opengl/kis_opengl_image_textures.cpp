@@ -17,6 +17,7 @@
  */
 
 #include "opengl/kis_opengl_image_textures.h"
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
 
 #include <QOpenGLFunctions>
 #include <QOpenGLContext>
@@ -250,51 +251,53 @@ void KisOpenGLImageTextures::destroyImageTextureTiles()
         delete tile;
     }
     m_textureTiles.clear();
+    m_coarseTilesPendingUpdate.clear();
     m_storedImageBounds = QRect();
 }
 
-KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCache(const QRect& rect, KisImageSP srcImage)
+KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCache(const QRect& rect, KisImageSP srcImage, bool allowDownsampling)
 {
-    return updateCacheImpl(rect, srcImage, true);
+    return updateCacheImpl(rect, srcImage, true, allowDownsampling);
 }
 
 KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCacheNoConversion(const QRect& rect)
 {
-    return updateCacheImpl(rect, m_image, false);
+    return updateCacheImpl(rect, m_image, false, false);
 }
 
 // TODO: add sanity checks about the conformance of the passed srcImage!
-KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCacheImpl(const QRect& rect, KisImageSP srcImage, bool convertColorSpace)
+KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCacheImpl(const QRect& rect, KisImageSP srcImage, bool convertColorSpace, bool allowDownsampling)
 {
-    const KoColorSpace *dstCS = m_tilesDestinationColorSpace;
+    QRect updateRect = rect & srcImage->bounds();
+    if (updateRect.isEmpty() || !(m_initialized)) {
+        ConversionOptions options;
 
-    ConversionOptions options;
+        if (convertColorSpace) {
+            options = ConversionOptions(m_tilesDestinationColorSpace, m_renderingIntent, m_conversionFlags);
+        }
 
-    if (convertColorSpace) {
-        options = ConversionOptions(dstCS, m_renderingIntent, m_conversionFlags);
+        return new KisOpenGLUpdateInfo(options);
     }
 
-    KisOpenGLUpdateInfoSP info = new KisOpenGLUpdateInfo(options);
+    KisOpenGLUpdateInfoBuilder builder;
+    setupUpdateInfoBuilder(&builder, srcImage, convertColorSpace);
 
-    QRect updateRect = rect & srcImage->bounds();
-    if (updateRect.isEmpty() || !(m_initialized)) return info;
+    if (allowDownsampling) {
+        builder.setDownsamplingLevelOfDetail(m_downsamplingLevelOfDetail.load());
+    }
 
-    /**
-     * Why the rect is artificial? That's easy!
-     * It does not represent any real piece of the image. It is
-     * intentionally stretched to get through the overlappping
-     * stripes of neutrality and poke neighbouring tiles.
-     * Thanks to the rect we get the coordinates of all the tiles
-     * involved into update process
-     */
+    return builder.buildUpdateInfo(rect, srcImage);
+}
 
-    QRect artificialRect = stretchRect(updateRect, m_texturesInfo.border);
-    artificialRect &= srcImage->bounds();
+void KisOpenGLImageTextures::setupUpdateInfoBuilder(KisOpenGLUpdateInfoBuilder *builder, KisImageSP srcImage, bool convertColorSpace)
+{
+    const KoColorSpace *dstCS = m_tilesDestinationColorSpace;
 
-    int firstColumn = xToCol(artificialRect.left());
-    int lastColumn = xToCol(artificialRect.right());
-    int firstRow = yToRow(artificialRect.top());
-    int lastRow = yToRow(artificialRect.bottom());
+    ConversionOptions options;
+
+    if (convertColorSpace) {
+        options = ConversionOptions(dstCS, m_renderingIntent, m_conversionFlags);
+    }
 
     QBitArray channelFlags; // empty by default
 
@@ -307,67 +310,22 @@ KisOpenGLUpdateInfoSP KisOpenGLImageTextures::updateCacheImpl(const QRect& rect,
         }
     }
 
-    qint32 numItems = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
-    info->tileList.reserve(numItems);
-
-    const QRect bounds = srcImage->bounds();
-    const int levelOfDetail = srcImage->currentLevelOfDetail();
-
-    QRect alignedUpdateRect = updateRect;
-    QRect alignedBounds = bounds;
-
-    if (levelOfDetail) {
-        alignedUpdateRect = KisLodTransform::alignedRect(alignedUpdateRect, levelOfDetail);
-        alignedBounds = KisLodTransform::alignedRect(alignedBounds, levelOfDetail);
+    //create transform
+    if (m_createNewProofingTransform && m_proofingConfig) {
+        const KoColorSpace *proofingSpace = KoColorSpaceRegistry::instance()->colorSpace(m_proofingConfig->proofingModel,m_proofingConfig->proofingDepth,m_proofingConfig->proofingProfile);
+        m_proofingTransform.reset(srcImage->projection()->colorSpace()->createProofingTransform(dstCS, proofingSpace, m_renderingIntent, m_proofingConfig->intent, m_proofingConfig->conversionFlags, m_proofingConfig->warningColor.data(), m_proofingConfig->adaptationState));
+        m_createNewProofingTransform = false;
     }
 
-    for (int col = firstColumn; col <= lastColumn; col++) {
-        for (int row = firstRow; row <= lastRow; row++) {
+    builder->setConversionOptions(options);
+    builder->setChannelFlags(channelFlags, m_onlyOneChannelSelected, m_selectedChannelIndex);
+    builder->setTextureBorder(m_texturesInfo.border);
+    builder->setEffectiveTextureSize(QSize(m_texturesInfo.effectiveWidth, m_texturesInfo.effectiveHeight));
+    builder->setTextureInfoPool(m_infoChunksPool);
 
-            const QRect tileRect = calculateTileRect(col, row);
-            const QRect tileTextureRect = stretchRect(tileRect, m_texturesInfo.border);
-
-            QRect alignedTileTextureRect = levelOfDetail ?
-                        KisLodTransform::alignedRect(tileTextureRect, levelOfDetail) :
-                        tileTextureRect;
-
-            KisTextureTileUpdateInfoSP tileInfo(
-                        new KisTextureTileUpdateInfo(col, row,
-                                                     alignedTileTextureRect,
-                                                     alignedUpdateRect,
-                                                     alignedBounds,
-                                                     levelOfDetail,
-                                                     m_infoChunksPool));
-            // Don't update empty tiles
-            if (tileInfo->valid()) {
-                tileInfo->retrieveData(srcImage->projection(), channelFlags, m_onlyOneChannelSelected, m_selectedChannelIndex);
-
-                //create transform
-                if (m_createNewProofingTransform) {
-                    const KoColorSpace *proofingSpace = KoColorSpaceRegistry::instance()->colorSpace(m_proofingConfig->proofingModel,m_proofingConfig->proofingDepth,m_proofingConfig->proofingProfile);
-                    m_proofingTransform.reset(tileInfo->generateProofingTransform(dstCS, proofingSpace, m_renderingIntent, m_proofingConfig->intent, m_proofingConfig->conversionFlags, m_proofingConfig->warningColor, m_proofingConfig->adaptationState));
-                    m_createNewProofingTransform = false;
-                }
-
-                if (convertColorSpace) {
-                    if (m_proofingConfig && m_proofingTransform && m_proofingConfig->conversionFlags.testFlag(KoColorConversionTransformation::SoftProofing)) {
-                        tileInfo->proofTo(dstCS, m_proofingConfig->conversionFlags, m_proofingTransform.data());
-                    } else {
-                        tileInfo->convertTo(dstCS, m_renderingIntent, m_conversionFlags);
-                    }
-                }
-
-                info->tileList.append(tileInfo);
-            }
-            else {
-                dbgUI << "Trying to create an empty tileinfo record" << col << row << tileTextureRect << updateRect << srcImage->bounds();
-            }
-        }
+    if (m_proofingConfig && m_proofingTransform && m_proofingConfig->conversionFlags.testFlag(KoColorConversionTransformation::SoftProofing)) {
+        builder->setProofingTransform(m_proofingTransform.data(), m_proofingConfig->conversionFlags);
     }
-
-    info->assignDirtyImageRect(rect);
-    info->assignLevelOfDetail(levelOfDetail);
-    return info;
 }
 
 void KisOpenGLImageTextures::recalculateCache(KisUpdateInfoSP info)
@@ -380,12 +338,46 @@ void KisOpenGLImageTextures::recalculateCache(KisUpdateInfoSP info)
     KisOpenGLUpdateInfoSP glInfo = dynamic_cast<KisOpenGLUpdateInfo*>(info.data());
     if(!glInfo) return;
 
+    QScopedPointer<KisOpenGLUpdateInfoBuilder> entireTileBuilder;
+
     KisTextureTileUpdateInfoSP tileInfo;
     Q_FOREACH (tileInfo, glInfo->tileList) {
         KisTextureTile *tile = getTextureTileCR(tileInfo->tileCol(), tileInfo->tileRow());
         KIS_ASSERT_RECOVER_RETURN(tile);
 
+        /**
+         * When the level of detail of the tile changes, the texture plane
+         * of the new level holds stale pixels around the patch, so the
+         * tile is refetched entirely. It happens when the canvas is zoomed
+         * while the image is being updated.
+         */
+        if (KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*tileInfo, tile->currentLodPlane())) {
+            if (!entireTileBuilder) {
+                entireTileBuilder.reset(new KisOpenGLUpdateInfoBuilder());
+                setupUpdateInfoBuilder(entireTileBuilder.data(), m_image, glInfo->needsConversion());
+            }
+
+            KisTextureTileUpdateInfoSP entireTileInfo =
+                entireTileBuilder->buildEntireTileUpdateInfo(tileInfo->tileCol(),
+                                                             tileInfo->tileRow(),
+                                                             tileInfo->patchLevelOfDetail(),
+                                                             m_image);
+
+            /**
+             * The image has already switched to another LoD plane, so
+             * the whole tile will be updated by the LoD synchronization
+             * anyway
+             */
+            if (!entireTileInfo) continue;
+
+            tileInfo = entireTileInfo;
+        }
+
         tile->update(*tileInfo);
+
+        if (tileInfo->isEntireTileUpdated()) {
+            m_coarseTilesPendingUpdate.remove(tileInfo->tileRow() * m_numCols + tileInfo->tileCol());
+        }
     }
 }
 
@@ -451,6 +443,43 @@ void KisOpenGLImageTextures::updateConfig(bool useBuffer, int NumMipmapLevels)
     }
 }
 
+void KisOpenGLImageTextures::setDownsamplingLevelOfDetail(int levelOfDetail)
+{
+    if (m_downsamplingLevelOfDetail.fetchAndStoreOrdered(levelOfDetail) != levelOfDetail) {
+        m_coarseTilesPendingUpdate.clear();
+    }
+}
+
+QRect KisOpenGLImageTextures::takeCoarseTilesRect(const QRect &imageRect)
+{
+    QRect coarseTilesRect;
+
+    const QRect rect = imageRect & m_storedImageBounds;
+    if (!m_initialized || rect.isEmpty()) return coarseTilesRect;
+
+    const int levelOfDetail = m_downsamplingLevelOfDetail.load();
+
+    const int firstColumn = xToCol(rect.left());
+    const int lastColumn = xToCol(rect.right());
+    const int firstRow = yToRow(rect.top());
+    const int lastRow = yToRow(rect.bottom());
+
+    for (int col = firstColumn; col <= lastColumn; col++) {
+        for (int row = firstRow; row <= lastRow; row++) {
+            KisTextureTile *tile = getTextureTileCR(col, row);
+            if (!tile || tile->currentLodPlane() <= levelOfDetail) continue;
+
+            const int index = row * m_numCols + col;
+            if (m_coarseTilesPendingUpdate.contains(index)) continue;
+
+            m_coarseTilesPendingUpdate.insert(index);
+            coarseTilesRect |= tile->textureRectInImagePixels();
+        }
+    }
+
+    return coarseTilesRect & m_storedImageBounds;
+}
+
 void KisOpenGLImageTextures::slotImageSizeChanged(qint32 /*w*/, qint32 /*h*/)
 {
     createImageTextureTiles();
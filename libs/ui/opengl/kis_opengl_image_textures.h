@@ -20,6 +20,8 @@
 
 #include <QVector>
 #include <QMap>
+#include <QSet>
+#include <QAtomicInt>
 #include <QOpenGLFunctions>
 
 #include "kritaui_export.h"
@@ -37,6 +39,7 @@ typedef KisSharedPtr<KisOpenGLImageTextures> KisOpenGLImageTexturesSP;
 
 class KoColorProfile;
 class KisTextureTileUpdateInfoPoolCollection;
+class KisOpenGLUpdateInfoBuilder;
 typedef QSharedPointer<KisTextureTileInfoPool> KisTextureTileInfoPoolSP;
 
 /**
@@ -104,6 +107,25 @@ public:
 
     void updateConfig(bool useBuffer, int NumMipmapLevels);
 
+    /**
+     * Sets the level of detail the tiles are fetched at, while the image
+     * itself is at full resolution. The projection is then downsampled
+     * on the CPU, so the zoomed-out canvas doesn't convert and upload the
+     * pixels it never shows.
+     *
+     * The tiles are not refetched. The dirty tiles are updated entirely
+     * when they switch to the new level, and the tiles that became too
+     * coarse are reported by takeCoarseTilesRect().
+     */
+    void setDownsamplingLevelOfDetail(int levelOfDetail);
+
+    /**
+     * \return the image rect of the tiles intersecting \p imageRect, which
+     *         show a coarser plane than the current downsampling level.
+     *         Every tile is reported only once, until it gets updated.
+     */
+    QRect takeCoarseTilesRect(const QRect &imageRect);
+
 public:
     inline QRect storedImageBounds() {
         return m_storedImageBounds;
@@ -131,7 +153,11 @@ public:
         return 1.0 / m_texturesInfo.width;
     }
 
-    KisOpenGLUpdateInfoSP updateCache(const QRect& rect, KisImageSP srcImage);
+    /**
+     * \p allowDownsampling should be false for the updates, which can be
+     *    shown at any zoom, like the frames of the animation cache
+     */
+    KisOpenGLUpdateInfoSP updateCache(const QRect& rect, KisImageSP srcImage, bool allowDownsampling = true);
     KisOpenGLUpdateInfoSP updateCacheNoConversion(const QRect& rect);
 
     void recalculateCache(KisUpdateInfoSP info);
@@ -146,6 +172,8 @@ protected:
 
     void createImageTextureTiles();
 
+    void setupUpdateInfoBuilder(KisOpenGLUpdateInfoBuilder *builder, KisImageSP srcImage, bool convertColorSpace);
+
     void destroyImageTextureTiles();
 
     static bool imageCanShareTextures();
@@ -157,7 +185,7 @@ private:
     void getTextureSize(KisGLTexturesInfo *texturesInfo);
 
     void updateTextureFormat();
-    KisOpenGLUpdateInfoSP updateCacheImpl(const QRect& rect, KisImageSP srcImage, bool convertColorSpace);
+    KisOpenGLUpdateInfoSP updateCacheImpl(const QRect& rect, KisImageSP srcImage, bool convertColorSpace, bool allowDownsampling);
 
 private:
     KisImageWSP m_image;
@@ -202,6 +230,9 @@ private:
 
     KisTextureTileInfoPoolSP m_infoChunksPool;
 
+    QAtomicInt m_downsamplingLevelOfDetail;
+    QSet<int> m_coarseTilesPendingUpdate;
+
 private:
     typedef QMap<KisImageWSP, KisOpenGLImageTextures*> ImageTexturesMap;
     static ImageTexturesMap imageTexturesMap;
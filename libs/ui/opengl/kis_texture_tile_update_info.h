@@ -21,8 +21,13 @@
 #include <QMessageBox>
 #include <QThreadStorage>
 #include <QScopedArrayPointer>
+#include <QByteArray>
+#include <QVarLengthArray>
+
+#include <algorithm>
 
 #include <KoColorSpace.h>
+#include <KoMixColorsOp.h>
 #include "kis_image.h"
 #include "kis_paint_device.h"
 #include "kis_config.h"
@@ -30,6 +35,7 @@
 #include <KoChannelInfo.h>
 #include <kis_lod_transform.h>
 #include "kis_texture_tile_info_pool.h"
+#include "tiles3/swap/kis_abstract_compression.h"
 
 
 class KisTextureTileUpdateInfo;
@@ -96,6 +102,156 @@ private:
     KisTextureTileInfoPoolSP m_pool;
 };
 
+/**
+ * Box-filter downsampling of the texture patches on the CPU. The colors
+ * are weighted by alpha, the same way KoMixColorsOp mixes them, so the
+ * transparent pixels don't darken the edges of the opaque areas. The
+ * vertical pass sums whole contiguous rows of interleaved channels,
+ * so the compiler can vectorize it.
+ */
+namespace KisTextureTileDownsampling {
+
+/**
+ * The sums of a 16-bit channel weighted by 16-bit alpha overflow
+ * 32 bits for a block of more than one pixel
+ */
+template <typename T>
+struct BoxFilterTraits {
+    typedef quint64 accumulator_type;
+
+    static inline T divide(accumulator_type sum, accumulator_type weight) {
+        return T((sum + weight / 2) / weight);
+    }
+};
+
+template <>
+struct BoxFilterTraits<quint8> {
+    typedef quint32 accumulator_type;
+
+    static inline quint8 divide(accumulator_type sum, accumulator_type weight) {
+        return quint8((sum + weight / 2) / weight);
+    }
+};
+
+template <>
+struct BoxFilterTraits<float> {
+    typedef float accumulator_type;
+
+    static inline float divide(accumulator_type sum, accumulator_type weight) {
+        return sum / weight;
+    }
+};
+
+/**
+ * Averages every \p factor x \p factor block of \p src into a
+ * pixel of \p dst. \p src should contain `numDstRows * factor` rows
+ * of `dstWidth * factor` pixels. The color channels are weighted by the
+ * channel at \p alphaPos, the blocks without any opaque pixels become
+ * fully transparent black.
+ */
+template <typename T>
+void downsampleBox(const quint8 *srcBytes, quint8 *dstBytes,
+                   int dstWidth, int numDstRows,
+                   int elementsPerPixel, int alphaPos, int levelOfDetail)
+{
+    typedef typename BoxFilterTraits<T>::accumulator_type Acc;
+
+    const int factor = 1 << levelOfDetail;
+    const int srcWidth = dstWidth * factor;
+    const int srcRowElements = srcWidth * elementsPerPixel;
+    const int blockElements = factor * elementsPerPixel;
+    const Acc blockPixels = Acc(factor * factor);
+
+    const T *src = reinterpret_cast<const T*>(srcBytes);
+    T *dst = reinterpret_cast<T*>(dstBytes);
+
+    // the vertical sums of the premultiplied source rows
+    QVarLengthArray<Acc, 4096> columnSums(srcRowElements);
+    QVarLengthArray<Acc, 1024> alphaSums(srcWidth);
+
+    for (int row = 0; row < numDstRows; row++) {
+        std::fill(columnSums.begin(), columnSums.end(), Acc(0));
+        std::fill(alphaSums.begin(), alphaSums.end(), Acc(0));
+
+        for (int r = 0; r < factor; r++) {
+            const T *srcPixel = src + (row * factor + r) * srcRowElements;
+            Acc *sums = columnSums.data();
+
+            for (int x = 0; x < srcWidth; x++) {
+                const Acc alpha = srcPixel[alphaPos];
+
+                for (int c = 0; c < elementsPerPixel; c++) {
+                    sums[c] += Acc(srcPixel[c]) * alpha;
+                }
+                alphaSums[x] += alpha;
+
+                srcPixel += elementsPerPixel;
+                sums += elementsPerPixel;
+            }
+        }
+
+        T *dstPixel = dst + row * dstWidth * elementsPerPixel;
+
+        for (int x = 0; x < dstWidth; x++) {
+            const Acc *block = columnSums.constData() + x * blockElements;
+
+            Acc alpha = 0;
+            for (int k = 0; k < factor; k++) {
+                alpha += alphaSums[x * factor + k];
+            }
+
+            if (alpha > Acc(0)) {
+                for (int c = 0; c < elementsPerPixel; c++) {
+                    Acc sum = 0;
+                    for (int k = 0; k < factor; k++) {
+                        sum += block[k * elementsPerPixel + c];
+                    }
+                    dstPixel[c] = BoxFilterTraits<T>::divide(sum, alpha);
+                }
+                dstPixel[alphaPos] = BoxFilterTraits<T>::divide(alpha, blockPixels);
+            } else {
+                std::fill(dstPixel, dstPixel + elementsPerPixel, T(0));
+            }
+
+            dstPixel += elementsPerPixel;
+        }
+    }
+}
+
+/**
+ * Generic version of downsampleBox() for the channel types without
+ * a fast path. It is much slower, since it mixes every block with
+ * KoMixColorsOp.
+ */
+inline void downsampleBoxGeneric(const KoColorSpace *cs,
+                                 const quint8 *src, quint8 *dst,
+                                 int dstWidth, int numDstRows,
+                                 int levelOfDetail)
+{
+    const int factor = 1 << levelOfDetail;
+    const int pixelSize = cs->pixelSize();
+    const int srcRowSize = dstWidth * factor * pixelSize;
+
+    QVarLengthArray<const quint8*, 256> blockPixels(factor * factor);
+
+    for (int row = 0; row < numDstRows; row++) {
+        for (int x = 0; x < dstWidth; x++) {
+            for (int r = 0; r < factor; r++) {
+                const quint8 *srcBlockRow = src + (row * factor + r) * srcRowSize + x * factor * pixelSize;
+
+                for (int k = 0; k < factor; k++) {
+                    blockPixels[r * factor + k] = srcBlockRow + k * pixelSize;
+                }
+            }
+
+            cs->mixColorsOp()->mixColors(blockPixels.constData(), factor * factor, dst);
+            dst += pixelSize;
+        }
+    }
+}
+
+}
+
 class KisTextureTileUpdateInfo
 {
 public:
@@ -141,55 +297,75 @@ public:
                                        m_patchRect.x(), m_patchRect.y(),
                                        m_patchRect.width(), m_patchRect.height());
 
-        // XXX: if the paint colorspace is rgb, we should do the channel swizzling in
-        //      the display shader
-        if (!channelFlags.isEmpty()) {
-            DataBuffer conversionCache(m_patchColorSpace->pixelSize(), m_pool);
+        applyChannelFlags(channelFlags, onlyOneChannelSelected, selectedChannelIndex);
+    }
 
-            QList<KoChannelInfo*> channelInfo = m_patchColorSpace->channels();
-            int channelSize = channelInfo[selectedChannelIndex]->size();
-            int pixelSize = m_patchColorSpace->pixelSize();
-            quint32 numPixels = m_patchRect.width() * m_patchRect.height();
+    /**
+     * Reads the patch from the full-resolution \p projectionDevice and
+     * downsamples it on the CPU to the level of detail of the patch. Only
+     * the downsampled pixels are stored, so the following conversion and
+     * the upload process 4^lod times less data than a full-resolution
+     * patch would.
+     *
+     * The pixels are averaged with a box filter weighted by alpha, the
+     * same way KoMixColorsOp mixes them.
+     */
+    void retrieveDownsampledData(KisPaintDeviceSP projectionDevice, const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex)
+    {
+        if (!m_patchLevelOfDetail) {
+            retrieveData(projectionDevice, channelFlags, onlyOneChannelSelected, selectedChannelIndex);
+            return;
+        }
 
-            KisConfig cfg;
+        m_patchColorSpace = projectionDevice->colorSpace();
+        m_patchPixels.allocate(m_patchColorSpace->pixelSize());
 
-            if (onlyOneChannelSelected && !cfg.showSingleChannelAsColor()) {
-                int selectedChannelPos = channelInfo[selectedChannelIndex]->pos();
-                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
-                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
+        const int factor = 1 << m_patchLevelOfDetail;
+        const int pixelSize = m_patchColorSpace->pixelSize();
+        const int dstWidth = m_patchRect.width();
+        const int dstHeight = m_patchRect.height();
+        const int srcWidth = m_originalPatchRect.width();
 
-                        if (channelInfo[channelIndex]->channelType() == KoChannelInfo::COLOR) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + selectedChannelPos,
-                                   channelSize);
-                        }
-                        else if (channelInfo[channelIndex]->channelType() == KoChannelInfo::ALPHA) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   channelSize);
-                        }
-                    }
-                }
-            }
-            else {
-                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
-                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
-                        if (channelFlags.testBit(channelIndex)) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   channelSize);
-                        }
-                        else {
-                            memset(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize), 0, channelSize);
-                        }
-                    }
-                }
+        KIS_SAFE_ASSERT_RECOVER_RETURN(srcWidth == dstWidth * factor);
+
+        const KoChannelInfo::enumChannelValueType valueType =
+            m_patchColorSpace->channels().first()->channelValueType();
+        const int channelCount = m_patchColorSpace->channelCount();
 
+        int alphaPos = -1;
+        Q_FOREACH (const KoChannelInfo *channel, m_patchColorSpace->channels()) {
+            if (channel->channelType() == KoChannelInfo::ALPHA) {
+                alphaPos = channel->pos() / channel->size();
             }
+        }
 
-            conversionCache.swap(m_patchPixels);
+        // read the source in stripes of about 64 rows
+        const int dstRowsPerStripe = qMax(1, 64 / factor);
+        QVector<quint8> stripe(srcWidth * dstRowsPerStripe * factor * pixelSize);
+
+        for (int row = 0; row < dstHeight; row += dstRowsPerStripe) {
+            const int numDstRows = qMin(dstRowsPerStripe, dstHeight - row);
+
+            projectionDevice->readBytes(stripe.data(),
+                                        m_originalPatchRect.x(), m_originalPatchRect.y() + row * factor,
+                                        srcWidth, numDstRows * factor);
+
+            quint8 *dstPtr = m_patchPixels.data() + row * dstWidth * pixelSize;
+
+            if (alphaPos < 0) {
+                KisTextureTileDownsampling::downsampleBoxGeneric(m_patchColorSpace, stripe.constData(), dstPtr, dstWidth, numDstRows, m_patchLevelOfDetail);
+            } else if (valueType == KoChannelInfo::UINT8 && channelCount * int(sizeof(quint8)) == pixelSize) {
+                KisTextureTileDownsampling::downsampleBox<quint8>(stripe.constData(), dstPtr, dstWidth, numDstRows, channelCount, alphaPos, m_patchLevelOfDetail);
+            } else if (valueType == KoChannelInfo::UINT16 && channelCount * int(sizeof(quint16)) == pixelSize) {
+                KisTextureTileDownsampling::downsampleBox<quint16>(stripe.constData(), dstPtr, dstWidth, numDstRows, channelCount, alphaPos, m_patchLevelOfDetail);
+            } else if (valueType == KoChannelInfo::FLOAT32 && channelCount * int(sizeof(float)) == pixelSize) {
+                KisTextureTileDownsampling::downsampleBox<float>(stripe.constData(), dstPtr, dstWidth, numDstRows, channelCount, alphaPos, m_patchLevelOfDetail);
+            } else {
+                KisTextureTileDownsampling::downsampleBoxGeneric(m_patchColorSpace, stripe.constData(), dstPtr, dstWidth, numDstRows, m_patchLevelOfDetail);
+            }
         }
 
+        applyChannelFlags(channelFlags, onlyOneChannelSelected, selectedChannelIndex);
     }
 
     void convertTo(const KoColorSpace* dstCS,
@@ -242,6 +418,100 @@ public:
         return m_patchColorSpace->createProofingTransform(dstCS, proofingSpace, renderingIntent, proofingIntent, conversionFlags, gamutWarning.data(), adaptationState);
     }
 
+    /**
+     * Compresses the pixels of the patch with \p compression and frees
+     * the uncompressed buffer. A compressed patch cannot be uploaded to
+     * the texture, use decompressedCopy() to get an uploadable one.
+     *
+     * If the compression fails, the patch is left uncompressed.
+     */
+    void compress(KisAbstractCompression *compression)
+    {
+        if (!m_patchRect.isValid() || !m_patchPixels.data()) return;
+
+        const int pixelSize = m_patchColorSpace->pixelSize();
+        const qint32 dataSize = m_patchRect.width() * m_patchRect.height() * pixelSize;
+
+        DataBuffer linearizedPixels(pixelSize, m_pool);
+        KisAbstractCompression::linearizeColors(m_patchPixels.data(), linearizedPixels.data(), dataSize, pixelSize);
+
+        QByteArray buffer(compression->outputBufferSize(dataSize), Qt::Uninitialized);
+        const qint32 compressedSize =
+            compression->compress(linearizedPixels.data(), dataSize,
+                                  reinterpret_cast<quint8*>(buffer.data()), buffer.size());
+
+        if (!compressedSize) return;
+
+        buffer.resize(compressedSize);
+        buffer.squeeze();
+
+        m_compressedPixels = buffer;
+
+        DataBuffer emptyBuffer(m_pool);
+        emptyBuffer.swap(m_patchPixels);
+    }
+
+    /**
+     * \return a new uncompressed tile info with the same pixels as the
+     *         compressed one. The compressed tile info is not changed, so
+     *         it is safe to be called for the same object from
+     *         different threads. \p compression should be the same
+     *         algorithm that was used for compress(). Returns a null
+     *         pointer if the compressed data is corrupted.
+     */
+    KisTextureTileUpdateInfoSP decompressedCopy(KisAbstractCompression *compression) const
+    {
+        KisTextureTileUpdateInfoSP info(new KisTextureTileUpdateInfo(m_pool));
+
+        info->m_tileCol = m_tileCol;
+        info->m_tileRow = m_tileRow;
+        info->m_currentImageRect = m_currentImageRect;
+        info->m_tileRect = m_tileRect;
+        info->m_patchRect = m_patchRect;
+        info->m_patchColorSpace = m_patchColorSpace;
+        info->m_patchLevelOfDetail = m_patchLevelOfDetail;
+        info->m_originalPatchRect = m_originalPatchRect;
+        info->m_originalTileRect = m_originalTileRect;
+
+        if (m_patchRect.isValid()) {
+            const int pixelSize = m_patchColorSpace->pixelSize();
+            info->m_patchPixels.allocate(pixelSize);
+
+            if (isCompressed()) {
+                const qint32 dataSize = m_patchRect.width() * m_patchRect.height() * pixelSize;
+
+                DataBuffer linearizedPixels(pixelSize, m_pool);
+                const qint32 decompressedSize =
+                    compression->decompress(reinterpret_cast<const quint8*>(m_compressedPixels.constData()),
+                                            m_compressedPixels.size(),
+                                            linearizedPixels.data(), dataSize);
+
+                if (decompressedSize != dataSize) {
+                    return KisTextureTileUpdateInfoSP();
+                }
+
+                KisAbstractCompression::delinearizeColors(linearizedPixels.data(), info->m_patchPixels.data(),
+                                                          dataSize, pixelSize);
+            } else {
+                memcpy(info->m_patchPixels.data(), m_patchPixels.data(), m_patchPixels.size());
+            }
+        }
+
+        return info;
+    }
+
+    inline bool isCompressed() const {
+        return !m_compressedPixels.isEmpty();
+    }
+
+    /**
+     * \return the number of bytes occupied by the pixels of the patch,
+     *         either compressed or not
+     */
+    inline int memoryFootprint() const {
+        return m_compressedPixels.size() + m_patchPixels.size();
+    }
+
     inline quint8* data() const {
         return m_patchPixels.data();
     }
@@ -306,6 +576,58 @@ public:
 private:
     Q_DISABLE_COPY(KisTextureTileUpdateInfo)
 
+    void applyChannelFlags(const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex)
+    {
+        // XXX: if the paint colorspace is rgb, we should do the channel swizzling in
+        //      the display shader
+        if (!channelFlags.isEmpty()) {
+            DataBuffer conversionCache(m_patchColorSpace->pixelSize(), m_pool);
+
+            QList<KoChannelInfo*> channelInfo = m_patchColorSpace->channels();
+            int channelSize = channelInfo[selectedChannelIndex]->size();
+            int pixelSize = m_patchColorSpace->pixelSize();
+            quint32 numPixels = m_patchRect.width() * m_patchRect.height();
+
+            KisConfig cfg;
+
+            if (onlyOneChannelSelected && !cfg.showSingleChannelAsColor()) {
+                int selectedChannelPos = channelInfo[selectedChannelIndex]->pos();
+                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
+                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
+
+                        if (channelInfo[channelIndex]->channelType() == KoChannelInfo::COLOR) {
+                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
+                                   m_patchPixels.data() + (pixelIndex * pixelSize) + selectedChannelPos,
+                                   channelSize);
+                        }
+                        else if (channelInfo[channelIndex]->channelType() == KoChannelInfo::ALPHA) {
+                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
+                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
+                                   channelSize);
+                        }
+                    }
+                }
+            }
+            else {
+                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
+                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
+                        if (channelFlags.testBit(channelIndex)) {
+                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
+                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
+                                   channelSize);
+                        }
+                        else {
+                            memset(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize), 0, channelSize);
+                        }
+                    }
+                }
+
+            }
+
+            conversionCache.swap(m_patchPixels);
+        }
+    }
+
 private:
     qint32 m_tileCol;
     qint32 m_tileRow;
@@ -323,6 +645,7 @@ private:
     QRect m_originalTileRect;
 
     DataBuffer m_patchPixels;
+    QByteArray m_compressedPixels;
     KisTextureTileInfoPoolSP m_pool;
 };
 
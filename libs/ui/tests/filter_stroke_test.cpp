@@ -26,6 +26,8 @@
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_registry.h"
 #include "filter/kis_filter_configuration.h"
+#include "krita_utils.h"
+#include "kis_lod_transform.h"
 
 
 class FilterStrokeTester : public utils::StrokeTester
@@ -90,4 +92,76 @@ void FilterStrokeTest::testBlurFilter()
     tester.test();
 }
 
+void FilterStrokeTest::testOptimalPatchSize()
+{
+    const QRect processRect(0, 0, 16000, 16000);
+    const QSize defaultPatchSize = KritaUtils::optimalPatchSize();
+
+    // pin the number of threads to keep the result machine-independent
+    const int numThreads = 4;
+
+    KisFilterSP invertFilter = KisFilterRegistry::instance()->value("invert");
+    QVERIFY(invertFilter);
+    KisFilterConfigurationSP invertConfig = invertFilter->defaultConfiguration();
+
+    // the filter doesn't read anything around the patch
+    QCOMPARE(KisFilterStrokeStrategy::optimalPatchSize(invertFilter, invertConfig, processRect, 0, numThreads),
+             defaultPatchSize);
+
+    KisFilterSP blurFilter = KisFilterRegistry::instance()->value("gaussian blur");
+    QVERIFY(blurFilter);
+    KisFilterConfigurationSP blurConfig = blurFilter->defaultConfiguration();
+    blurConfig->setProperty("horizRadius", 100);
+    blurConfig->setProperty("vertRadius", 100);
+
+    const QSize blurPatchSize =
+        KisFilterStrokeStrategy::optimalPatchSize(blurFilter, blurConfig, processRect, 0, numThreads);
+
+    QVERIFY(blurPatchSize.width() > defaultPatchSize.width());
+    QVERIFY(blurPatchSize.height() > defaultPatchSize.height());
+
+    const QRect patchRect(QPoint(), blurPatchSize);
+    const QRect needRect = blurFilter->neededRect(patchRect, blurConfig, 0);
+    QVERIFY(needRect.width() * needRect.height() <= 1.5 * patchRect.width() * patchRect.height());
+
+    // the margins are checked on the LoD plane as well
+    const int lod = 2;
+    const QSize lodPatchSize =
+        KisFilterStrokeStrategy::optimalPatchSize(blurFilter, blurConfig, processRect, lod, numThreads);
+
+    const QRect lodPatchRect = KisLodTransform(lod).map(QRect(QPoint(), lodPatchSize));
+    const QRect lodNeedRect = blurFilter->neededRect(lodPatchRect, blurConfig, lod);
+    QVERIFY(lodNeedRect.width() * lodNeedRect.height() <= 1.5 * lodPatchRect.width() * lodPatchRect.height());
+    QVERIFY(lodPatchSize.width() >= blurPatchSize.width());
+
+    // a small rect is split into enough patches to load all the threads
+    const QRect mediumRect(0, 0, 1024, 1024);
+    const QSize mediumPatchSize =
+        KisFilterStrokeStrategy::optimalPatchSize(invertFilter, invertConfig, mediumRect, 0, numThreads);
+    QVERIFY(KritaUtils::splitRectIntoPatches(mediumRect, mediumPatchSize).size() >= 2 * numThreads);
+    QVERIFY(KritaUtils::splitRectIntoPatches(mediumRect, mediumPatchSize * 2).size() < 2 * numThreads);
+
+    // the jobs should cover the process rect exactly once
+    const QRect smallRect(10, 20, 1000, 700);
+    QVector<KisStrokeJobData*> jobsData =
+        KisFilterStrokeStrategy::createJobsData(blurFilter, blurConfig, smallRect, 0, numThreads);
+
+    QRect jobsBounds;
+    qint64 jobsArea = 0;
+
+    Q_FOREACH (KisStrokeJobData *jobData, jobsData) {
+        KisFilterStrokeStrategy::Data *data =
+            dynamic_cast<KisFilterStrokeStrategy::Data*>(jobData);
+        QVERIFY(data);
+
+        jobsBounds |= data->processRect;
+        jobsArea += data->processRect.width() * data->processRect.height();
+    }
+
+    qDeleteAll(jobsData);
+
+    QCOMPARE(jobsBounds, smallRect);
+    QCOMPARE(jobsArea, qint64(smallRect.width()) * smallRect.height());
+}
+
 QTEST_MAIN(FilterStrokeTest)
@@ -28,6 +28,7 @@ class FilterStrokeTest : public QObject
 
 private Q_SLOTS:
     void testBlurFilter();
+    void testOptimalPatchSize();
 };
 
 #endif /* __FILTER_STROKE_TEST_H */
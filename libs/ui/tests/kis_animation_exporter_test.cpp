@@ -30,6 +30,7 @@
 #include <KoUpdater.h>
 #include "kis_time_range.h"
 #include "kis_keyframe_channel.h"
+#include "kis_image_config.h"
 
 
 void KisAnimationExporterTest::testAnimationExport()
@@ -86,4 +87,85 @@ void KisAnimationExporterTest::testAnimationExport()
     QCOMPARE(exported, frame2);
 }
 
+void KisAnimationExporterTest::testOrderedFramesExport()
+{
+    KisDocument *document = KisPart::instance()->createDocument();
+    QRect rect(0,0,512,512);
+    TestUtil::MaskParent p(rect);
+    document->setCurrentImage(p.image);
+    const KoColorSpace *cs = p.image->colorSpace();
+
+    KUndo2Command parentCommand;
+
+    p.layer->enableAnimation();
+    KisKeyframeChannel *rasterChannel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+
+    const int numFrames = 12;
+    QVector<KoColor> frameColors;
+
+    KisPaintDeviceSP dev = p.layer->paintDevice();
+
+    for (int i = 0; i < numFrames; i++) {
+        if (i > 0) {
+            rasterChannel->addKeyframe(i, &parentCommand);
+            p.image->animationInterface()->switchCurrentTimeAsync(i);
+            p.image->waitForDone();
+        }
+
+        KoColor color(QColor(10 * i, 255 - 10 * i, 0), cs);
+        dev->fill(rect, color);
+        frameColors.append(color);
+    }
+
+    p.image->animationInterface()->setFullClipRange(KisTimeRange::fromTime(0, numFrames - 1));
+
+    KisImageConfig cfg;
+    const int oldNumClones = cfg.frameRenderingClones();
+    cfg.setFrameRenderingClones(4);
+
+    QMutex mutex;
+    QVector<int> consumedFrames;
+    bool isConsuming = false;
+    bool hadConcurrentCalls = false;
+    bool hadWrongContent = false;
+
+    KisAsyncAnimationFramesSaveDialog exporter(document->image(),
+                                               KisTimeRange::fromTime(0, numFrames - 1),
+                                               "export-ordered-test.png",
+                                               0, 0);
+    exporter.setBatchMode(true);
+    exporter.setFrameConsumer(
+        [&] (int frame, KisPaintDeviceSP device) {
+            {
+                QMutexLocker l(&mutex);
+                hadConcurrentCalls |= isConsuming;
+                isConsuming = true;
+            }
+
+            KoColor color(cs);
+            device->pixel(QPoint(100, 100), &color);
+            const bool contentMatches = color == frameColors[frame];
+
+            QMutexLocker l(&mutex);
+            hadWrongContent |= !contentMatches;
+            consumedFrames.append(frame);
+            isConsuming = false;
+
+            return true;
+        });
+
+    KisAsyncAnimationFramesSaveDialog::Result result = exporter.regenerateRange(0);
+
+    cfg.setFrameRenderingClones(oldNumClones);
+
+    QCOMPARE(result, KisAsyncAnimationFramesSaveDialog::RenderComplete);
+    QVERIFY(!hadConcurrentCalls);
+    QVERIFY(!hadWrongContent);
+
+    QCOMPARE(consumedFrames.size(), numFrames);
+    for (int i = 0; i < numFrames; i++) {
+        QCOMPARE(consumedFrames[i], i);
+    }
+}
+
 QTEST_MAIN(KisAnimationExporterTest)
@@ -29,6 +29,11 @@
 
 #include "kundo2command.h"
 
+#include <KoColorSpaceRegistry.h>
+#include "opengl/kis_texture_tile_update_info.h"
+#include "canvas/kis_update_info.h"
+#include "tiles3/swap/kis_abstract_compression.h"
+
 void verifyRangeIsCachedStatus(KisAnimationFrameCacheSP cache, int start, int end, KisAnimationFrameCache::CacheStatus status)
 {
     for (int t = start; t <= end; t++) {
@@ -100,4 +105,209 @@ void KisAnimationFrameCacheTest::testCache()
 
 }
 
+/**
+ * Compresses with \p compression, but fails to decompress, like
+ * it happens with corrupted data
+ */
+struct FailingDecompression : public KisAbstractCompression
+{
+    FailingDecompression(KisAbstractCompression *compression)
+        : m_compression(compression)
+    {
+    }
+
+    qint32 compress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength) override {
+        return m_compression->compress(input, inputLength, output, outputLength);
+    }
+
+    qint32 decompress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength) override {
+        Q_UNUSED(input);
+        Q_UNUSED(inputLength);
+        Q_UNUSED(output);
+        Q_UNUSED(outputLength);
+        return 0;
+    }
+
+    qint32 outputBufferSize(qint32 dataSize) override {
+        return m_compression->outputBufferSize(dataSize);
+    }
+
+    QString name() const override {
+        return m_compression->name();
+    }
+
+private:
+    KisAbstractCompression *m_compression;
+};
+
+void KisAnimationFrameCacheTest::testTileCompression()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect imageRect(0, 0, 300, 300);
+    const QRect tileRect(0, 0, 256, 256);
+
+    dev->fill(imageRect, KoColor(Qt::red, cs));
+    dev->fill(QRect(30, 40, 50, 60), KoColor(Qt::blue, cs));
+
+    KisTextureTileInfoPoolSP pool = toQShared(new KisTextureTileInfoPool(256, 256));
+
+    KisTextureTileUpdateInfo info(0, 0, tileRect, imageRect, imageRect, 0, pool);
+    info.retrieveData(dev, QBitArray(), false, 0);
+
+    QVector<quint8> originalPixels(tileRect.width() * tileRect.height() * cs->pixelSize());
+    memcpy(originalPixels.data(), info.data(), originalPixels.size());
+
+    const int originalFootprint = info.memoryFootprint();
+
+    QScopedPointer<KisAbstractCompression> compression(
+        KisAbstractCompression::create(KisAbstractCompression::fastestCompression()));
+
+    info.compress(compression.data());
+
+    QVERIFY(info.isCompressed());
+    QVERIFY(!info.data());
+    QVERIFY(info.memoryFootprint() < originalFootprint / 10);
+
+    KisTextureTileUpdateInfoSP copy = info.decompressedCopy(compression.data());
+
+    QVERIFY(!copy->isCompressed());
+    QCOMPARE(copy->realPatchSize(), info.realPatchSize());
+    QCOMPARE(copy->realPatchOffset(), info.realPatchOffset());
+    QCOMPARE(copy->pixelSize(), cs->pixelSize());
+    QVERIFY(!memcmp(copy->data(), originalPixels.constData(), originalPixels.size()));
+
+    // the compressed info stays intact
+    QVERIFY(info.isCompressed());
+
+    FailingDecompression failingCompression(compression.data());
+    QVERIFY(!info.decompressedCopy(&failingCompression));
+}
+
+/**
+ * The textures are not initialized without an OpenGL context, so
+ * the frames are built manually. Every frame takes one full tile.
+ */
+KisOpenGLUpdateInfoSP createFrameData(const KoColor &color)
+{
+    const QRect imageRect(0, 0, 256, 256);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(color.colorSpace());
+    dev->fill(imageRect, color);
+
+    KisTextureTileInfoPoolSP pool = toQShared(new KisTextureTileInfoPool(256, 256));
+
+    KisTextureTileUpdateInfoSP tileInfo(
+        new KisTextureTileUpdateInfo(0, 0, imageRect, imageRect, imageRect, 0, pool));
+    tileInfo->retrieveData(dev, QBitArray(), false, 0);
+
+    KisOpenGLUpdateInfoSP info = new KisOpenGLUpdateInfo(ConversionOptions());
+    info->assignDirtyImageRect(imageRect);
+    info->tileList.append(tileInfo);
+
+    return info;
+}
+
+struct FrameCacheTester
+{
+    FrameCacheTester()
+    {
+        image = p.image;
+
+        KisKeyframeChannel *channel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id());
+        for (int time = 10; time <= 50; time += 10) {
+            channel->addKeyframe(time, &parentCommand);
+        }
+
+        KisOpenGLImageTexturesSP glTex = KisOpenGLImageTextures::getImageTextures(image, 0, KoColorConversionTransformation::IntentPerceptual, KoColorConversionTransformation::Empty);
+        cache = new KisAnimationFrameCache(glTex);
+
+        frameFootprint = createFrameData(KoColor(Qt::red, image->colorSpace()))->tileList.first()->memoryFootprint();
+    }
+
+    void cacheFrame(int time)
+    {
+        int savedTime;
+        image->animationInterface()->saveAndResetCurrentTime(time, &savedTime);
+
+        KoColor color(QColor(time, 255 - time, 0), image->colorSpace());
+        cache->addConvertedFrameData(createFrameData(color), time);
+    }
+
+    TestUtil::MaskParent p;
+    KisImageSP image;
+    KUndo2Command parentCommand;
+    KisAnimationFrameCacheSP cache;
+    qint64 frameFootprint;
+};
+
+void KisAnimationFrameCacheTest::testMemoryLimit()
+{
+    FrameCacheTester t;
+    QVERIFY(t.frameFootprint > 0);
+
+    t.cache->testingSetMemoryLimit(3 * t.frameFootprint);
+
+    t.cacheFrame(10);
+    t.cacheFrame(20);
+    QCOMPARE(t.cache->testingMemoryUsage(), 2 * t.frameFootprint);
+    QVERIFY(!t.cache->isMemoryLimitReached());
+
+    // a split range shares the frame data, it is counted only once
+    t.image->invalidateFrames(KisTimeRange::fromTime(13, 14), QRect());
+    verifyRangeIsCachedStatus(t.cache, 10, 12, KisAnimationFrameCache::Cached);
+    verifyRangeIsCachedStatus(t.cache, 13, 14, KisAnimationFrameCache::Uncached);
+    verifyRangeIsCachedStatus(t.cache, 15, 19, KisAnimationFrameCache::Cached);
+    QCOMPARE(t.cache->testingMemoryUsage(), 2 * t.frameFootprint);
+
+    t.cacheFrame(30);
+    QCOMPARE(t.cache->testingMemoryUsage(), 3 * t.frameFootprint);
+    QVERIFY(t.cache->isMemoryLimitReached());
+
+    // the budget is never exceeded
+    t.cacheFrame(40);
+    QCOMPARE(t.cache->testingMemoryUsage(), 3 * t.frameFootprint);
+    verifyRangeIsCachedStatus(t.cache, 40, 49, KisAnimationFrameCache::Cached);
+
+    // shrinking the budget evicts the frames immediately
+    t.cache->testingSetMemoryLimit(t.frameFootprint);
+    QCOMPARE(t.cache->testingMemoryUsage(), t.frameFootprint);
+
+    // invalidated frames release their memory
+    t.image->invalidateFrames(KisTimeRange::infinite(0), QRect());
+    QCOMPARE(t.cache->testingMemoryUsage(), qint64(0));
+    verifyRangeIsCachedStatus(t.cache, 0, 60, KisAnimationFrameCache::Uncached);
+}
+
+void KisAnimationFrameCacheTest::testLeastRecentlyUsedEviction()
+{
+    FrameCacheTester t;
+
+    t.cache->testingSetMemoryLimit(3 * t.frameFootprint);
+
+    t.cacheFrame(10);
+    t.cacheFrame(20);
+    t.cacheFrame(30);
+
+    // the oldest frame is shown again, so it becomes the most recent one
+    t.cache->testingTouchFrame(10);
+
+    t.cacheFrame(40);
+    verifyRangeIsCachedStatus(t.cache, 10, 19, KisAnimationFrameCache::Cached);
+    verifyRangeIsCachedStatus(t.cache, 20, 29, KisAnimationFrameCache::Uncached);
+    verifyRangeIsCachedStatus(t.cache, 30, 49, KisAnimationFrameCache::Cached);
+
+    t.cacheFrame(50);
+    verifyRangeIsCachedStatus(t.cache, 10, 19, KisAnimationFrameCache::Cached);
+    verifyRangeIsCachedStatus(t.cache, 30, 39, KisAnimationFrameCache::Uncached);
+    verifyRangeIsCachedStatus(t.cache, 40, 59, KisAnimationFrameCache::Cached);
+
+    // a frame that doesn't fit into the budget alone is still kept
+    t.cache->testingSetMemoryLimit(t.frameFootprint / 2);
+    t.cacheFrame(20);
+    verifyRangeIsCachedStatus(t.cache, 20, 29, KisAnimationFrameCache::Cached);
+    QCOMPARE(t.cache->testingMemoryUsage(), t.frameFootprint);
+}
+
 QTEST_MAIN(KisAnimationFrameCacheTest)
@@ -27,6 +27,9 @@ class KisAnimationFrameCacheTest : public QObject
 
 private Q_SLOTS:
     void testCache();
+    void testTileCompression();
+    void testMemoryLimit();
+    void testLeastRecentlyUsedEviction();
 
 };
 #endif
@@ -0,0 +1,338 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_opengl_update_info_builder_test.h"
+
+#include <QTest>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include <KoChannelInfo.h>
+#include <KoMixColorsOp.h>
+
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_lod_transform.h"
+#include "opengl/kis_texture_tile.h"
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
+
+namespace {
+
+const int textureSize = 128;
+const int textureBorder = 4;
+
+/**
+ * Fills \p dev with semi-transparent noise. The values are written in
+ * normalized form, so every channel type gets valid values.
+ */
+void fillWithNoise(KisPaintDeviceSP dev, const QRect &rc)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    QVector<quint8> pixels(rc.width() * rc.height() * pixelSize);
+    QVector<float> values(cs->channelCount());
+
+    quint32 seed = 1;
+    for (int i = 0; i < rc.width() * rc.height(); i++) {
+        for (int c = 0; c < values.size(); c++) {
+            seed = seed * 1664525 + 1013904223;
+            values[c] = float(seed >> 24) / 255.0f;
+        }
+        cs->fromNormalisedChannelsValue(pixels.data() + i * pixelSize, values);
+    }
+
+    dev->writeBytes(pixels.constData(), rc);
+}
+
+KisImageSP createNoiseImage(const QRect &imageRect, const KoColorSpace *cs)
+{
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "downsampling test");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+    image->addNode(layer, image->root());
+
+    fillWithNoise(layer->paintDevice(), imageRect);
+    image->refreshGraph();
+    image->waitForDone();
+
+    return image;
+}
+
+void setupBuilder(KisOpenGLUpdateInfoBuilder *builder, int levelOfDetail)
+{
+    builder->setTextureBorder(textureBorder);
+    builder->setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder, textureSize - 2 * textureBorder));
+    builder->setTextureInfoPool(toQShared(new KisTextureTileInfoPool(textureSize, textureSize)));
+    builder->setDownsamplingLevelOfDetail(levelOfDetail);
+}
+
+/**
+ * \return the image rect, the patch of \p tileInfo is fetched from
+ */
+QRect sourcePatchRect(const KisOpenGLUpdateInfoBuilder &builder,
+                      KisTextureTileUpdateInfoSP tileInfo,
+                      const QRect &imageRect)
+{
+    const int levelOfDetail = tileInfo->patchLevelOfDetail();
+
+    const QRect tileTextureRect =
+        stretchRect(builder.calculateEffectiveTileRect(tileInfo->tileCol(), tileInfo->tileRow(), imageRect),
+                    textureBorder);
+    const QRect tileRect =
+        KisLodTransform::scaledRect(KisLodTransform::alignedRect(tileTextureRect, levelOfDetail), levelOfDetail);
+    const QRect patchRect(tileRect.topLeft() + tileInfo->realPatchOffset(), tileInfo->realPatchSize());
+
+    const int factor = 1 << levelOfDetail;
+    return QRect(patchRect.topLeft() * factor, patchRect.size() * factor);
+}
+
+/**
+ * Compares the downsampled \p tileInfo with the blocks of the projection
+ * mixed by KoMixColorsOp of the color space
+ */
+bool compareWithMixedColors(KisPaintDeviceSP projection, const QRect &sourceRect,
+                            KisTextureTileUpdateInfoSP tileInfo, double tolerance)
+{
+    const KoColorSpace *cs = projection->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    const int factor = 1 << tileInfo->patchLevelOfDetail();
+    const QSize patchSize = tileInfo->realPatchSize();
+
+    QVector<quint8> source(sourceRect.width() * sourceRect.height() * pixelSize);
+    projection->readBytes(source.data(), sourceRect);
+
+    QVector<const quint8*> block(factor * factor);
+    QVector<quint8> expectedPixel(pixelSize);
+    QVector<float> expected(cs->channelCount());
+    QVector<float> value(cs->channelCount());
+
+    for (int y = 0; y < patchSize.height(); y++) {
+        for (int x = 0; x < patchSize.width(); x++) {
+            for (int r = 0; r < factor; r++) {
+                for (int k = 0; k < factor; k++) {
+                    block[r * factor + k] =
+                        source.constData() + ((y * factor + r) * sourceRect.width() + x * factor + k) * pixelSize;
+                }
+            }
+
+            cs->mixColorsOp()->mixColors(block.constData(), block.size(), expectedPixel.data());
+
+            cs->normalisedChannelsValue(expectedPixel.constData(), expected);
+            cs->normalisedChannelsValue(tileInfo->data() + (y * patchSize.width() + x) * pixelSize, value);
+
+            for (int c = 0; c < expected.size(); c++) {
+                if (qAbs(value[c] - expected[c]) > tolerance) {
+                    qWarning() << "Failed to compare pixel" << x << y << c << value[c] << expected[c];
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+void KisOpenGLUpdateInfoBuilderTest::testDownsampledTiles_data()
+{
+    QTest::addColumn<QString>("colorDepthId");
+    QTest::addColumn<int>("levelOfDetail");
+    QTest::addColumn<double>("tolerance");
+
+    /**
+     * KoMixColorsOp truncates the integer averages, the fast paths round
+     * them, so the integer results may differ in the last bit
+     */
+    QTest::newRow("8-bit, lod 1") << Integer8BitsColorDepthID.id() << 1 << 1.01 / 255;
+    QTest::newRow("8-bit, lod 3") << Integer8BitsColorDepthID.id() << 3 << 1.01 / 255;
+    QTest::newRow("16-bit, lod 1") << Integer16BitsColorDepthID.id() << 1 << 1.01 / 65535;
+    QTest::newRow("16-bit, lod 3") << Integer16BitsColorDepthID.id() << 3 << 1.01 / 65535;
+    QTest::newRow("float, lod 2") << Float32BitsColorDepthID.id() << 2 << 1e-5;
+
+    // half-float channels have no fast path and are mixed by KoMixColorsOp itself
+    if (KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), Float16BitsColorDepthID.id(), 0)) {
+        QTest::newRow("half, lod 2") << Float16BitsColorDepthID.id() << 2 << 0.0;
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderTest::testDownsampledTiles()
+{
+    QFETCH(QString, colorDepthId);
+    QFETCH(int, levelOfDetail);
+    QFETCH(double, tolerance);
+
+    // the size is intentionally not aligned to the LoD
+    const QRect imageRect(0, 0, 601, 403);
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), colorDepthId, 0);
+    QVERIFY(cs);
+
+    KisImageSP image = createNoiseImage(imageRect, cs);
+
+    KisOpenGLUpdateInfoBuilder builder;
+    setupBuilder(&builder, levelOfDetail);
+
+    KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(imageRect, image);
+
+    QVERIFY(!info->tileList.isEmpty());
+    QCOMPARE(info->levelOfDetail(), levelOfDetail);
+
+    Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, info->tileList) {
+        QCOMPARE(tileInfo->patchLevelOfDetail(), levelOfDetail);
+
+        const QRect sourceRect = sourcePatchRect(builder, tileInfo, imageRect);
+        QVERIFY(compareWithMixedColors(image->projection(), sourceRect, tileInfo, tolerance));
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderTest::testAlphaWeightedAverage()
+{
+    // BGRA: a red opaque pixel among transparent green ones
+    const quint8 src[] = {
+        0,   0, 255, 255,    0, 255,   0,   0,      0, 255,   0,   0,    0, 255,   0,   0,
+        0, 255,   0,   0,    0, 255,   0,   0,      0, 255,   0,   0,    0, 255,   0,   0
+    };
+    quint8 dst[8];
+
+    KisTextureTileDownsampling::downsampleBox<quint8>(src, dst, 2, 1, 4, 3, 1);
+
+    // the transparent pixels don't change the color, only the opacity
+    QCOMPARE(dst[0], quint8(0));
+    QCOMPARE(dst[1], quint8(0));
+    QCOMPARE(dst[2], quint8(255));
+    QCOMPARE(dst[3], quint8(64));
+
+    // a fully transparent block becomes transparent black
+    QCOMPARE(dst[4], quint8(0));
+    QCOMPARE(dst[5], quint8(0));
+    QCOMPARE(dst[6], quint8(0));
+    QCOMPARE(dst[7], quint8(0));
+}
+
+void KisOpenGLUpdateInfoBuilderTest::testDownsampledChannelFlags()
+{
+    const QRect imageRect(0, 0, 300, 200);
+    const int levelOfDetail = 2;
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = createNoiseImage(imageRect, cs);
+
+    QBitArray channelFlags(cs->channelCount(), true);
+    channelFlags.clearBit(0);
+
+    KisOpenGLUpdateInfoBuilder builder;
+    setupBuilder(&builder, levelOfDetail);
+    KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(imageRect, image);
+
+    KisOpenGLUpdateInfoBuilder flagsBuilder;
+    setupBuilder(&flagsBuilder, levelOfDetail);
+    flagsBuilder.setChannelFlags(channelFlags, false, -1);
+    KisOpenGLUpdateInfoSP flagsInfo = flagsBuilder.buildUpdateInfo(imageRect, image);
+
+    QCOMPARE(flagsInfo->tileList.size(), info->tileList.size());
+
+    const int pixelSize = cs->pixelSize();
+
+    for (int i = 0; i < info->tileList.size(); i++) {
+        KisTextureTileUpdateInfoSP tileInfo = info->tileList[i];
+        KisTextureTileUpdateInfoSP flagsTileInfo = flagsInfo->tileList[i];
+
+        QCOMPARE(flagsTileInfo->realPatchSize(), tileInfo->realPatchSize());
+
+        const int numPixels = tileInfo->realPatchSize().width() * tileInfo->realPatchSize().height();
+
+        // the disabled channel is zeroed after downsampling, the rest are kept
+        for (int p = 0; p < numPixels; p++) {
+            const quint8 *pixel = tileInfo->data() + p * pixelSize;
+            const quint8 *flagsPixel = flagsTileInfo->data() + p * pixelSize;
+
+            QCOMPARE(flagsPixel[0], quint8(0));
+            QCOMPARE(flagsPixel[1], pixel[1]);
+            QCOMPARE(flagsPixel[2], pixel[2]);
+            QCOMPARE(flagsPixel[3], pixel[3]);
+        }
+    }
+}
+
+void KisOpenGLUpdateInfoBuilderTest::testEntireTileUpdateAfterZoomOut()
+{
+    const QRect imageRect(0, 0, 601, 403);
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = createNoiseImage(imageRect, cs);
+
+    // the tiles show LoD 1, then the canvas is zoomed out to LoD 3
+    const int oldLevelOfDetail = 1;
+    const int newLevelOfDetail = 3;
+
+    KisOpenGLUpdateInfoBuilder builder;
+    setupBuilder(&builder, newLevelOfDetail);
+
+    // a small update in the middle of a tile
+    const QRect dirtyRect(150, 150, 10, 10);
+    KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(dirtyRect, image);
+
+    QCOMPARE(info->tileList.size(), 1);
+    KisTextureTileUpdateInfoSP tileInfo = info->tileList.first();
+
+    QVERIFY(!tileInfo->isEntireTileUpdated());
+    QCOMPARE(tileInfo->patchLevelOfDetail(), newLevelOfDetail);
+
+    // the plane of LoD 3 was never uploaded, so the patch cannot be used
+    QVERIFY(KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*tileInfo, oldLevelOfDetail));
+
+    // the same plane and the planes regenerated from level 0 are valid
+    QVERIFY(!KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*tileInfo, newLevelOfDetail));
+    QVERIFY(!KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*tileInfo, 0));
+
+    KisTextureTileUpdateInfoSP entireTileInfo =
+        builder.buildEntireTileUpdateInfo(tileInfo->tileCol(), tileInfo->tileRow(), newLevelOfDetail, image);
+
+    QVERIFY(entireTileInfo);
+    QVERIFY(entireTileInfo->isEntireTileUpdated());
+    QCOMPARE(entireTileInfo->patchLevelOfDetail(), newLevelOfDetail);
+    QVERIFY(!KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*entireTileInfo, oldLevelOfDetail));
+
+    // the entire tile should be the same as the one of the full update
+    KisOpenGLUpdateInfoSP fullInfo = builder.buildUpdateInfo(imageRect, image);
+    KisTextureTileUpdateInfoSP fullTileInfo;
+
+    Q_FOREACH (KisTextureTileUpdateInfoSP info, fullInfo->tileList) {
+        if (info->tileCol() == tileInfo->tileCol() && info->tileRow() == tileInfo->tileRow()) {
+            fullTileInfo = info;
+        }
+    }
+
+    QVERIFY(fullTileInfo);
+    QCOMPARE(entireTileInfo->realPatchSize(), fullTileInfo->realPatchSize());
+
+    const int numBytes =
+        fullTileInfo->realPatchSize().width() * fullTileInfo->realPatchSize().height() * cs->pixelSize();
+    QVERIFY(!memcmp(entireTileInfo->data(), fullTileInfo->data(), numBytes));
+
+    // a full-resolution patch cannot be uploaded into a downsampled tile either
+    builder.setDownsamplingLevelOfDetail(0);
+    KisOpenGLUpdateInfoSP fullResolutionInfo = builder.buildUpdateInfo(dirtyRect, image);
+
+    QCOMPARE(fullResolutionInfo->tileList.size(), 1);
+    QVERIFY(KisOpenGLUpdateInfoBuilder::needsEntireTileUpdate(*fullResolutionInfo->tileList.first(), newLevelOfDetail));
+}
+
+QTEST_MAIN(KisOpenGLUpdateInfoBuilderTest)
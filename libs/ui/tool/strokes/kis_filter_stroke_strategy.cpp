@@ -18,10 +18,17 @@
 
 #include "kis_filter_stroke_strategy.h"
 
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QThread>
+
 #include <filter/kis_filter.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_transaction.h>
 #include <KoCompositeOpRegistry.h>
+#include <krita_utils.h>
+#include <kis_debug.h>
+#include <kis_lod_transform.h>
 
 
 struct KisFilterStrokeStrategy::Private {
@@ -29,7 +36,10 @@ struct KisFilterStrokeStrategy::Private {
         : updatesFacade(0),
           cancelSilently(false),
           secondaryTransaction(0),
-          levelOfDetail(0)
+          levelOfDetail(0),
+          numProcessedPatches(0),
+          totalPatchTime(0),
+          maxPatchTime(0)
     {
     }
 
@@ -43,7 +53,10 @@ struct KisFilterStrokeStrategy::Private {
           filterDeviceBounds(),
           secondaryTransaction(0),
           progressHelper(),
-          levelOfDetail(0)
+          levelOfDetail(0),
+          numProcessedPatches(0),
+          totalPatchTime(0),
+          maxPatchTime(0)
     {
         KIS_ASSERT_RECOVER_RETURN(!rhs.filterDevice);
         KIS_ASSERT_RECOVER_RETURN(rhs.filterDeviceBounds.isEmpty());
@@ -64,6 +77,24 @@ struct KisFilterStrokeStrategy::Private {
     QScopedPointer<KisProcessingVisitor::ProgressHelper> progressHelper;
 
     int levelOfDetail;
+
+    /**
+     * Timing statistics of the processed patches in microseconds,
+     * reported when the stroke is finished
+     */
+    QAtomicInt numProcessedPatches;
+    QAtomicInteger<qint64> totalPatchTime;
+    QAtomicInteger<qint64> maxPatchTime;
+
+    void registerPatchTime(qint64 time) {
+        numProcessedPatches.ref();
+        totalPatchTime.fetchAndAddOrdered(time);
+
+        qint64 oldMax = maxPatchTime.load();
+        while (time > oldMax && !maxPatchTime.testAndSetOrdered(oldMax, time)) {
+            oldMax = maxPatchTime.load();
+        }
+    }
 };
 
 
@@ -142,6 +173,9 @@ void KisFilterStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
             return;
         }
 
+        QElapsedTimer patchTimer;
+        patchTimer.start();
+
         m_d->filter->processImpl(m_d->filterDevice, rc,
                                  m_d->filterConfig.data(),
                                  m_d->progressHelper->updater());
@@ -153,6 +187,8 @@ void KisFilterStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
             m_d->filterDevice->clear(rc);
         }
 
+        m_d->registerPatchTime(patchTimer.nsecsElapsed() / 1000);
+
         m_d->node->setDirty(rc);
     } else if (cancelJob) {
         m_d->cancelSilently = true;
@@ -196,6 +232,15 @@ void KisFilterStrokeStrategy::finishStrokeCallback()
     delete m_d->secondaryTransaction;
     m_d->filterDevice = 0;
 
+    const int numPatches = m_d->numProcessedPatches.load();
+    if (numPatches > 0) {
+        dbgFilters << "Filter" << m_d->filter->id()
+                   << "lod" << m_d->levelOfDetail
+                   << "patches:" << numPatches
+                   << "avg time (ms):" << 0.001 * m_d->totalPatchTime.load() / numPatches
+                   << "max time (ms):" << 0.001 * m_d->maxPatchTime.load();
+    }
+
     KisPainterBasedStrokeStrategy::finishStrokeCallback();
 }
 
@@ -206,3 +251,109 @@ KisStrokeStrategy* KisFilterStrokeStrategy::createLodClone(int levelOfDetail)
     KisFilterStrokeStrategy *clone = new KisFilterStrokeStrategy(*this, levelOfDetail);
     return clone;
 }
+
+namespace {
+
+qreal patchOverheadAtLod(KisFilterSP filter,
+                         const KisFilterConfigurationSP filterConfig,
+                         const QSize &patchSize,
+                         int levelOfDetail)
+{
+    const QRect patchRect = KisLodTransform(levelOfDetail).map(QRect(QPoint(), patchSize));
+    if (patchRect.isEmpty()) return 1.0;
+
+    const QRect needRect = filter->neededRect(patchRect, filterConfig, levelOfDetail);
+
+    return qreal(needRect.width()) * needRect.height() /
+        (qreal(patchRect.width()) * patchRect.height());
+}
+
+/**
+ * The jobs are processed on the LoD plane first, where the patches
+ * are smaller, but the margins of some filters are not, so the worst
+ * of both levels is taken
+ */
+qreal patchOverhead(KisFilterSP filter,
+                    const KisFilterConfigurationSP filterConfig,
+                    const QSize &patchSize,
+                    int levelOfDetail)
+{
+    qreal overhead = patchOverheadAtLod(filter, filterConfig, patchSize, 0);
+
+    if (levelOfDetail > 0) {
+        overhead = qMax(overhead, patchOverheadAtLod(filter, filterConfig, patchSize, levelOfDetail));
+    }
+
+    return overhead;
+}
+
+}
+
+QSize KisFilterStrokeStrategy::optimalPatchSize(KisFilterSP filter,
+                                                const KisFilterConfigurationSP filterConfig,
+                                                const QRect &processRect,
+                                                int levelOfDetail,
+                                                int numThreads)
+{
+    /**
+     * A patch may read at most 50% more pixels than it writes. The
+     * minimal size is the size of a tile, the patches smaller than that
+     * would share tiles with each other.
+     */
+    const qreal maxOverhead = 1.5;
+    const int minPatchSize = 64;
+
+    if (numThreads <= 0) {
+        numThreads = QThread::idealThreadCount();
+    }
+    const int minNumPatches = 2 * numThreads;
+
+    QSize patchSize = KritaUtils::optimalPatchSize();
+
+    while (KritaUtils::splitRectIntoPatches(processRect, patchSize).size() < minNumPatches) {
+        const QSize smallerSize = patchSize / 2;
+
+        if (smallerSize.width() < minPatchSize ||
+            smallerSize.height() < minPatchSize ||
+            patchOverhead(filter, filterConfig, smallerSize, levelOfDetail) > maxOverhead) {
+
+            break;
+        }
+
+        patchSize = smallerSize;
+    }
+
+    while (patchOverhead(filter, filterConfig, patchSize, levelOfDetail) > maxOverhead) {
+        const QSize largerSize = patchSize * 2;
+
+        if (KritaUtils::splitRectIntoPatches(processRect, largerSize).size() < minNumPatches) {
+            break;
+        }
+
+        patchSize = largerSize;
+    }
+
+    return patchSize;
+}
+
+QVector<KisStrokeJobData*> KisFilterStrokeStrategy::createJobsData(KisFilterSP filter,
+                                                                   const KisFilterConfigurationSP filterConfig,
+                                                                   const QRect &processRect,
+                                                                   int levelOfDetail,
+                                                                   int numThreads)
+{
+    QVector<KisStrokeJobData*> jobsData;
+
+    if (filter->supportsThreading()) {
+        const QSize size = optimalPatchSize(filter, filterConfig, processRect, levelOfDetail, numThreads);
+        QVector<QRect> rects = KritaUtils::splitRectIntoPatches(processRect, size);
+
+        Q_FOREACH (const QRect &rc, rects) {
+            jobsData << new Data(rc, true);
+        }
+    } else {
+        jobsData << new Data(processRect, false);
+    }
+
+    return jobsData;
+}
@@ -19,6 +19,8 @@
 #ifndef __KIS_FILTER_STROKE_STRATEGY_H
 #define __KIS_FILTER_STROKE_STRATEGY_H
 
+#include <QVector>
+
 #include "kis_types.h"
 #include "kis_painter_based_stroke_strategy.h"
 #include "kis_lod_transform.h"
@@ -76,6 +78,36 @@ public:
 
     KisStrokeStrategy* createLodClone(int levelOfDetail) override;
 
+    /**
+     * Picks the size of the patches the filter stroke is split into.
+     * Every patch reads a margin of neededRect() around itself, so for
+     * the filters with large margins the patches are grown until the
+     * margin becomes a small portion of the work. The patches are
+     * shrunk or kept from growing when there would be too few of them
+     * to load all the threads.
+     *
+     * \p levelOfDetail is the level the stroke is previewed at, the
+     *    margins are checked at that level as well.
+     * \p numThreads is the number of threads to load, the ideal
+     *    thread count is used if it is not positive.
+     */
+    static QSize optimalPatchSize(KisFilterSP filter,
+                                  const KisFilterConfigurationSP filterConfig,
+                                  const QRect &processRect,
+                                  int levelOfDetail = 0,
+                                  int numThreads = -1);
+
+    /**
+     * Creates the jobs for applying \p filter to \p processRect. The
+     * patches are aligned to the grid of optimalPatchSize(), so they
+     * never share a tile with each other.
+     */
+    static QVector<KisStrokeJobData*> createJobsData(KisFilterSP filter,
+                                                     const KisFilterConfigurationSP filterConfig,
+                                                     const QRect &processRect,
+                                                     int levelOfDetail = 0,
+                                                     int numThreads = -1);
+
 private:
     struct Private;
     Private* const m_d;
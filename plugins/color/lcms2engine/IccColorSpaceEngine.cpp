@@ -24,6 +24,9 @@
 
 #include <klocalizedstring.h>
 
+#include <KoBgrColorSpaceTraits.h>
+#include <KoMatrixShaperColorConversionTransformation.h>
+
 #include "LcmsColorSpace.h"
 
 // -- KoLcmsColorConversionTransformation --
@@ -173,6 +176,231 @@ private:
     mutable cmsHTRANSFORM m_transform;
 };
 
+// -- KoMatrixShaperColorConversionTransformation --
+
+namespace {
+
+bool isRgbMatrixShaper(cmsHPROFILE profile, KoColorConversionTransformation::Intent renderingIntent, int direction)
+{
+    // lcms prefers the LUT-based tags over the matrix when both are present
+    return cmsGetColorSpace(profile) == cmsSigRgbData &&
+        cmsIsMatrixShaper(profile) &&
+        !cmsIsCLUT(profile, renderingIntent, direction);
+}
+
+bool curveStartsAtZero(const cmsToneCurve *curve)
+{
+    return qFuzzyIsNull(cmsEvalToneCurveFloat(curve, 0.0f));
+}
+
+bool invertMatrix(const double m[9], double result[9])
+{
+    const double det =
+        m[0] * (m[4] * m[8] - m[5] * m[7]) -
+        m[1] * (m[3] * m[8] - m[5] * m[6]) +
+        m[2] * (m[3] * m[7] - m[4] * m[6]);
+
+    if (qAbs(det) < 1e-9) return false;
+
+    result[0] = (m[4] * m[8] - m[5] * m[7]) / det;
+    result[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+    result[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+    result[3] = (m[5] * m[6] - m[3] * m[8]) / det;
+    result[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+    result[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+    result[6] = (m[3] * m[7] - m[4] * m[6]) / det;
+    result[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+    result[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+
+    return true;
+}
+
+/**
+ * Fills \p data in if lcms would build a plain curves-matrix-curves
+ * pipeline for the conversion between the two profiles.
+ */
+bool fetchMatrixShaperData(cmsHPROFILE srcProfile, cmsHPROFILE dstProfile,
+                           int srcUnitValue,
+                           KoColorConversionTransformation::Intent renderingIntent,
+                           KoMatrixShaperConversionData *data)
+{
+    if (!isRgbMatrixShaper(srcProfile, renderingIntent, LCMS_USED_AS_INPUT) ||
+        !isRgbMatrixShaper(dstProfile, renderingIntent, LCMS_USED_AS_OUTPUT)) {
+
+        return false;
+    }
+
+    /**
+     * Black point compensation is a no-op only when the black points of
+     * the profiles coincide. For the perceptual intent lcms assigns a
+     * fixed black point to v4 profiles, so the versions must match. The
+     * curves are checked to start at zero below.
+     */
+    if (renderingIntent == KoColorConversionTransformation::IntentPerceptual &&
+        (cmsGetEncodedICCversion(srcProfile) >= 0x4000000) !=
+        (cmsGetEncodedICCversion(dstProfile) >= 0x4000000)) {
+
+        return false;
+    }
+
+    const cmsTagSignature curveTags[3] = {cmsSigRedTRCTag, cmsSigGreenTRCTag, cmsSigBlueTRCTag};
+    const cmsTagSignature colorantTags[3] = {cmsSigRedColorantTag, cmsSigGreenColorantTag, cmsSigBlueColorantTag};
+
+    const cmsToneCurve *srcCurves[3];
+    const cmsToneCurve *dstCurves[3];
+    double srcMatrix[9];
+    double dstMatrix[9];
+
+    for (int ch = 0; ch < 3; ch++) {
+        srcCurves[ch] = static_cast<const cmsToneCurve*>(cmsReadTag(srcProfile, curveTags[ch]));
+        dstCurves[ch] = static_cast<const cmsToneCurve*>(cmsReadTag(dstProfile, curveTags[ch]));
+
+        const cmsCIEXYZ *srcColorant = static_cast<const cmsCIEXYZ*>(cmsReadTag(srcProfile, colorantTags[ch]));
+        const cmsCIEXYZ *dstColorant = static_cast<const cmsCIEXYZ*>(cmsReadTag(dstProfile, colorantTags[ch]));
+
+        if (!srcCurves[ch] || !dstCurves[ch] || !srcColorant || !dstColorant ||
+            !curveStartsAtZero(srcCurves[ch]) ||
+            !curveStartsAtZero(dstCurves[ch])) {
+
+            return false;
+        }
+
+        /**
+         * The colorants are the columns of the RGB->XYZ matrix. They are
+         * already adapted to the D50 PCS, and lcms builds its matrix from
+         * them as they are: the chromatic adaptation tag is used only
+         * for the absolute colorimetric intent, which is rejected above.
+         */
+        srcMatrix[ch] = srcColorant->X;
+        srcMatrix[3 + ch] = srcColorant->Y;
+        srcMatrix[6 + ch] = srcColorant->Z;
+
+        dstMatrix[ch] = dstColorant->X;
+        dstMatrix[3 + ch] = dstColorant->Y;
+        dstMatrix[6 + ch] = dstColorant->Z;
+    }
+
+    double invertedDstMatrix[9];
+    if (!invertMatrix(dstMatrix, invertedDstMatrix)) return false;
+
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            double value = 0.0;
+            for (int i = 0; i < 3; i++) {
+                value += invertedDstMatrix[row * 3 + i] * srcMatrix[i * 3 + col];
+            }
+            data->matrix[row * 3 + col] = value;
+        }
+    }
+
+    const int tableSize = KoMatrixShaperConversionData::delinearizationSize;
+
+    for (int ch = 0; ch < 3; ch++) {
+        cmsToneCurve *reversedCurve = cmsReverseToneCurve(dstCurves[ch]);
+        if (!reversedCurve) return false;
+
+        data->linearization[ch].resize(srcUnitValue + 1);
+        for (int i = 0; i <= srcUnitValue; i++) {
+            data->linearization[ch][i] = cmsEvalToneCurveFloat(srcCurves[ch], float(i) / srcUnitValue);
+        }
+
+        data->delinearization[ch].resize(tableSize + 1);
+        for (int i = 0; i <= tableSize; i++) {
+            const float t = float(i) / tableSize;
+            data->delinearization[ch][i] = qBound(0.0f, cmsEvalToneCurveFloat(reversedCurve, t * t), 1.0f);
+        }
+
+        cmsFreeToneCurve(reversedCurve);
+    }
+
+    return true;
+}
+
+template <typename SrcTraits>
+KoColorConversionTransformation *createMatrixShaperTransformation(const KoColorSpace *srcColorSpace,
+                                                                  const KoColorSpace *dstColorSpace,
+                                                                  KoColorConversionTransformation::Intent renderingIntent,
+                                                                  KoColorConversionTransformation::ConversionFlags conversionFlags,
+                                                                  const KoMatrixShaperConversionData &data)
+{
+    if (dstColorSpace->colorDepthId() == Integer8BitsColorDepthID) {
+        return new KoMatrixShaperColorConversionTransformation<SrcTraits, KoBgrU8Traits>(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags, data);
+    } else {
+        return new KoMatrixShaperColorConversionTransformation<SrcTraits, KoBgrU16Traits>(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags, data);
+    }
+}
+
+/**
+ * The fast path is tested against lcms only for the relative colorimetric
+ * and perceptual intents with black point compensation, which is what
+ * Krita uses internally, for adjustments and for the display by default.
+ * The other flags allowed here only tune the precision of the lcms
+ * optimizations, and the fast path matches the unoptimized lcms pipeline.
+ */
+bool isVerifiedMatrixShaperCase(KoColorConversionTransformation::Intent renderingIntent,
+                                KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (renderingIntent != KoColorConversionTransformation::IntentRelativeColorimetric &&
+        renderingIntent != KoColorConversionTransformation::IntentPerceptual) {
+
+        return false;
+    }
+
+    const KoColorConversionTransformation::ConversionFlags allowedFlags =
+        KoColorConversionTransformation::BlackpointCompensation |
+        KoColorConversionTransformation::NoWhiteOnWhiteFixup |
+        KoColorConversionTransformation::HighQuality |
+        KoColorConversionTransformation::NoOptimization;
+
+    return conversionFlags.testFlag(KoColorConversionTransformation::BlackpointCompensation) &&
+        (int(conversionFlags) & ~int(allowedFlags)) == 0;
+}
+
+/**
+ * Integer RGB conversions between matrix-shaper profiles are the most
+ * common ones (projection to display, export, depth changes), so they
+ * are done by a vectorized LUT-and-matrix transformation. Float color
+ * spaces are left to lcms, since it converts them in unbounded mode.
+ */
+KoColorConversionTransformation *tryCreateMatrixShaperTransformation(const KoColorSpace *srcColorSpace,
+                                                                     const KoColorSpace *dstColorSpace,
+                                                                     KoColorConversionTransformation::Intent renderingIntent,
+                                                                     KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (!isVerifiedMatrixShaperCase(renderingIntent, conversionFlags) ||
+        srcColorSpace->colorModelId() != RGBAColorModelID ||
+        dstColorSpace->colorModelId() != RGBAColorModelID) {
+
+        return 0;
+    }
+
+    const bool srcIs8Bit = srcColorSpace->colorDepthId() == Integer8BitsColorDepthID;
+    const bool srcIs16Bit = srcColorSpace->colorDepthId() == Integer16BitsColorDepthID;
+    const bool dstIsInteger =
+        dstColorSpace->colorDepthId() == Integer8BitsColorDepthID ||
+        dstColorSpace->colorDepthId() == Integer16BitsColorDepthID;
+
+    if (!(srcIs8Bit || srcIs16Bit) || !dstIsInteger) return 0;
+
+    const IccColorProfile *srcProfile = dynamic_cast<const IccColorProfile *>(srcColorSpace->profile());
+    const IccColorProfile *dstProfile = dynamic_cast<const IccColorProfile *>(dstColorSpace->profile());
+    if (!srcProfile || !dstProfile) return 0;
+
+    KoMatrixShaperConversionData data;
+    if (!fetchMatrixShaperData(srcProfile->asLcms()->lcmsProfile(),
+                               dstProfile->asLcms()->lcmsProfile(),
+                               srcIs8Bit ? 0xff : 0xffff,
+                               renderingIntent, &data)) {
+        return 0;
+    }
+
+    return srcIs8Bit ?
+        createMatrixShaperTransformation<KoBgrU8Traits>(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags, data) :
+        createMatrixShaperTransformation<KoBgrU16Traits>(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags, data);
+}
+
+}
+
 struct IccColorSpaceEngine::Private {
 };
 
@@ -254,6 +482,13 @@ KoColorConversionTransformation *IccColorSpaceEngine::createColorTransformation(
     Q_ASSERT(srcColorSpace);
     Q_ASSERT(dstColorSpace);
 
+    KoColorConversionTransformation *transform =
+        tryCreateMatrixShaperTransformation(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags);
+
+    if (transform) {
+        return transform;
+    }
+
     return new KoLcmsColorConversionTransformation(
                 srcColorSpace, computeColorSpaceType(srcColorSpace),
                 dynamic_cast<const IccColorProfile *>(srcColorSpace->profile())->asLcms(), dstColorSpace, computeColorSpaceType(dstColorSpace),
@@ -24,8 +24,11 @@
 
 #include <colorprofiles/LcmsColorProfileContainer.h>
 #include <KoColorSpaceAbstract.h>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QVector>
 
 class LcmsColorProfileContainer;
 
@@ -153,16 +156,96 @@ class LcmsColorSpace : public KoColorSpaceAbstract<_CSTraits>, public KoLcmsInfo
         cmsHTRANSFORM cmsAlphaTransform;
     };
 
+    /**
+     * Transformations to/from 8-bit BGR in a non-default profile. They
+     * are keyed by the unique id of the profile, that is, by the hash of
+     * its content, so all the copies of a profile share them.
+     */
+    struct RGBTransformations {
+        QByteArray rgbProfileId;
+        cmsHTRANSFORM toRGB;
+        cmsHTRANSFORM fromRGB;
+    };
+
+    /**
+     * The list is never changed after it has been published in
+     * Private::rgbTransformations, so it can be read without any locks.
+     * When a new profile is requested, a copy of the list is published
+     * and the old one is retired. When the list is full, the oldest
+     * transformations are retired as well.
+     *
+     * The readers hold RGBTransformationsReadGuard while they use the
+     * list and the transformations found in it. The retired objects are
+     * deleted by the last reader leaving its guard (the same
+     * delete-blockers trick as in KisLocklessStack).
+     */
+    typedef QVector<RGBTransformations> RGBTransformationsList;
+
+    static const int maxRGBTransformations = 16;
+
     struct Private {
-        mutable quint8 *qcolordata; // A small buffer for conversion from and to qcolor.
         KoLcmsDefaultTransformations *defaultTransformations;
 
-        mutable cmsHPROFILE   lastRGBProfile;  // Last used profile to transform to/from RGB
-        mutable cmsHTRANSFORM lastToRGB;       // Last used transform to transform to RGB
-        mutable cmsHTRANSFORM lastFromRGB;     // Last used transform to transform from RGB
+        QAtomicPointer<const RGBTransformationsList> rgbTransformations;
+        QAtomicInt numRGBTransformationsReaders;
+
+        /**
+         * The retired objects are guarded by the mutex. The flag lets
+         * the readers skip the mutex when nothing is retired.
+         */
+        QVector<const RGBTransformationsList*> retiredRGBTransformationsLists;
+        QVector<RGBTransformations> retiredRGBTransformations;
+        QAtomicInt hasRetiredRGBTransformations;
+
         LcmsColorProfileContainer *profile;
         KoColorProfile *colorProfile;
-        QMutex mutex;
+        QMutex mutex; // serializes creation and deletion of the transformations only
+
+        void freeRetiredRGBTransformations()
+        {
+            QMutexLocker locker(&mutex);
+
+            /**
+             * The retired objects are not reachable from
+             * rgbTransformations anymore, so only the readers, which
+             * entered before the objects were retired, could see them
+             */
+            if (numRGBTransformationsReaders.fetchAndAddOrdered(0) != 0) return;
+
+            qDeleteAll(retiredRGBTransformationsLists);
+            retiredRGBTransformationsLists.clear();
+
+            for (auto it = retiredRGBTransformations.constBegin(); it != retiredRGBTransformations.constEnd(); ++it) {
+                cmsDeleteTransform(it->toRGB);
+                cmsDeleteTransform(it->fromRGB);
+            }
+            retiredRGBTransformations.clear();
+
+            hasRetiredRGBTransformations.storeRelease(0);
+        }
+    };
+
+    class RGBTransformationsReadGuard
+    {
+    public:
+        RGBTransformationsReadGuard(Private *d)
+            : m_d(d)
+        {
+            m_d->numRGBTransformationsReaders.ref();
+        }
+
+        ~RGBTransformationsReadGuard()
+        {
+            if (!m_d->numRGBTransformationsReaders.deref() &&
+                m_d->hasRetiredRGBTransformations.loadAcquire()) {
+
+                m_d->freeRetiredRGBTransformations();
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(RGBTransformationsReadGuard)
+        Private *m_d;
     };
 
 protected:
@@ -181,27 +264,29 @@ protected:
         d->profile = asLcmsProfile(p);
         Q_ASSERT(d->profile);
         d->colorProfile = p;
-        d->qcolordata = 0;
-        d->lastRGBProfile = 0;
-        d->lastToRGB = 0;
-        d->lastFromRGB = 0;
         d->defaultTransformations = 0;
     }
 
     ~LcmsColorSpace() override
     {
+        d->freeRetiredRGBTransformations();
+
+        const RGBTransformationsList *transformations = d->rgbTransformations.load();
+        if (transformations) {
+            for (auto it = transformations->constBegin(); it != transformations->constEnd(); ++it) {
+                cmsDeleteTransform(it->toRGB);
+                cmsDeleteTransform(it->fromRGB);
+            }
+            delete transformations;
+        }
+
         delete d->colorProfile;
-        delete[] d->qcolordata;
         delete d->defaultTransformations;
         delete d;
     }
 
     void init()
     {
-        // Default pixel buffer for QColor conversion
-        d->qcolordata = new quint8[3];
-        Q_CHECK_PTR(d->qcolordata);
-
         Q_ASSERT(d->profile);
 
         if (KoLcmsDefaultTransformations::s_RGBProfile == 0) {
@@ -248,29 +333,21 @@ public:
 
     void fromQColor(const QColor &color, quint8 *dst, const KoColorProfile *koprofile = 0) const override
     {
-        QMutexLocker locker(&d->mutex);
-        d->qcolordata[2] = color.red();
-        d->qcolordata[1] = color.green();
-        d->qcolordata[0] = color.blue();
+        quint8 qcolordata[3];
+        qcolordata[2] = color.red();
+        qcolordata[1] = color.green();
+        qcolordata[0] = color.blue();
+
+        RGBTransformationsReadGuard guard(d);
 
         LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
         if (profile == 0) {
             // Default sRGB
             Q_ASSERT(d->defaultTransformations && d->defaultTransformations->fromRGB);
 
-            cmsDoTransform(d->defaultTransformations->fromRGB, d->qcolordata, dst, 1);
+            cmsDoTransform(d->defaultTransformations->fromRGB, qcolordata, dst, 1);
         } else {
-            if (d->lastFromRGB == 0 || (d->lastFromRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
-                d->lastFromRGB = cmsCreateTransform(profile->lcmsProfile(),
-                                                    TYPE_BGR_8,
-                                                    d->profile->lcmsProfile(),
-                                                    this->colorSpaceType(),
-                                                    KoColorConversionTransformation::internalRenderingIntent(),
-                                                    KoColorConversionTransformation::internalConversionFlags());
-                d->lastRGBProfile = profile->lcmsProfile();
-
-            }
-            cmsDoTransform(d->lastFromRGB, d->qcolordata, dst, 1);
+            cmsDoTransform(rgbTransformations(profile)->fromRGB, qcolordata, dst, 1);
         }
 
         this->setOpacity(dst, (quint8)(color.alpha()), 1);
@@ -278,24 +355,42 @@ public:
 
     void toQColor(const quint8 *src, QColor *c, const KoColorProfile *koprofile = 0) const override
     {
-        QMutexLocker locker(&d->mutex);
-        LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
-        if (profile == 0) {
-            // Default sRGB transform
-            Q_ASSERT(d->defaultTransformations && d->defaultTransformations->toRGB);
-            cmsDoTransform(d->defaultTransformations->toRGB, const_cast <quint8 *>(src), d->qcolordata, 1);
-        } else {
-            if (d->lastToRGB == 0 || (d->lastToRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
-                d->lastToRGB = cmsCreateTransform(d->profile->lcmsProfile(), this->colorSpaceType(),
-                                                  profile->lcmsProfile(), TYPE_BGR_8,
-                                                  KoColorConversionTransformation::internalRenderingIntent(),
-                                                  KoColorConversionTransformation::internalConversionFlags());
-                d->lastRGBProfile = profile->lcmsProfile();
+        quint8 qcolordata[3];
+
+        RGBTransformationsReadGuard guard(d);
+        cmsDoTransform(toRGBTransformation(koprofile), const_cast <quint8 *>(src), qcolordata, 1);
+
+        c->setRgb(qcolordata[2], qcolordata[1], qcolordata[0]);
+        c->setAlpha(this->opacityU8(src));
+    }
+
+    void toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile *koprofile = 0) const override
+    {
+        const int chunkSize = 256;
+        quint8 qcolordata[3 * chunkSize];
+
+        RGBTransformationsReadGuard guard(d);
+
+        const cmsHTRANSFORM transform = toRGBTransformation(koprofile);
+        const quint32 pixelSize = this->pixelSize();
+
+        while (nPixels > 0) {
+            const int numPixels = qMin(nPixels, quint32(chunkSize));
+
+            cmsDoTransform(transform, const_cast <quint8 *>(src), qcolordata, numPixels);
+
+            const quint8 *rgb = qcolordata;
+            for (int i = 0; i < numPixels; i++) {
+                colors->setRgb(rgb[2], rgb[1], rgb[0]);
+                colors->setAlpha(this->opacityU8(src));
+
+                rgb += 3;
+                src += pixelSize;
+                colors++;
             }
-            cmsDoTransform(d->lastToRGB, const_cast <quint8 *>(src), d->qcolordata, 1);
+
+            nPixels -= numPixels;
         }
-        c->setRgb(d->qcolordata[2], d->qcolordata[1], d->qcolordata[0]);
-        c->setAlpha(this->opacityU8(src));
     }
 
     KoColorTransformation *createBrightnessContrastAdjustment(const quint16 *transferValues) const override
@@ -447,6 +542,95 @@ private:
         return iccp->asLcms();
     }
 
+    inline cmsHTRANSFORM toRGBTransformation(const KoColorProfile *koprofile) const
+    {
+        LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
+        if (profile == 0) {
+            // Default sRGB transform
+            Q_ASSERT(d->defaultTransformations && d->defaultTransformations->toRGB);
+            return d->defaultTransformations->toRGB;
+        }
+
+        return rgbTransformations(profile)->toRGB;
+    }
+
+    /**
+     * Returns the transformations to/from \p profile. The lookup is
+     * lock-free, the mutex is taken only when the transformations
+     * for the profile are created for the first time. The caller
+     * should hold RGBTransformationsReadGuard while using the result.
+     */
+    const RGBTransformations *rgbTransformations(LcmsColorProfileContainer *profile) const
+    {
+        const QByteArray profileId = profile->getProfileUniqueId();
+
+        const RGBTransformationsList *transformations = d->rgbTransformations.loadAcquire();
+        const RGBTransformations *result = findRGBTransformations(transformations, profileId);
+        if (result) return result;
+
+        QMutexLocker locker(&d->mutex);
+
+        // someone could have created the transformations while we were waiting
+        transformations = d->rgbTransformations.loadAcquire();
+        result = findRGBTransformations(transformations, profileId);
+        if (result) return result;
+
+        const cmsHPROFILE rgbProfile = profile->lcmsProfile();
+
+        RGBTransformations newTransformations;
+        newTransformations.rgbProfileId = profileId;
+        newTransformations.toRGB =
+            cmsCreateTransform(d->profile->lcmsProfile(), this->colorSpaceType(),
+                               rgbProfile, TYPE_BGR_8,
+                               KoColorConversionTransformation::internalRenderingIntent(),
+                               KoColorConversionTransformation::internalConversionFlags());
+        newTransformations.fromRGB =
+            cmsCreateTransform(rgbProfile, TYPE_BGR_8,
+                               d->profile->lcmsProfile(), this->colorSpaceType(),
+                               KoColorConversionTransformation::internalRenderingIntent(),
+                               KoColorConversionTransformation::internalConversionFlags());
+
+        RGBTransformationsList *newList = new RGBTransformationsList();
+        newList->reserve(maxRGBTransformations);
+
+        if (transformations) {
+            // the oldest transformations are in the beginning of the list
+            const int numEvicted = qMax(0, transformations->size() - maxRGBTransformations + 1);
+
+            for (int i = 0; i < transformations->size(); i++) {
+                if (i < numEvicted) {
+                    d->retiredRGBTransformations.append(transformations->at(i));
+                } else {
+                    newList->append(transformations->at(i));
+                }
+            }
+
+            d->retiredRGBTransformationsLists.append(transformations);
+            d->hasRetiredRGBTransformations.storeRelease(1);
+        }
+
+        newList->append(newTransformations);
+        result = &newList->constLast();
+
+        d->rgbTransformations.fetchAndStoreOrdered(newList);
+
+        return result;
+    }
+
+    static inline const RGBTransformations *findRGBTransformations(const RGBTransformationsList *transformations,
+                                                                   const QByteArray &profileId)
+    {
+        if (!transformations) return 0;
+
+        for (auto it = transformations->constBegin(); it != transformations->constEnd(); ++it) {
+            if (it->rgbProfileId == profileId) {
+                return &(*it);
+            }
+        }
+
+        return 0;
+    }
+
     Private *const d;
 };
 
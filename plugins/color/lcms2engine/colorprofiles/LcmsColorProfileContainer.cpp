@@ -126,6 +126,14 @@ bool LcmsColorProfileContainer::init()
 
     d->profile = cmsOpenProfileFromMem((void *)d->data->rawData().constData(), d->data->rawData().size());
 
+    /**
+     * The id is used as a key of the caches of the color spaces from
+     * multiple threads, so it is calculated in advance, while the
+     * profile is not shared yet
+     */
+    d->uniqueId.clear();
+    getProfileUniqueId();
+
 #ifndef NDEBUG
     if (d->data->rawData().size() == 4096) {
         qWarning() << "Profile has a size of 4096, which is suspicious and indicates a possible misuse of QIODevice::read(int), check your code.";
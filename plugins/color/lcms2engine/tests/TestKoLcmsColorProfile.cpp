@@ -3,8 +3,12 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <LcmsColorProfileContainer.h>
+#include <IccColorProfile.h>
 
 #include <KoColor.h>
+#include <KoColorSpaceEngine.h>
+#include <KoBgrColorSpaceTraits.h>
+#include <KoMatrixShaperColorConversionTransformation.h>
 
 #include <QTest>
 
@@ -211,4 +215,329 @@ void TestKoLcmsColorProfile::testProofingConversion()
     Q_ASSERT((dst[0] == alarm[0]) && (dst[1] == alarm[1]) && (dst[2] == alarm[2]));
 
 }
+
+void TestKoLcmsColorProfile::testToQColors()
+{
+    QList<const KoColorSpace*> colorSpaces;
+    colorSpaces << KoColorSpaceRegistry::instance()->rgb8();
+    colorSpaces << KoColorSpaceRegistry::instance()->rgb16();
+    colorSpaces << KoColorSpaceRegistry::instance()->lab16();
+
+    // a non-default profile makes the color space use the cached transformations
+    QList<const KoColorProfile*> profiles;
+    profiles << 0;
+    profiles << KoColorSpaceRegistry::instance()->rgb8()->profile();
+
+    const int numPixels = 1000; // more than one chunk of toQColors()
+
+    Q_FOREACH (const KoColorSpace *cs, colorSpaces) {
+        QVector<quint8> data(numPixels * cs->pixelSize());
+        for (int i = 0; i < data.size(); i++) {
+            data[i] = (i * 37) % 256;
+        }
+
+        Q_FOREACH (const KoColorProfile *profile, profiles) {
+            QVector<QColor> colors(numPixels);
+            cs->toQColors(data.constData(), colors.data(), numPixels, profile);
+
+            for (int i = 0; i < numPixels; i++) {
+                QColor color;
+                cs->toQColor(data.constData() + i * cs->pixelSize(), &color, profile);
+                QCOMPARE(colors[i], color);
+            }
+        }
+    }
+}
+
+namespace {
+
+/**
+ * A matrix-shaper profile with sRGB primaries and a pure gamma curve
+ */
+QByteArray gammaProfileData(double gamma, const QString &name = QString(),
+                            const cmsCIExyY *whitePoint = cmsD50_xyY(), double version = 4.3)
+{
+    const cmsCIExyYTRIPLE primaries = {{0.64, 0.33, 1.0}, {0.30, 0.60, 1.0}, {0.15, 0.06, 1.0}};
+    cmsToneCurve *curve = cmsBuildGamma(0, gamma);
+    cmsToneCurve *curves[3] = {curve, curve, curve};
+
+    cmsHPROFILE profile = cmsCreateRGBProfile(whitePoint, &primaries, curves);
+    cmsFreeToneCurve(curve);
+
+    cmsSetProfileVersion(profile, version);
+
+    if (!name.isEmpty()) {
+        cmsMLU *description = cmsMLUalloc(0, 1);
+        cmsMLUsetASCII(description, "en", "US", name.toLatin1().constData());
+        cmsWriteTag(profile, cmsSigProfileDescriptionTag, description);
+        cmsMLUfree(description);
+    }
+
+    cmsUInt32Number size = 0;
+    cmsSaveProfileToMem(profile, 0, &size);
+    QByteArray data(size, 0);
+    cmsSaveProfileToMem(profile, data.data(), &size);
+    cmsCloseProfile(profile);
+
+    return data;
+}
+
+}
+
+void TestKoLcmsColorProfile::testRGBTransformationsCache()
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+    const KoColorSpace *cs = registry->rgb8();
+
+    const quint8 pixel[4] = {128, 64, 192, 255};
+
+    /**
+     * More profiles than the cache can hold, so the transformations
+     * are evicted and created again on the second pass
+     */
+    const int numProfiles = 40;
+
+    QVector<QByteArray> profileData;
+    QVector<QColor> expected;
+
+    for (int i = 0; i < numProfiles; i++) {
+        profileData << gammaProfileData(1.0 + 0.05 * i);
+
+        IccColorProfile profile(profileData.last());
+        QVERIFY(profile.valid());
+
+        QColor color;
+        cs->toQColor(pixel, &color, &profile);
+        expected << color;
+    }
+
+    QVERIFY(expected.first() != expected.last());
+
+    /**
+     * Every short-living profile is a new object, which is very likely
+     * to get the address of the deleted one, but the cached
+     * transformations must not be mixed up
+     */
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < numProfiles; i++) {
+            QScopedPointer<IccColorProfile> profile(new IccColorProfile(profileData[i]));
+
+            QColor color;
+            cs->toQColor(pixel, &color, profile.data());
+            QCOMPARE(color, expected[i]);
+
+            quint8 dst[4];
+            cs->fromQColor(expected[i], dst, profile.data());
+
+            QColor roundTripColor;
+            cs->toQColor(dst, &roundTripColor, profile.data());
+            QVERIFY(qAbs(roundTripColor.red() - expected[i].red()) <= 2);
+            QVERIFY(qAbs(roundTripColor.green() - expected[i].green()) <= 2);
+            QVERIFY(qAbs(roundTripColor.blue() - expected[i].blue()) <= 2);
+        }
+    }
+}
+
+namespace {
+
+const KoColorProfile *matrixShaperProfile(const QString &name, double gamma,
+                                          const cmsCIExyY *whitePoint = cmsD50_xyY(), double version = 4.3)
+{
+    const KoColorProfile *existingProfile = KoColorSpaceRegistry::instance()->profileByName(name);
+    if (existingProfile) return existingProfile;
+
+    return KoColorSpaceEngineRegistry::instance()->get("icc")->addProfile(gammaProfileData(gamma, name, whitePoint, version));
+}
+
+bool hasChromaticAdaptationTag(const KoColorProfile *profile)
+{
+    const QByteArray rawData = profile->rawData();
+    cmsHPROFILE lcmsProfile = cmsOpenProfileFromMem((void *)rawData.constData(), rawData.size());
+    const bool result = cmsIsTag(lcmsProfile, cmsSigChromaticAdaptationTag);
+    cmsCloseProfile(lcmsProfile);
+
+    return result;
+}
+
+template <typename SrcTraits, typename DstTraits>
+bool isMatrixShaperTransformation(const KoColorConversionTransformation *transform)
+{
+    return dynamic_cast<const KoMatrixShaperColorConversionTransformation<SrcTraits, DstTraits>*>(transform);
+}
+
+bool isMatrixShaperTransformation(const KoColorConversionTransformation *transform)
+{
+    return isMatrixShaperTransformation<KoBgrU8Traits, KoBgrU8Traits>(transform) ||
+        isMatrixShaperTransformation<KoBgrU8Traits, KoBgrU16Traits>(transform) ||
+        isMatrixShaperTransformation<KoBgrU16Traits, KoBgrU8Traits>(transform) ||
+        isMatrixShaperTransformation<KoBgrU16Traits, KoBgrU16Traits>(transform);
+}
+
+}
+
+void TestKoLcmsColorProfile::testMatrixShaperConversion_data()
+{
+    QTest::addColumn<QString>("srcProfileName");
+    QTest::addColumn<QString>("dstProfileName");
+    QTest::addColumn<bool>("srcIs16Bit");
+    QTest::addColumn<bool>("dstIs16Bit");
+    QTest::addColumn<int>("renderingIntent");
+    QTest::addColumn<int>("conversionFlags");
+    QTest::addColumn<bool>("expectFastPath");
+
+    const QString gammaRgb = matrixShaperProfile("Test D50 gamma 2.2", 2.2)->name();
+    const QString flatRgb = matrixShaperProfile("Test D50 gamma 1.0", 1.0)->name();
+    const QString sRgb = "sRGB built-in";
+    const QString linearRgb = "scRGB (linear)";
+
+    cmsCIExyY d65;
+    cmsWhitePointFromTemp(&d65, 6504);
+    const KoColorProfile *v2Profile = matrixShaperProfile("Test D65 gamma 2.2 v2", 2.2, &d65, 2.1);
+    const QString v2Rgb = v2Profile->name();
+
+    // the D65 profiles carry a non-trivial chromatic adaptation tag
+    QVERIFY(hasChromaticAdaptationTag(KoColorSpaceRegistry::instance()->profileByName(sRgb)));
+    QVERIFY(hasChromaticAdaptationTag(v2Profile));
+
+    struct ProfilePair {
+        QString name;
+        QString src;
+        QString dst;
+        bool sameVersion;
+    };
+
+    const QVector<ProfilePair> profilePairs = {
+        {"d50 gamma->flat", gammaRgb, flatRgb, true},
+        {"d50 flat->gamma", flatRgb, gammaRgb, true},
+        {"d50 gamma->gamma", gammaRgb, gammaRgb, true},
+        {"srgb->linear", sRgb, linearRgb, true},
+        {"linear->srgb", linearRgb, sRgb, true},
+        {"srgb->d50 gamma", sRgb, gammaRgb, true},
+        {"v2->srgb", v2Rgb, sRgb, false},
+        {"linear->v2", linearRgb, v2Rgb, false}
+    };
+
+    typedef KoColorConversionTransformation KCCT;
+
+    struct ConversionMode {
+        QString name;
+        KCCT::Intent intent;
+        KCCT::ConversionFlags flags;
+        bool fastPathAllowed;
+    };
+
+    const QVector<ConversionMode> conversionModes = {
+        {"relative bpc", KCCT::IntentRelativeColorimetric, KCCT::BlackpointCompensation, true},
+        {"perceptual bpc", KCCT::IntentPerceptual, KCCT::BlackpointCompensation, true},
+        {"perceptual bpc no-fixup", KCCT::IntentPerceptual, KCCT::adjustmentConversionFlags(), true},
+        {"relative", KCCT::IntentRelativeColorimetric, KCCT::Empty, false},
+        {"saturation bpc", KCCT::IntentSaturation, KCCT::BlackpointCompensation, false},
+        {"absolute bpc", KCCT::IntentAbsoluteColorimetric, KCCT::BlackpointCompensation, false}
+    };
+
+    Q_FOREACH (const ProfilePair &pair, profilePairs) {
+        Q_FOREACH (const ConversionMode &mode, conversionModes) {
+            for (int i = 0; i < 4; i++) {
+                const bool srcIs16Bit = i & 0x1;
+                const bool dstIs16Bit = i & 0x2;
+                const QString rowName = QString("%1 %2 %3->%4")
+                    .arg(pair.name).arg(mode.name)
+                    .arg(srcIs16Bit ? 16 : 8).arg(dstIs16Bit ? 16 : 8);
+
+                QTest::newRow(qPrintable(rowName))
+                    << pair.src << pair.dst << srcIs16Bit << dstIs16Bit
+                    << int(mode.intent) << int(mode.flags)
+                    << (mode.fastPathAllowed &&
+                        (pair.sameVersion || mode.intent != KCCT::IntentPerceptual));
+            }
+        }
+    }
+}
+
+void TestKoLcmsColorProfile::testMatrixShaperConversion()
+{
+    QFETCH(QString, srcProfileName);
+    QFETCH(QString, dstProfileName);
+    QFETCH(bool, srcIs16Bit);
+    QFETCH(bool, dstIs16Bit);
+    QFETCH(int, renderingIntent);
+    QFETCH(int, conversionFlags);
+    QFETCH(bool, expectFastPath);
+
+    const KoColorConversionTransformation::Intent intent =
+        KoColorConversionTransformation::Intent(renderingIntent);
+    const KoColorConversionTransformation::ConversionFlags flags =
+        KoColorConversionTransformation::ConversionFlags(conversionFlags);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+    const KoColorSpace *srcCs = srcIs16Bit ? registry->rgb16(srcProfileName) : registry->rgb8(srcProfileName);
+    const KoColorSpace *dstCs = dstIs16Bit ? registry->rgb16(dstProfileName) : registry->rgb8(dstProfileName);
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    QScopedPointer<KoColorConversionTransformation> transform(srcCs->createColorConverter(dstCs, intent, flags));
+    QCOMPARE(isMatrixShaperTransformation(transform.data()), expectFastPath);
+
+    const int numPixels = 4096;
+    QVector<quint8> src(numPixels * srcCs->pixelSize());
+
+    for (int i = 0; i < numPixels; i++) {
+        if (srcIs16Bit) {
+            quint16 *pixel = reinterpret_cast<quint16*>(src.data()) + 4 * i;
+            pixel[0] = i * 16;
+            pixel[1] = (i * 37 * 16) % 65536;
+            pixel[2] = 65535 - i * 16;
+            pixel[3] = (i * 16) % 65536;
+        } else {
+            quint8 *pixel = src.data() + 4 * i;
+            pixel[0] = i % 256;
+            pixel[1] = (i * 37) % 256;
+            pixel[2] = i / 16;
+            pixel[3] = 255 - i % 256;
+        }
+    }
+
+    QVector<quint8> dst(numPixels * dstCs->pixelSize());
+    transform->transform(src.constData(), dst.data(), numPixels);
+
+    QByteArray srcRawData = srcCs->profile()->rawData();
+    QByteArray dstRawData = dstCs->profile()->rawData();
+    cmsHPROFILE srcProfile = cmsOpenProfileFromMem((void *)srcRawData.constData(), srcRawData.size());
+    cmsHPROFILE dstProfile = cmsOpenProfileFromMem((void *)dstRawData.constData(), dstRawData.size());
+
+    cmsHTRANSFORM tf = cmsCreateTransform(srcProfile,
+                                          srcIs16Bit ? TYPE_BGRA_16 : TYPE_BGRA_8,
+                                          dstProfile,
+                                          dstIs16Bit ? TYPE_BGRA_16 : TYPE_BGRA_8,
+                                          renderingIntent,
+                                          cmsFLAGS_NOOPTIMIZE | conversionFlags);
+
+    QVector<quint8> expected(numPixels * dstCs->pixelSize());
+    cmsDoTransform(tf, src.constData(), expected.data(), numPixels);
+
+    cmsDeleteTransform(tf);
+    cmsCloseProfile(srcProfile);
+    cmsCloseProfile(dstProfile);
+
+    /**
+     * Both the fast path and the optimized lcms pipelines are compared
+     * against the unoptimized one, so allow for rounding of the
+     * interpolated tables: one code value in 8 bits, 32 in 16 bits.
+     */
+    const int tolerance = dstIs16Bit ? 32 : 1;
+
+    for (int i = 0; i < numPixels; i++) {
+        // lcms doesn't touch alpha, so check only the color channels
+        for (int ch = 0; ch < 3; ch++) {
+            const int index = 4 * i + ch;
+            const int value = dstIs16Bit ? reinterpret_cast<const quint16*>(dst.constData())[index] : dst[index];
+            const int expectedValue = dstIs16Bit ? reinterpret_cast<const quint16*>(expected.constData())[index] : expected[index];
+
+            QVERIFY2(qAbs(value - expectedValue) <= tolerance,
+                     qPrintable(QString("pixel %1, channel %2: %3, lcms gives %4")
+                                .arg(i).arg(ch).arg(value).arg(expectedValue)));
+        }
+    }
+}
+
 QTEST_MAIN(TestKoLcmsColorProfile)
@@ -12,6 +12,10 @@ class TestKoLcmsColorProfile : public QObject
 private Q_SLOTS:
     void testConversion();
     void testProofingConversion();
+    void testToQColors();
+    void testRGBTransformationsCache();
+    void testMatrixShaperConversion_data();
+    void testMatrixShaperConversion();
 
 };
 
@@ -27,6 +27,7 @@
 #include <kis_convolution_kernel.h>
 #include <kis_convolution_painter.h>
 #include <kis_gaussian_kernel.h>
+#include <kis_iir_gaussian_blur.h>
 
 #include "ui_wdg_gaussian_blur.h"
 
@@ -89,9 +90,15 @@ void KisGaussianBlurFilter::processImpl(KisPaintDeviceSP device,
         channelFlags = QBitArray(device->colorSpace()->channelCount(), true);
     }
 
-    KisGaussianKernel::applyGaussian(device, rect,
-                                     horizontalRadius, verticalRadius,
-                                     channelFlags, progressUpdater);
+    if (KisIIRGaussianBlur::isPreferable(horizontalRadius, verticalRadius)) {
+        KisIIRGaussianBlur::applyGaussian(device, rect,
+                                          horizontalRadius, verticalRadius,
+                                          channelFlags, progressUpdater);
+    } else {
+        KisGaussianKernel::applyGaussian(device, rect,
+                                         horizontalRadius, verticalRadius,
+                                         channelFlags, progressUpdater);
+    }
 }
 
 QRect KisGaussianBlurFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
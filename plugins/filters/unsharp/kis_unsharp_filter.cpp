@@ -26,6 +26,7 @@
 #include <kis_convolution_kernel.h>
 #include <kis_convolution_painter.h>
 #include <kis_gaussian_kernel.h>
+#include <kis_iir_gaussian_blur.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
 #include <KoProgressUpdater.h>
@@ -103,10 +104,17 @@ void KisUnsharpFilter::processImpl(KisPaintDeviceSP device,
     const uint lightnessOnly = (config->getProperty("lightnessOnly", value)) ? value.toBool() : true;
 
     QBitArray channelFlags = config->channelFlags();
-    KisGaussianKernel::applyGaussian(device, applyRect,
-                                     halfSize, halfSize,
-                                     channelFlags,
-                                     progressUpdater);
+    if (KisIIRGaussianBlur::isPreferable(halfSize, halfSize)) {
+        KisIIRGaussianBlur::applyGaussian(device, applyRect,
+                                          halfSize, halfSize,
+                                          channelFlags,
+                                          progressUpdater);
+    } else {
+        KisGaussianKernel::applyGaussian(device, applyRect,
+                                         halfSize, halfSize,
+                                         channelFlags,
+                                         progressUpdater);
+    }
 
     if (progressUpdater && progressUpdater->interrupted()) {
         return;
@@ -24,6 +24,8 @@
 #include <QRect>
 #include <QBuffer>
 #include <QByteArray>
+#include <QSharedPointer>
+#include <QtConcurrent>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColorProfile.h>
@@ -59,6 +61,7 @@
 #include "kis_dom_utils.h"
 #include "kis_raster_keyframe_channel.h"
 #include "kis_paint_device_frames_interface.h"
+#include "kis_image_config.h"
 
 using namespace KRA;
 
@@ -116,6 +119,13 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
         m_store->popDirectory();
     }
     m_syntaxVersion = syntaxVersion;
+
+    m_decodingPool.setMaxThreadCount(qMax(1, KisImageConfig(true).maxNumberOfThreads()));
+}
+
+KisKraLoadVisitor::~KisKraLoadVisitor()
+{
+    finishPendingLoads();
 }
 
 void KisKraLoadVisitor::setExternalUri(const QString &uri)
@@ -173,6 +183,9 @@ bool KisKraLoadVisitor::visit(KisPaintLayer *layer)
             if (!pixelSelection->read(m_store->device())) {
                 pixelSelection->disconnect();
             } else {
+                // adding a node may start updating the layer
+                finishPendingLoads();
+
                 KisTransparencyMask* mask = new KisTransparencyMask();
                 mask->setSelection(selection);
                 m_image->addNode(mask, layer, layer->firstChild());
@@ -209,7 +222,11 @@ bool KisKraLoadVisitor::visit(KisAdjustmentLayer* layer)
         KisSelectionSP selection = new KisSelection();
         KisPixelSelectionSP pixelSelection = selection->pixelSelection();
         result = loadPaintDevice(pixelSelection, getLocation(layer, ".selection"));
-        layer->setInternalSelection(selection);
+
+        // the layer copies the pixels of the selection
+        runAfterPendingLoads([layer, selection] () {
+            layer->setInternalSelection(selection);
+        });
     } else if (m_syntaxVersion == 2) {
         result = loadSelection(getLocation(layer), layer->internalSelection());
 
@@ -239,7 +256,11 @@ bool KisKraLoadVisitor::visit(KisGeneratorLayer* layer)
     result = loadSelection(getLocation(layer), layer->internalSelection());
 
     result = loadFilterConfiguration(layer->filter().data(), getLocation(layer, DOT_FILTERCONFIG));
-    layer->update();
+
+    // the content is generated inside the loaded selection
+    runAfterPendingLoads([layer] () {
+        layer->update();
+    });
 
     result = visitAll(layer);
     return result;
@@ -388,7 +409,9 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
         loadPaintDevice(stroke.dev, fileName);
     }
 
-    mask->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
+    runAfterPendingLoads([mask, strokes] () {
+        mask->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
+    });
 
     loadPaintDevice(mask->coloringProjection(), COLORIZE_COLORING_DEVICE);
 
@@ -396,6 +419,42 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
     return true;
 }
 
+void KisKraLoadVisitor::addPendingLoad(const QFuture<void> &decoding, std::function<void()> finish)
+{
+    PendingLoad load;
+    load.decoding = decoding;
+    load.finish = finish;
+    m_pendingLoads.enqueue(load);
+
+    /**
+     * Every pending device keeps its compressed data in memory,
+     * so don't let the visitor run too far ahead of the pool
+     */
+    while (m_pendingLoads.size() > 2 * m_decodingPool.maxThreadCount()) {
+        finishOldestPendingLoad();
+    }
+}
+
+void KisKraLoadVisitor::runAfterPendingLoads(std::function<void()> step)
+{
+    // a default constructed future is already finished
+    addPendingLoad(QFuture<void>(), step);
+}
+
+void KisKraLoadVisitor::finishOldestPendingLoad()
+{
+    PendingLoad load = m_pendingLoads.dequeue();
+    load.decoding.waitForFinished();
+    load.finish();
+}
+
+void KisKraLoadVisitor::finishPendingLoads()
+{
+    while (!m_pendingLoads.isEmpty()) {
+        finishOldestPendingLoad();
+    }
+}
+
 QStringList KisKraLoadVisitor::errorMessages() const
 {
     return m_errorMessages;
@@ -443,8 +502,10 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
         frames = device->framesInterface()->frames();
     }
 
+    QSharedPointer<QVector<PendingFrame>> pendingFrames(new QVector<PendingFrame>());
+
     if (!frameInterface || frames.count() <= 1) {
-        return loadPaintDeviceFrame(device, location, SimpleDevicePolicy());
+        fetchPaintDeviceFrame(device, location, SimpleDevicePolicy(), pendingFrames.data());
     } else {
         KisRasterKeyframeChannel *keyframeChannel = device->keyframeChannel();
 
@@ -458,42 +519,85 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
                 QString frameFilename = getLocation(keyframeChannel->frameFilename(id));
                 Q_ASSERT(!frameFilename.isEmpty());
 
-                if (!loadPaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id))) {
-                    m_warningMessages << i18n("Could not load keyframe pixel data for frame %1 in %2.").arg(id).arg(location);
-                }
+                fetchPaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id), pendingFrames.data());
             }
         }
     }
 
+    if (pendingFrames->isEmpty()) {
+        return true;
+    }
+
+    /**
+     * The frames of the same device share the frames map
+     * of the device, so they are decoded sequentially
+     */
+    QFuture<void> decoding = QtConcurrent::run(&m_decodingPool, [pendingFrames] () {
+        for (auto it = pendingFrames->begin(); it != pendingFrames->end(); ++it) {
+            QBuffer buffer(&it->data);
+            buffer.open(QIODevice::ReadOnly);
+            it->readSuccess = it->read(&buffer);
+            it->data.clear();
+        }
+    });
+
+    addPendingLoad(decoding, [this, device, pendingFrames] () {
+        bool hasFailedFrames = false;
+
+        Q_FOREACH (const PendingFrame &frame, *pendingFrames) {
+            if (!frame.readSuccess) {
+                m_warningMessages << i18n("Could not read pixel data: %1.", frame.location);
+                hasFailedFrames = true;
+            } else if (frame.setDefaultPixel) {
+                frame.setDefaultPixel();
+            }
+        }
+
+        if (hasFailedFrames) {
+            device->disconnect();
+        }
+    });
+
     return true;
 }
 
 template<class DevicePolicy>
-bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy)
+void KisKraLoadVisitor::fetchPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy, QVector<PendingFrame> *frames)
 {
-    if (m_store->open(location)) {
-        if (!policy.read(device, m_store->device())) {
-            m_warningMessages << i18n("Could not read pixel data: %1.", location);
-            device->disconnect();
-            m_store->close();
-            return true;
-        }
-        m_store->close();
-    } else {
+    /**
+     * KoStore can read only one file at a time, so we just fetch
+     * the raw data here, it is decoded by m_decodingPool later
+     */
+    if (!m_store->open(location)) {
         m_warningMessages << i18n("Could not load pixel data: %1.", location);
-        return true;
+        return;
     }
+
+    PendingFrame frame;
+    frame.location = location;
+    frame.data = m_store->device()->readAll();
+    frame.read = [device, policy] (QIODevice *stream) mutable {
+        return policy.read(device, stream);
+    };
+    m_store->close();
+
+    /**
+     * The default pixel is set only after the frame is decoded,
+     * otherwise the decoded data would overwrite it
+     */
     if (m_store->open(location + ".defaultpixel")) {
         int pixelSize = device->colorSpace()->pixelSize();
         if (m_store->size() == pixelSize) {
             KoColor color(Qt::transparent, device->colorSpace());
             m_store->read((char*)color.data(), pixelSize);
-            policy.setDefaultPixel(device, color);
+            frame.setDefaultPixel = [device, policy, color] () {
+                policy.setDefaultPixel(device, color);
+            };
         }
         m_store->close();
     }
 
-    return true;
+    frames->append(frame);
 }
 
 
@@ -507,11 +611,17 @@ bool KisKraLoadVisitor::loadProfile(KisPaintDeviceSP device, const QString& loca
         int read = m_store->read(data.data(), m_store->size());
         dbgFile << "Profile size: " << data.size() << " " << m_store->atEnd() << " " << m_store->device()->bytesAvailable() << " " << read;
         m_store->close();
-        // Create a colorspace with the embedded profile
-        const KoColorProfile *profile = KoColorSpaceRegistry::instance()->createColorProfile(device->colorSpace()->colorModelId().id(), device->colorSpace()->colorDepthId().id(), data);
-        if (device->setProfile(profile)) {
-            return true;
-        }
+
+        // assigning the profile changes the color space of the device,
+        // so wait until its pixel data is decoded
+        runAfterPendingLoads([this, device, data, location] () {
+            // Create a colorspace with the embedded profile
+            const KoColorProfile *profile = KoColorSpaceRegistry::instance()->createColorProfile(device->colorSpace()->colorModelId().id(), device->colorSpace()->colorDepthId().id(), data);
+            if (!device->setProfile(profile)) {
+                m_warningMessages << i18n("Could not load profile: %1.", location);
+            }
+        });
+        return true;
     }
     m_warningMessages << i18n("Could not load profile: %1.", location);
     return true;
@@ -583,7 +693,9 @@ bool KisKraLoadVisitor::loadSelection(const QString& location, KisSelectionSP ds
         if (!result) {
             m_warningMessages << i18n("Could not load raster selection %1.", location);
         }
-        pixelSelection->invalidateOutlineCache();
+        runAfterPendingLoads([pixelSelection] () {
+            pixelSelection->invalidateOutlineCache();
+        });
     }
 
     // Shape selection
@@ -591,6 +703,9 @@ bool KisKraLoadVisitor::loadSelection(const QString& location, KisSelectionSP ds
     if (m_store->hasFile(shapeSelectionLocation + "/content.svg") ||
         m_store->hasFile(shapeSelectionLocation + "/content.xml")) {
 
+        // the shapes are rendered into the pixel selection
+        finishPendingLoads();
+
         m_store->pushDirectory();
         m_store->enterDirectory(shapeSelectionLocation) ;
 
@@ -22,6 +22,12 @@
 
 #include <QRect>
 #include <QStringList>
+#include <QByteArray>
+#include <QFuture>
+#include <QQueue>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
 
 // kritaimage
 #include "kis_types.h"
@@ -31,6 +37,7 @@
 
 class KisFilterConfiguration;
 class KoStore;
+class QIODevice;
 
 class KRITALIBKRA_EXPORT KisKraLoadVisitor : public KisNodeVisitor
 {
@@ -43,6 +50,7 @@ public:
                       QMap<KisNode *, QString> &keyframeFilenames,
                       const QString & name,
                       int syntaxVersion);
+    ~KisKraLoadVisitor() override;
 
 public:
     void setExternalUri(const QString &uri);
@@ -65,12 +73,47 @@ public:
     QStringList errorMessages() const;
     QStringList warningMessages() const;
 
+    /**
+     * The pixel data of the devices is decoded by a pool of threads
+     * while the visitor goes on with the next layers. The method waits
+     * until all the devices are decoded and runs the steps that depend
+     * on their data. It should be called right after the visitor has
+     * been accepted by the root layer, before fetching the messages.
+     */
+    void finishPendingLoads();
+
 private:
+    struct PendingFrame {
+        QString location;
+        QByteArray data;
+        std::function<bool(QIODevice*)> read;
+        std::function<void()> setDefaultPixel;
+        bool readSuccess = false;
+    };
+
+    struct PendingLoad {
+        QFuture<void> decoding;
+        std::function<void()> finish;
+    };
 
     bool loadPaintDevice(KisPaintDeviceSP device, const QString& location);
 
     template<class DevicePolicy>
-    bool loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy);
+    void fetchPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy, QVector<PendingFrame> *frames);
+
+    /**
+     * Calls \p finish on the visitor's thread when \p decoding and
+     * all the loads added before it have finished
+     */
+    void addPendingLoad(const QFuture<void> &decoding, std::function<void()> finish);
+
+    /**
+     * Calls \p step on the visitor's thread when all the devices
+     * added so far have been decoded
+     */
+    void runAfterPendingLoads(std::function<void()> step);
+
+    void finishOldestPendingLoad();
 
     bool loadProfile(KisPaintDeviceSP device,  const QString& location);
     bool loadFilterConfiguration(KisFilterConfigurationSP kfc, const QString& location);
@@ -92,6 +135,8 @@ private:
     int m_syntaxVersion;
     QStringList m_errorMessages;
     QStringList m_warningMessages;
+    QThreadPool m_decodingPool;
+    QQueue<PendingLoad> m_pendingLoads;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
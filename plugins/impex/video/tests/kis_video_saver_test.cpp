@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_video_saver_test.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+
+#include <testutil.h>
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+#include "kis_image_animation_interface.h"
+#include "kis_keyframe_channel.h"
+#include "kis_time_range.h"
+#include "KoColor.h"
+
+#include "video_saver.h"
+
+#ifndef STREAM_CHECKSUM_PATH
+#error "STREAM_CHECKSUM_PATH not set. The path to the stand-in encoder is needed for the test"
+#endif
+
+
+void KisVideoSaverTest::testStreamedFrames()
+{
+    const int numFrames = 6;
+    const QRect rect(0,0,64,48);
+
+    QScopedPointer<KisDocument> document(KisPart::instance()->createDocument());
+    TestUtil::MaskParent p(rect);
+    document->setCurrentImage(p.image);
+    const KoColorSpace *cs = p.image->colorSpace();
+
+    KUndo2Command parentCommand;
+
+    p.layer->enableAnimation();
+    KisKeyframeChannel *rasterChannel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+
+    for (int i = 1; i < numFrames; i++) {
+        rasterChannel->addKeyframe(i, &parentCommand);
+    }
+    p.image->animationInterface()->setFullClipRange(KisTimeRange::fromTime(0, numFrames - 1));
+
+    QStringList expectedChecksums;
+
+    for (int i = 0; i < numFrames; i++) {
+        p.image->animationInterface()->switchCurrentTimeAsync(i);
+        p.image->waitForDone();
+
+        p.layer->paintDevice()->fill(QRect(i * 8, 0, 16, 48), KoColor(QColor(40 * i, 255 - 40 * i, 100), cs));
+        p.image->refreshGraph();
+        p.image->waitForDone();
+
+        const QImage frame = p.image->projection()->convertToQImage(0, rect).convertToFormat(QImage::Format_RGBA8888);
+        const QByteArray bytes(reinterpret_cast<const char*>(frame.constBits()), frame.byteCount());
+        expectedChecksums << QCryptographicHash::hash(bytes, QCryptographicHash::Md5).toHex();
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    KisPropertiesConfigurationSP configuration = new KisPropertiesConfiguration();
+    configuration->setProperty("first_frame", 0);
+    configuration->setProperty("last_frame", numFrames - 1);
+    configuration->setProperty("include_audio", false);
+    configuration->setProperty("directory", dir.path());
+    configuration->setProperty("stream_frames", true);
+
+    const QString resultPath = dir.path() + "/result.mkv";
+
+    VideoSaver saver(document.data(), STREAM_CHECKSUM_PATH, true);
+    QCOMPARE(saver.encode(resultPath, configuration), KisImageBuilder_RESULT_OK);
+
+    QFile result(resultPath);
+    QVERIFY(result.open(QIODevice::ReadOnly | QIODevice::Text));
+
+    const QStringList checksums = QString(result.readAll()).split('\n', QString::SkipEmptyParts);
+    QCOMPARE(checksums, expectedChecksums);
+}
+
+QTEST_MAIN(KisVideoSaverTest)
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * A stand-in for ffmpeg used by KisVideoSaverTest. It understands only
+ * the options needed for the streamed input: reads raw RGBA frames of
+ * the size passed in "-s" from the standard input and writes md5 sums
+ * of them, one line per frame, into the file passed after "-y".
+ */
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    QString progressPath;
+    QString resultPath;
+    QSize frameSize;
+
+    for (int i = 1; i < args.size() - 1; i++) {
+        if (args[i] == "-progress") {
+            progressPath = args[i + 1];
+        } else if (args[i] == "-y") {
+            resultPath = args[i + 1];
+        } else if (args[i] == "-s") {
+            const QStringList size = args[i + 1].split('x');
+            if (size.size() == 2) {
+                frameSize = QSize(size[0].toInt(), size[1].toInt());
+            }
+        }
+    }
+
+    if (resultPath.isEmpty() || frameSize.isEmpty()) {
+        return 1;
+    }
+
+    QFile input;
+    QFile result(resultPath);
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered) ||
+        !result.open(QIODevice::WriteOnly | QIODevice::Text)) {
+
+        return 2;
+    }
+
+    QTextStream resultStream(&result);
+
+    const int frameBytes = frameSize.width() * frameSize.height() * 4;
+    QByteArray frame(frameBytes, 0);
+
+    int numFrames = 0;
+    bool inputEnded = false;
+
+    while (!inputEnded) {
+        int bytesRead = 0;
+
+        while (bytesRead < frameBytes) {
+            const qint64 chunk = input.read(frame.data() + bytesRead, frameBytes - bytesRead);
+            if (chunk <= 0) {
+                inputEnded = true;
+                break;
+            }
+            bytesRead += chunk;
+        }
+
+        if (bytesRead == frameBytes) {
+            resultStream << QCryptographicHash::hash(frame, QCryptographicHash::Md5).toHex() << "\n";
+            numFrames++;
+        } else if (bytesRead > 0) {
+            // a truncated frame
+            return 3;
+        }
+    }
+
+    if (!progressPath.isEmpty()) {
+        QFile progress(progressPath);
+        if (progress.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            QTextStream progressStream(&progress);
+            progressStream << "frame=" << numFrames << "\n"
+                           << "progress=end" << "\n";
+        }
+    }
+
+    return 0;
+}
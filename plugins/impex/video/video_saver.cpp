@@ -33,11 +33,16 @@
 #include <kis_image.h>
 #include <kis_image_animation_interface.h>
 #include <kis_time_range.h>
+#include <kis_paint_device.h>
+#include <dialogs/KisAsyncAnimationFramesSaveDialog.h>
 
 #include "kis_config.h"
 
 #include <QFileSystemWatcher>
 #include <QProcess>
+#include <QQueue>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QProgressDialog>
 #include <QEventLoop>
 #include <QTemporaryFile>
@@ -95,6 +100,108 @@ private:
 };
 
 
+/**
+ * Feeds the raw frames into the standard input of the encoder process.
+ *
+ * The frames are pushed by the image worker threads and are written into
+ * the process in the GUI thread, one frame at a time. When more than
+ * maxQueuedFrames frames are waiting for the encoder, isReady() returns
+ * false, which pauses the rendering until sigReadyForFrames() is emitted.
+ * The workers themselves never wait for the encoder, because the image
+ * might need them to finish the rendering of other clones.
+ */
+class KisFFMpegFramesPipe : public QObject {
+    Q_OBJECT
+public:
+    KisFFMpegFramesPipe(QProcess *process, int maxQueuedFrames)
+        : m_process(process),
+          m_maxQueuedFrames(maxQueuedFrames)
+    {
+        connect(this, SIGNAL(sigFrameQueued()), SLOT(slotWriteFrames()), Qt::QueuedConnection);
+        connect(m_process, SIGNAL(bytesWritten(qint64)), SLOT(slotWriteFrames()));
+        connect(m_process, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(slotProcessFinished()));
+    }
+
+    /**
+     * Called from the image worker threads
+     *
+     * @return false if the encoder has already exited
+     */
+    bool pushFrame(const QByteArray &frame) {
+        {
+            QMutexLocker l(&m_mutex);
+            if (m_failed) return false;
+            m_queue.enqueue(frame);
+        }
+
+        emit sigFrameQueued();
+        return true;
+    }
+
+    bool isReady() const {
+        QMutexLocker l(&m_mutex);
+        return m_failed || m_queue.size() < m_maxQueuedFrames;
+    }
+
+    /**
+     * Writes the rest of the frames and closes the write channel, so the
+     * encoder could finish the file
+     */
+    void finish() {
+        QMutexLocker l(&m_mutex);
+
+        while (!m_queue.isEmpty() && !m_failed) {
+            m_process->write(m_queue.dequeue());
+        }
+
+        m_process->closeWriteChannel();
+    }
+
+private Q_SLOTS:
+    void slotWriteFrames() {
+        if (m_process->bytesToWrite() > 0) return;
+
+        QByteArray frame;
+
+        {
+            QMutexLocker l(&m_mutex);
+            if (m_queue.isEmpty() || m_failed) return;
+            frame = m_queue.dequeue();
+        }
+
+        if (m_process->write(frame) != frame.size()) {
+            slotProcessFinished();
+            return;
+        }
+
+        emit sigReadyForFrames();
+    }
+
+    void slotProcessFinished() {
+        {
+            QMutexLocker l(&m_mutex);
+            m_failed = true;
+            m_queue.clear();
+        }
+
+        // let the renderer continue, the consumer will report the failure
+        emit sigReadyForFrames();
+    }
+
+Q_SIGNALS:
+    void sigFrameQueued();
+    void sigReadyForFrames();
+
+private:
+    QProcess *m_process;
+    const int m_maxQueuedFrames;
+
+    mutable QMutex m_mutex;
+    QQueue<QByteArray> m_queue;
+    bool m_failed = false;
+};
+
+
 class KisFFMpegRunner
 {
 public:
@@ -106,28 +213,57 @@ public:
                                      const QString &actionName,
                                      const QString &logPath,
                                      int totalFrames)
+    {
+        if (!startFFMpeg(specialArgs, logPath, false)) {
+            return KisImageBuilder_RESULT_FAILURE;
+        }
+
+        return waitForFFMpeg(actionName, totalFrames);
+    }
+
+    /**
+     * Starts the encoder without waiting for it to finish. If \p readFramesFromStdin
+     * is true, the frames should be written into process() and the write channel
+     * closed before calling waitForFFMpeg().
+     */
+    bool startFFMpeg(const QStringList &specialArgs,
+                     const QString &logPath,
+                     bool readFramesFromStdin)
     {
         dbgFile << "runFFMpeg: specialArgs" << specialArgs
-                << "actionName" << actionName
                 << "logPath" << logPath
-                << "totalFrames" << totalFrames;
+                << "readFramesFromStdin" << readFramesFromStdin;
 
-        QTemporaryFile progressFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX");
-        progressFile.open();
+        m_progressFile.reset(new QTemporaryFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX"));
+        m_progressFile->open();
 
         m_process.setStandardOutputFile(logPath);
         m_process.setProcessChannelMode(QProcess::MergedChannels);
         QStringList args;
-        args << "-v" << "debug"
-             << "-nostdin"
-             << "-progress" << progressFile.fileName()
+        args << "-v" << "debug";
+
+        if (!readFramesFromStdin) {
+            args << "-nostdin";
+        }
+
+        args << "-progress" << m_progressFile->fileName()
              << specialArgs;
 
         qDebug() << "\t" << m_ffmpegPath << args.join(" ");
 
         m_cancelled = false;
         m_process.start(m_ffmpegPath, args);
-        return waitForFFMpegProcess(actionName, progressFile, m_process, totalFrames);
+        return m_process.waitForStarted();
+    }
+
+    KisImageBuilder_Result waitForFFMpeg(const QString &actionName, int totalFrames)
+    {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_progressFile, KisImageBuilder_RESULT_FAILURE);
+        return waitForFFMpegProcess(actionName, *m_progressFile, m_process, totalFrames);
+    }
+
+    QProcess* process() {
+        return &m_process;
     }
 
     void cancel() {
@@ -155,7 +291,11 @@ private:
         loop.connect(&watcher, SIGNAL(sigProcessingFinished()), SLOT(quit()));
         loop.connect(&ffmpegProcess, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(quit()));
         loop.connect(&watcher, SIGNAL(sigProgressChanged(int)), &progress, SLOT(setValue(int)));
-        loop.exec();
+
+        // the process might have been already killed on cancel
+        if (ffmpegProcess.state() != QProcess::NotRunning) {
+            loop.exec();
+        }
 
         // wait for some errorneous case
         ffmpegProcess.waitForFinished(5000);
@@ -179,6 +319,7 @@ private:
     QProcess m_process;
     bool m_cancelled;
     QString m_ffmpegPath;
+    QScopedPointer<QTemporaryFile> m_progressFile;
 };
 
 
@@ -228,7 +369,9 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
     KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("include_audio"));
     KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("directory"));
 
-    const KisTimeRange clipRange(configuration->getInt("first_frame", fullRange.start()), configuration->getInt("last_frame", fullRange.end()));
+    const KisTimeRange clipRange =
+        KisTimeRange::fromTime(configuration->getInt("first_frame", fullRange.start()),
+                               configuration->getInt("last_frame", fullRange.end()));
     const bool includeAudio = configuration->getBool("include_audio", true);
 
     const QDir framesDir(configuration->getString("directory"));
@@ -249,7 +392,36 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
 
     const QStringList additionalOptionsList = configuration->getString("customUserOptions").split(' ', QString::SkipEmptyParts);
 
-    if (suffix == "gif") {
+    const bool streamFrames = configuration->getBool("stream_frames", false);
+
+    QStringList inputArgs;
+    if (streamFrames) {
+        inputArgs << "-f" << "rawvideo"
+                  << "-pix_fmt" << "rgba"
+                  << "-s" << QString("%1x%2").arg(m_image->width()).arg(m_image->height())
+                  << "-r" << QString::number(frameRate)
+                  << "-i" << "-";
+    } else {
+        inputArgs << "-r" << QString::number(frameRate)
+                  << "-start_number" << QString::number(clipRange.start())
+                  << "-i" << savedFilesMask;
+    }
+
+    if (suffix == "gif" && streamFrames) {
+        /**
+         * The streamed frames cannot be read twice, so the palette
+         * is generated and used in a single pass
+         */
+        QStringList args;
+        args << inputArgs
+             << "-lavfi" << "split[a][b];[a]palettegen[p];[b][p]paletteuse"
+             << additionalOptionsList
+             << "-y" << resultFile;
+
+        result = runFFMpegStreamed(args, i18n("Encoding frames..."),
+                                   framesDir.filePath("log_encode_gif.log"),
+                                   clipRange);
+    } else if (suffix == "gif") {
         {
             QStringList args;
             args << "-r" << QString::number(frameRate)
@@ -291,9 +463,7 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
         }
     } else {
         QStringList args;
-        args << "-r" << QString::number(frameRate)
-             << "-start_number" << QString::number(clipRange.start())
-             << "-i" << savedFilesMask;
+        args << inputArgs;
 
 
         QFileInfo audioFileInfo = animation->audioChannelFileName();
@@ -314,14 +484,65 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
         args << additionalOptionsList
              << "-y" << resultFile;
 
-        result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
-                                     framesDir.filePath("log_encode.log"),
-                                     clipRange.duration());
+        if (streamFrames) {
+            result = runFFMpegStreamed(args, i18n("Encoding frames..."),
+                                       framesDir.filePath("log_encode.log"),
+                                       clipRange);
+        } else {
+            result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
+                                         framesDir.filePath("log_encode.log"),
+                                         clipRange.duration());
+        }
     }
 
     return result;
 }
 
+KisImageBuilder_Result VideoSaver::runFFMpegStreamed(const QStringList &args,
+                                                     const QString &actionName,
+                                                     const QString &logPath,
+                                                     const KisTimeRange &clipRange)
+{
+    if (!m_runner->startFFMpeg(args, logPath, true)) {
+        return KisImageBuilder_RESULT_FAILURE;
+    }
+
+    /**
+     * Keep only a few frames in memory: the encoder is usually
+     * slower than the renderer, so the queue would just grow
+     */
+    const int maxQueuedFrames = 4;
+    KisFFMpegFramesPipe pipe(m_runner->process(), maxQueuedFrames);
+
+    const QRect bounds = m_image->bounds();
+
+    KisAsyncAnimationFramesSaveDialog exporter(m_image, clipRange, QString(), 0, 0);
+    exporter.setBatchMode(m_batchMode);
+    exporter.setFrameConsumer(
+        [&pipe, bounds] (int, KisPaintDeviceSP device) {
+            const QImage frame = device->convertToQImage(0, bounds).convertToFormat(QImage::Format_RGBA8888);
+            return pipe.pushFrame(QByteArray(reinterpret_cast<const char*>(frame.constBits()), frame.byteCount()));
+        },
+        [&pipe] () {
+            return pipe.isReady();
+        });
+
+    connect(&pipe, SIGNAL(sigReadyForFrames()), &exporter, SLOT(resumeFrameRegeneration()));
+
+    const KisAsyncAnimationRenderDialogBase::Result renderResult = exporter.regenerateRange(0);
+
+    if (renderResult != KisAsyncAnimationRenderDialogBase::RenderComplete) {
+        m_runner->cancel();
+        m_runner->waitForFFMpeg(actionName, clipRange.duration());
+
+        return renderResult == KisAsyncAnimationRenderDialogBase::RenderCancelled ?
+            KisImageBuilder_RESULT_CANCEL : KisImageBuilder_RESULT_FAILURE;
+    }
+
+    pipe.finish();
+    return m_runner->waitForFFMpeg(actionName, clipRange.duration());
+}
+
 void VideoSaver::cancel()
 {
     m_runner->cancel();
@@ -33,6 +33,7 @@ class KisFFMpegRunner;
 /* The KisImageBuilder_Result definitions come from kis_png_converter.h here */
 
 class KisDocument;
+class KisTimeRange;
 
 class KRITAVIDEOEXPORT_EXPORT VideoSaver : public QObject {
 
@@ -49,6 +50,16 @@ public:
 private Q_SLOTS:
     void cancel();
 
+private:
+    /**
+     * Renders the frames of \p clipRange and writes them into the standard
+     * input of the encoder while it is running
+     */
+    KisImageBuilder_Result runFFMpegStreamed(const QStringList &args,
+                                             const QString &actionName,
+                                             const QString &logPath,
+                                             const KisTimeRange &clipRange);
+
 private:
     KisImageSP m_image;
     KisDocument* m_doc;
@@ -43,6 +43,15 @@
 #include <kis_lod_transform.h>
 #include <kis_paintop_plugin_utils.h>
 
+namespace {
+
+/**
+ * Dabs with the area bigger than that are composited in
+ * parallel, see KisPainter::bltFixedConcurrent()
+ */
+const int CONCURRENT_DAB_AREA_THRESHOLD = 500 * 500;
+
+}
 
 KisBrushOp::KisBrushOp(const KisPaintOpSettingsSP settings, KisPainter *painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
@@ -161,7 +170,16 @@ KisSpacingInformation KisBrushOp::paintAt(const KisPaintInformation& info)
         warnKrita << "KisBrushOp: dab bounds is not dab rect. See bug 327156" << dab->bounds().size() << dabRect.size();
     }
 
-    painter()->bltFixed(dabRect.topLeft(), dab, dab->bounds());
+    /**
+     * Compositing of a huge dab takes tens of milliseconds, so split it
+     * into tile-aligned strips and composite them concurrently. The mask
+     * of such dabs is already generated in parallel by the auto brush.
+     */
+    if (dabRect.width() * dabRect.height() >= CONCURRENT_DAB_AREA_THRESHOLD) {
+        painter()->bltFixedConcurrent(dabRect.topLeft(), dab, dab->bounds());
+    } else {
+        painter()->bltFixed(dabRect.topLeft(), dab, dab->bounds());
+    }
 
     painter()->renderMirrorMaskSafe(dabRect,
                                     dab,
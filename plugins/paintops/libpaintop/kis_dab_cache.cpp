@@ -31,6 +31,10 @@
 
 #include <kundo2command.h>
 
+#include <QCache>
+#include <QHash>
+#include <cmath>
+
 struct PrecisionValues {
     qreal angle;
     qreal sizeFrac;
@@ -47,6 +51,82 @@ static const PrecisionValues precisionLevels[] = {
     {eps,         0, eps,  eps}
 };
 
+/**
+ * Maximum amount of memory (in KiB) the cached dabs can occupy
+ */
+const int DAB_CACHE_MAX_COST = 32 * 1024;
+
+namespace {
+
+/**
+ * The parameters of the dab quantized according to the current
+ * precision level. Two dabs with equal keys are considered to be
+ * the same dab and can be reused.
+ */
+struct DabCacheKey {
+    const KoColorSpace *colorSpace;
+    QByteArray color;
+    int precisionLevel;
+    int angle;
+    int width;
+    int height;
+    int subPixelX;
+    int subPixelY;
+    int softnessFactor;
+    int index;
+    bool horizontalMirror;
+    bool verticalMirror;
+
+    bool operator==(const DabCacheKey &rhs) const {
+        return colorSpace == rhs.colorSpace &&
+               color == rhs.color &&
+               precisionLevel == rhs.precisionLevel &&
+               angle == rhs.angle &&
+               width == rhs.width &&
+               height == rhs.height &&
+               subPixelX == rhs.subPixelX &&
+               subPixelY == rhs.subPixelY &&
+               softnessFactor == rhs.softnessFactor &&
+               index == rhs.index &&
+               horizontalMirror == rhs.horizontalMirror &&
+               verticalMirror == rhs.verticalMirror;
+    }
+};
+
+inline uint qHash(const DabCacheKey &key, uint seed = 0)
+{
+    uint h = ::qHash(key.color, seed);
+    h ^= ::qHash(quintptr(key.colorSpace)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= uint(key.angle) * 31 + uint(key.width) * 131 + uint(key.height) * 1031;
+    h ^= (uint(key.subPixelX) << 8) ^ (uint(key.subPixelY) << 12);
+    h ^= uint(key.softnessFactor) * 8191 + uint(key.index) * 65521;
+    h ^= uint(key.precisionLevel) << 24;
+    h ^= (uint(key.horizontalMirror) << 28) ^ (uint(key.verticalMirror) << 29);
+    return h;
+}
+
+struct CachedDab {
+    KisFixedPaintDeviceSP dab;
+    KisFixedPaintDeviceSP dabOriginal;
+};
+
+inline int quantize(qreal value, qreal step)
+{
+    return qRound(value / step);
+}
+
+/**
+ * The size of the dab is quantized in a logarithmic scale, so that
+ * the dabs with relative difference of the size less than \p sizeFrac
+ * usually fall into the same bucket
+ */
+inline int quantizeSize(int size, qreal sizeFrac)
+{
+    return sizeFrac > 0 ? qRound(std::log(qreal(qMax(size, 1))) / std::log1p(sizeFrac)) : size;
+}
+
+}
+
 struct KisDabCache::SavedDabParameters {
     KoColor color;
     qreal angle;
@@ -58,19 +138,25 @@ struct KisDabCache::SavedDabParameters {
     int index;
     MirrorProperties mirrorProperties;
 
-    bool compare(const SavedDabParameters &rhs, int precisionLevel) const {
+    DabCacheKey cacheKey(const KoColorSpace *cs, int precisionLevel) const {
         const PrecisionValues &prec = precisionLevels[precisionLevel];
 
-        return color == rhs.color &&
-               qAbs(angle - rhs.angle) <= prec.angle &&
-               qAbs(width - rhs.width) <= (int)(prec.sizeFrac * width) &&
-               qAbs(height - rhs.height) <= (int)(prec.sizeFrac * height) &&
-               qAbs(subPixelX - rhs.subPixelX) <= prec.subPixel &&
-               qAbs(subPixelY - rhs.subPixelY) <= prec.subPixel &&
-               qAbs(softnessFactor - rhs.softnessFactor) <= prec.softnessFactor &&
-               index == rhs.index &&
-               mirrorProperties.horizontalMirror == rhs.mirrorProperties.horizontalMirror &&
-               mirrorProperties.verticalMirror == rhs.mirrorProperties.verticalMirror;
+        DabCacheKey key;
+        key.colorSpace = cs;
+        key.color = QByteArray(reinterpret_cast<const char*>(color.data()),
+                               color.colorSpace()->pixelSize());
+        key.precisionLevel = precisionLevel;
+        key.angle = quantize(angle, prec.angle);
+        key.width = quantizeSize(width, prec.sizeFrac);
+        key.height = quantizeSize(height, prec.sizeFrac);
+        key.subPixelX = std::floor(subPixelX / prec.subPixel);
+        key.subPixelY = std::floor(subPixelY / prec.subPixel);
+        key.softnessFactor = quantize(softnessFactor, prec.softnessFactor);
+        key.index = index;
+        key.horizontalMirror = mirrorProperties.horizontalMirror;
+        key.verticalMirror = mirrorProperties.verticalMirror;
+
+        return key;
     }
 };
 
@@ -83,7 +169,9 @@ struct KisDabCache::Private {
           textureOption(0),
           precisionOption(0),
           subPixelPrecisionDisabled(false),
-          cachedDabParameters(new SavedDabParameters)
+          cache(DAB_CACHE_MAX_COST),
+          cacheHits(0),
+          cacheMisses(0)
     {}
     KisFixedPaintDeviceSP dab;
     KisFixedPaintDeviceSP dabOriginal;
@@ -97,7 +185,17 @@ struct KisDabCache::Private {
     KisPrecisionOption *precisionOption;
     bool subPixelPrecisionDisabled;
 
-    SavedDabParameters *cachedDabParameters;
+    /**
+     * QCache drops the least recently used dabs when
+     * the total cost exceeds DAB_CACHE_MAX_COST
+     */
+    QCache<DabCacheKey, CachedDab> cache;
+    int cacheHits;
+    int cacheMisses;
+
+    int precisionLevel() const {
+        return precisionOption ? precisionOption->precisionLevel() - 1 : 3;
+    }
 };
 
 
@@ -109,7 +207,6 @@ KisDabCache::KisDabCache(KisBrushSP brush)
 
 KisDabCache::~KisDabCache()
 {
-    delete m_d->cachedDabParameters;
     delete m_d;
 }
 
@@ -138,6 +235,16 @@ void KisDabCache::disableSubpixelPrecision()
     m_d->subPixelPrecisionDisabled = true;
 }
 
+int KisDabCache::cacheHits() const
+{
+    return m_d->cacheHits;
+}
+
+int KisDabCache::cacheMisses() const
+{
+    return m_d->cacheMisses;
+}
+
 inline KisDabCache::SavedDabParameters
 KisDabCache::getDabParameters(const KoColor& color,
                               KisDabShape const& shape,
@@ -226,26 +333,52 @@ QRect KisDabCache::correctDabRectWhenFetchedFromCache(const QRect &dabRect,
 
 inline
 KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &params,
+        const KoColorSpace *cs,
         const KisPaintInformation& info,
         QRect *dstDabRect)
 {
-    int precisionLevel = m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
+    CachedDab *cachedDab = m_d->cache.object(params.cacheKey(cs, m_d->precisionLevel()));
 
-    if (!params.compare(*m_d->cachedDabParameters, precisionLevel)) {
+    if (!cachedDab) {
+        m_d->cacheMisses++;
         return 0;
     }
 
-    if (needSeparateOriginal()) {
-        *m_d->dab = *m_d->dabOriginal;
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
-        postProcessDab(m_d->dab, dstDabRect->topLeft(), info);
+    m_d->cacheHits++;
+
+    KisFixedPaintDeviceSP dab = cachedDab->dab;
+
+    if (needSeparateOriginal() && cachedDab->dabOriginal) {
+        *dab = *cachedDab->dabOriginal;
+        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, dab->bounds().size());
+        postProcessDab(dab, dstDabRect->topLeft(), info);
     }
     else {
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
+        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, dab->bounds().size());
     }
 
     m_d->brush->notifyCachedDabPainted(info);
-    return m_d->dab;
+    return dab;
+}
+
+inline
+void KisDabCache::putIntoCache(const SavedDabParameters &params,
+                               const KoColorSpace *cs,
+                               KisFixedPaintDeviceSP dab,
+                               KisFixedPaintDeviceSP dabOriginal)
+{
+    CachedDab *cachedDab = new CachedDab();
+    cachedDab->dab = dab;
+    cachedDab->dabOriginal = dabOriginal;
+
+    const QRect bounds = dab->bounds();
+    int cost = bounds.width() * bounds.height() * dab->pixelSize() / 1024;
+    if (dabOriginal) {
+        cost *= 2;
+    }
+
+    // if the dab is too big for the cache, QCache will just delete it
+    m_d->cache.insert(params.cacheKey(cs, m_d->precisionLevel()), cachedDab, qMax(1, cost));
 }
 
 qreal positiveFraction(qreal x) {
@@ -338,73 +471,98 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
     shape = KisDabShape(shape.scale(), shape.ratio(), position.realAngle);
     *dstDabRect = position.rect;
 
-    bool cachingIsPossible = !colorSource || colorSource->isUniformColor();
+    const bool isImageBrush =
+        m_d->brush->brushType() == IMAGE ||
+        m_d->brush->brushType() == PIPE_IMAGE;
+
+    bool cachingIsPossible = !isImageBrush && (!colorSource || colorSource->isUniformColor());
     KoColor paintColor = colorSource && colorSource->isUniformColor() ?
                          colorSource->uniformColor() : color;
 
-    SavedDabParameters newParams = getDabParameters(paintColor,
-                                   shape, info,
-                                   position.subPixel.x(),
-                                   position.subPixel.y(),
-                                   softnessFactor,
-                                   mirrorProperties);
+    KisFixedPaintDeviceSP dab;
+
+    if (cachingIsPossible) {
+        SavedDabParameters newParams = getDabParameters(paintColor,
+                                       shape, info,
+                                       position.subPixel.x(),
+                                       position.subPixel.y(),
+                                       softnessFactor,
+                                       mirrorProperties);
 
-    if (!m_d->dab || *m_d->dab->colorSpace() != *cs) {
-        m_d->dab = new KisFixedPaintDevice(cs);
-    }
-    else if (cachingIsPossible) {
         KisFixedPaintDeviceSP cachedDab =
-            tryFetchFromCache(newParams, info, dstDabRect);
+            tryFetchFromCache(newParams, cs, info, dstDabRect);
 
         if (cachedDab) return cachedDab;
-    }
 
-    if (m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE) {
-        m_d->dab = m_d->brush->paintDevice(cs, shape, info,
-                                           position.subPixel.x(),
-                                           position.subPixel.y());
-    }
-    else if (cachingIsPossible) {
-        *m_d->cachedDabParameters = newParams;
-        m_d->brush->mask(m_d->dab, paintColor, shape,
+        /**
+         * The cached dabs are shared with the cache, so every new
+         * dab should get its own device
+         */
+        dab = new KisFixedPaintDevice(cs);
+        m_d->brush->mask(dab, paintColor, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
+
+        if (!mirrorProperties.isEmpty()) {
+            dab->mirror(mirrorProperties.horizontalMirror,
+                        mirrorProperties.verticalMirror);
+        }
+
+        KisFixedPaintDeviceSP dabOriginal;
+        if (needSeparateOriginal()) {
+            dabOriginal = new KisFixedPaintDevice(*dab);
+        }
+
+        putIntoCache(newParams, cs, dab, dabOriginal);
     }
     else {
-        if (!m_d->colorSourceDevice || *cs != *m_d->colorSourceDevice->colorSpace()) {
-            m_d->colorSourceDevice = new KisPaintDevice(cs);
+        if (!m_d->dab || *m_d->dab->colorSpace() != *cs) {
+            m_d->dab = new KisFixedPaintDevice(cs);
+        }
+
+        if (isImageBrush) {
+            m_d->dab = m_d->brush->paintDevice(cs, shape, info,
+                                               position.subPixel.x(),
+                                               position.subPixel.y());
         }
         else {
-            m_d->colorSourceDevice->clear();
+            if (!m_d->colorSourceDevice || *cs != *m_d->colorSourceDevice->colorSpace()) {
+                m_d->colorSourceDevice = new KisPaintDevice(cs);
+            }
+            else {
+                m_d->colorSourceDevice->clear();
+            }
+
+            QRect maskRect(QPoint(), position.rect.size());
+            colorSource->colorize(m_d->colorSourceDevice, maskRect, info.pos().toPoint());
+            delete m_d->colorSourceDevice->convertTo(cs);
+
+            m_d->brush->mask(m_d->dab, m_d->colorSourceDevice, shape,
+                             info,
+                             position.subPixel.x(), position.subPixel.y(),
+                             softnessFactor);
         }
 
-        QRect maskRect(QPoint(), position.rect.size());
-        colorSource->colorize(m_d->colorSourceDevice, maskRect, info.pos().toPoint());
-        delete m_d->colorSourceDevice->convertTo(cs);
-
-        m_d->brush->mask(m_d->dab, m_d->colorSourceDevice, shape,
-                         info,
-                         position.subPixel.x(), position.subPixel.y(),
-                         softnessFactor);
-    }
+        if (!mirrorProperties.isEmpty()) {
+            m_d->dab->mirror(mirrorProperties.horizontalMirror,
+                             mirrorProperties.verticalMirror);
+        }
 
-    if (!mirrorProperties.isEmpty()) {
-        m_d->dab->mirror(mirrorProperties.horizontalMirror,
-                         mirrorProperties.verticalMirror);
-    }
+        if (needSeparateOriginal()) {
+            if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
+                m_d->dabOriginal = new KisFixedPaintDevice(cs);
+            }
 
-    if (needSeparateOriginal()) {
-        if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
-            m_d->dabOriginal = new KisFixedPaintDevice(cs);
+            *m_d->dabOriginal = *m_d->dab;
         }
 
-        *m_d->dabOriginal = *m_d->dab;
+        dab = m_d->dab;
     }
 
-    postProcessDab(m_d->dab, position.rect.topLeft(), info);
+    postProcessDab(dab, position.rect.topLeft(), info);
 
-    return m_d->dab;
+    return dab;
 }
 
 void KisDabCache::postProcessDab(KisFixedPaintDeviceSP dab,
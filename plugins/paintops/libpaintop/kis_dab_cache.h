@@ -48,6 +48,12 @@ struct MirrorProperties;
  *  level.
  *
  *  The texturing and mirroring problems are solved.
+ *
+ *  The cache keeps several recently used dabs (see DAB_CACHE_MAX_COST),
+ *  so the strokes alternating between a few dab shapes (e.g. with
+ *  rotation sensors or mirroring) can reuse them as well. The dabs are
+ *  looked up by their parameters quantized according to the precision
+ *  level.
  */
 class PAINTOP_EXPORT KisDabCache
 {
@@ -70,6 +76,14 @@ public:
 
     bool needSeparateOriginal();
 
+    /**
+     * The number of dabs fetched from the cache and the number
+     * of dabs that had to be generated, though could be cached.
+     * The counters are used in tests and benchmarks.
+     */
+    int cacheHits() const;
+    int cacheMisses() const;
+
     KisFixedPaintDeviceSP fetchDab(const KoColorSpace *cs,
                                    const KisColorSource *colorSource,
                                    const QPointF &cursorPoint,
@@ -108,9 +122,15 @@ private:
             const QSize &realDabSize);
 
     inline KisFixedPaintDeviceSP tryFetchFromCache(const SavedDabParameters &params,
+            const KoColorSpace *cs,
             const KisPaintInformation& info,
             QRect *dstDabRect);
 
+    inline void putIntoCache(const SavedDabParameters &params,
+                             const KoColorSpace *cs,
+                             KisFixedPaintDeviceSP dab,
+                             KisFixedPaintDeviceSP dabOriginal);
+
     inline KisFixedPaintDeviceSP fetchDabCommon(const KoColorSpace *cs,
             const KisColorSource *colorSource,
             const KoColor& color,
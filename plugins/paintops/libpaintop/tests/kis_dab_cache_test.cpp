@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_cache_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_auto_brush.h>
+#include <kis_circle_mask_generator.h>
+#include <kis_fixed_paint_device.h>
+#include <kis_dab_shape.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_dab_cache.h"
+#include "kis_precision_option.h"
+
+
+void KisDabCacheTest::testAlternatingShapes()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisBrushSP brush = new KisAutoBrush(new KisCircleMaskGenerator(30, 0.5, 1.0, 1.0, 2, true), 0.0, 0.0);
+
+    KisPrecisionOption precisionOption;
+    precisionOption.setPrecisionLevel(5);
+
+    KisDabCache cache(brush);
+    cache.setPrecisionOption(&precisionOption);
+
+    const KoColor color(Qt::black, cs);
+    const QPointF pos(100, 100);
+    const KisPaintInformation info(pos, 1.0);
+
+    // the stroke alternates between two elongated dab shapes
+    for (int i = 0; i < 10; i++) {
+        const KisDabShape shape(1.0, 0.5, (i % 2) ? M_PI_2 : 0.0);
+
+        QRect dabRect;
+        KisFixedPaintDeviceSP dab = cache.fetchDab(cs, color, pos, shape, info, 1.0, &dabRect);
+        QVERIFY(dab);
+    }
+
+    QCOMPARE(cache.cacheMisses(), 2);
+    QCOMPARE(cache.cacheHits(), 8);
+}
+
+void KisDabCacheTest::testCachedDabIsEqual()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisBrushSP brush = new KisAutoBrush(new KisCircleMaskGenerator(30, 0.5, 0.7, 0.7, 2, true), 0.0, 0.0);
+
+    KisPrecisionOption precisionOption;
+    precisionOption.setPrecisionLevel(5);
+
+    KisDabCache cache(brush);
+    cache.setPrecisionOption(&precisionOption);
+
+    const KoColor color(Qt::red, cs);
+    const QPointF pos(100, 100);
+    const KisPaintInformation info(pos, 1.0);
+
+    const KisDabShape shape1(1.0, 0.5, 0.3);
+    const KisDabShape shape2(1.0, 0.5, 1.3);
+
+    QRect dabRect1;
+    KisFixedPaintDeviceSP dab1 = cache.fetchDab(cs, color, pos, shape1, info, 1.0, &dabRect1);
+    const QByteArray originalData(reinterpret_cast<const char*>(dab1->data()),
+                                  dab1->bounds().width() * dab1->bounds().height() * cs->pixelSize());
+
+    QRect dabRect2;
+    cache.fetchDab(cs, color, pos, shape2, info, 1.0, &dabRect2);
+
+    QRect dabRect3;
+    KisFixedPaintDeviceSP dab3 = cache.fetchDab(cs, color, pos, shape1, info, 1.0, &dabRect3);
+    QCOMPARE(cache.cacheHits(), 1);
+
+    const QByteArray cachedData(reinterpret_cast<const char*>(dab3->data()),
+                                dab3->bounds().width() * dab3->bounds().height() * cs->pixelSize());
+
+    QCOMPARE(dabRect3, dabRect1);
+    QCOMPARE(cachedData, originalData);
+}
+
+QTEST_MAIN(KisDabCacheTest)